@@ -0,0 +1,156 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __DATABASE_UTILS_H__
+#define __DATABASE_UTILS_H__
+
+// Qt
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVariant>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlError>
+#include <QtSql/QSqlQuery>
+
+namespace DatabaseUtils {
+
+// A migration upgrades the schema by one version, it is run in a transaction
+typedef bool (*Migration)(QSqlDatabase& database);
+
+static bool exec(QSqlDatabase& database, const QString& statement)
+{
+    QSqlQuery query(database);
+    if (!query.exec(statement)) {
+        qWarning() << "Failed to execute" << statement << ":" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+static bool exec(QSqlDatabase& database, const QStringList& statements)
+{
+    Q_FOREACH(const QString& statement, statements) {
+        if (!exec(database, statement)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static QVariant pragmaValue(QSqlDatabase& database, const QString& pragma)
+{
+    QSqlQuery query(database);
+    if (query.exec(QStringLiteral("PRAGMA %1;").arg(pragma)) && query.next()) {
+        return query.value(0);
+    }
+    return QVariant();
+}
+
+static int schemaVersion(QSqlDatabase& database)
+{
+    return pragmaValue(database, QStringLiteral("user_version")).toInt();
+}
+
+static bool hasColumn(QSqlDatabase& database, const QString& table, const QString& column)
+{
+    QSqlQuery query(database);
+    query.exec(QStringLiteral("PRAGMA TABLE_INFO(%1);").arg(table));
+    while (query.next()) {
+        // The second column of the result set is the column name
+        if (query.value(1).toString() == column) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool hasTable(QSqlDatabase& database, const QString& table)
+{
+    QSqlQuery query(database);
+    query.prepare(QStringLiteral("SELECT 1 FROM sqlite_master WHERE type='table' AND name=?;"));
+    query.addBindValue(table);
+    return query.exec() && query.next();
+}
+
+static bool addColumnIfMissing(QSqlDatabase& database, const QString& table,
+                               const QString& column, const QString& type)
+{
+    if (hasColumn(database, table, column)) {
+        return true;
+    }
+    return exec(database, QStringLiteral("ALTER TABLE %1 ADD COLUMN %2 %3;").arg(table, column, type));
+}
+
+/*
+    Switch the database to write-ahead logging, so that writes don’t block
+    readers and commits only need to sync the log. This setting is persistent,
+    and it has no effect on in-memory databases.
+*/
+static void enableWriteAheadLog(QSqlDatabase& database)
+{
+    exec(database, QStringLiteral("PRAGMA journal_mode=WAL;"));
+    exec(database, QStringLiteral("PRAGMA synchronous=NORMAL;"));
+}
+
+/*
+    Remove a database file together with the write-ahead log and shared memory
+    files that SQLite creates next to it. The database must be closed.
+*/
+static void removeDatabaseFiles(const QString& path)
+{
+    QFile::remove(path);
+    QFile::remove(path + QStringLiteral("-wal"));
+    QFile::remove(path + QStringLiteral("-shm"));
+}
+
+/*
+    Bring the schema of the database up to date.
+
+    The version of the schema is stored in the user_version pragma, and the
+    migration at index N upgrades the schema from version N to version N+1.
+    Databases created before the versioning was introduced are at version 0,
+    so the first migration must cope with tables that may already exist.
+    Each migration is run in its own transaction, together with the version
+    bump, so that an interrupted upgrade resumes from the last completed step.
+
+    Return false if a migration failed, in which case the schema is left at
+    the last version that was successfully reached.
+*/
+static bool migrate(QSqlDatabase& database, const QList<Migration>& migrations)
+{
+    int version = schemaVersion(database);
+    for (int i = version; i < migrations.count(); ++i) {
+        database.transaction();
+        if (!migrations.at(i)(database) ||
+            !exec(database, QStringLiteral("PRAGMA user_version=%1;").arg(i + 1))) {
+            qWarning() << "Failed to migrate" << database.databaseName()
+                       << "to schema version" << (i + 1);
+            database.rollback();
+            return false;
+        }
+        database.commit();
+    }
+    return true;
+}
+
+} // namespace DatabaseUtils
+
+#endif // __DATABASE_UTILS_H__
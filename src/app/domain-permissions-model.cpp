@@ -16,6 +16,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "database-utils.h"
 #include "domain-permissions-model.h"
 #include "domain-utils.h"
 
@@ -50,8 +51,8 @@ void DomainPermissionsModel::resetDatabase(const QString& databaseName)
     m_database.setDatabaseName(databaseName);
     m_database.open();
     createOrAlterDatabaseSchema();
-    endResetModel();
     populateFromDatabase();
+    endResetModel();
     Q_EMIT rowCountChanged();
 }
 
@@ -93,14 +94,18 @@ QVariant DomainPermissionsModel::data(const QModelIndex& index, int role) const
     }
 }
 
+static bool createDomainPermissionsSchema(QSqlDatabase& database)
+{
+    return DatabaseUtils::exec(database,
+               QLatin1String("CREATE TABLE IF NOT EXISTS domainpermissions "
+                             "(domain VARCHAR NOT NULL UNIQUE, requestedByDomain VARCHAR, permission INTEGER, lastRequested DATETIME, PRIMARY KEY(domain));"));
+}
+
 void DomainPermissionsModel::createOrAlterDatabaseSchema()
 {
-    // permissions table
-    QSqlQuery createQuery(m_database);
-    QString query = QLatin1String("CREATE TABLE IF NOT EXISTS domainpermissions "
-                                  "(domain VARCHAR NOT NULL UNIQUE, requestedByDomain VARCHAR, permission INTEGER, lastRequested DATETIME, PRIMARY KEY(domain));");
-    createQuery.prepare(query);
-    createQuery.exec();
+    DatabaseUtils::enableWriteAheadLog(m_database);
+    DatabaseUtils::migrate(m_database, QList<DatabaseUtils::Migration>()
+                           << createDomainPermissionsSchema);
 }
 
 void DomainPermissionsModel::populateFromDatabase()
@@ -108,19 +113,16 @@ void DomainPermissionsModel::populateFromDatabase()
     // populate domainpermissions
     QSqlQuery populateQuery(m_database);
     QString query = QLatin1String("SELECT domain, requestedByDomain, permission, lastRequested FROM domainpermissions;");
+    populateQuery.setForwardOnly(true);
     populateQuery.prepare(query);
     populateQuery.exec();
-    int count = 0; // size() isn't supported on the sqlite backend
     while (populateQuery.next()) {
         DomainPermissionEntry entry;
-        entry.domain = populateQuery.value("domain").toString();
-        entry.requestedByDomain = populateQuery.value("requestedByDomain").toString();
-        entry.permission = static_cast<DomainPermission>(populateQuery.value("permission").toInt());
-        entry.lastRequested = QDateTime::fromTime_t(populateQuery.value("lastRequested").toUInt());
-        beginInsertRows(QModelIndex(), count, count);
+        entry.domain = populateQuery.value(0).toString();
+        entry.requestedByDomain = populateQuery.value(1).toString();
+        entry.permission = static_cast<DomainPermission>(populateQuery.value(2).toInt());
+        entry.lastRequested = QDateTime::fromTime_t(populateQuery.value(3).toUInt());
         m_entries.append(entry);
-        endInsertRows();
-        count++;
     }
 }
 
@@ -217,11 +219,12 @@ bool DomainPermissionsModel::contains(const QString& domain) const
 
 void DomainPermissionsModel::deleteAndResetDataBase()
 {
-    if (QFile::exists(databasePath()))
-    {
-        QFile(databasePath()).remove();
-    }
-    resetDatabase(databasePath());
+    // Close the database first, so that its write-ahead log is not replayed
+    // into the new database
+    QString path = databasePath();
+    m_database.close();
+    DatabaseUtils::removeDatabaseFiles(path);
+    resetDatabase(path);
 }
 
 void DomainPermissionsModel::insertEntry(const QString &domain, bool incognito)
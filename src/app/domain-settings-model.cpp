@@ -16,6 +16,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "database-utils.h"
 #include "domain-settings-model.h"
 #include "domain-utils.h"
 
@@ -58,8 +59,10 @@ void DomainSettingsModel::resetDatabase(const QString& databaseName)
     createOrAlterDatabaseSchema();
     removeDefaultZoomFactorFromEntries();
     removeObsoleteEntries();
-    endResetModel();
+    // Entries are read before the end of the reset rather than inserted one
+    // by one, so that views are notified once for all of them
     populateFromDatabase();
+    endResetModel();
     Q_EMIT rowCountChanged();
 }
 
@@ -107,14 +110,28 @@ QVariant DomainSettingsModel::data(const QModelIndex& index, int role) const
     }
 }
 
+static bool createDomainSettingsSchema(QSqlDatabase& database)
+{
+    return DatabaseUtils::exec(database,
+               QLatin1String("CREATE TABLE IF NOT EXISTS domainsettings "
+                             "(domain VARCHAR NOT NULL UNIQUE, domainWithoutSubdomain VARCHAR, allowCustomUrlSchemes BOOL, allowLocation BOOL, "
+                             "userAgentId INTEGER, zoomFactor REAL, PRIMARY KEY(domain), FOREIGN KEY(userAgentId) REFERENCES useragents(id)); "));
+}
+
+static bool indexDomainSettings(QSqlDatabase& database)
+{
+    return DatabaseUtils::exec(database,
+               QLatin1String("CREATE INDEX domainsettings_userAgentId ON domainsettings (userAgentId);"));
+}
+
 void DomainSettingsModel::createOrAlterDatabaseSchema()
 {
-    QSqlQuery createQuery(m_database);
-    QString query = QLatin1String("CREATE TABLE IF NOT EXISTS domainsettings "
-                                  "(domain VARCHAR NOT NULL UNIQUE, domainWithoutSubdomain VARCHAR, allowCustomUrlSchemes BOOL, allowLocation BOOL, "
-                                  "userAgentId INTEGER, zoomFactor REAL, PRIMARY KEY(domain), FOREIGN KEY(userAgentId) REFERENCES useragents(id)); ");
-    createQuery.prepare(query);
-    createQuery.exec();
+    // The database file is shared with UserAgentsModel, whose table is
+    // created independently, the schema version is owned by this model.
+    DatabaseUtils::enableWriteAheadLog(m_database);
+    DatabaseUtils::migrate(m_database, QList<DatabaseUtils::Migration>()
+                           << createDomainSettingsSchema
+                           << indexDomainSettings);
 }
 
 void DomainSettingsModel::populateFromDatabase()
@@ -122,23 +139,20 @@ void DomainSettingsModel::populateFromDatabase()
     QSqlQuery populateQuery(m_database);
     QString query = QLatin1String("SELECT domain, domainWithoutSubdomain, allowCustomUrlSchemes, allowLocation, userAgentId, zoomFactor "
                                   "FROM domainsettings;");
+    populateQuery.setForwardOnly(true);
     populateQuery.prepare(query);
     populateQuery.exec();
-    int count = 0; // size() isn't supported on the sqlite backend
     while (populateQuery.next()) {
         DomainSetting entry;
-        entry.domain = populateQuery.value("domain").toString();
-        entry.domainWithoutSubdomain = populateQuery.value("domainWithoutSubdomain").toString();
-        entry.allowCustomUrlSchemes = populateQuery.value("allowCustomUrlSchemes").toBool();
-        entry.allowLocation = populateQuery.value("allowLocation").toBool();
-        entry.userAgentId = populateQuery.value("userAgentId").toInt();
-        entry.zoomFactor =  populateQuery.value("zoomFactor").isNull() ? std::numeric_limits<double>::quiet_NaN()
-                                                                       : populateQuery.value("zoomFactor").toDouble();
-
-        beginInsertRows(QModelIndex(), count, count);
+        entry.domain = populateQuery.value(0).toString();
+        entry.domainWithoutSubdomain = populateQuery.value(1).toString();
+        entry.allowCustomUrlSchemes = populateQuery.value(2).toBool();
+        entry.allowLocation = populateQuery.value(3).toBool();
+        entry.userAgentId = populateQuery.value(4).toInt();
+        QVariant zoomFactor = populateQuery.value(5);
+        entry.zoomFactor = zoomFactor.isNull() ? std::numeric_limits<double>::quiet_NaN()
+                                               : zoomFactor.toDouble();
         m_entries.append(entry);
-        endInsertRows();
-        count++;
     }
 }
 
@@ -176,11 +190,12 @@ bool DomainSettingsModel::contains(const QString& domain) const
 
 void DomainSettingsModel::deleteAndResetDataBase()
 {
-    if (QFile::exists(databasePath()))
-    {
-        QFile(databasePath()).remove();
-    }
-    resetDatabase(databasePath());
+    // Close the database first, so that its write-ahead log is not replayed
+    // into the new database
+    QString path = databasePath();
+    m_database.close();
+    DatabaseUtils::removeDatabaseFiles(path);
+    resetDatabase(path);
 }
 
 bool DomainSettingsModel::areCustomUrlSchemesAllowed(const QString& domain)
@@ -16,6 +16,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "database-utils.h"
 #include "domain-settings-user-agents-model.h"
 
 #include <QFile>
@@ -49,8 +50,8 @@ void UserAgentsModel::resetDatabase(const QString& databaseName)
     m_database.setDatabaseName(databaseName);
     m_database.open();
     createOrAlterDatabaseSchema();
-    endResetModel();
     populateFromDatabase();
+    endResetModel();
     Q_EMIT rowCountChanged();
 }
 
@@ -102,18 +103,15 @@ void UserAgentsModel::populateFromDatabase()
 {
     QSqlQuery populateQuery(m_database);
     QString query = QLatin1String("SELECT id, name, userAgentString FROM useragents");
+    populateQuery.setForwardOnly(true);
     populateQuery.prepare(query);
     populateQuery.exec();
-    int count = 0; // size() isn't supported on the sqlite backend
     while (populateQuery.next()) {
         UserAgent entry;
-        entry.id = populateQuery.value("id").toInt();
-        entry.name = populateQuery.value("name").toString();
-        entry.userAgentString = populateQuery.value("userAgentString").toString();
-        beginInsertRows(QModelIndex(), count, count);
+        entry.id = populateQuery.value(0).toInt();
+        entry.name = populateQuery.value(1).toString();
+        entry.userAgentString = populateQuery.value(2).toString();
         m_entries.append(entry);
-        endInsertRows();
-        count++;
     }
 }
 
@@ -141,11 +139,12 @@ bool UserAgentsModel::contains(const QString& userAgentName) const
 
 void UserAgentsModel::deleteAndResetDataBase()
 {
-    if (QFile::exists(databasePath()))
-    {
-        QFile(databasePath()).remove();
-    }
-    resetDatabase(databasePath());
+    // Close the database first, so that its write-ahead log is not replayed
+    // into the new database
+    QString path = databasePath();
+    m_database.close();
+    DatabaseUtils::removeDatabaseFiles(path);
+    resetDatabase(path);
 }
 
 void UserAgentsModel::insertEntry(const QString& userAgentName, const QString& userAgentString)
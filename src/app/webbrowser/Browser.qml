@@ -879,18 +879,16 @@ BrowserView {
         models: searchTerms && searchTerms.length > 0 ?
                 [historySuggestions,
                  bookmarksSuggestions,
+                 fuzzySuggestions,
                  searchSuggestions.limit(4)] : []
 
-        LimitProxyModel {
+        HistorySearchModel {
             id: historySuggestions
             limit: 2
             readonly property string icon: "history"
             readonly property bool displayUrl: true
-            sourceModel: TextSearchFilterModel {
-                sourceModel: HistoryModel
-                terms: suggestionsList.searchTerms
-                searchFields: ["url", "title"]
-            }
+            sourceModel: HistoryModel
+            terms: suggestionsList.searchTerms
         }
 
         LimitProxyModel {
@@ -902,9 +900,24 @@ BrowserView {
                 sourceModel: BookmarksModel
                 terms: suggestionsList.searchTerms
                 searchFields: ["url", "title"]
+                asynchronous: true
             }
         }
 
+        // Fallback for typos, when too few entries match the terms exactly.
+        // Its results may include these entries, which are shown only once.
+        FuzzySearchModel {
+            id: fuzzySuggestions
+            limit: (historySuggestions.count + bookmarksSuggestions.count < 2) ? 2 : 0
+            readonly property bool displayUrl: true
+            function iconOf(item) {
+                return (item.source === FuzzySearchModel.Bookmarks) ? bookmarksSuggestions.icon : historySuggestions.icon
+            }
+            historyModel: HistoryModel
+            bookmarksModel: BookmarksModel
+            terms: suggestionsList.searchTerms
+        }
+
         SearchSuggestions {
             id: searchSuggestions
             terms: suggestionsList.searchTerms
@@ -67,14 +67,13 @@ Common.BrowserPage {
                 var results = []
                 if (internalFilePicker) {
                     for (var i = 0; i < downloadsListView.ViewItems.selectedIndices.length; i++) {
-                        var selectedDownload = downloadsListView.model.get(downloadsListView.ViewItems.selectedIndices[i])
-                        results.push(selectedDownload.path)
+                        results.push(downloadsListView.model.getRole(downloadsListView.ViewItems.selectedIndices[i], "path"))
                     }
                     internalFilePicker.accept(results)
                 } else {
                     for (var i = 0; i < downloadsListView.ViewItems.selectedIndices.length; i++) {
-                        var selectedDownload = downloadsListView.model.get(downloadsListView.ViewItems.selectedIndices[i])
-                        results.push(resultComponent.createObject(downloadsItem, {"url": "file://" + selectedDownload.path}))
+                        var path = downloadsListView.model.getRole(downloadsListView.ViewItems.selectedIndices[i], "path")
+                        results.push(resultComponent.createObject(downloadsItem, {"url": "file://" + path}))
                     }
                     activeTransfer.items = results
                     activeTransfer.state = ContentTransfer.Charged
@@ -106,8 +105,7 @@ Common.BrowserPage {
             onTriggered: {
                 var toDelete = []
                 for (var i = 0; i < downloadsListView.ViewItems.selectedIndices.length; i++) {
-                    var selectedDownload = downloadsListView.model.get(downloadsListView.ViewItems.selectedIndices[i])
-                    toDelete.push(selectedDownload.path)
+                    toDelete.push(downloadsListView.model.getRole(downloadsListView.ViewItems.selectedIndices[i], "path"))
                 }
                 for (var i = 0; i < toDelete.length; i++) {
                     DownloadsModel.deleteDownload(toDelete[i])
@@ -156,18 +154,22 @@ Common.BrowserPage {
         anchors.fill: parent
         focus: !exportPeerPicker.focus
 
-        model: SortFilterModel {
-            model: SortFilterModel {
-                model: DownloadsModel
+        // Selected downloads are read with getRole(), which doesn't build a
+        // map of all the roles like get() does
+        model: WindowProxyModel {
+            sourceModel: SortFilterModel {
+                model: SortFilterModel {
+                    model: DownloadsModel
+                    filter {
+                        property: "incognito"
+                        pattern: RegExp(downloadsItem.incognito ? "" : "^false$")
+                    }
+                }
                 filter {
-                    property: "incognito"
-                    pattern: RegExp(downloadsItem.incognito ? "" : "^false$")
+                    id: downloadModelFilter
+                    property: "mimetype"
                 }
             }
-            filter {
-                id: downloadModelFilter
-                property: "mimetype"
-            }
         }
 
         property int selectedIndex: -1
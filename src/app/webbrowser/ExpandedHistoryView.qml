@@ -23,7 +23,8 @@ import ".."
 FocusScope {
     id: expandedHistoryView
 
-    property alias model: entriesListView.model
+    // A row of a GroupedHistoryQueryModel grouped by domain
+    property var group: null
     property alias count: entriesListView.count
 
     signal historyEntryClicked(url url)
@@ -47,6 +48,9 @@ FocusScope {
         focus: true
         clip: true
 
+        // The entries of the group are read page by page as the view scrolls
+        model: expandedHistoryView.group ? expandedHistoryView.group.entries : null
+
         anchors {
             top: header.bottom
             topMargin: units.gu(1.5)
@@ -112,9 +116,10 @@ FocusScope {
                 top: parent.top
                 topMargin: -units.gu(0.7)
             }
-            icon: model ? model.lastVisitedIcon : ""
-            title: model ? model.domain : ""
-            url: i18n.tr("%1 page", "%1 pages", entriesListView.count).arg(entriesListView.count)
+            readonly property int entryCount: expandedHistoryView.group ? expandedHistoryView.group.entryCount : 0
+            icon: expandedHistoryView.group ? expandedHistoryView.group.lastVisitedIcon : ""
+            title: expandedHistoryView.group ? expandedHistoryView.group.domain : ""
+            url: i18n.tr("%1 page", "%1 pages", entryCount).arg(entryCount)
             enabled: false
         }
 
@@ -25,7 +25,7 @@ import "." as Local
 Common.BrowserPage {
     id: historyView
 
-    signal seeMoreEntriesClicked(var model)
+    signal seeMoreEntriesClicked(var group)
     signal newTabRequested()
 
     title: domainsListView.ViewItems.selectMode ? "" : i18n.tr("History")
@@ -39,7 +39,7 @@ Common.BrowserPage {
         // the view is displayed as early as possible.
         id: loadModelTimer
         interval: 1
-        onTriggered: historyDomainListModel.sourceModel = HistoryModel
+        onTriggered: historyDomainsModel.sourceModel = HistoryModel
     }
 
     function loadModel() { loadModelTimer.restart() }
@@ -58,8 +58,9 @@ Common.BrowserPage {
             bottom: toolbar.top
         }
 
-        model: HistoryDomainListModel {
-            id: historyDomainListModel
+        model: GroupedHistoryQueryModel {
+            id: historyDomainsModel
+            groupBy: HistoryModel.GroupByDomain
         }
 
         section.property: "lastVisitDate"
@@ -85,7 +86,7 @@ Common.BrowserPage {
                 if (selectMode) {
                     selected = !selected
                 } else {
-                    historyView.seeMoreEntriesClicked(model.entries)
+                    historyView.seeMoreEntriesClicked(domainsListView.model.get(index))
                 }
             }
             onRemoved: HistoryModel.removeEntriesByDomain(model.domain)
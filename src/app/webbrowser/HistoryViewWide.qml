@@ -129,15 +129,40 @@ Common.BrowserPage {
         // the view is displayed as early as possible.
         id: loadModelTimer
         interval: 1
-        onTriggered: historySearchModel.sourceModel = HistoryModel
+        onTriggered: {
+            historyDaysModel.sourceModel = HistoryModel
+            historySearchModel.sourceModel = HistoryModel
+        }
     }
 
     function loadModel() { loadModelTimer.restart() }
 
+    // Days of the history and their entries, read page by page from the
+    // database when not searching
+    GroupedHistoryQueryModel {
+        id: historyDaysModel
+        groupBy: HistoryModel.GroupByDay
+    }
+
     TextSearchFilterModel {
         id: historySearchModel
         searchFields: ["title", "url"]
         terms: searchQuery.terms
+        asynchronous: true
+    }
+
+    SortFilterModel {
+        id: historyLastVisitDateModel
+        readonly property date lastVisitDate: lastVisitDateListView.currentItem ? lastVisitDateListView.currentItem.lastVisitDate : ""
+        filter {
+            property: "lastVisitDateString"
+            pattern: new RegExp(lastVisitDate.isValid() ? "^%1$".arg(Qt.formatDate(lastVisitDate, "yyyy-MM-dd")) : "")
+        }
+        // Until a valid HistoryModel is assigned the TextSearchFilterModel
+        // will not report role names, and the HistoryLastVisitDateListModel
+        // will emit warnings since it needs a dateLastVisit role to be
+        // present.
+        model: historySearchModel.sourceModel ? historySearchModel : null
     }
 
     TextField {
@@ -201,7 +226,14 @@ Common.BrowserPage {
                 onCurrentIndexChanged: urlsListView.ViewItems.selectedIndices = []
 
                 model: HistoryLastVisitDateListModel {
-                    sourceModel: historyLastVisitDateModel.model
+                    id: lastVisitDateModel
+                    sourceModel: internal.searching ? historyLastVisitDateModel.model : historyDaysModel
+
+                    // The list is reset when switching between the days of
+                    // the history and those of the search results, select
+                    // the same date again once it is rebuilt
+                    onModelAboutToBeReset: internal.restoringDate = true
+                    onModelReset: restoreDateTimer.restart()
                 }
 
                 delegate: ListItem {
@@ -210,6 +242,12 @@ Common.BrowserPage {
 
                     property var lastVisitDate: model.lastVisitDate
 
+                    ListView.onIsCurrentItemChanged: {
+                        if (ListView.isCurrentItem && !internal.restoringDate) {
+                            internal.selectedDate = lastVisitDate
+                        }
+                    }
+
                     anchors {
                         left: parent.left
                         right: parent.right
@@ -276,6 +314,19 @@ Common.BrowserPage {
                     interval: 0
                     onTriggered: lastVisitDateListView.currentIndex = 0
                 }
+
+                Timer {
+                    id: restoreDateTimer
+                    interval: 0
+                    onTriggered: {
+                        var index = lastVisitDateModel.indexOf(internal.selectedDate)
+                        if (index == -1) {
+                            internal.selectedDate = undefined
+                        }
+                        lastVisitDateListView.currentIndex = Math.max(index, 0)
+                        internal.restoringDate = false
+                    }
+                }
             }
 
             Keys.onUpPressed: {
@@ -302,18 +353,17 @@ Common.BrowserPage {
 
                 anchors.fill: parent
 
-                model: SortFilterModel {
-                    id: historyLastVisitDateModel
-                    readonly property date lastVisitDate: lastVisitDateListView.currentItem ? lastVisitDateListView.currentItem.lastVisitDate : ""
-                    filter {
-                        property: "lastVisitDateString"
-                        pattern: new RegExp(lastVisitDate.isValid() ? "^%1$".arg(Qt.formatDate(lastVisitDate, "yyyy-MM-dd")) : "")
+                // Search results are filtered by date in memory, otherwise
+                // the entries of a day are read page by page from the
+                // database as the view scrolls
+                model: {
+                    if (internal.searching) {
+                        return historyLastVisitDateModel
+                    } else if (historyLastVisitDateModel.lastVisitDate.isValid()) {
+                        return internal.dayEntries
+                    } else {
+                        return historyDaysModel.sourceModel
                     }
-                    // Until a valid HistoryModel is assigned the TextSearchFilterModel
-                    // will not report role names, and the HistoryLastVisitDateListModel
-                    // will emit warnings since it needs a dateLastVisit role to be
-                    // present.
-                    model: historySearchModel.sourceModel ? historySearchModel : null
                 }
 
                 clip: true
@@ -429,6 +479,23 @@ Common.BrowserPage {
     QtObject {
         id: internal
 
+        readonly property bool searching: historyViewWide.searchMode && (searchQuery.terms.length > 0)
+
+        // Date selected by the user in the dates list, undefined for all
+        // dates
+        property var selectedDate
+        property bool restoringDate: false
+
+        // The dates list mirrors the days of historyDaysModel when not
+        // searching, after the special entry for all dates
+        readonly property var dayEntries: {
+            var index = lastVisitDateListView.currentIndex
+            if (searching || !lastVisitDateListView.currentItem || (index < 1)) {
+                return null
+            }
+            return historyDaysModel.get(index - 1).entries
+        }
+
         function toggleSelectAll() {
             if (urlsListView.ViewItems.selectedIndices.length === urlsListView.count) {
                 urlsListView.ViewItems.selectedIndices = []
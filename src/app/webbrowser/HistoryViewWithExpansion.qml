@@ -37,7 +37,7 @@ FocusScope {
         focus: !expandedHistoryViewLoader.focus
         visible: focus
         onSeeMoreEntriesClicked: {
-            expandedHistoryViewLoader.model = model
+            expandedHistoryViewLoader.group = group
             expandedHistoryViewLoader.active = true
         }
         onNewTabRequested: historyViewWithExpansion.newTabRequested()
@@ -50,10 +50,10 @@ FocusScope {
         anchors.fill: parent
         active: false
         focus: active
-        property var model: null
+        property var group: null
         sourceComponent: ExpandedHistoryView {
             focus: true
-            model: expandedHistoryViewLoader.model
+            group: expandedHistoryViewLoader.group
             onHistoryEntryClicked: historyViewWithExpansion.historyEntryClicked(url)
             onHistoryEntryRemoved: {
                 if (count == 1) {
@@ -34,7 +34,8 @@ FocusScope {
 
     TopSitesModel {
         id: topSitesModel
-        model: HistoryModel
+        sourceModel: HistoryModel
+        limit: 10
     }
 
     QtObject {
@@ -391,10 +392,7 @@ FocusScope {
                     visible: opacity > 0
                     interactive: false
 
-                    model: LimitProxyModel {
-                        limit: 10
-                        sourceModel: topSitesModel
-                    }
+                    model: topSitesModel
                     showFavicons: false
 
                     onActivated: newTabView.historyEntryClicked(url)
@@ -44,12 +44,10 @@ FocusScope {
         }
     }
 
-    LimitProxyModel {
+    TopSitesModel {
         id: topSitesModel
+        sourceModel: HistoryModel
         limit: 10
-        sourceModel: TopSitesModel {
-            model: HistoryModel
-        }
     }
 
     BookmarksFoldersViewWide {
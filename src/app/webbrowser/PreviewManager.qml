@@ -28,24 +28,10 @@ Item {
     property string capturesDir:  cacheLocation + "/captures"
     signal previewSaved(url pageUrl, url previewUrl)
 
-    LimitProxyModel {
+    TopSitesModel {
         id: topSites
+        sourceModel: HistoryModel
         limit: 10
-        sourceModel: TopSitesModel {
-            model: HistoryModel
-        }
-        function contains(url) {
-            for (var i = 0; i < topSites.count; i++) {
-                if (topSites.get(i).url === url) return true
-            }
-            return false
-        }
-        function containsHash(hash) {
-            for (var i = 0; i < topSites.count; i++) {
-                if (Qt.md5(topSites.get(i).url) === hash) return true
-            }
-            return false
-        }
     }
 
     function previewPathFromUrl(url) {
@@ -50,6 +50,7 @@ FocusScope {
 
         model: models.reduce(function(list, model) {
             var modelItems = []
+            var urls = list.map(function(item) { return String(item.url) })
 
             // Models inheriting from QAbstractItemModel and JS arrays expose their
             // data differently, so we need to collect their items differently
@@ -60,7 +61,11 @@ FocusScope {
             }
 
             modelItems.forEach(function(item) {
-                item["icon"] = model.icon
+                // Models may have suggestions in common
+                if (item.url && urls.indexOf(String(item.url)) !== -1) return
+                // Models that mix several kinds of suggestions pick the icon
+                // of each one
+                item["icon"] = model.iconOf ? model.iconOf(item) : model.icon
                 item["displayUrl"] = model.displayUrl
                 list.push(item)
             })
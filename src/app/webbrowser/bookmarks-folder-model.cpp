@@ -24,11 +24,11 @@
 
 /*!
     \class BookmarksFolderModel
-    \brief Proxy model that filters the contents of a bookmarks model
-           based on a folder name
+    \brief List model that exposes the entries of a bookmarks model
+           stored in a given folder
 
-    BookmarksFolderModel is a proxy model that filters the contents of a
-    bookmarks model based on a folder name.
+    BookmarksFolderModel is a list model that exposes the contents of a
+    bookmarks model stored in a given folder, in the same order.
 
     An entry in the bookmarks model matches if it is stored in a folder
     with the same name that the filter folder name (case-sensitive
@@ -36,21 +36,75 @@
 
     When no folder name is set (null or empty string), all entries that
     are not stored in any folder match.
+
+    The bookmarks model keeps the entries of each folder, so reading a row
+    doesn’t require going through the entries of other folders, and changes
+    are notified as the bookmarks model notifies them for the folder.
 */
 BookmarksFolderModel::BookmarksFolderModel(QObject* parent)
-    : QSortFilterProxyModel(parent)
+    : QAbstractListModel(parent)
+    , m_sourceModel(0)
+{
+}
+
+QHash<int, QByteArray> BookmarksFolderModel::roleNames() const
 {
+    if (m_sourceModel == 0) {
+        return QHash<int, QByteArray>();
+    }
+    return m_sourceModel->roleNames();
+}
+
+int BookmarksFolderModel::rowCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    if (m_sourceModel == 0) {
+        return 0;
+    }
+    return m_sourceModel->folderRowCount(m_folder);
+}
+
+QVariant BookmarksFolderModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || (m_sourceModel == 0)) {
+        return QVariant();
+    }
+    int row = m_sourceModel->mapFromFolder(m_folder, index.row());
+    if (row == -1) {
+        return QVariant();
+    }
+    return m_sourceModel->data(m_sourceModel->index(row, 0), role);
 }
 
 BookmarksModel* BookmarksFolderModel::sourceModel() const
 {
-    return qobject_cast<BookmarksModel*>(QSortFilterProxyModel::sourceModel());
+    return m_sourceModel;
 }
 
 void BookmarksFolderModel::setSourceModel(BookmarksModel* sourceModel)
 {
-    if (sourceModel != this->sourceModel()) {
-        QSortFilterProxyModel::setSourceModel(sourceModel);
+    if (sourceModel != m_sourceModel) {
+        beginResetModel();
+        if (m_sourceModel != 0) {
+            m_sourceModel->disconnect(this);
+        }
+        m_sourceModel = sourceModel;
+        if (m_sourceModel != 0) {
+            connect(m_sourceModel, SIGNAL(folderRowAboutToBeInserted(const QString&, int)),
+                    SLOT(onFolderRowAboutToBeInserted(const QString&, int)));
+            connect(m_sourceModel, SIGNAL(folderRowInserted(const QString&)),
+                    SLOT(onFolderRowInserted(const QString&)));
+            connect(m_sourceModel, SIGNAL(folderRowAboutToBeRemoved(const QString&, int)),
+                    SLOT(onFolderRowAboutToBeRemoved(const QString&, int)));
+            connect(m_sourceModel, SIGNAL(folderRowRemoved(const QString&)),
+                    SLOT(onFolderRowRemoved(const QString&)));
+            connect(m_sourceModel, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)),
+                    SLOT(onSourceDataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)));
+            connect(m_sourceModel, SIGNAL(modelAboutToBeReset()), SLOT(onSourceModelAboutToBeReset()));
+            connect(m_sourceModel, SIGNAL(modelReset()), SLOT(onSourceModelReset()));
+            connect(m_sourceModel, SIGNAL(destroyed()), SLOT(onSourceModelDestroyed()));
+        }
+        endResetModel();
         Q_EMIT sourceModelChanged();
         Q_EMIT countChanged();
     }
@@ -64,8 +118,9 @@ const QString& BookmarksFolderModel::folder() const
 void BookmarksFolderModel::setFolder(const QString& folder)
 {
     if (folder != m_folder) {
+        beginResetModel();
         m_folder = folder;
-        invalidate();
+        endResetModel();
         Q_EMIT folderChanged();
         Q_EMIT countChanged();
     }
@@ -96,9 +151,64 @@ QVariantMap BookmarksFolderModel::get(int row) const
     return res;
 }
 
-bool BookmarksFolderModel::filterAcceptsRow(int source_row, const QModelIndex& source_parent) const
+void BookmarksFolderModel::onFolderRowAboutToBeInserted(const QString& folder, int row)
+{
+    if (folder == m_folder) {
+        beginInsertRows(QModelIndex(), row, row);
+    }
+}
+
+void BookmarksFolderModel::onFolderRowInserted(const QString& folder)
+{
+    if (folder == m_folder) {
+        endInsertRows();
+        Q_EMIT countChanged();
+    }
+}
+
+void BookmarksFolderModel::onFolderRowAboutToBeRemoved(const QString& folder, int row)
+{
+    if (folder == m_folder) {
+        beginRemoveRows(QModelIndex(), row, row);
+    }
+}
+
+void BookmarksFolderModel::onFolderRowRemoved(const QString& folder)
+{
+    if (folder == m_folder) {
+        endRemoveRows();
+        Q_EMIT countChanged();
+    }
+}
+
+void BookmarksFolderModel::onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight,
+                                               const QVector<int>& roles)
+{
+    for (int i = topLeft.row(); i <= bottomRight.row(); ++i) {
+        QModelIndex index = m_sourceModel->index(i, 0);
+        if (m_sourceModel->data(index, BookmarksModel::Folder).toString() == m_folder) {
+            QModelIndex changed = this->index(m_sourceModel->mapToFolder(i), 0);
+            Q_EMIT dataChanged(changed, changed, roles);
+        }
+    }
+}
+
+void BookmarksFolderModel::onSourceModelAboutToBeReset()
+{
+    beginResetModel();
+}
+
+void BookmarksFolderModel::onSourceModelReset()
+{
+    endResetModel();
+    Q_EMIT countChanged();
+}
+
+void BookmarksFolderModel::onSourceModelDestroyed()
 {
-    QModelIndex index = sourceModel()->index(source_row, 0, source_parent);
-    QString folder = sourceModel()->data(index, BookmarksModel::Folder).toString();
-    return (folder.compare(m_folder, Qt::CaseSensitive) == 0);
+    beginResetModel();
+    m_sourceModel = 0;
+    endResetModel();
+    Q_EMIT sourceModelChanged();
+    Q_EMIT countChanged();
 }
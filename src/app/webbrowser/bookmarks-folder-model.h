@@ -20,12 +20,12 @@
 #define __BOOKMARKS_FOLDER_MODEL_H__
 
 // Qt
-#include <QtCore/QSortFilterProxyModel>
+#include <QtCore/QAbstractListModel>
 #include <QtCore/QString>
 
 class BookmarksModel;
 
-class BookmarksFolderModel : public QSortFilterProxyModel
+class BookmarksFolderModel : public QAbstractListModel
 {
     Q_OBJECT
 
@@ -36,6 +36,11 @@ class BookmarksFolderModel : public QSortFilterProxyModel
 public:
     BookmarksFolderModel(QObject* parent=0);
 
+    // reimplemented from QAbstractListModel
+    QHash<int, QByteArray> roleNames() const;
+    int rowCount(const QModelIndex& parent=QModelIndex()) const;
+    QVariant data(const QModelIndex& index, int role) const;
+
     BookmarksModel* sourceModel() const;
     void setSourceModel(BookmarksModel* sourceModel);
 
@@ -50,11 +55,19 @@ Q_SIGNALS:
     void folderChanged() const;
     void countChanged() const;
 
-protected:
-    // reimplemented from QSortFilterProxyModel
-    bool filterAcceptsRow(int source_row, const QModelIndex& source_parent) const;
+private Q_SLOTS:
+    void onFolderRowAboutToBeInserted(const QString& folder, int row);
+    void onFolderRowInserted(const QString& folder);
+    void onFolderRowAboutToBeRemoved(const QString& folder, int row);
+    void onFolderRowRemoved(const QString& folder);
+    void onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight,
+                             const QVector<int>& roles);
+    void onSourceModelAboutToBeReset();
+    void onSourceModelReset();
+    void onSourceModelDestroyed();
 
 private:
+    BookmarksModel* m_sourceModel;
     QString m_folder;
 };
 
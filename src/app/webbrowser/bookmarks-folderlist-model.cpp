@@ -22,7 +22,9 @@
 
 // Qt
 #include <QtCore/QDebug>
-#include <QtCore/QStringList>
+
+// std
+#include <algorithm>
 
 /*!
     \class BookmarksFolderListModel
@@ -57,7 +59,7 @@ QHash<int, QByteArray> BookmarksFolderListModel::roleNames() const
 int BookmarksFolderListModel::rowCount(const QModelIndex& parent) const
 {
     Q_UNUSED(parent);
-    return m_folders.count();
+    return m_folderNames.count();
 }
 
 QVariant BookmarksFolderListModel::data(const QModelIndex& index, int role) const
@@ -65,7 +67,7 @@ QVariant BookmarksFolderListModel::data(const QModelIndex& index, int role) cons
     if (!index.isValid() || !checkValidFolderIndex(index.row())) {
         return QVariant();
     }
-    const QString folder = m_folders.keys().at(index.row());
+    const QString& folder = m_folderNames.at(index.row());
     BookmarksFolderModel* entries = m_folders.value(folder);
 
     switch (role) {
@@ -125,8 +127,11 @@ QVariantMap BookmarksFolderListModel::get(int row) const
 
 int BookmarksFolderListModel::indexOf(const QString& folder) const
 {
-    QStringList folders = m_folders.keys();
-    return folders.indexOf(folder);
+    int index = lowerBound(folder);
+    if ((index < m_folderNames.count()) && (m_folderNames.at(index) == folder)) {
+        return index;
+    }
+    return -1;
 }
 
 void BookmarksFolderListModel::createNewFolder(const QString& folder)
@@ -134,9 +139,17 @@ void BookmarksFolderListModel::createNewFolder(const QString& folder)
     m_sourceModel->addFolder(folder);
 }
 
+/*
+    Return the index of the first folder name that is not before the given one.
+*/
+int BookmarksFolderListModel::lowerBound(const QString& folder) const
+{
+    return std::lower_bound(m_folderNames.constBegin(), m_folderNames.constEnd(), folder) - m_folderNames.constBegin();
+}
+
 bool BookmarksFolderListModel::checkValidFolderIndex(int index) const
 {
-    if ((index < 0) || (index >= m_folders.count())) {
+    if ((index < 0) || (index >= m_folderNames.count())) {
         qWarning() << "Invalid folder index:" << index;
         return false;
     }
@@ -145,9 +158,9 @@ bool BookmarksFolderListModel::checkValidFolderIndex(int index) const
 
 void BookmarksFolderListModel::clearFolders()
 {
-    Q_FOREACH(const QString& folder, m_folders.keys()) {
-        delete m_folders.take(folder);
-    }
+    qDeleteAll(m_folders);
+    m_folders.clear();
+    m_folderNames.clear();
 }
 
 void BookmarksFolderListModel::populateModel()
@@ -164,14 +177,7 @@ void BookmarksFolderListModel::populateModel()
 void BookmarksFolderListModel::onFolderAdded(const QString& folder)
 {
     if (!m_folders.contains(folder)) {
-        QStringList folders = m_folders.keys();
-        int insertAt = 0;
-        while (insertAt < folders.count()) {
-            if (folder.compare(folders.at(insertAt)) < 0) {
-                break;
-            }
-            ++insertAt;
-        }
+        int insertAt = lowerBound(folder);
         beginInsertRows(QModelIndex(), insertAt, insertAt);
         addFolder(folder);
         endInsertRows();
@@ -201,6 +207,7 @@ void BookmarksFolderListModel::addFolder(const QString& folder)
     connect(model, SIGNAL(layoutChanged(QList<QPersistentModelIndex>, QAbstractItemModel::LayoutChangeHint)), SLOT(onFolderDataChanged()));
     connect(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), SLOT(onFolderDataChanged()));
     connect(model, SIGNAL(modelReset()), SLOT(onFolderDataChanged()));
+    m_folderNames.insert(lowerBound(folder), folder);
     m_folders.insert(folder, model);
 }
 
@@ -214,7 +221,7 @@ void BookmarksFolderListModel::onFolderDataChanged()
 
 void BookmarksFolderListModel::emitDataChanged(const QString& folder)
 {
-    int i = m_folders.keys().indexOf(folder);
+    int i = indexOf(folder);
     if (i != -1) {
         QModelIndex index = this->index(i, 0);
         Q_EMIT dataChanged(index, index, QVector<int>() << Entries);
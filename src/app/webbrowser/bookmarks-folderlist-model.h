@@ -21,8 +21,9 @@
 
 // Qt
 #include <QtCore/QAbstractListModel>
-#include <QtCore/QMap>
+#include <QtCore/QHash>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 
 class BookmarksFolderModel;
 class BookmarksModel;
@@ -69,8 +70,11 @@ private Q_SLOTS:
 
 private:
     BookmarksModel* m_sourceModel;
-    QMap<QString, BookmarksFolderModel*> m_folders;
+    // Folder names in alphabetical order, and the model of each folder
+    QStringList m_folderNames;
+    QHash<QString, BookmarksFolderModel*> m_folders;
 
+    int lowerBound(const QString& folder) const;
     bool checkValidFolderIndex(int row) const;
     void clearFolders();
     void populateModel();
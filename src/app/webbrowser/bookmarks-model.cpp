@@ -16,13 +16,16 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "../database-utils.h"
 #include "bookmarks-model.h"
 
 // Qt
 #include <QtCore/QDebug>
-#include <QtSql/QSqlQuery>
+#include <QtCore/QTimer>
+#include <QtSql/QSqlError>
 
 #define CONNECTION_NAME "morph-browser-bookmarks"
+#define FLUSH_INTERVAL 1000
 
 /*!
     \class BookmarksModel
@@ -38,131 +41,254 @@
     entry is added to the model or an entry is removed from the model
     the database is updated.
     However the model doesn’t monitor the database for external changes.
+
+    The database is read without blocking the UI thread: the model is
+    populated in a single reset once its contents are available, after which
+    the loaded() signal is emitted. Entries added in the meantime are kept.
+
+    All database operations are performed on a separate thread. Changes are
+    written to the database in batches, each in one transaction, at most one
+    second after they are made to the model, and when the model is destroyed
+    or its database path changes. Folders are referred to by name on the UI
+    thread, their ids are only known to the database thread.
+
+    Entries are indexed by URL, and grouped by folder, so that finding an
+    entry or the entries of a folder doesn’t require going through all of
+    them. The rows are kept in a RankIndex, so that finding the row of an
+    entry and removing it take logarithmic time. Changes to the entries of
+    each folder are notified with the folderRow* signals, this is what
+    BookmarksFolderModel uses.
 */
 BookmarksModel::BookmarksModel(QObject* parent)
     : QAbstractListModel(parent)
+    , m_resetId(0)
 {
-    m_database = QSqlDatabase::addDatabase(QLatin1String("QSQLITE"), CONNECTION_NAME);
+    m_dbWorker = new BookmarksDbWorker;
+    m_dbWorker->moveToThread(&m_dbWorkerThread);
+    connect(m_dbWorker,
+            SIGNAL(databaseReset(int, const QStringList&, const QList<BookmarksModel::BookmarkEntry>&)),
+            SLOT(onDatabaseReset(int, const QStringList&, const QList<BookmarksModel::BookmarkEntry>&)),
+            Qt::QueuedConnection);
+    m_dbWorkerThread.start(QThread::LowPriority);
 }
 
 BookmarksModel::~BookmarksModel()
 {
-    m_database.close();
-    m_database = QSqlDatabase();
-    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_dbWorker->deleteLater();
+    m_dbWorkerThread.quit();
+    m_dbWorkerThread.wait();
 }
 
 void BookmarksModel::resetDatabase(const QString& databaseName)
 {
-    beginResetModel();
-    m_folders.clear();
-    m_urls.clear();
-    m_orderedEntries.clear();
-    m_database.close();
-    m_database.setDatabaseName(databaseName);
-    m_database.open();
-    createOrAlterDatabaseSchema();
-    endResetModel();
-    populateFromDatabase();
-    Q_EMIT rowCountChanged();
-}
-
-void BookmarksModel::createOrAlterDatabaseSchema()
-{
-    QSqlQuery createQuery(m_database);
-    QString query = QLatin1String("CREATE TABLE IF NOT EXISTS bookmarks "
-                                  "(url VARCHAR, title VARCHAR, icon VARCHAR, "
-                                  "created INTEGER, folderId INTEGER);");
-    createQuery.prepare(query);
-    createQuery.exec();
-
-    QSqlQuery createFolderQuery(m_database);
-    query = QLatin1String("CREATE TABLE IF NOT EXISTS folders "
-                          "(folderId INTEGER PRIMARY KEY, folder VARCHAR);");
-    createFolderQuery.prepare(query);
-    createFolderQuery.exec();
-
-    // Older version of the database schema didn’t have 'created' and/or
-    // 'folderId' columns
-    QSqlQuery tableInfoQuery(m_database);
-    query = QLatin1String("PRAGMA TABLE_INFO(bookmarks);");
-    tableInfoQuery.prepare(query);
-    tableInfoQuery.exec();
-
-    bool missingCreatedColumn = true;
-    bool missingFolderIdColumn = true;
-
-    while (tableInfoQuery.next()) {
-        if (tableInfoQuery.value("name").toString() == "created") {
-            missingCreatedColumn = false;
-        }
-        if (tableInfoQuery.value("name").toString() == "folderId") {
-            missingFolderIdColumn = false;
+    // The contents of the previous database are cleared right away, those of
+    // the new one are populated once read, see onDatabaseReset().
+    bool populated = !m_databasePath.isEmpty();
+    m_databasePath = databaseName;
+    if (populated) {
+        beginResetModel();
+        m_entries.clear();
+        m_freeIds.clear();
+        m_rows.clear();
+        m_urlIndex.clear();
+        m_folders.clear();
+        m_folderIds.clear();
+        m_folderEntries.clear();
+    }
+    //Add default empty folder
+    internFolder("");
+    if (populated) {
+        endResetModel();
+        Q_EMIT rowCountChanged();
+    }
+    Q_EMIT folderAdded("");
+    Q_EMIT m_dbWorker->resetDatabase(++m_resetId, databaseName);
+}
+
+void BookmarksModel::onDatabaseReset(int id, const QStringList& folders,
+                                     const QList<BookmarkEntry>& entries)
+{
+    if (id != m_resetId) {
+        // The database path changed again since this one was read
+        return;
+    }
+    if (entries.isEmpty()) {
+        Q_FOREACH(const QString& folder, folders) {
+            if (!m_folderIds.contains(folder)) {
+                internFolder(folder);
+                Q_EMIT folderAdded(folder);
+            }
         }
-        if (!missingCreatedColumn && !missingFolderIdColumn) {
-            break;
+    } else {
+        beginResetModel();
+        populateFromDatabase(folders, entries);
+        endResetModel();
+        Q_FOREACH(const QString& folder, m_folders) {
+            Q_EMIT folderAdded(folder);
         }
+        Q_EMIT rowCountChanged();
     }
-    if (missingCreatedColumn) {
-        QSqlQuery addCreatedColumnQuery(m_database);
-        query = QLatin1String("ALTER TABLE bookmarks ADD COLUMN created INTEGER;");
-        addCreatedColumnQuery.prepare(query);
-        addCreatedColumnQuery.exec();
-        // the default for the column is an empty value, which is interpreted as zero
-        // when converted to a number. Zero represents a date far in the past, so
-        // any newly created bookmark will correctly be represented as more recent than any other
+    Q_EMIT loaded();
+}
+
+static bool createBookmarksSchema(QSqlDatabase& database)
+{
+    // Databases created before the schema was versioned may already have the
+    // tables, and older versions of the schema didn’t have 'created' and/or
+    // 'folderId' columns. The default for a missing 'created' column is an
+    // empty value, which is interpreted as zero when converted to a number.
+    // Zero represents a date far in the past, so any newly created bookmark
+    // will correctly be represented as more recent than any other.
+    return DatabaseUtils::exec(database, QStringList()
+               << QLatin1String("CREATE TABLE IF NOT EXISTS bookmarks "
+                                "(url VARCHAR, title VARCHAR, icon VARCHAR, "
+                                "created INTEGER, folderId INTEGER);")
+               << QLatin1String("CREATE TABLE IF NOT EXISTS folders "
+                                "(folderId INTEGER PRIMARY KEY, folder VARCHAR);"))
+        && DatabaseUtils::addColumnIfMissing(database, QLatin1String("bookmarks"),
+                                             QLatin1String("created"), QLatin1String("INTEGER"))
+        && DatabaseUtils::addColumnIfMissing(database, QLatin1String("bookmarks"),
+                                             QLatin1String("folderId"), QLatin1String("INTEGER"));
+}
+
+static bool indexBookmarks(QSqlDatabase& database)
+{
+    return DatabaseUtils::exec(database, QStringList()
+               << QLatin1String("DELETE FROM bookmarks WHERE rowid NOT IN "
+                                "(SELECT MIN(rowid) FROM bookmarks GROUP BY url);")
+               << QLatin1String("CREATE UNIQUE INDEX bookmarks_url ON bookmarks (url);")
+               << QLatin1String("CREATE INDEX bookmarks_created ON bookmarks (created);")
+               << QLatin1String("CREATE INDEX folders_folder ON folders (folder);"));
+}
+
+void BookmarksModel::populateFromDatabase(const QStringList& folders,
+                                          const QList<BookmarkEntry>& entries)
+{
+    Q_FOREACH(const QString& folder, folders) {
+        internFolder(folder);
+    }
+
+    // This is called while the model is being reset. Entries added while the
+    // database was being read are the most recent ones, they stay first, and
+    // they take precedence over entries in the database with the same URL.
+    // The other entries are in the order of the model so they are appended
+    // to their folder as they come.
+    int added = m_rows.count();
+    QVector<int> rows;
+    rows.reserve(added + entries.count());
+    for (int i = 0; i < added; ++i) {
+        rows.append(m_rows.itemAt(i));
     }
-    if (missingFolderIdColumn) {
-        QSqlQuery addFolderColumnQuery(m_database);
-        query = QLatin1String("ALTER TABLE bookmarks ADD COLUMN folderId INTEGER;");
-        addFolderColumnQuery.prepare(query);
-        addFolderColumnQuery.exec();
+    m_urlIndex.reserve(added + entries.count());
+    m_entries.reserve(added + entries.count());
+    Q_FOREACH(const BookmarkEntry& entry, entries) {
+        if (!m_urlIndex.contains(entry.url)) {
+            rows.append(insertEntry(entry));
+            m_folderEntries[internFolder(entry.folder)].append(entry.url);
+        }
     }
+    m_rows.reset(rows);
 }
 
-void BookmarksModel::populateFromDatabase()
+int BookmarksModel::rowOf(const QUrl& url) const
 {
-    //Add default empty folder
-    m_folders.insert(0, "");
-    Q_EMIT folderAdded("");
+    QHash<QUrl, int>::const_iterator i = m_urlIndex.constFind(url);
+    if (i == m_urlIndex.constEnd()) {
+        return -1;
+    }
+    return m_rows.rankOf(i.value());
+}
 
-    QSqlQuery populateFolderQuery(m_database);
-    QString query = QLatin1String("SELECT folderId, folder FROM folders;");
-    populateFolderQuery.prepare(query);
-    populateFolderQuery.exec();
-    while (populateFolderQuery.next()) {
-        QString folder = populateFolderQuery.value(1).toString();
-        m_folders.insert(populateFolderQuery.value(0).toInt(), folder);
-        Q_EMIT folderAdded(folder);
+BookmarksModel::BookmarkEntry& BookmarksModel::entryAt(int row)
+{
+    return m_entries[m_rows.itemAt(row)];
+}
+
+const BookmarksModel::BookmarkEntry& BookmarksModel::entryAt(int row) const
+{
+    return m_entries.at(m_rows.itemAt(row));
+}
+
+/*
+    Store a new entry and index it by URL, and return its id. Adding it to
+    the rows is up to the caller.
+*/
+int BookmarksModel::insertEntry(const BookmarkEntry& entry)
+{
+    int id;
+    if (m_freeIds.isEmpty()) {
+        id = m_entries.count();
+        m_entries.append(entry);
+    } else {
+        id = m_freeIds.takeLast();
+        m_entries[id] = entry;
     }
+    m_urlIndex.insert(entry.url, id);
+    return id;
+}
 
-    QSqlQuery populateQuery(m_database);
-    query = QLatin1String("SELECT url, title, icon, created, folderId "
-                          "FROM bookmarks ORDER BY created DESC;");
-    populateQuery.prepare(query);
-    populateQuery.exec();
-    int count = 0;
-    while (populateQuery.next()) {
-        BookmarkEntry entry;
-        entry.url = populateQuery.value(0).toUrl();
-        entry.title = populateQuery.value(1).toString();
-        entry.icon = populateQuery.value(2).toUrl();
-        entry.created = QDateTime::fromMSecsSinceEpoch(populateQuery.value(3).toULongLong());
-        entry.folderId = populateQuery.value(4).toInt();
+/* Unindex a stored entry that is no longer in the rows, and free its id */
+void BookmarksModel::releaseEntry(int id)
+{
+    BookmarkEntry& entry = m_entries[id];
+    m_urlIndex.remove(entry.url);
+    entry = BookmarkEntry();
+    m_freeIds.append(id);
+}
+
+/*
+    Return the id of a folder, adding it to the list of folders if needed.
+    It is up to the caller to notify that the folder was added.
+*/
+int BookmarksModel::internFolder(const QString& folder)
+{
+    QHash<QString, int>::const_iterator i = m_folderIds.constFind(folder);
+    if (i != m_folderIds.constEnd()) {
+        return i.value();
+    }
+    int id = m_folders.count();
+    m_folders.append(folder);
+    m_folderIds.insert(folder, id);
+    m_folderEntries.append(QList<QUrl>());
+    return id;
+}
 
-        if (m_folders.contains(entry.folderId)) {
-            entry.folder = m_folders.value(entry.folderId);
+/*
+    Return the index of the first entry of a folder that is not before the
+    given row of the model.
+*/
+int BookmarksModel::lowerBound(int folderId, int row) const
+{
+    const QList<QUrl>& entries = m_folderEntries.at(folderId);
+    int first = 0;
+    int last = entries.count();
+    while (first < last) {
+        int middle = (first + last) / 2;
+        if (rowOf(entries.at(middle)) < row) {
+            first = middle + 1;
         } else {
-            entry.folderId = 0;
-            updateExistingEntryInDatabase(entry);
+            last = middle;
         }
-
-        beginInsertRows(QModelIndex(), count, count);
-        m_urls.insert(entry.url);
-        m_orderedEntries.append(entry);
-        endInsertRows();
-        ++count;
     }
+    return first;
+}
+
+void BookmarksModel::insertInFolder(const QUrl& url, const QString& folder)
+{
+    int id = m_folderIds.value(folder);
+    int row = lowerBound(id, rowOf(url));
+    Q_EMIT folderRowAboutToBeInserted(folder, row);
+    m_folderEntries[id].insert(row, url);
+    Q_EMIT folderRowInserted(folder);
+}
+
+void BookmarksModel::removeFromFolder(const QUrl& url, const QString& folder)
+{
+    int id = m_folderIds.value(folder);
+    int row = lowerBound(id, rowOf(url));
+    Q_EMIT folderRowAboutToBeRemoved(folder, row);
+    m_folderEntries[id].removeAt(row);
+    Q_EMIT folderRowRemoved(folder);
 }
 
 QHash<int, QByteArray> BookmarksModel::roleNames() const
@@ -181,7 +307,7 @@ QHash<int, QByteArray> BookmarksModel::roleNames() const
 int BookmarksModel::rowCount(const QModelIndex& parent) const
 {
     Q_UNUSED(parent);
-    return m_orderedEntries.count();
+    return m_rows.count();
 }
 
 QVariant BookmarksModel::data(const QModelIndex& index, int role) const
@@ -189,7 +315,7 @@ QVariant BookmarksModel::data(const QModelIndex& index, int role) const
     if (!index.isValid()) {
         return QVariant();
     }
-    const BookmarkEntry& entry = m_orderedEntries.at(index.row());
+    const BookmarkEntry& entry = entryAt(index.row());
     switch (role) {
     case Url:
         return entry.url;
@@ -208,7 +334,7 @@ QVariant BookmarksModel::data(const QModelIndex& index, int role) const
 
 const QString BookmarksModel::databasePath() const
 {
-    return m_database.databaseName();
+    return m_databasePath;
 }
 
 void BookmarksModel::setDatabasePath(const QString& path)
@@ -225,17 +351,61 @@ void BookmarksModel::setDatabasePath(const QString& path)
 
 QStringList BookmarksModel::folders() const
 {
-    return m_folders.values();
+    return m_folders;
 }
 
-int BookmarksModel::addFolder(const QString& folder)
+/*!
+    Add a folder to the list of folders.
+
+    If the folder already exists, do nothing.
+*/
+void BookmarksModel::addFolder(const QString& folder)
 {
-    int newFolderId = insertNewFolderInDatabase(folder);
-    if (newFolderId != 0) {
-        m_folders.insert(newFolderId, folder);
+    if (!m_folderIds.contains(folder)) {
+        internFolder(folder);
         Q_EMIT folderAdded(folder);
+        insertNewFolderInDatabase(folder);
     }
-    return newFolderId;
+}
+
+/*!
+    Return the number of entries in a given folder.
+*/
+int BookmarksModel::folderRowCount(const QString& folder) const
+{
+    QHash<QString, int>::const_iterator i = m_folderIds.constFind(folder);
+    if (i == m_folderIds.constEnd()) {
+        return 0;
+    }
+    return m_folderEntries.at(i.value()).count();
+}
+
+/*!
+    Return the row in the model of the entry at a given row in a folder,
+    or -1 if there is no such entry.
+*/
+int BookmarksModel::mapFromFolder(const QString& folder, int folderRow) const
+{
+    QHash<QString, int>::const_iterator i = m_folderIds.constFind(folder);
+    if (i == m_folderIds.constEnd()) {
+        return -1;
+    }
+    const QList<QUrl>& entries = m_folderEntries.at(i.value());
+    if ((folderRow < 0) || (folderRow >= entries.count())) {
+        return -1;
+    }
+    return rowOf(entries.at(folderRow));
+}
+
+/*!
+    Return the row of the entry at a given row of the model in its folder.
+*/
+int BookmarksModel::mapToFolder(int row) const
+{
+    if ((row < 0) || (row >= m_rows.count())) {
+        return -1;
+    }
+    return lowerBound(m_folderIds.value(entryAt(row).folder), row);
 }
 
 /*!
@@ -246,7 +416,7 @@ int BookmarksModel::addFolder(const QString& folder)
 */
 bool BookmarksModel::contains(const QUrl& url) const
 {
-    return m_urls.contains(url);
+    return m_urlIndex.contains(url);
 }
 
 /*!
@@ -256,9 +426,10 @@ bool BookmarksModel::contains(const QUrl& url) const
 */
 void BookmarksModel::add(const QUrl& url, const QString& title, const QUrl& icon, const QString& folder)
 {
-    if (m_urls.contains(url)) {
+    if (m_urlIndex.contains(url)) {
         qWarning() << "URL already bookmarked:" << url;
     } else {
+        addFolder(folder);
         beginInsertRows(QModelIndex(), 0, 0);
         BookmarkEntry entry;
         entry.url = url;
@@ -266,10 +437,9 @@ void BookmarksModel::add(const QUrl& url, const QString& title, const QUrl& icon
         entry.icon = icon;
         entry.created = QDateTime::currentDateTime();
         entry.folder = folder;
-        entry.folderId = getFolderId(entry.folder);
-        m_urls.insert(url);
-        m_orderedEntries.prepend(entry);
+        m_rows.prepend(insertEntry(entry));
         endInsertRows();
+        insertInFolder(url, folder);
         Q_EMIT added(url);
         insertNewEntryInDatabase(entry);
         Q_EMIT rowCountChanged();
@@ -278,21 +448,10 @@ void BookmarksModel::add(const QUrl& url, const QString& title, const QUrl& icon
 
 void BookmarksModel::insertNewEntryInDatabase(const BookmarkEntry& entry)
 {
-    QSqlQuery query(m_database);
-    static QString insertStatement = QLatin1String("INSERT INTO bookmarks (url, "
-                                                   "title, icon, created, folderId) "
-                                                   "VALUES (?, ?, ?, ?, ?);");
-    query.prepare(insertStatement);
-    query.addBindValue(entry.url.toString());
-    query.addBindValue(entry.title);
-    query.addBindValue(entry.icon.toString());
-    query.addBindValue(entry.created.toMSecsSinceEpoch());
-    if (!entry.folderId) {
-        query.addBindValue(QVariant());
-    } else {
-        query.addBindValue(entry.folderId);
-    }
-    query.exec();
+    QVariantList values;
+    values << entry.url.toString() << entry.title << entry.icon.toString()
+           << entry.created.toMSecsSinceEpoch() << entry.folder;
+    Q_EMIT m_dbWorker->enqueue(BookmarksDbWorker::InsertNewEntry, values);
 }
 
 /*!
@@ -302,22 +461,17 @@ void BookmarksModel::insertNewEntryInDatabase(const BookmarkEntry& entry)
 */
 void BookmarksModel::remove(const QUrl& url)
 {
-    if (m_urls.contains(url)) {
-        int index = 0;
-        Q_FOREACH(BookmarkEntry entry, m_orderedEntries) {
-            if (entry.url == url) {
-                beginRemoveRows(QModelIndex(), index, index);
-                m_orderedEntries.removeAt(index);
-                m_urls.remove(url);
-                endRemoveRows();
-                Q_EMIT removed(url);
-                removeExistingEntryFromDatabase(url);
-                Q_EMIT rowCountChanged();
-                return;
-            } else {
-                index++;
-            }
-        };
+    int index = rowOf(url);
+    if (index != -1) {
+        removeFromFolder(url, entryAt(index).folder);
+        beginRemoveRows(QModelIndex(), index, index);
+        int id = m_urlIndex.value(url);
+        m_rows.remove(id);
+        releaseEntry(id);
+        endRemoveRows();
+        Q_EMIT removed(url);
+        removeExistingEntryFromDatabase(url);
+        Q_EMIT rowCountChanged();
     } else {
         qWarning() << "Invalid bookmark:" << url;
     }
@@ -325,39 +479,31 @@ void BookmarksModel::remove(const QUrl& url)
 
 void BookmarksModel::removeExistingEntryFromDatabase(const QUrl& url)
 {
-    QSqlQuery query(m_database);
-    static QString deleteStatement = QLatin1String("DELETE FROM bookmarks WHERE url=?;");
-    query.prepare(deleteStatement);
-    query.addBindValue(url.toString());
-    query.exec();
+    Q_EMIT m_dbWorker->enqueue(BookmarksDbWorker::RemoveExistingEntry,
+                               QVariantList() << url.toString());
 }
 
 void BookmarksModel::update(const QUrl& url, const QString& title, const QString& folder)
 {
-    if (m_urls.contains(url)) {
-        int index = 0;
-        Q_FOREACH(BookmarkEntry entry, m_orderedEntries) {
-            if (entry.url == url) {
-                BookmarkEntry& updatedEntry = m_orderedEntries[index];
-                QVector<int> roles;
-                if (title != updatedEntry.title) {
-                    updatedEntry.title = title;
-                    roles << Title;
-                }
-                if (folder != updatedEntry.folder) {
-                    updatedEntry.folder = folder;
-                    updatedEntry.folderId = getFolderId(updatedEntry.folder);
-                    roles << Folder;
-                }
-                if (!roles.isEmpty()) {
-                    Q_EMIT dataChanged(this->index(index, 0), this->index(index, 0), roles);
-                    updateExistingEntryInDatabase(updatedEntry);
-                }
-                return;
-            } else {
-                index++;
-            }
-        };
+    int index = rowOf(url);
+    if (index != -1) {
+        BookmarkEntry& updatedEntry = entryAt(index);
+        QVector<int> roles;
+        if (title != updatedEntry.title) {
+            updatedEntry.title = title;
+            roles << Title;
+        }
+        if (folder != updatedEntry.folder) {
+            addFolder(folder);
+            removeFromFolder(url, updatedEntry.folder);
+            updatedEntry.folder = folder;
+            insertInFolder(url, folder);
+            roles << Folder;
+        }
+        if (!roles.isEmpty()) {
+            Q_EMIT dataChanged(this->index(index, 0), this->index(index, 0), roles);
+            updateExistingEntryInDatabase(updatedEntry);
+        }
     } else {
         qWarning() << "Invalid bookmark:" << url;
     }
@@ -365,51 +511,236 @@ void BookmarksModel::update(const QUrl& url, const QString& title, const QString
 
 void BookmarksModel::updateExistingEntryInDatabase(const BookmarkEntry& entry)
 {
-    QSqlQuery query(m_database);
-    static QString updateStatement = QLatin1String("UPDATE bookmarks SET title=?, "
-                                                   "icon=?, created=?, folderId=? "
-                                                   "WHERE url=?;");
-    query.prepare(updateStatement);
-    query.addBindValue(entry.title);
-    query.addBindValue(entry.icon.toString());
-    query.addBindValue(entry.created.toMSecsSinceEpoch());
-    if (entry.folderId == 0) {
-        query.addBindValue(QVariant());
-    } else {
-        query.addBindValue(entry.folderId);
+    QVariantList values;
+    values << entry.title << entry.icon.toString() << entry.created.toMSecsSinceEpoch()
+           << entry.folder << entry.url.toString();
+    Q_EMIT m_dbWorker->enqueue(BookmarksDbWorker::UpdateExistingEntry, values);
+}
+
+void BookmarksModel::insertNewFolderInDatabase(const QString& folder)
+{
+    Q_EMIT m_dbWorker->enqueue(BookmarksDbWorker::InsertNewFolder, QVariantList() << folder);
+}
+
+BookmarksDbWorker::BookmarksDbWorker()
+    : QObject()
+    , m_flush(nullptr)
+{
+    qRegisterMetaType<BookmarksDbWorker::Operation>("BookmarksDbWorker::Operation");
+    qRegisterMetaType<QList<BookmarksModel::BookmarkEntry> >("QList<BookmarksModel::BookmarkEntry>");
+    // Ensure all database operations are performed on the same thread
+    connect(this, SIGNAL(resetDatabase(int, const QString&)),
+            SLOT(doResetDatabase(int, const QString&)), Qt::QueuedConnection);
+    connect(this, SIGNAL(enqueue(BookmarksDbWorker::Operation, QVariantList)),
+            SLOT(doEnqueue(BookmarksDbWorker::Operation, QVariantList)), Qt::QueuedConnection);
+}
+
+BookmarksDbWorker::~BookmarksDbWorker()
+{
+    if (m_flush) {
+        m_flush->stop();
+        delete m_flush;
+        m_flush = nullptr;
+    }
+    doFlush();
+    discardPending();
+    m_statements.clear();
+    if (m_database.isOpen()) {
+        m_database.close();
     }
-    query.addBindValue(entry.url.toString());
-    query.exec();
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
 }
 
-int BookmarksModel::getFolderId(const QString& folder) {
-    QHashIterator<int, QString> i(m_folders);
-    while (i.hasNext()) {
-        i.next();
-        if (i.value() == folder) {
-            return i.key();
+void BookmarksDbWorker::doResetDatabase(int id, const QString& databaseName)
+{
+    if (m_flush) {
+        m_flush->stop();
+    }
+    doFlush();
+    // Operations that could not be written don’t belong in the new database
+    discardPending();
+    m_statements.clear();
+    m_folderIds.clear();
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    if (!m_database.isValid()) {
+        m_database = QSqlDatabase::addDatabase(QLatin1String("QSQLITE"), CONNECTION_NAME);
+    }
+    m_database.setDatabaseName(databaseName);
+    m_database.open();
+    createOrAlterDatabaseSchema();
+
+    QStringList folders;
+    QSqlQuery populateFolderQuery(m_database);
+    QString query = QLatin1String("SELECT folderId, folder FROM folders;");
+    populateFolderQuery.setForwardOnly(true);
+    populateFolderQuery.prepare(query);
+    populateFolderQuery.exec();
+    while (populateFolderQuery.next()) {
+        QString folder = populateFolderQuery.value(1).toString();
+        m_folderIds.insert(folder, populateFolderQuery.value(0).toInt());
+        folders.append(folder);
+    }
+
+    // Entries in a folder that doesn’t exist are moved to the default folder
+    QSqlQuery orphansQuery(m_database);
+    query = QLatin1String("UPDATE bookmarks SET folderId=NULL WHERE folderId "
+                          "NOT IN (SELECT folderId FROM folders);");
+    orphansQuery.prepare(query);
+    orphansQuery.exec();
+
+    QSqlQuery populateQuery(m_database);
+    query = QLatin1String("SELECT url, title, icon, created, folder FROM bookmarks "
+                          "LEFT JOIN folders ON bookmarks.folderId = folders.folderId "
+                          "ORDER BY created DESC;");
+    populateQuery.setForwardOnly(true);
+    populateQuery.prepare(query);
+    populateQuery.exec();
+    QList<BookmarksModel::BookmarkEntry> entries;
+    while (populateQuery.next()) {
+        BookmarksModel::BookmarkEntry entry;
+        entry.url = populateQuery.value(0).toUrl();
+        entry.title = populateQuery.value(1).toString();
+        entry.icon = populateQuery.value(2).toUrl();
+        entry.created = QDateTime::fromMSecsSinceEpoch(populateQuery.value(3).toULongLong());
+        entry.folder = populateQuery.value(4).toString();
+        entries.append(entry);
+    }
+    Q_EMIT databaseReset(id, folders, entries);
+}
+
+void BookmarksDbWorker::createOrAlterDatabaseSchema()
+{
+    DatabaseUtils::enableWriteAheadLog(m_database);
+    DatabaseUtils::migrate(m_database, QList<DatabaseUtils::Migration>()
+                           << createBookmarksSchema
+                           << indexBookmarks);
+}
+
+void BookmarksDbWorker::doEnqueue(BookmarksDbWorker::Operation operation, QVariantList values)
+{
+    if (!m_flush) {
+        m_flush = new QTimer;
+        m_flush->setInterval(FLUSH_INTERVAL);
+        m_flush->setSingleShot(true);
+        connect(m_flush, SIGNAL(timeout()), SLOT(doFlush()));
+    }
+    m_pending.enqueue(qMakePair(operation, values));
+    if (!m_flush->isActive()) {
+        m_flush->start();
+    }
+}
+
+QSqlQuery* BookmarksDbWorker::preparedStatement(const QString& statement)
+{
+    QHash<QString, QSqlQuery>::iterator i = m_statements.find(statement);
+    if (i == m_statements.end()) {
+        QSqlQuery query(m_database);
+        if (!query.prepare(statement)) {
+            return nullptr;
         }
+        i = m_statements.insert(statement, query);
     }
+    return &i.value();
+}
 
-    return addFolder(folder);
+/*
+    Return the id of a folder, inserting it in the database if needed.
+    Entries in the default (empty) folder have no folder id.
+*/
+QVariant BookmarksDbWorker::folderId(const QString& folder)
+{
+    if (folder.isEmpty()) {
+        return QVariant();
+    }
+    QHash<QString, int>::const_iterator i = m_folderIds.constFind(folder);
+    if (i != m_folderIds.constEnd()) {
+        return i.value();
+    }
+    QSqlQuery* query = preparedStatement(QLatin1String("INSERT INTO folders (folder) VALUES (?);"));
+    if (!query) {
+        return QVariant();
+    }
+    query->bindValue(0, folder);
+    if (!query->exec()) {
+        return QVariant();
+    }
+    int id = query->lastInsertId().toInt();
+    m_folderIds.insert(folder, id);
+    return id;
 }
 
-int BookmarksModel::insertNewFolderInDatabase(const QString& folder)
+void BookmarksDbWorker::doFlush()
 {
-    QSqlQuery insertQuery(m_database);
-    QString query = QLatin1String("INSERT INTO folders (folder) VALUES (?);");
-    insertQuery.prepare(query);
-    insertQuery.addBindValue(folder);
-    insertQuery.exec();
+    if (m_pending.isEmpty()) {
+        return;
+    }
 
-    QSqlQuery selectQuery(m_database);
-    query = QLatin1String("SELECT folderId FROM folders WHERE folder=?;");
-    selectQuery.prepare(query);
-    selectQuery.addBindValue(folder);
-    selectQuery.exec();
-    if (selectQuery.next()) {
-        return selectQuery.value(0).toInt();
+    // Group all the operations in one transaction, so that the journal is
+    // synced to disk once per flush rather than once per operation. If it
+    // can’t be committed, the operations are queued again for the next
+    // flush, and the ids of the folders inserted in it are forgotten.
+    bool transaction = m_database.transaction();
+    QQueue<QPair<Operation, QVariantList>> flushed;
+    QHash<QString, int> folderIds = m_folderIds;
+    while (!m_pending.isEmpty()) {
+        QPair<Operation, QVariantList> args = m_pending.dequeue();
+        flushed.enqueue(args);
+        QString statement;
+        switch (args.first) {
+        case InsertNewEntry:
+            // The URL may already be in the database if it was bookmarked
+            // again before the database was read, see populateFromDatabase()
+            statement = QLatin1String("INSERT OR REPLACE INTO bookmarks (url, title, icon, created, folderId) "
+                                      "VALUES (?, ?, ?, ?, ?);");
+            args.second[4] = folderId(args.second.at(4).toString());
+            break;
+        case UpdateExistingEntry:
+            statement = QLatin1String("UPDATE bookmarks SET title=?, icon=?, created=?, folderId=? "
+                                      "WHERE url=?;");
+            args.second[3] = folderId(args.second.at(3).toString());
+            break;
+        case RemoveExistingEntry:
+            statement = QLatin1String("DELETE FROM bookmarks WHERE url=?;");
+            break;
+        case InsertNewFolder:
+            folderId(args.second.first().toString());
+            continue;
+        default:
+            Q_UNREACHABLE();
+        }
+        QSqlQuery* query = preparedStatement(statement);
+        if (!query) {
+            continue;
+        }
+        for (int i = 0; i < args.second.count(); ++i) {
+            query->bindValue(i, args.second.at(i));
+        }
+        query->exec();
+    }
+    if (transaction && !m_database.commit()) {
+        qWarning() << "Failed to write" << flushed.count() << "bookmark operations,"
+                   << "will retry:" << m_database.lastError().text();
+        m_database.rollback();
+        m_folderIds = folderIds;
+        flushed.append(m_pending);
+        m_pending = flushed;
+        if (m_flush) {
+            m_flush->start();
+        }
     }
+}
 
-    return 0;
+/*
+    Drop the operations left over by a flush that failed, reporting them.
+*/
+void BookmarksDbWorker::discardPending()
+{
+    if (!m_pending.isEmpty()) {
+        qWarning() << "Discarding" << m_pending.count() << "bookmark operations"
+                   << "that could not be written to" << m_database.databaseName();
+        m_pending.clear();
+    }
 }
@@ -22,11 +22,24 @@
 // Qt
 #include <QtCore/QAbstractListModel>
 #include <QtCore/QDateTime>
+#include <QtCore/QHash>
 #include <QtCore/QList>
-#include <QtCore/QSet>
+#include <QtCore/QPair>
+#include <QtCore/QQueue>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
 #include <QtCore/QUrl>
+#include <QtCore/QVariant>
+#include <QtCore/QVector>
 #include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
+
+#include "rank-index.h"
+
+class QTimer;
+
+class BookmarksDbWorker;
 
 class BookmarksModel : public QAbstractListModel
 {
@@ -49,6 +62,14 @@ public:
         Folder
     };
 
+    struct BookmarkEntry {
+        QUrl url;
+        QString title;
+        QUrl icon;
+        QDateTime created;
+        QString folder;
+    };
+
     // reimplemented from QAbstractListModel
     QHash<int, QByteArray> roleNames() const;
     int rowCount(const QModelIndex& parent=QModelIndex()) const;
@@ -58,7 +79,11 @@ public:
     void setDatabasePath(const QString& path);
 
     QStringList folders() const;
-    int addFolder(const QString& folder);
+    void addFolder(const QString& folder);
+
+    int folderRowCount(const QString& folder) const;
+    int mapFromFolder(const QString& folder, int folderRow) const;
+    int mapToFolder(int row) const;
 
     Q_INVOKABLE bool contains(const QUrl& url) const;
     Q_INVOKABLE void add(const QUrl& url, const QString& title, const QUrl& icon, const QString& folder);
@@ -71,30 +96,95 @@ Q_SIGNALS:
     void added(const QUrl& url) const;
     void removed(const QUrl& url) const;
     void rowCountChanged();
+    void folderRowAboutToBeInserted(const QString& folder, int row) const;
+    void folderRowInserted(const QString& folder) const;
+    void folderRowAboutToBeRemoved(const QString& folder, int row) const;
+    void folderRowRemoved(const QString& folder) const;
+    void loaded() const;
 
-private:
-    QSqlDatabase m_database;
-
-    struct BookmarkEntry {
-        QUrl url;
-        QString title;
-        QUrl icon;
-        QDateTime created;
-        int folderId;
-        QString folder;
-    };
-    QHash<int, QString> m_folders;
-    QSet<QUrl> m_urls;
-    QList<BookmarkEntry> m_orderedEntries;
+private Q_SLOTS:
+    void onDatabaseReset(int id, const QStringList& folders,
+                         const QList<BookmarksModel::BookmarkEntry>& entries);
 
+private:
+    QString m_databasePath;
+    // Id of the latest database reset, results of earlier ones are ignored
+    int m_resetId;
+    // Entries are stored by id, the ids of removed entries being reused,
+    // and the order of the rows is kept in m_rows, so that removing a row
+    // doesn’t move any other entry.
+    QVector<BookmarkEntry> m_entries;
+    QVector<int> m_freeIds;
+    RankIndex m_rows;
+    // Id of each entry
+    QHash<QUrl, int> m_urlIndex;
+    // Folder names by id and ids by folder name, and the URLs of the entries
+    // in each folder (by id), in the order of the model
+    QStringList m_folders;
+    QHash<QString, int> m_folderIds;
+    QVector<QList<QUrl>> m_folderEntries;
+
+    int rowOf(const QUrl& url) const;
+    BookmarkEntry& entryAt(int row);
+    const BookmarkEntry& entryAt(int row) const;
+    int insertEntry(const BookmarkEntry& entry);
+    void releaseEntry(int id);
+    int internFolder(const QString& folder);
+    int lowerBound(int folderId, int row) const;
+    void insertInFolder(const QUrl& url, const QString& folder);
+    void removeFromFolder(const QUrl& url, const QString& folder);
     void resetDatabase(const QString& databaseName);
-    void createOrAlterDatabaseSchema();
-    void populateFromDatabase();
+    void populateFromDatabase(const QStringList& folders, const QList<BookmarkEntry>& entries);
     void insertNewEntryInDatabase(const BookmarkEntry& entry);
     void removeExistingEntryFromDatabase(const QUrl& url);
     void updateExistingEntryInDatabase(const BookmarkEntry& entry);
-    int getFolderId(const QString& folder);
-    int insertNewFolderInDatabase(const QString& folder);
+    void insertNewFolderInDatabase(const QString& folder);
+
+    QThread m_dbWorkerThread;
+    BookmarksDbWorker* m_dbWorker;
+};
+
+Q_DECLARE_METATYPE(QList<BookmarksModel::BookmarkEntry>)
+
+class BookmarksDbWorker : public QObject {
+    Q_OBJECT
+
+    Q_ENUMS(Operation)
+
+public:
+    BookmarksDbWorker();
+    ~BookmarksDbWorker();
+
+    enum Operation {
+        InsertNewEntry,
+        UpdateExistingEntry,
+        RemoveExistingEntry,
+        InsertNewFolder,
+    };
+
+Q_SIGNALS:
+    void resetDatabase(int id, const QString& databaseName);
+    void enqueue(BookmarksDbWorker::Operation operation, QVariantList values);
+    void databaseReset(int id, const QStringList& folders,
+                       const QList<BookmarksModel::BookmarkEntry>& entries);
+
+private Q_SLOTS:
+    void doResetDatabase(int id, const QString& databaseName);
+    void doEnqueue(BookmarksDbWorker::Operation operation, QVariantList values);
+    void doFlush();
+
+private:
+    QSqlDatabase m_database;
+    QQueue<QPair<Operation, QVariantList>> m_pending;
+    QHash<QString, QSqlQuery> m_statements;
+    QTimer* m_flush;
+    // Id of each folder in the database, by name
+    QHash<QString, int> m_folderIds;
+
+    void createOrAlterDatabaseSchema();
+    QSqlQuery* preparedStatement(const QString& statement);
+    QVariant folderId(const QString& folder);
+    void discardPending();
 };
 
 #endif // __BOOKMARKS_MODEL_H__
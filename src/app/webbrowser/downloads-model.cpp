@@ -16,6 +16,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "../database-utils.h"
 #include "downloads-model.h"
 
 #include <QtCore/QDebug>
@@ -72,36 +73,73 @@ void DownloadsModel::resetDatabase(const QString& databaseName)
     m_database.close();
     m_database.setDatabaseName(databaseName);
     m_database.open();
-    m_numRows = 0;
     m_fetchedCount = 0;
     m_canFetchMore = true;
     createOrAlterDatabaseSchema();
+    // The first page is part of the reset, further pages are inserted
+    m_orderedEntries = fetchPage();
+    m_numRows = m_orderedEntries.count();
     endResetModel();
     Q_EMIT rowCountChanged();
 }
 
+static bool createDownloadsSchema(QSqlDatabase& database)
+{
+    return DatabaseUtils::exec(database,
+               QLatin1String("CREATE TABLE IF NOT EXISTS downloads "
+                             "(downloadId VARCHAR, url VARCHAR, path VARCHAR, "
+                             "mimetype VARCHAR, complete BOOL, paused BOOL, "
+                             "error VARCHAR, created DATETIME DEFAULT "
+                             "CURRENT_TIMESTAMP);"));
+}
+
+static bool indexDownloads(QSqlDatabase& database)
+{
+    return DatabaseUtils::exec(database, QStringList()
+               << QLatin1String("CREATE INDEX downloads_downloadId ON downloads (downloadId);")
+               << QLatin1String("CREATE INDEX downloads_path ON downloads (path);")
+               << QLatin1String("CREATE INDEX downloads_created ON downloads (created);"));
+}
+
 void DownloadsModel::createOrAlterDatabaseSchema()
 {
-    QSqlQuery createQuery(m_database);
-    QString query = QLatin1String("CREATE TABLE IF NOT EXISTS downloads "
-                                  "(downloadId VARCHAR, url VARCHAR, path VARCHAR, "
-                                  "mimetype VARCHAR, complete BOOL, paused BOOL, "
-                                  "error VARCHAR, created DATETIME DEFAULT "
-                                  "CURRENT_TIMESTAMP);");
-    createQuery.prepare(query);
-    createQuery.exec();
+    DatabaseUtils::enableWriteAheadLog(m_database);
+    DatabaseUtils::migrate(m_database, QList<DatabaseUtils::Migration>()
+                           << createDownloadsSchema
+                           << indexDownloads);
 }
 
 void DownloadsModel::fetchMore(const QModelIndex &parent)
+{
+    Q_UNUSED(parent)
+
+    // Publish the whole page at once
+    QList<DownloadEntry> entries = fetchPage();
+    if (!entries.isEmpty()) {
+        beginInsertRows(QModelIndex(), m_orderedEntries.count(),
+                        m_orderedEntries.count() + entries.count() - 1);
+        m_orderedEntries.append(entries);
+        endInsertRows();
+        m_numRows += entries.count();
+        Q_EMIT rowCountChanged();
+    }
+}
+
+/*
+    Read the next page of entries from the database.
+*/
+QList<DownloadsModel::DownloadEntry> DownloadsModel::fetchPage()
 {
     QSqlQuery populateQuery(m_database);
     QString query = QLatin1String("SELECT downloadId, url, path, mimetype, "
                                   "complete, error, created, paused "
                                   "FROM downloads ORDER BY created DESC LIMIT 100 OFFSET ?;");
+    populateQuery.setForwardOnly(true);
     populateQuery.prepare(query);
     populateQuery.addBindValue(m_fetchedCount);
     populateQuery.exec();
     int count = 0; // size() isn't supported on the sqlite backend
+    QList<DownloadEntry> entries;
     while (populateQuery.next()) {
         DownloadEntry entry;
         entry.incognito = false;
@@ -122,10 +160,7 @@ void DownloadsModel::fetchMore(const QModelIndex &parent)
         // remove the entry if the file is missing as it may be stored on a
         // removable medium like an SD card in the future, so could reappear.
         if (!entry.complete || fileInfo.exists()) {
-            beginInsertRows(QModelIndex(), m_numRows, m_numRows);
-            m_orderedEntries.append(entry);
-            endInsertRows();
-            m_numRows++;
+            entries.append(entry);
         }
         count++;
     }
@@ -133,6 +168,7 @@ void DownloadsModel::fetchMore(const QModelIndex &parent)
     if (count == 0) {
         m_canFetchMore = false;
     }
+    return entries;
 }
 
 QHash<int, QByteArray> DownloadsModel::roleNames() const
@@ -100,6 +100,7 @@ private:
 
     void resetDatabase(const QString& databaseName);
     void createOrAlterDatabaseSchema();
+    QList<DownloadEntry> fetchPage();
     void insertNewEntryInDatabase(const DownloadEntry& entry);
     void removeExistingEntryFromDatabase(const QString& path);
     void setPaused(const QString& downloadId, bool paused);
@@ -0,0 +1,440 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fuzzy-search-model.h"
+
+// Qt
+#include <QtCore/QMetaObject>
+#include <QtCore/QSet>
+
+// Source model signals that update the index, and the corresponding slots
+static const char* const SOURCE_CONNECTIONS[][2] = {
+    { SIGNAL(rowsInserted(const QModelIndex&, int, int)),
+      SLOT(onRowsInserted(const QModelIndex&, int, int)) },
+    { SIGNAL(rowsAboutToBeRemoved(const QModelIndex&, int, int)),
+      SLOT(onRowsAboutToBeRemoved(const QModelIndex&, int, int)) },
+    { SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)),
+      SLOT(onDataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)) },
+    { SIGNAL(modelReset()), SLOT(onModelReset()) },
+};
+
+/*!
+    \class FuzzySearchModel
+    \brief List model that exposes history entries and bookmarks that
+           approximately match search terms
+
+    FuzzySearchModel keeps a trigram index (see TrigramIndex) of the titles
+    and URLs of the entries of a HistoryModel and of a BookmarksModel, and
+    holds the entries that are the most similar to the search terms, up to a
+    given limit. It tolerates typos and incomplete words, which exact
+    matching doesn’t, and is meant to complement it when it doesn’t find
+    enough results.
+
+    The index lives on a worker thread. It is built there from the contents
+    of the models when they are set, then updated as they change, and
+    searched there too. Results are published asynchronously, see
+    SearchResultsModel, and the search is run again when the threshold
+    changes or the index is updated.
+
+    An entry that is both in the history and in the bookmarks is only
+    returned once. Hidden history entries are not indexed.
+*/
+FuzzySearchModel::FuzzySearchModel(QObject* parent)
+    : SearchResultsModel(parent)
+    , m_threshold(0.3)
+    , m_lastRequestId(0)
+    , m_searchQueued(false)
+{
+    qRegisterMetaType<QVector<FuzzySearchModel::Entry>>();
+    qRegisterMetaType<QList<QUrl>>();
+    m_worker = new FuzzySearchWorker;
+    m_worker->moveToThread(&m_workerThread);
+    connect(m_worker, SIGNAL(searchResults(int, const QVector<FuzzySearchModel::Entry>&)),
+            SLOT(onSearchResults(int, const QVector<FuzzySearchModel::Entry>&)),
+            Qt::QueuedConnection);
+    m_workerThread.start(QThread::LowPriority);
+}
+
+FuzzySearchModel::~FuzzySearchModel()
+{
+    m_worker->setLatestRequest(-1);
+    m_worker->deleteLater();
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+QHash<int, QByteArray> FuzzySearchModel::roleNames() const
+{
+    static QHash<int, QByteArray> roles;
+    if (roles.isEmpty()) {
+        roles[Url] = "url";
+        roles[Title] = "title";
+        roles[Icon] = "icon";
+        roles[Source] = "source";
+        roles[Similarity] = "similarity";
+    }
+    return roles;
+}
+
+int FuzzySearchModel::rowCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    return m_results.count();
+}
+
+QVariant FuzzySearchModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+    const Entry& entry = m_results.at(index.row());
+    switch (role) {
+    case Url:
+        return entry.url;
+    case Title:
+        return entry.title;
+    case Icon:
+        return entry.icon;
+    case Source:
+        return entry.source;
+    case Similarity:
+        return entry.similarity;
+    default:
+        return QVariant();
+    }
+}
+
+HistoryModel* FuzzySearchModel::historyModel() const
+{
+    return m_historyModel;
+}
+
+void FuzzySearchModel::setHistoryModel(HistoryModel* historyModel)
+{
+    if (historyModel != m_historyModel) {
+        setSource(m_historyModel, historyModel, History);
+        m_historyModel = historyModel;
+        Q_EMIT historyModelChanged();
+    }
+}
+
+BookmarksModel* FuzzySearchModel::bookmarksModel() const
+{
+    return m_bookmarksModel;
+}
+
+void FuzzySearchModel::setBookmarksModel(BookmarksModel* bookmarksModel)
+{
+    if (bookmarksModel != m_bookmarksModel) {
+        setSource(m_bookmarksModel, bookmarksModel, Bookmarks);
+        m_bookmarksModel = bookmarksModel;
+        Q_EMIT bookmarksModelChanged();
+    }
+}
+
+void FuzzySearchModel::setSource(QAbstractItemModel* current, QAbstractItemModel* model, SourceType source)
+{
+    for (const auto& connection : SOURCE_CONNECTIONS) {
+        if (current) {
+            disconnect(current, connection[0], this, connection[1]);
+        }
+        if (model) {
+            connect(model, connection[0], this, connection[1]);
+        }
+    }
+    Q_EMIT m_worker->clear(source);
+    if (model) {
+        indexSource(model, source);
+    }
+    queueSearch();
+}
+
+/* Index all the entries of a source model */
+void FuzzySearchModel::indexSource(QAbstractItemModel* model, SourceType source)
+{
+    if (model->rowCount() > 0) {
+        Q_EMIT m_worker->insert(readEntries(model, source, 0, model->rowCount() - 1));
+    }
+}
+
+FuzzySearchModel::SourceType FuzzySearchModel::sourceOf(const QObject* model) const
+{
+    return (model == m_bookmarksModel) ? Bookmarks : History;
+}
+
+/* Entries of the given rows of a source model, except hidden history entries */
+QVector<FuzzySearchModel::Entry> FuzzySearchModel::readEntries(QAbstractItemModel* model, SourceType source,
+                                                               int first, int last) const
+{
+    QVector<Entry> entries;
+    entries.reserve(last - first + 1);
+    for (int row = first; row <= last; ++row) {
+        QModelIndex index = model->index(row, 0);
+        Entry entry;
+        entry.source = source;
+        entry.similarity = 0;
+        if (source == History) {
+            if (model->data(index, HistoryModel::Hidden).toBool()) {
+                continue;
+            }
+            entry.url = model->data(index, HistoryModel::Url).toUrl();
+            entry.title = model->data(index, HistoryModel::Title).toString();
+            entry.icon = model->data(index, HistoryModel::Icon).toUrl();
+        } else {
+            entry.url = model->data(index, BookmarksModel::Url).toUrl();
+            entry.title = model->data(index, BookmarksModel::Title).toString();
+            entry.icon = model->data(index, BookmarksModel::Icon).toUrl();
+        }
+        entries.append(entry);
+    }
+    return entries;
+}
+
+void FuzzySearchModel::onRowsInserted(const QModelIndex& parent, int first, int last)
+{
+    QAbstractItemModel* model = qobject_cast<QAbstractItemModel*>(sender());
+    if (model && !parent.isValid()) {
+        Q_EMIT m_worker->insert(readEntries(model, sourceOf(model), first, last));
+        queueSearch();
+    }
+}
+
+void FuzzySearchModel::onRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last)
+{
+    QAbstractItemModel* model = qobject_cast<QAbstractItemModel*>(sender());
+    if (model && !parent.isValid()) {
+        SourceType source = sourceOf(model);
+        int role = (source == History) ? int(HistoryModel::Url) : int(BookmarksModel::Url);
+        QList<QUrl> urls;
+        for (int row = first; row <= last; ++row) {
+            urls.append(model->data(model->index(row, 0), role).toUrl());
+        }
+        Q_EMIT m_worker->remove(source, urls);
+        queueSearch();
+    }
+}
+
+void FuzzySearchModel::onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight,
+                                     const QVector<int>& roles)
+{
+    QAbstractItemModel* model = qobject_cast<QAbstractItemModel*>(sender());
+    if (!model || topLeft.parent().isValid()) {
+        return;
+    }
+    SourceType source = sourceOf(model);
+    QVector<int> indexedRoles;
+    if (source == History) {
+        indexedRoles << HistoryModel::Url << HistoryModel::Title << HistoryModel::Icon << HistoryModel::Hidden;
+    } else {
+        indexedRoles << BookmarksModel::Url << BookmarksModel::Title << BookmarksModel::Icon;
+    }
+    bool changed = roles.isEmpty();
+    Q_FOREACH(int role, roles) {
+        changed = changed || indexedRoles.contains(role);
+    }
+    if (!changed) {
+        return;
+    }
+
+    // Entries that were hidden are removed, the others indexed again
+    QVector<Entry> entries = readEntries(model, source, topLeft.row(), bottomRight.row());
+    if (entries.count() < (bottomRight.row() - topLeft.row() + 1)) {
+        QSet<QUrl> visible;
+        Q_FOREACH(const Entry& entry, entries) {
+            visible.insert(entry.url);
+        }
+        QList<QUrl> hidden;
+        for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+            QUrl url = model->data(model->index(row, 0), HistoryModel::Url).toUrl();
+            if (!visible.contains(url)) {
+                hidden.append(url);
+            }
+        }
+        Q_EMIT m_worker->remove(source, hidden);
+    }
+    Q_EMIT m_worker->insert(entries);
+    queueSearch();
+}
+
+void FuzzySearchModel::onModelReset()
+{
+    QAbstractItemModel* model = qobject_cast<QAbstractItemModel*>(sender());
+    if (model) {
+        SourceType source = sourceOf(model);
+        Q_EMIT m_worker->clear(source);
+        indexSource(model, source);
+        queueSearch();
+    }
+}
+
+double FuzzySearchModel::threshold() const
+{
+    return m_threshold;
+}
+
+void FuzzySearchModel::setThreshold(double threshold)
+{
+    if (threshold != m_threshold) {
+        m_threshold = threshold;
+        search();
+        Q_EMIT thresholdChanged();
+    }
+}
+
+/*
+    Search again once the source models are done changing, as they often
+    change several rows in a row.
+*/
+void FuzzySearchModel::queueSearch()
+{
+    if (!terms().isEmpty() && !m_searchQueued) {
+        m_searchQueued = true;
+        QMetaObject::invokeMethod(this, "onSearchQueued", Qt::QueuedConnection);
+    }
+}
+
+void FuzzySearchModel::onSearchQueued()
+{
+    if (m_searchQueued) {
+        search();
+    }
+}
+
+void FuzzySearchModel::search()
+{
+    // A search that was queued is superseded by this one
+    m_searchQueued = false;
+    SearchResultsModel::search();
+}
+
+int FuzzySearchModel::startSearch()
+{
+    if (!m_historyModel && !m_bookmarksModel) {
+        return 0;
+    }
+    int id = ++m_lastRequestId;
+    m_worker->setLatestRequest(id);
+    Q_EMIT m_worker->search(id, terms(), m_threshold, limit());
+    return id;
+}
+
+void FuzzySearchModel::clearResults()
+{
+    setResults(m_results, QVector<Entry>());
+}
+
+void FuzzySearchModel::onSearchResults(int id, const QVector<FuzzySearchModel::Entry>& results)
+{
+    publishResults(id, m_results, results);
+}
+
+FuzzySearchWorker::FuzzySearchWorker()
+{
+    connect(this, SIGNAL(insert(const QVector<FuzzySearchModel::Entry>&)),
+            SLOT(doInsert(const QVector<FuzzySearchModel::Entry>&)), Qt::QueuedConnection);
+    connect(this, SIGNAL(remove(int, const QList<QUrl>&)),
+            SLOT(doRemove(int, const QList<QUrl>&)), Qt::QueuedConnection);
+    connect(this, SIGNAL(clear(int)), SLOT(doClear(int)), Qt::QueuedConnection);
+    connect(this, SIGNAL(search(int, const QStringList&, double, int)),
+            SLOT(doSearch(int, const QStringList&, double, int)), Qt::QueuedConnection);
+}
+
+void FuzzySearchWorker::setLatestRequest(int id)
+{
+    m_latestRequest.store(id);
+}
+
+void FuzzySearchWorker::doInsert(const QVector<FuzzySearchModel::Entry>& entries)
+{
+    Q_FOREACH(const FuzzySearchModel::Entry& entry, entries) {
+        QPair<int, QUrl> key(entry.source, entry.url);
+        int id = m_ids.value(key, -1);
+        if (id == -1) {
+            if (m_freeIds.isEmpty()) {
+                id = m_entries.count();
+                m_entries.append(entry);
+            } else {
+                id = m_freeIds.takeLast();
+                m_entries[id] = entry;
+            }
+            m_ids.insert(key, id);
+        } else {
+            m_entries[id] = entry;
+        }
+        // The scheme is left out, as it is common to most entries
+        m_index.insert(id, entry.title + QLatin1Char(' ') + entry.url.toString(QUrl::RemoveScheme));
+    }
+}
+
+void FuzzySearchWorker::doRemove(int source, const QList<QUrl>& urls)
+{
+    Q_FOREACH(const QUrl& url, urls) {
+        QHash<QPair<int, QUrl>, int>::iterator i = m_ids.find(qMakePair(source, url));
+        if (i != m_ids.end()) {
+            removeDocument(i.value());
+            m_ids.erase(i);
+        }
+    }
+}
+
+void FuzzySearchWorker::doClear(int source)
+{
+    QHash<QPair<int, QUrl>, int>::iterator i = m_ids.begin();
+    while (i != m_ids.end()) {
+        if (i.key().first == source) {
+            removeDocument(i.value());
+            i = m_ids.erase(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void FuzzySearchWorker::removeDocument(int id)
+{
+    m_index.remove(id);
+    m_entries[id] = FuzzySearchModel::Entry();
+    m_freeIds.append(id);
+}
+
+void FuzzySearchWorker::doSearch(int id, const QStringList& terms, double threshold, int limit)
+{
+    if (m_latestRequest.load() != id) {
+        // Superseded by a search queued after this one
+        return;
+    }
+
+    // Entries both in the history and in the bookmarks are returned once,
+    // which takes at most twice as many matches
+    QVector<TrigramIndex::Match> matches = m_index.search(terms.join(QLatin1Char(' ')), threshold, limit * 2);
+    QVector<FuzzySearchModel::Entry> results;
+    QSet<QUrl> urls;
+    Q_FOREACH(const TrigramIndex::Match& match, matches) {
+        const FuzzySearchModel::Entry& entry = m_entries.at(match.document);
+        if (urls.contains(entry.url)) {
+            continue;
+        }
+        urls.insert(entry.url);
+        results.append(entry);
+        results.last().similarity = match.similarity;
+        if (results.count() == limit) {
+            break;
+        }
+    }
+    Q_EMIT searchResults(id, results);
+}
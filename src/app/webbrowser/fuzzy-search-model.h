@@ -0,0 +1,163 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FUZZY_SEARCH_MODEL_H__
+#define __FUZZY_SEARCH_MODEL_H__
+
+// Qt
+#include <QtCore/QAtomicInt>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMetaType>
+#include <QtCore/QPair>
+#include <QtCore/QPointer>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+#include <QtCore/QUrl>
+#include <QtCore/QVector>
+
+#include "bookmarks-model.h"
+#include "history-model.h"
+#include "search-results-model.h"
+#include "trigram-index.h"
+
+class FuzzySearchWorker;
+
+class FuzzySearchModel : public SearchResultsModel
+{
+    Q_OBJECT
+
+    Q_PROPERTY(HistoryModel* historyModel READ historyModel WRITE setHistoryModel NOTIFY historyModelChanged)
+    Q_PROPERTY(BookmarksModel* bookmarksModel READ bookmarksModel WRITE setBookmarksModel NOTIFY bookmarksModelChanged)
+    Q_PROPERTY(double threshold READ threshold WRITE setThreshold NOTIFY thresholdChanged)
+
+    Q_ENUMS(Roles SourceType)
+
+public:
+    FuzzySearchModel(QObject* parent=0);
+    ~FuzzySearchModel();
+
+    enum Roles {
+        Url = Qt::UserRole + 1,
+        Title,
+        Icon,
+        Source,
+        Similarity
+    };
+
+    enum SourceType {
+        History,
+        Bookmarks
+    };
+
+    struct Entry {
+        QUrl url;
+        QString title;
+        QUrl icon;
+        int source;
+        double similarity;
+    };
+
+    // reimplemented from QAbstractListModel
+    QHash<int, QByteArray> roleNames() const;
+    int rowCount(const QModelIndex& parent=QModelIndex()) const;
+    QVariant data(const QModelIndex& index, int role) const;
+
+    HistoryModel* historyModel() const;
+    void setHistoryModel(HistoryModel* historyModel);
+
+    BookmarksModel* bookmarksModel() const;
+    void setBookmarksModel(BookmarksModel* bookmarksModel);
+
+    double threshold() const;
+    void setThreshold(double threshold);
+
+Q_SIGNALS:
+    void historyModelChanged() const;
+    void bookmarksModelChanged() const;
+    void thresholdChanged() const;
+
+protected Q_SLOTS:
+    void search();
+
+protected:
+    int startSearch();
+    void clearResults();
+
+private Q_SLOTS:
+    void onSearchQueued();
+    void onRowsInserted(const QModelIndex& parent, int first, int last);
+    void onRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last);
+    void onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles);
+    void onModelReset();
+    void onSearchResults(int id, const QVector<FuzzySearchModel::Entry>& results);
+
+private:
+    QPointer<HistoryModel> m_historyModel;
+    QPointer<BookmarksModel> m_bookmarksModel;
+    double m_threshold;
+    int m_lastRequestId;
+    bool m_searchQueued;
+    QVector<Entry> m_results;
+    QThread m_workerThread;
+    FuzzySearchWorker* m_worker;
+
+    void setSource(QAbstractItemModel* current, QAbstractItemModel* model, SourceType source);
+    void indexSource(QAbstractItemModel* model, SourceType source);
+    SourceType sourceOf(const QObject* model) const;
+    QVector<Entry> readEntries(QAbstractItemModel* model, SourceType source, int first, int last) const;
+    void queueSearch();
+};
+
+Q_DECLARE_METATYPE(QVector<FuzzySearchModel::Entry>)
+
+class FuzzySearchWorker : public QObject {
+    Q_OBJECT
+
+public:
+    FuzzySearchWorker();
+
+    // Thread safe, earlier searches still queued are skipped
+    void setLatestRequest(int id);
+
+Q_SIGNALS:
+    void insert(const QVector<FuzzySearchModel::Entry>& entries);
+    void remove(int source, const QList<QUrl>& urls);
+    void clear(int source);
+    void search(int id, const QStringList& terms, double threshold, int limit);
+    void searchResults(int id, const QVector<FuzzySearchModel::Entry>& results);
+
+private Q_SLOTS:
+    void doInsert(const QVector<FuzzySearchModel::Entry>& entries);
+    void doRemove(int source, const QList<QUrl>& urls);
+    void doClear(int source);
+    void doSearch(int id, const QStringList& terms, double threshold, int limit);
+
+private:
+    TrigramIndex m_index;
+    // Entries by document id in the index, and the ids of the entries from
+    // each source by URL
+    QVector<FuzzySearchModel::Entry> m_entries;
+    QVector<int> m_freeIds;
+    QHash<QPair<int, QUrl>, int> m_ids;
+    QAtomicInt m_latestRequest;
+
+    void removeDocument(int id);
+};
+
+#endif // __FUZZY_SEARCH_MODEL_H__
@@ -0,0 +1,464 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "grouped-history-query-model.h"
+
+// Qt
+#include <QtCore/QSet>
+
+GroupedHistoryListModel::GroupedHistoryListModel(QObject* parent)
+    : QAbstractListModel(parent)
+{
+}
+
+static QString entryKey(const HistoryModel::HistoryEntry& entry)
+{
+    return entry.url.toString();
+}
+
+static bool sameEntry(const HistoryModel::HistoryEntry& a, const HistoryModel::HistoryEntry& b)
+{
+    return (a.url == b.url) && (a.domain == b.domain) && (a.title == b.title) &&
+           (a.icon == b.icon) && (a.visits == b.visits) && (a.lastVisit == b.lastVisit) &&
+           (a.hidden == b.hidden) && (a.frecency == b.frecency);
+}
+
+static bool sameGroup(const HistoryModel::HistoryGroup& a, const HistoryModel::HistoryGroup& b)
+{
+    return (a.count == b.count) && sameEntry(a.lastVisited, b.lastVisited);
+}
+
+/*!
+    \class GroupedHistoryEntriesModel
+    \brief List model that exposes the entries of one group of the history
+
+    GroupedHistoryEntriesModel is a list model that holds the entries of one
+    domain or one day of the history, the most recent first. Entries are read
+    from the history database one page at a time: the first page when the
+    model is created, and the following ones when views request more rows
+    through fetchMore().
+
+    reload() reads again all the entries loaded so far, and is called by
+    GroupedHistoryQueryModel when the group changed in the history
+    database. The entries read are applied as row insertions, removals,
+    moves and data changes, so that views keep their position.
+*/
+GroupedHistoryEntriesModel::GroupedHistoryEntriesModel(HistoryModel* sourceModel,
+                                                       HistoryModel::Grouping grouping,
+                                                       const QVariant& group, int pageSize,
+                                                       QObject* parent)
+    : GroupedHistoryListModel(parent)
+    , m_sourceModel(sourceModel)
+    , m_grouping(grouping)
+    , m_group(group)
+    , m_pageSize(pageSize)
+    , m_more(true)
+    , m_requestId(0)
+    , m_reloading(false)
+{
+    if (m_sourceModel) {
+        connect(m_sourceModel,
+                SIGNAL(groupEntriesReady(int, const QVector<HistoryModel::HistoryEntry>&, const QVariantList&)),
+                SLOT(onGroupEntriesReady(int, const QVector<HistoryModel::HistoryEntry>&, const QVariantList&)));
+    }
+    fetchMore();
+}
+
+QHash<int, QByteArray> GroupedHistoryEntriesModel::roleNames() const
+{
+    static QHash<int, QByteArray> roles;
+    if (roles.isEmpty()) {
+        roles[HistoryModel::Url] = "url";
+        roles[HistoryModel::Domain] = "domain";
+        roles[HistoryModel::Title] = "title";
+        roles[HistoryModel::Icon] = "icon";
+        roles[HistoryModel::Visits] = "visits";
+        roles[HistoryModel::LastVisit] = "lastVisit";
+        roles[HistoryModel::LastVisitDate] = "lastVisitDate";
+        roles[HistoryModel::Hidden] = "hidden";
+        roles[HistoryModel::Frecency] = "frecency";
+    }
+    return roles;
+}
+
+int GroupedHistoryEntriesModel::rowCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    return m_entries.count();
+}
+
+QVariant GroupedHistoryEntriesModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+    const HistoryModel::HistoryEntry& entry = m_entries.at(index.row());
+    switch (role) {
+    case HistoryModel::Url:
+        return entry.url;
+    case HistoryModel::Domain:
+        return entry.domain;
+    case HistoryModel::Title:
+        return entry.title;
+    case HistoryModel::Icon:
+        return entry.icon;
+    case HistoryModel::Visits:
+        return entry.visits;
+    case HistoryModel::LastVisit:
+        return entry.lastVisit;
+    case HistoryModel::LastVisitDate:
+        return entry.lastVisit.toLocalTime().date();
+    case HistoryModel::Hidden:
+        return entry.hidden;
+    case HistoryModel::Frecency:
+        return entry.frecency;
+    default:
+        return QVariant();
+    }
+}
+
+bool GroupedHistoryEntriesModel::canFetchMore(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    return m_sourceModel && m_more && (m_requestId == 0);
+}
+
+void GroupedHistoryEntriesModel::fetchMore(const QModelIndex& parent)
+{
+    if (canFetchMore(parent)) {
+        request(m_next, m_pageSize);
+    }
+}
+
+bool GroupedHistoryEntriesModel::loading() const
+{
+    return (m_requestId != 0);
+}
+
+void GroupedHistoryEntriesModel::reload()
+{
+    if (m_sourceModel) {
+        // A page still pending will be discarded
+        m_reloading = true;
+        request(QVariantList(), qMax(m_pageSize, m_entries.count()));
+    }
+}
+
+void GroupedHistoryEntriesModel::request(const QVariantList& cursor, int limit)
+{
+    bool wasLoading = loading();
+    m_requestId = m_sourceModel->queryGroupEntries(m_grouping, m_group, cursor, limit);
+    if (!wasLoading) {
+        Q_EMIT loadingChanged();
+    }
+}
+
+void GroupedHistoryEntriesModel::onGroupEntriesReady(int id, const QVector<HistoryModel::HistoryEntry>& entries,
+                                                     const QVariantList& next)
+{
+    if (id != m_requestId) {
+        return;
+    }
+    m_requestId = 0;
+    int count = m_entries.count();
+    if (m_reloading) {
+        m_reloading = false;
+        updateRows(m_entries, entries, entryKey, sameEntry);
+    } else if (!entries.isEmpty()) {
+        beginInsertRows(QModelIndex(), count, count + entries.count() - 1);
+        m_entries += entries;
+        endInsertRows();
+    }
+    m_next = next;
+    m_more = !next.isEmpty();
+    if (m_entries.count() != count) {
+        Q_EMIT countChanged();
+    }
+    Q_EMIT loadingChanged();
+}
+
+QVariantMap GroupedHistoryEntriesModel::get(int i) const
+{
+    QVariantMap item;
+    QHash<int, QByteArray> roles = roleNames();
+
+    QModelIndex modelIndex = index(i, 0);
+    if (modelIndex.isValid()) {
+        Q_FOREACH(int role, roles.keys()) {
+            QString roleName = QString::fromUtf8(roles.value(role));
+            item.insert(roleName, data(modelIndex, role));
+        }
+    }
+    return item;
+}
+
+/*!
+    \class GroupedHistoryQueryModel
+    \brief List model that exposes the history grouped by domain or by day
+
+    GroupedHistoryQueryModel is a list model that exposes one row per domain
+    or per day (in local time) of the history, the group with the most recent
+    visit first. Each row has the following roles: 'domain' or
+    'lastVisitDate' for the group, 'lastVisit', 'lastVisitedTitle' and
+    'lastVisitedIcon' for its most recently visited entry, 'entryCount' for
+    its number of entries, and 'entries' for a GroupedHistoryEntriesModel
+    that loads the entries of the group page by page.
+
+    Unlike HistoryDomainListModel and HistoryLastVisitDateListModel, it
+    doesn’t require the entries to be loaded in the source model: groups are
+    aggregated by the history database, on the database thread, and only the
+    pages of entries actually displayed are read. The entries of a group are
+    only read when its 'entries' role is first requested.
+
+    The groups are read again when the history database is updated, and
+    changes are applied as row insertions, removals, moves and data changes,
+    so that views keep their position. The entries loaded so far are read
+    again only for the groups whose count or most recently visited entry
+    changed.
+*/
+GroupedHistoryQueryModel::GroupedHistoryQueryModel(QObject* parent)
+    : GroupedHistoryListModel(parent)
+    , m_groupBy(HistoryModel::GroupByDomain)
+    , m_pageSize(50)
+    , m_queryId(0)
+{
+}
+
+GroupedHistoryQueryModel::~GroupedHistoryQueryModel()
+{
+    clearEntries();
+}
+
+QHash<int, QByteArray> GroupedHistoryQueryModel::roleNames() const
+{
+    static QHash<int, QByteArray> roles;
+    if (roles.isEmpty()) {
+        roles[Domain] = "domain";
+        roles[LastVisit] = "lastVisit";
+        roles[LastVisitDate] = "lastVisitDate";
+        roles[LastVisitedTitle] = "lastVisitedTitle";
+        roles[LastVisitedIcon] = "lastVisitedIcon";
+        roles[EntryCount] = "entryCount";
+        roles[Entries] = "entries";
+    }
+    return roles;
+}
+
+int GroupedHistoryQueryModel::rowCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    return m_groups.count();
+}
+
+QVariant GroupedHistoryQueryModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+    const HistoryModel::HistoryGroup& group = m_groups.at(index.row());
+    switch (role) {
+    case Domain:
+        return group.domain;
+    case LastVisit:
+        return group.lastVisited.lastVisit;
+    case LastVisitDate:
+        if (m_groupBy == HistoryModel::GroupByDay) {
+            return group.lastVisitDate;
+        }
+        return group.lastVisited.lastVisit.toLocalTime().date();
+    case LastVisitedTitle:
+        return group.lastVisited.title;
+    case LastVisitedIcon:
+        return group.lastVisited.icon;
+    case EntryCount:
+        return group.count;
+    case Entries:
+        return QVariant::fromValue(entries(index.row()));
+    default:
+        return QVariant();
+    }
+}
+
+HistoryModel* GroupedHistoryQueryModel::sourceModel() const
+{
+    return m_sourceModel;
+}
+
+void GroupedHistoryQueryModel::setSourceModel(HistoryModel* sourceModel)
+{
+    if (sourceModel != m_sourceModel) {
+        if (m_sourceModel) {
+            m_sourceModel->disconnect(this);
+        }
+        clearEntries();
+        m_sourceModel = sourceModel;
+        if (m_sourceModel) {
+            connect(m_sourceModel,
+                    SIGNAL(groupsReady(int, const QVector<HistoryModel::HistoryGroup>&)),
+                    SLOT(onGroupsReady(int, const QVector<HistoryModel::HistoryGroup>&)));
+            connect(m_sourceModel, SIGNAL(flushed(int, int, qint64)), SLOT(query()));
+            connect(m_sourceModel, SIGNAL(modelReset()), SLOT(query()));
+        }
+        query();
+        Q_EMIT sourceModelChanged();
+    }
+}
+
+HistoryModel::Grouping GroupedHistoryQueryModel::groupBy() const
+{
+    return m_groupBy;
+}
+
+void GroupedHistoryQueryModel::setGroupBy(HistoryModel::Grouping groupBy)
+{
+    if (groupBy != m_groupBy) {
+        clearEntries();
+        m_groupBy = groupBy;
+        query();
+        Q_EMIT groupByChanged();
+    }
+}
+
+int GroupedHistoryQueryModel::pageSize() const
+{
+    return m_pageSize;
+}
+
+void GroupedHistoryQueryModel::setPageSize(int pageSize)
+{
+    // Only applies to the groups whose entries are requested afterwards
+    if ((pageSize > 0) && (pageSize != m_pageSize)) {
+        m_pageSize = pageSize;
+        Q_EMIT pageSizeChanged();
+    }
+}
+
+bool GroupedHistoryQueryModel::loading() const
+{
+    return (m_queryId != 0);
+}
+
+void GroupedHistoryQueryModel::query()
+{
+    bool wasLoading = loading();
+    if (m_sourceModel) {
+        // Results of a previous query still pending will be discarded
+        m_queryId = m_sourceModel->queryGroups(m_groupBy);
+    } else {
+        m_queryId = 0;
+        onGroupsReady(0, QVector<HistoryModel::HistoryGroup>());
+    }
+    if (loading() != wasLoading) {
+        Q_EMIT loadingChanged();
+    }
+}
+
+void GroupedHistoryQueryModel::onGroupsReady(int id, const QVector<HistoryModel::HistoryGroup>& groups)
+{
+    if (id != m_queryId) {
+        return;
+    }
+    bool wasLoading = loading();
+    m_queryId = 0;
+
+    QHash<QString, HistoryModel::HistoryGroup> previous;
+    Q_FOREACH(const HistoryModel::HistoryGroup& group, m_groups) {
+        previous.insert(groupKey(group), group);
+    }
+    int count = m_groups.count();
+    updateRows(m_groups, groups,
+               [this] (const HistoryModel::HistoryGroup& group) { return groupKey(group); },
+               sameGroup);
+    if (m_groups.count() != count) {
+        Q_EMIT countChanged();
+    }
+
+    // Entries of the groups that are gone are discarded, those of the groups
+    // that changed are read again
+    QHash<QString, int> rows;
+    for (int row = 0; row < m_groups.count(); ++row) {
+        rows.insert(groupKey(m_groups.at(row)), row);
+    }
+    QHash<QString, GroupedHistoryEntriesModel*>::iterator i = m_entries.begin();
+    while (i != m_entries.end()) {
+        int row = rows.value(i.key(), -1);
+        if (row == -1) {
+            i.value()->deleteLater();
+            i = m_entries.erase(i);
+            continue;
+        }
+        QHash<QString, HistoryModel::HistoryGroup>::const_iterator before = previous.constFind(i.key());
+        if ((before == previous.constEnd()) || !sameGroup(before.value(), m_groups.at(row))) {
+            i.value()->reload();
+        }
+        ++i;
+    }
+
+    if (wasLoading) {
+        Q_EMIT loadingChanged();
+    }
+}
+
+QVariant GroupedHistoryQueryModel::groupValue(const HistoryModel::HistoryGroup& group) const
+{
+    if (m_groupBy == HistoryModel::GroupByDay) {
+        return group.lastVisitDate;
+    }
+    return group.domain;
+}
+
+QString GroupedHistoryQueryModel::groupKey(const HistoryModel::HistoryGroup& group) const
+{
+    return groupValue(group).toString();
+}
+
+GroupedHistoryEntriesModel* GroupedHistoryQueryModel::entries(int row) const
+{
+    const HistoryModel::HistoryGroup& group = m_groups.at(row);
+    QString key = groupKey(group);
+    GroupedHistoryEntriesModel* model = m_entries.value(key);
+    if (!model) {
+        model = new GroupedHistoryEntriesModel(m_sourceModel, m_groupBy, groupValue(group), m_pageSize,
+                                               const_cast<GroupedHistoryQueryModel*>(this));
+        m_entries.insert(key, model);
+    }
+    return model;
+}
+
+void GroupedHistoryQueryModel::clearEntries()
+{
+    Q_FOREACH(GroupedHistoryEntriesModel* model, m_entries) {
+        model->deleteLater();
+    }
+    m_entries.clear();
+}
+
+QVariantMap GroupedHistoryQueryModel::get(int row) const
+{
+    QVariantMap item;
+    QHash<int, QByteArray> roles = roleNames();
+
+    QModelIndex modelIndex = index(row, 0);
+    if (modelIndex.isValid()) {
+        Q_FOREACH(int role, roles.keys()) {
+            QString roleName = QString::fromUtf8(roles.value(role));
+            item.insert(roleName, data(modelIndex, role));
+        }
+    }
+    return item;
+}
@@ -0,0 +1,214 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GROUPED_HISTORY_QUERY_MODEL_H__
+#define __GROUPED_HISTORY_QUERY_MODEL_H__
+
+// Qt
+#include <QtCore/QAbstractListModel>
+#include <QtCore/QHash>
+#include <QtCore/QPointer>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "history-model.h"
+
+// Base of the grouped history models, which update their rows in place when
+// the history database changes, so that views keep their state
+class GroupedHistoryListModel : public QAbstractListModel
+{
+protected:
+    GroupedHistoryListModel(QObject* parent=0);
+
+    template <typename T, typename KeyOf, typename Equal>
+    void updateRows(QVector<T>& rows, const QVector<T>& updated, KeyOf keyOf, Equal equal);
+};
+
+/*
+    Turn rows into updated (whose keys must be unique) with row removals,
+    moves, insertions and data changes rather than a reset.
+*/
+template <typename T, typename KeyOf, typename Equal>
+void GroupedHistoryListModel::updateRows(QVector<T>& rows, const QVector<T>& updated,
+                                         KeyOf keyOf, Equal equal)
+{
+    QSet<QString> keys;
+    Q_FOREACH(const T& row, updated) {
+        keys.insert(keyOf(row));
+    }
+    for (int i = rows.count() - 1; i >= 0; --i) {
+        if (!keys.contains(keyOf(rows.at(i)))) {
+            int last = i;
+            while ((i > 0) && !keys.contains(keyOf(rows.at(i - 1)))) {
+                --i;
+            }
+            beginRemoveRows(QModelIndex(), i, last);
+            rows.remove(i, last - i + 1);
+            endRemoveRows();
+        }
+    }
+
+    QSet<QString> present;
+    Q_FOREACH(const T& row, rows) {
+        present.insert(keyOf(row));
+    }
+    for (int i = 0; i < updated.count(); ++i) {
+        const T& row = updated.at(i);
+        QString key = keyOf(row);
+        if (!present.contains(key)) {
+            beginInsertRows(QModelIndex(), i, i);
+            rows.insert(i, row);
+            endInsertRows();
+            continue;
+        }
+        // Rows before i are in place, so a row that moved is further down,
+        // usually not far as only recently visited rows move
+        int from = i;
+        while (keyOf(rows.at(from)) != key) {
+            ++from;
+        }
+        if (from != i) {
+            beginMoveRows(QModelIndex(), from, from, QModelIndex(), i);
+            rows.move(from, i);
+            endMoveRows();
+        }
+        if (!equal(rows.at(i), row)) {
+            rows[i] = row;
+            Q_EMIT dataChanged(index(i, 0), index(i, 0));
+        }
+    }
+}
+
+class GroupedHistoryEntriesModel : public GroupedHistoryListModel
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged)
+
+public:
+    GroupedHistoryEntriesModel(HistoryModel* sourceModel, HistoryModel::Grouping grouping,
+                               const QVariant& group, int pageSize, QObject* parent=0);
+
+    // reimplemented from QAbstractListModel
+    QHash<int, QByteArray> roleNames() const;
+    int rowCount(const QModelIndex& parent=QModelIndex()) const;
+    QVariant data(const QModelIndex& index, int role) const;
+    bool canFetchMore(const QModelIndex& parent=QModelIndex()) const;
+    void fetchMore(const QModelIndex& parent=QModelIndex());
+
+    bool loading() const;
+
+    void reload();
+
+    Q_INVOKABLE QVariantMap get(int index) const;
+
+Q_SIGNALS:
+    void countChanged() const;
+    void loadingChanged() const;
+
+private Q_SLOTS:
+    void onGroupEntriesReady(int id, const QVector<HistoryModel::HistoryEntry>& entries, const QVariantList& next);
+
+private:
+    QPointer<HistoryModel> m_sourceModel;
+    HistoryModel::Grouping m_grouping;
+    QVariant m_group;
+    int m_pageSize;
+    QVector<HistoryModel::HistoryEntry> m_entries;
+    // Cursor of the next page, empty once all entries are loaded
+    QVariantList m_next;
+    bool m_more;
+    int m_requestId;
+    bool m_reloading;
+
+    void request(const QVariantList& cursor, int limit);
+};
+
+class GroupedHistoryQueryModel : public GroupedHistoryListModel
+{
+    Q_OBJECT
+
+    Q_PROPERTY(HistoryModel* sourceModel READ sourceModel WRITE setSourceModel NOTIFY sourceModelChanged)
+    Q_PROPERTY(HistoryModel::Grouping groupBy READ groupBy WRITE setGroupBy NOTIFY groupByChanged)
+    Q_PROPERTY(int pageSize READ pageSize WRITE setPageSize NOTIFY pageSizeChanged)
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged)
+
+    Q_ENUMS(Roles)
+
+public:
+    GroupedHistoryQueryModel(QObject* parent=0);
+    ~GroupedHistoryQueryModel();
+
+    enum Roles {
+        Domain = Qt::UserRole + 1,
+        LastVisit,
+        LastVisitDate,
+        LastVisitedTitle,
+        LastVisitedIcon,
+        EntryCount,
+        Entries
+    };
+
+    // reimplemented from QAbstractListModel
+    QHash<int, QByteArray> roleNames() const;
+    int rowCount(const QModelIndex& parent=QModelIndex()) const;
+    QVariant data(const QModelIndex& index, int role) const;
+
+    HistoryModel* sourceModel() const;
+    void setSourceModel(HistoryModel* sourceModel);
+
+    HistoryModel::Grouping groupBy() const;
+    void setGroupBy(HistoryModel::Grouping groupBy);
+
+    int pageSize() const;
+    void setPageSize(int pageSize);
+
+    bool loading() const;
+
+    Q_INVOKABLE QVariantMap get(int row) const;
+
+Q_SIGNALS:
+    void sourceModelChanged() const;
+    void groupByChanged() const;
+    void pageSizeChanged() const;
+    void countChanged() const;
+    void loadingChanged() const;
+
+private Q_SLOTS:
+    void query();
+    void onGroupsReady(int id, const QVector<HistoryModel::HistoryGroup>& groups);
+
+private:
+    QPointer<HistoryModel> m_sourceModel;
+    HistoryModel::Grouping m_groupBy;
+    int m_pageSize;
+    int m_queryId;
+    QVector<HistoryModel::HistoryGroup> m_groups;
+    // Entries of the groups, by group key, created when first requested
+    mutable QHash<QString, GroupedHistoryEntriesModel*> m_entries;
+
+    QVariant groupValue(const HistoryModel::HistoryGroup& group) const;
+    QString groupKey(const HistoryModel::HistoryGroup& group) const;
+    GroupedHistoryEntriesModel* entries(int row) const;
+    void clearEntries();
+};
+
+#endif // __GROUPED_HISTORY_QUERY_MODEL_H__
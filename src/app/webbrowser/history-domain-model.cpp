@@ -22,38 +22,97 @@
 // Qt
 #include <QtCore/QUrl>
 
+// std
+#include <algorithm>
+
 /*!
     \class HistoryDomainModel
-    \brief Proxy model that filters the contents of a history model
-           based on a domain name
+    \brief List model that exposes the entries of a history model
+           for a given domain name
 
-    HistoryDomainModel is a proxy model that filters the contents of a
-    history model based on a domain name.
+    HistoryDomainModel is a view on a history model that only exposes the
+    entries for a given domain name, in the same order and with the same roles.
 
     An entry in the history model matches if the domain name extracted from
     its URL equals the filter domain name (case-insensitive comparison).
 
     When no domain name is set (null or empty string), all entries match.
+
+    The rows of the matching entries are looked up once, when the source model
+    or the domain change, and then updated incrementally as entries are
+    inserted, moved or removed in the source model, so that only the entries
+    inserted need to be checked against the domain name.
 */
 HistoryDomainModel::HistoryDomainModel(QObject* parent)
-    : QSortFilterProxyModel(parent)
+    : QAbstractListModel(parent)
+    , m_moving(false)
+    , m_removing(false)
 {
     connect(this, SIGNAL(layoutChanged(QList<QPersistentModelIndex>, QAbstractItemModel::LayoutChangeHint)), SLOT(onModelChanged()));
     connect(this, SIGNAL(modelReset()), SLOT(onModelChanged()));
     connect(this, SIGNAL(rowsInserted(QModelIndex, int, int)), SLOT(onModelChanged()));
     connect(this, SIGNAL(rowsRemoved(QModelIndex, int, int)), SLOT(onModelChanged()));
+    connect(this, SIGNAL(rowsMoved(QModelIndex, int, int, QModelIndex, int)), SLOT(onModelChanged()));
     connect(this, SIGNAL(dataChanged(QModelIndex, QModelIndex, QVector<int>)), SLOT(onModelChanged()));
 }
 
+QHash<int, QByteArray> HistoryDomainModel::roleNames() const
+{
+    if (m_sourceModel) {
+        return m_sourceModel->roleNames();
+    }
+    return QHash<int, QByteArray>();
+}
+
+int HistoryDomainModel::rowCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    return m_rows.count();
+}
+
+QVariant HistoryDomainModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || !m_sourceModel) {
+        return QVariant();
+    }
+    return m_sourceModel->data(m_sourceModel->index(m_rows.at(index.row()), 0), role);
+}
+
 HistoryModel* HistoryDomainModel::sourceModel() const
 {
-    return qobject_cast<HistoryModel*>(QSortFilterProxyModel::sourceModel());
+    return m_sourceModel;
 }
 
 void HistoryDomainModel::setSourceModel(HistoryModel* sourceModel)
 {
-    if (sourceModel != this->sourceModel()) {
-        QSortFilterProxyModel::setSourceModel(sourceModel);
+    if (sourceModel != m_sourceModel) {
+        beginResetModel();
+        if (m_sourceModel) {
+            m_sourceModel->disconnect(this);
+        }
+        m_sourceModel = sourceModel;
+        if (m_sourceModel) {
+            connect(m_sourceModel, SIGNAL(rowsInserted(const QModelIndex&, int, int)),
+                    SLOT(onSourceRowsInserted(const QModelIndex&, int, int)));
+            connect(m_sourceModel, SIGNAL(rowsAboutToBeRemoved(const QModelIndex&, int, int)),
+                    SLOT(onSourceRowsAboutToBeRemoved(const QModelIndex&, int, int)));
+            connect(m_sourceModel, SIGNAL(rowsRemoved(const QModelIndex&, int, int)),
+                    SLOT(onSourceRowsRemoved(const QModelIndex&, int, int)));
+            connect(m_sourceModel,
+                    SIGNAL(rowsAboutToBeMoved(const QModelIndex&, int, int, const QModelIndex&, int)),
+                    SLOT(onSourceRowsAboutToBeMoved(const QModelIndex&, int, int, const QModelIndex&, int)));
+            connect(m_sourceModel,
+                    SIGNAL(rowsMoved(const QModelIndex&, int, int, const QModelIndex&, int)),
+                    SLOT(onSourceRowsMoved(const QModelIndex&, int, int, const QModelIndex&, int)));
+            connect(m_sourceModel,
+                    SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)),
+                    SLOT(onSourceDataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)));
+            connect(m_sourceModel, SIGNAL(modelReset()), SLOT(onSourceModelReset()));
+            connect(m_sourceModel, SIGNAL(layoutChanged(QList<QPersistentModelIndex>, QAbstractItemModel::LayoutChangeHint)),
+                    SLOT(onSourceModelReset()));
+        }
+        populateModel();
+        endResetModel();
         Q_EMIT sourceModelChanged();
     }
 }
@@ -66,8 +125,10 @@ const QString& HistoryDomainModel::domain() const
 void HistoryDomainModel::setDomain(const QString& domain)
 {
     if (domain != m_domain) {
+        beginResetModel();
         m_domain = domain;
-        invalidate();
+        populateModel();
+        endResetModel();
         Q_EMIT domainChanged();
     }
 }
@@ -87,16 +148,145 @@ const QUrl& HistoryDomainModel::lastVisitedIcon() const
     return m_lastVisitedIcon;
 }
 
-bool HistoryDomainModel::filterAcceptsRow(int source_row, const QModelIndex& source_parent) const
+bool HistoryDomainModel::matches(int sourceRow) const
 {
     if (m_domain.isEmpty()) {
         return true;
     }
-    QModelIndex index = sourceModel()->index(source_row, 0, source_parent);
-    QString domain = sourceModel()->data(index, HistoryModel::Domain).toString();
+    QModelIndex index = m_sourceModel->index(sourceRow, 0);
+    QString domain = m_sourceModel->data(index, HistoryModel::Domain).toString();
     return (domain.compare(m_domain, Qt::CaseInsensitive) == 0);
 }
 
+void HistoryDomainModel::populateModel()
+{
+    m_rows.clear();
+    if (m_sourceModel) {
+        int count = m_sourceModel->rowCount();
+        for (int i = 0; i < count; ++i) {
+            if (matches(i)) {
+                m_rows.append(i);
+            }
+        }
+    }
+}
+
+/*
+    Return the row of the first matching entry at or after a given source row.
+*/
+int HistoryDomainModel::lowerBound(int sourceRow) const
+{
+    return std::lower_bound(m_rows.constBegin(), m_rows.constEnd(), sourceRow) - m_rows.constBegin();
+}
+
+void HistoryDomainModel::onSourceRowsInserted(const QModelIndex& parent, int start, int end)
+{
+    Q_UNUSED(parent);
+    QVector<int> inserted;
+    for (int i = start; i <= end; ++i) {
+        if (matches(i)) {
+            inserted.append(i);
+        }
+    }
+    int first = lowerBound(start);
+    int count = end - start + 1;
+    if (!inserted.isEmpty()) {
+        beginInsertRows(QModelIndex(), first, first + inserted.count() - 1);
+    }
+    for (int i = first; i < m_rows.count(); ++i) {
+        m_rows[i] += count;
+    }
+    if (!inserted.isEmpty()) {
+        m_rows.insert(first, inserted.count(), 0);
+        std::copy(inserted.constBegin(), inserted.constEnd(), m_rows.begin() + first);
+        endInsertRows();
+    }
+}
+
+void HistoryDomainModel::onSourceRowsAboutToBeRemoved(const QModelIndex& parent, int start, int end)
+{
+    Q_UNUSED(parent);
+    int first = lowerBound(start);
+    int last = lowerBound(end + 1) - 1;
+    m_removing = (last >= first);
+    if (m_removing) {
+        beginRemoveRows(QModelIndex(), first, last);
+    }
+}
+
+void HistoryDomainModel::onSourceRowsRemoved(const QModelIndex& parent, int start, int end)
+{
+    Q_UNUSED(parent);
+    int first = lowerBound(start);
+    int last = lowerBound(end + 1) - 1;
+    m_rows.remove(first, last - first + 1);
+    int count = end - start + 1;
+    for (int i = first; i < m_rows.count(); ++i) {
+        m_rows[i] -= count;
+    }
+    if (m_removing) {
+        m_removing = false;
+        endRemoveRows();
+    }
+}
+
+void HistoryDomainModel::onSourceRowsAboutToBeMoved(const QModelIndex& parent, int start, int end,
+                                                    const QModelIndex& destination, int row)
+{
+    Q_UNUSED(parent);
+    Q_UNUSED(destination);
+    // The matching entries only change order if some of them are moved past
+    // other matching entries.
+    int first = lowerBound(start);
+    int last = lowerBound(end + 1) - 1;
+    int to = lowerBound(row);
+    m_moving = false;
+    if ((last >= first) && (to != first) && (to != last + 1)) {
+        m_moving = beginMoveRows(QModelIndex(), first, last, QModelIndex(), to);
+    }
+}
+
+void HistoryDomainModel::onSourceRowsMoved(const QModelIndex& parent, int start, int end,
+                                           const QModelIndex& destination, int row)
+{
+    Q_UNUSED(parent);
+    Q_UNUSED(destination);
+    int count = end - start + 1;
+    int to = (row < start) ? row : row - count;
+    for (int i = 0; i < m_rows.count(); ++i) {
+        int sourceRow = m_rows.at(i);
+        if ((sourceRow >= start) && (sourceRow <= end)) {
+            m_rows[i] = to + sourceRow - start;
+        } else if ((row < start) && (sourceRow >= row) && (sourceRow < start)) {
+            m_rows[i] += count;
+        } else if ((row > end) && (sourceRow > end) && (sourceRow < row)) {
+            m_rows[i] -= count;
+        }
+    }
+    std::sort(m_rows.begin(), m_rows.end());
+    if (m_moving) {
+        m_moving = false;
+        endMoveRows();
+    }
+}
+
+void HistoryDomainModel::onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight,
+                                             const QVector<int>& roles)
+{
+    int first = lowerBound(topLeft.row());
+    int last = lowerBound(bottomRight.row() + 1) - 1;
+    if (last >= first) {
+        Q_EMIT dataChanged(index(first, 0), index(last, 0), roles);
+    }
+}
+
+void HistoryDomainModel::onSourceModelReset()
+{
+    beginResetModel();
+    populateModel();
+    endResetModel();
+}
+
 void HistoryDomainModel::onModelChanged()
 {
     // If the rowCount is zero all the history entries of this model were
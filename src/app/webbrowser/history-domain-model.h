@@ -20,14 +20,16 @@
 #define __HISTORY_DOMAIN_MODEL_H__
 
 // Qt
+#include <QtCore/QAbstractListModel>
 #include <QtCore/QDateTime>
-#include <QtCore/QSortFilterProxyModel>
+#include <QtCore/QPointer>
 #include <QtCore/QString>
 #include <QtCore/QUrl>
+#include <QtCore/QVector>
 
 class HistoryModel;
 
-class HistoryDomainModel : public QSortFilterProxyModel
+class HistoryDomainModel : public QAbstractListModel
 {
     Q_OBJECT
 
@@ -40,6 +42,11 @@ class HistoryDomainModel : public QSortFilterProxyModel
 public:
     HistoryDomainModel(QObject* parent=0);
 
+    // reimplemented from QAbstractListModel
+    QHash<int, QByteArray> roleNames() const;
+    int rowCount(const QModelIndex& parent=QModelIndex()) const;
+    QVariant data(const QModelIndex& index, int role) const;
+
     HistoryModel* sourceModel() const;
     void setSourceModel(HistoryModel* sourceModel);
 
@@ -57,18 +64,32 @@ Q_SIGNALS:
     void lastVisitedTitleChanged() const;
     void lastVisitedIconChanged() const;
 
-protected:
-    // reimplemented from QSortFilterProxyModel
-    bool filterAcceptsRow(int source_row, const QModelIndex& source_parent) const;
-
 private:
+    QPointer<HistoryModel> m_sourceModel;
     QString m_domain;
     QDateTime m_lastVisit;
     QString m_lastVisitedTitle;
     QUrl m_lastVisitedIcon;
+    // Rows of the matching entries in the source model, in ascending order
+    QVector<int> m_rows;
+    // Whether the rows being moved or removed in the source model
+    // move or remove rows of this model
+    bool m_moving;
+    bool m_removing;
+
+    bool matches(int sourceRow) const;
+    void populateModel();
+    int lowerBound(int sourceRow) const;
 
 private Q_SLOTS:
     void onModelChanged();
+    void onSourceRowsInserted(const QModelIndex& parent, int start, int end);
+    void onSourceRowsAboutToBeRemoved(const QModelIndex& parent, int start, int end);
+    void onSourceRowsRemoved(const QModelIndex& parent, int start, int end);
+    void onSourceRowsAboutToBeMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int row);
+    void onSourceRowsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int row);
+    void onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles);
+    void onSourceModelReset();
 };
 
 #endif // __HISTORY_DOMAIN_MODEL_H__
@@ -23,6 +23,9 @@
 // Qt
 #include <QtCore/QStringList>
 
+// std
+#include <algorithm>
+
 /*!
     \class HistoryDomainListModel
     \brief List model that exposes history entries grouped by domain name
@@ -32,6 +35,21 @@
     three roles: 'domain' for the domain name, 'lastVisit' for the timestamp
     of the last page visited in this domain, and 'entries' for the corresponding
     HistoryDomainModel that contains all entries in this group.
+
+    Domains are listed in the order in which they are first seen in the source
+    model. The groups are built in a single pass over the source model, which
+    records the group of each row, and are then updated incrementally as rows
+    are inserted, moved or removed, looking up only the domain of inserted
+    rows. The HistoryDomainModel of a group is only created when its 'entries'
+    role is requested.
+
+    Source rows are tracked by ids kept in a RankIndex, and the rows of each
+    group are linked together in order, so that inserting rows at the top or
+    at the bottom (which is what HistoryModel does when adding and loading
+    entries), moving rows to the top and removing rows cost time in
+    proportion to the number of rows affected (times a logarithmic factor)
+    rather than to the size of the source model or to the number of groups.
+    Rows inserted or moved anywhere else are linked again from scratch.
 */
 HistoryDomainListModel::HistoryDomainListModel(QObject* parent)
     : QAbstractListModel(parent)
@@ -61,7 +79,7 @@ QHash<int, QByteArray> HistoryDomainListModel::roleNames() const
 int HistoryDomainListModel::rowCount(const QModelIndex& parent) const
 {
     Q_UNUSED(parent);
-    return m_domains.count();
+    return m_order.count();
 }
 
 QVariant HistoryDomainListModel::data(const QModelIndex& index, int role) const
@@ -69,22 +87,23 @@ QVariant HistoryDomainListModel::data(const QModelIndex& index, int role) const
     if (!index.isValid()) {
         return QVariant();
     }
-    const QString domain = m_domainsPerLastVisit.at(index.row());
-    HistoryDomainModel* entries = m_domains.value(domain);
+    int id = m_order.at(index.row());
+    const DomainGroup& group = m_groups.at(id);
+    QModelIndex top = m_sourceModel->index(m_rows.rankOf(group.top), 0);
 
     switch (role) {
     case Domain:
-        return domain;
+        return group.domain;
     case LastVisit:
-        return entries->lastVisit();
+        return m_sourceModel->data(top, HistoryModel::LastVisit);
     case LastVisitDate:
-        return entries->lastVisit().toLocalTime().date();
+        return m_sourceModel->data(top, HistoryModel::LastVisitDate);
     case LastVisitedTitle:
-        return entries->lastVisitedTitle();
+        return m_sourceModel->data(top, HistoryModel::Title);
     case LastVisitedIcon:
-        return entries->lastVisitedIcon();
+        return m_sourceModel->data(top, HistoryModel::Icon);
     case Entries:
-        return QVariant::fromValue(entries);
+        return QVariant::fromValue(entries(id));
     default:
         return QVariant();
     }
@@ -108,6 +127,13 @@ void HistoryDomainListModel::setSourceModel(HistoryModel* sourceModel)
         if (m_sourceModel != 0) {
             connect(m_sourceModel, SIGNAL(rowsInserted(const QModelIndex&, int, int)),
                     SLOT(onRowsInserted(const QModelIndex&, int, int)));
+            connect(m_sourceModel, SIGNAL(rowsRemoved(const QModelIndex&, int, int)),
+                    SLOT(onRowsRemoved(const QModelIndex&, int, int)));
+            connect(m_sourceModel,
+                    SIGNAL(rowsMoved(const QModelIndex&, int, int, const QModelIndex&, int)),
+                    SLOT(onRowsMoved(const QModelIndex&, int, int, const QModelIndex&, int)));
+            connect(m_sourceModel, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&)),
+                    SLOT(onDataChanged(const QModelIndex&, const QModelIndex&)));
             connect(m_sourceModel, SIGNAL(modelReset()), SLOT(onModelReset()));
             connect(m_sourceModel, SIGNAL(layoutChanged(QList<QPersistentModelIndex>, QAbstractItemModel::LayoutChangeHint)),
                     SLOT(onModelReset()));
@@ -139,105 +165,326 @@ QVariantMap HistoryDomainListModel::get(int row) const
 
 void HistoryDomainListModel::clearDomains()
 {
-    Q_FOREACH(const QString& domain, m_domains.keys()) {
-        delete m_domains.take(domain);
+    Q_FOREACH(const DomainGroup& group, m_groups) {
+        delete group.entries;
     }
-    m_domainsPerLastVisit.clear();
+    m_groups.clear();
+    m_groupIds.clear();
+    m_rows.clear();
+    m_rowGroups.clear();
+    m_previousRows.clear();
+    m_nextRows.clear();
+    m_freeRowIds.clear();
+    m_order.clear();
 }
 
 void HistoryDomainListModel::populateModel()
 {
     if (m_sourceModel != 0) {
         int count = m_sourceModel->rowCount();
+        QVector<int> rowIds;
+        rowIds.reserve(count);
         for (int i = 0; i < count; ++i) {
-            QString domain = getDomainFromSourceModel(m_sourceModel->index(i, 0));
-            if (!m_domains.contains(domain)) {
-                insertNewDomain(domain);
+            int id = groupId(getDomainFromSourceModel(i));
+            DomainGroup& group = m_groups[id];
+            if (group.count++ == 0) {
+                group.position = m_order.count();
+                m_order.append(id);
             }
+            rowIds.append(newRowId(id));
         }
+        relinkRows(rowIds);
     }
 }
 
-void HistoryDomainListModel::onRowsInserted(const QModelIndex& parent, int start, int end)
+int HistoryDomainListModel::groupId(const QString& domain)
 {
+    QHash<QString, int>::const_iterator i = m_groupIds.constFind(domain);
+    if (i != m_groupIds.constEnd()) {
+        return i.value();
+    }
+    DomainGroup group;
+    group.domain = domain;
+    group.count = 0;
+    group.top = -1;
+    group.bottom = -1;
+    group.position = -1;
+    group.entries = 0;
+    int id = m_groups.count();
+    m_groups.append(group);
+    m_groupIds.insert(domain, id);
+    return id;
+}
+
+/* Allocate an id for a source row of the given group, not linked yet */
+int HistoryDomainListModel::newRowId(int group)
+{
+    int rowId;
+    if (m_freeRowIds.isEmpty()) {
+        rowId = m_rowGroups.count();
+        m_rowGroups.append(group);
+        m_previousRows.append(-1);
+        m_nextRows.append(-1);
+    } else {
+        rowId = m_freeRowIds.takeLast();
+        m_rowGroups[rowId] = group;
+        m_previousRows[rowId] = -1;
+        m_nextRows[rowId] = -1;
+    }
+    return rowId;
+}
+
+/* Link a row above all the other rows of its group */
+void HistoryDomainListModel::linkFirst(int rowId)
+{
+    DomainGroup& group = m_groups[m_rowGroups.at(rowId)];
+    m_previousRows[rowId] = -1;
+    m_nextRows[rowId] = group.top;
+    if (group.top != -1) {
+        m_previousRows[group.top] = rowId;
+    } else {
+        group.bottom = rowId;
+    }
+    group.top = rowId;
+}
+
+/* Link a row below all the other rows of its group */
+void HistoryDomainListModel::linkLast(int rowId)
+{
+    DomainGroup& group = m_groups[m_rowGroups.at(rowId)];
+    m_nextRows[rowId] = -1;
+    m_previousRows[rowId] = group.bottom;
+    if (group.bottom != -1) {
+        m_nextRows[group.bottom] = rowId;
+    } else {
+        group.top = rowId;
+    }
+    group.bottom = rowId;
+}
+
+void HistoryDomainListModel::unlink(int rowId)
+{
+    DomainGroup& group = m_groups[m_rowGroups.at(rowId)];
+    int previous = m_previousRows.at(rowId);
+    int next = m_nextRows.at(rowId);
+    if (previous != -1) {
+        m_nextRows[previous] = next;
+    } else {
+        group.top = next;
+    }
+    if (next != -1) {
+        m_previousRows[next] = previous;
+    } else {
+        group.bottom = previous;
+    }
+    m_previousRows[rowId] = -1;
+    m_nextRows[rowId] = -1;
+}
+
+/* Replace the order of the rows, and link the rows of each group again */
+void HistoryDomainListModel::relinkRows(const QVector<int>& rowIds)
+{
+    m_rows.reset(rowIds);
+    for (int i = 0; i < m_groups.count(); ++i) {
+        m_groups[i].top = -1;
+        m_groups[i].bottom = -1;
+    }
+    Q_FOREACH(int rowId, rowIds) {
+        linkLast(rowId);
+    }
+}
+
+/* Ids of the source rows start to end, in row order */
+QVector<int> HistoryDomainListModel::rowIds(int start, int end) const
+{
+    QVector<int> ids;
+    ids.reserve(end - start + 1);
     for (int i = start; i <= end; ++i) {
-        QString domain = getDomainFromSourceModel(m_sourceModel->index(i, 0, parent));
-        if (!m_domains.contains(domain)) {
-            QStringList domains = m_domainsPerLastVisit;
-            int insertAt = 0;
-            while (insertAt < domains.count()) {
-                if (domain.compare(domains.at(insertAt)) < 0) {
-                    break;
-                }
-                ++insertAt;
-            }
-            beginInsertRows(QModelIndex(), insertAt, insertAt);
-            insertNewDomain(domain);
-            endInsertRows();
-        }
+        ids.append(m_rows.itemAt(i));
     }
+    return ids;
 }
 
-void HistoryDomainListModel::onModelReset()
+/* List a group that just got its first entry, after all the others */
+void HistoryDomainListModel::insertGroup(int id)
 {
-    beginResetModel();
-    clearDomains();
-    populateModel();
-    endResetModel();
+    beginInsertRows(QModelIndex(), m_order.count(), m_order.count());
+    m_groups[id].position = m_order.count();
+    m_order.append(id);
+    endInsertRows();
+}
+
+/*
+    Stop listing a group that has no entries left.
+    Its id remains valid, for when entries for the same domain are added again.
+*/
+void HistoryDomainListModel::removeGroup(int id)
+{
+    int removeAt = m_groups.at(id).position;
+    beginRemoveRows(QModelIndex(), removeAt, removeAt);
+    m_order.remove(removeAt);
+    for (int i = removeAt; i < m_order.count(); ++i) {
+        m_groups[m_order.at(i)].position = i;
+    }
+    DomainGroup& group = m_groups[id];
+    group.position = -1;
+    if (group.entries) {
+        // It is still connected to the source model,
+        // which may not be done notifying the removal.
+        group.entries->deleteLater();
+        group.entries = 0;
+    }
+    endRemoveRows();
 }
 
-void HistoryDomainListModel::insertNewDomain(const QString& domain)
+HistoryDomainModel* HistoryDomainListModel::entries(int id) const
 {
-    HistoryDomainModel* model = new HistoryDomainModel(this);
-    model->setSourceModel(m_sourceModel);
-    model->setDomain(domain);
-    connect(model, SIGNAL(rowsInserted(QModelIndex, int, int)), SLOT(onDomainDataChanged()));
-    connect(model, SIGNAL(rowsRemoved(QModelIndex, int, int)), SLOT(onDomainRowsRemoved(QModelIndex, int, int)));
-    connect(model, SIGNAL(rowsMoved(QModelIndex, int, int, QModelIndex, int)), SLOT(onDomainDataChanged()));
-    connect(model, SIGNAL(layoutChanged(QList<QPersistentModelIndex>, QAbstractItemModel::LayoutChangeHint)), SLOT(onDomainDataChanged()));
-    connect(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), SLOT(onDomainDataChanged()));
-    connect(model, SIGNAL(modelReset()), SLOT(onDomainDataChanged()));
-    connect(model, SIGNAL(lastVisitChanged()), SLOT(onDomainDataChanged()));
-    m_domains.insert(domain, model);
-    m_domainsPerLastVisit.append(domain);
+    const DomainGroup& group = m_groups.at(id);
+    if (!group.entries) {
+        HistoryDomainModel* model = new HistoryDomainModel(const_cast<HistoryDomainListModel*>(this));
+        model->setDomain(group.domain);
+        model->setSourceModel(m_sourceModel);
+        group.entries = model;
+    }
+    return group.entries;
 }
 
-QString HistoryDomainListModel::getDomainFromSourceModel(const QModelIndex& index) const
+void HistoryDomainListModel::onRowsInserted(const QModelIndex& parent, int start, int end)
 {
-    return m_sourceModel->data(index, HistoryModel::Domain).toString();
+    Q_UNUSED(parent);
+    QVector<int> inserted;
+    inserted.reserve(end - start + 1);
+    for (int i = start; i <= end; ++i) {
+        inserted.append(newRowId(groupId(getDomainFromSourceModel(i))));
+    }
+    if (start == 0) {
+        for (int i = inserted.count() - 1; i >= 0; --i) {
+            m_rows.prepend(inserted.at(i));
+            linkFirst(inserted.at(i));
+        }
+    } else if (start == m_rows.count()) {
+        Q_FOREACH(int rowId, inserted) {
+            m_rows.append(rowId);
+            linkLast(rowId);
+        }
+    } else {
+        QVector<int> ids = rowIds(0, m_rows.count() - 1);
+        ids.insert(start, inserted.count(), -1);
+        std::copy(inserted.constBegin(), inserted.constEnd(), ids.begin() + start);
+        relinkRows(ids);
+    }
+
+    QSet<int> changed;
+    Q_FOREACH(int rowId, inserted) {
+        int id = m_rowGroups.at(rowId);
+        DomainGroup& group = m_groups[id];
+        if (group.count++ == 0) {
+            insertGroup(id);
+        } else if (group.top == rowId) {
+            changed.insert(id);
+        }
+    }
+    Q_FOREACH(int id, changed) {
+        emitDataChanged(id);
+    }
 }
 
-void HistoryDomainListModel::onDomainRowsRemoved(const QModelIndex& parent, int start, int end)
+void HistoryDomainListModel::onRowsRemoved(const QModelIndex& parent, int start, int end)
 {
     Q_UNUSED(parent);
-    Q_UNUSED(start);
-    Q_UNUSED(end);
-    HistoryDomainModel* model = qobject_cast<HistoryDomainModel*>(sender());
-    if (model != 0) {
-        const QString& domain = model->domain();
-        if (model->rowCount() == 0) {
-            int removeAt = m_domainsPerLastVisit.indexOf(domain);
-            beginRemoveRows(QModelIndex(), removeAt, removeAt);
-            delete m_domains.take(domain);
-            m_domainsPerLastVisit.removeAt(removeAt);
-            endRemoveRows();
-        } else {
-            emitDataChanged(domain);
+    QVector<int> emptied;
+    QSet<int> changed;
+    Q_FOREACH(int rowId, rowIds(start, end)) {
+        int id = m_rowGroups.at(rowId);
+        DomainGroup& group = m_groups[id];
+        if (group.top == rowId) {
+            // The next entry of the group, if any, becomes the most recent
+            changed.insert(id);
+        }
+        unlink(rowId);
+        m_rows.remove(rowId);
+        m_freeRowIds.append(rowId);
+        if (--group.count == 0) {
+            emptied.append(id);
         }
     }
+    Q_FOREACH(int id, emptied) {
+        changed.remove(id);
+        removeGroup(id);
+    }
+    Q_FOREACH(int id, changed) {
+        emitDataChanged(id);
+    }
 }
 
-void HistoryDomainListModel::onDomainDataChanged()
+void HistoryDomainListModel::onRowsMoved(const QModelIndex& parent, int start, int end,
+                                         const QModelIndex& destination, int row)
 {
-    HistoryDomainModel* model = qobject_cast<HistoryDomainModel*>(sender());
-    if (model != 0) {
-        emitDataChanged(model->domain());
+    Q_UNUSED(parent);
+    Q_UNUSED(destination);
+    int count = end - start + 1;
+    int to = (row < start) ? row : row - count;
+    QVector<int> moved = rowIds(start, end);
+
+    // Only the groups whose most recent entry is another one are changed
+    QHash<int, int> tops;
+    if (to == 0) {
+        // Moved rows come before all the other rows of their groups
+        for (int i = moved.count() - 1; i >= 0; --i) {
+            int rowId = moved.at(i);
+            int id = m_rowGroups.at(rowId);
+            if (!tops.contains(id)) {
+                tops.insert(id, m_groups.at(id).top);
+            }
+            unlink(rowId);
+            linkFirst(rowId);
+            m_rows.moveToFront(rowId);
+        }
+    } else {
+        for (int id = 0; id < m_groups.count(); ++id) {
+            tops.insert(id, m_groups.at(id).top);
+        }
+        QVector<int> ids = rowIds(0, m_rows.count() - 1);
+        ids.remove(start, count);
+        ids.insert(to, count, -1);
+        std::copy(moved.constBegin(), moved.constEnd(), ids.begin() + to);
+        relinkRows(ids);
+    }
+    QHash<int, int>::const_iterator i;
+    for (i = tops.constBegin(); i != tops.constEnd(); ++i) {
+        if (m_groups.at(i.key()).top != i.value()) {
+            emitDataChanged(i.key());
+        }
+    }
+}
+
+void HistoryDomainListModel::onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+    for (int i = topLeft.row(); i <= bottomRight.row(); ++i) {
+        int rowId = m_rows.itemAt(i);
+        int id = m_rowGroups.at(rowId);
+        if (m_groups.at(id).top == rowId) {
+            emitDataChanged(id);
+        }
     }
 }
 
-void HistoryDomainListModel::emitDataChanged(const QString& domain)
+void HistoryDomainListModel::onModelReset()
+{
+    beginResetModel();
+    clearDomains();
+    populateModel();
+    endResetModel();
+}
+
+QString HistoryDomainListModel::getDomainFromSourceModel(int row) const
+{
+    return m_sourceModel->data(m_sourceModel->index(row, 0), HistoryModel::Domain).toString();
+}
+
+void HistoryDomainListModel::emitDataChanged(int id)
 {
-    int i = m_domainsPerLastVisit.indexOf(domain);
+    int i = m_groups.at(id).position;
     if (i != -1) {
         QModelIndex index = this->index(i, 0);
         Q_EMIT dataChanged(index, index, QVector<int>() << LastVisit << LastVisitDate << LastVisitedTitle << LastVisitedIcon << Entries);
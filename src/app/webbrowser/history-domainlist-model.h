@@ -21,8 +21,12 @@
 
 // Qt
 #include <QtCore/QAbstractListModel>
-#include <QtCore/QMap>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
 #include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "rank-index.h"
 
 class HistoryDomainModel;
 class HistoryModel;
@@ -63,21 +67,53 @@ Q_SIGNALS:
 
 private Q_SLOTS:
     void onRowsInserted(const QModelIndex& parent, int start, int end);
+    void onRowsRemoved(const QModelIndex& parent, int start, int end);
+    void onRowsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int row);
+    void onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight);
     void onModelReset();
 
-    void onDomainRowsRemoved(const QModelIndex& parent, int start, int end);
-    void onDomainDataChanged();
-
 private:
+    struct DomainGroup {
+        QString domain;
+        // Number of entries, the group is not listed when there are none
+        int count;
+        // Row ids of the most and least recent entries in the source model
+        int top;
+        int bottom;
+        // Position in the list, or -1 when not listed
+        int position;
+        // Created when first requested
+        mutable HistoryDomainModel* entries;
+    };
+
     HistoryModel* m_sourceModel;
-    QMap<QString, HistoryDomainModel*> m_domains;
-    QStringList m_domainsPerLastVisit;
+    QVector<DomainGroup> m_groups;
+    QHash<QString, int> m_groupIds;
+    // Rows of the source model are given ids that don’t change when other
+    // rows are inserted, moved or removed, and their order is kept in
+    // m_rows. The rows of each group are linked in order by their ids.
+    RankIndex m_rows;
+    QVector<int> m_rowGroups;
+    QVector<int> m_previousRows;
+    QVector<int> m_nextRows;
+    QVector<int> m_freeRowIds;
+    // Groups in the order in which they are listed
+    QVector<int> m_order;
 
     void clearDomains();
     void populateModel();
-    void insertNewDomain(const QString& domain);
-    QString getDomainFromSourceModel(const QModelIndex& index) const;
-    void emitDataChanged(const QString& domain);
+    int groupId(const QString& domain);
+    int newRowId(int group);
+    void linkFirst(int rowId);
+    void linkLast(int rowId);
+    void unlink(int rowId);
+    void relinkRows(const QVector<int>& rowIds);
+    QVector<int> rowIds(int start, int end) const;
+    void insertGroup(int id);
+    void removeGroup(int id);
+    HistoryDomainModel* entries(int id) const;
+    QString getDomainFromSourceModel(int row) const;
+    void emitDataChanged(int id);
 };
 
 #endif // __HISTORY_DOMAINLIST_MODEL_H__
@@ -23,6 +23,10 @@
 #include <QtCore/QDebug>
 #include <QtCore/QStringList>
 
+// std
+#include <algorithm>
+#include <functional>
+
 /*!
     \class HistoryLastVisitDateListModel
     \brief List model that exposes a list of all last visit dates from history
@@ -35,10 +39,19 @@
     The source model needs to expose a role named 'lastVisitDate', from which
     the input dates will be read. If such role is not present, this model will
     not expose any dates.
+
+    The model keeps the number of source rows for each date, and the date of
+    each source row (so that it knows which date a row had before it was
+    removed, moved or changed), which makes updates proportional to the
+    number of source rows affected rather than to the size of the source.
+    The dates of source rows are kept in a double-ended queue, as sources
+    such as the history usually prepend the rows they add and append the
+    rows they load, which it does without moving the other rows.
 */
 HistoryLastVisitDateListModel::HistoryLastVisitDateListModel(QObject* parent)
     : QAbstractListModel(parent)
     , m_sourceModel(0)
+    , m_sourceModelRole(-1)
 {
 }
 
@@ -109,6 +122,8 @@ void HistoryLastVisitDateListModel::setSourceModel(QVariant sourceModel)
             connect(m_sourceModel,
                     SIGNAL(rowsMoved(const QModelIndex&, int, int, const QModelIndex&, int)),
                     SLOT(onRowsMoved(const QModelIndex&, int, int, const QModelIndex&, int)));
+            connect(m_sourceModel, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&)),
+                    SLOT(onDataChanged(const QModelIndex&, const QModelIndex&)));
             connect(m_sourceModel, SIGNAL(modelReset()), SLOT(onModelReset()));
             connect(m_sourceModel, SIGNAL(layoutChanged(QList<QPersistentModelIndex>, QAbstractItemModel::LayoutChangeHint)),
                     SLOT(onModelReset()));
@@ -118,59 +133,111 @@ void HistoryLastVisitDateListModel::setSourceModel(QVariant sourceModel)
     }
 }
 
+/*!
+    Return the row of \a date, or -1 if there is no such date. An invalid
+    date is the special entry that represents all dates.
+*/
+int HistoryLastVisitDateListModel::indexOf(const QVariant& date) const
+{
+    if (m_orderedDates.isEmpty()) {
+        return -1;
+    }
+    QDate lastVisitDate = date.toDate();
+    if (!lastVisitDate.isValid()) {
+        return 0;
+    }
+    QList<QDate>::const_iterator it = std::lower_bound(m_orderedDates.constBegin() + 1, m_orderedDates.constEnd(),
+                                                       lastVisitDate, std::greater<QDate>());
+    if ((it == m_orderedDates.constEnd()) || (*it != lastVisitDate)) {
+        return -1;
+    }
+    return it - m_orderedDates.constBegin();
+}
+
 void HistoryLastVisitDateListModel::clearLastVisitDates()
 {
     m_orderedDates.clear();
-    Q_FOREACH(const QDate& lastVisitDate, m_lastVisitDates.keys()) {
-        delete m_lastVisitDates.take(lastVisitDate);
-    }
+    m_counts.clear();
+    m_rowDates.clear();
 }
 
 void HistoryLastVisitDateListModel::populateModel()
 {
-    if (m_sourceModel != 0) {
-        int count = m_sourceModel->rowCount();
-        for (int i = 0; i < count; ++i) {
-            insertNewHistoryEntry(new QPersistentModelIndex(m_sourceModel->index(i, 0)), false);
-        }
+    if ((m_sourceModel == 0) || (m_sourceModelRole == -1)) {
+        return;
+    }
+    int count = m_sourceModel->rowCount();
+    for (int i = 0; i < count; ++i) {
+        QDate lastVisitDate = sourceDate(i);
+        m_rowDates.push_back(lastVisitDate);
+        ++m_counts[lastVisitDate];
+    }
+    if (!m_counts.isEmpty()) {
+        m_orderedDates = m_counts.keys();
+        std::sort(m_orderedDates.begin(), m_orderedDates.end(), std::greater<QDate>());
+        // Add default entry to represent all dates
+        m_orderedDates.prepend(QDate());
     }
 }
 
-void HistoryLastVisitDateListModel::onRowsInserted(const QModelIndex& parent, int start, int end)
+QDate HistoryLastVisitDateListModel::sourceDate(int row) const
+{
+    return m_sourceModel->data(m_sourceModel->index(row, 0), m_sourceModelRole).toDate();
+}
+
+/* Insert the dates of source rows inserted at start, in row order. */
+void HistoryLastVisitDateListModel::insertRowDates(int start, const QVector<QDate>& dates)
+{
+    m_rowDates.insert(m_rowDates.begin() + start, dates.constBegin(), dates.constEnd());
+}
+
+/* Remove and return the dates of source rows start to end, in row order. */
+QVector<QDate> HistoryLastVisitDateListModel::takeRowDates(int start, int end)
 {
+    QVector<QDate> dates;
+    dates.reserve(end - start + 1);
     for (int i = start; i <= end; ++i) {
-        insertNewHistoryEntry(new QPersistentModelIndex(m_sourceModel->index(i, 0)), true);
+        dates.append(m_rowDates[i]);
     }
+    m_rowDates.erase(m_rowDates.begin() + start, m_rowDates.begin() + end + 1);
+    return dates;
 }
 
-void HistoryLastVisitDateListModel::onRowsRemoved(const QModelIndex& parent, int start, int end)
+void HistoryLastVisitDateListModel::addDate(const QDate& date)
 {
-    QMap<QDate, QList<QPersistentModelIndex*>*>::iterator lastVisitDate = m_lastVisitDates.begin();
-    while (lastVisitDate != m_lastVisitDates.end()) {
-
-        QList<QPersistentModelIndex*>::iterator entry = lastVisitDate.value()->begin();
-        while (entry != lastVisitDate.value()->end()) {
-            QPersistentModelIndex *index = *entry;
-            if (!index->isValid()) {
-                entry = lastVisitDate.value()->erase(entry);
-            } else {
-                ++entry;
-            }
-        }
-
-        if (lastVisitDate.value()->isEmpty()) {
-            int removeAt = m_orderedDates.indexOf(lastVisitDate.key());
-            beginRemoveRows(QModelIndex(), removeAt, removeAt);
-            m_orderedDates.removeAt(removeAt);
-            delete lastVisitDate.value();
-            lastVisitDate = m_lastVisitDates.erase(lastVisitDate);
-            endRemoveRows();
-        } else {
-            ++lastVisitDate;
-        }
+    int& count = m_counts[date];
+    if (count++ > 0) {
+        return;
+    }
+    if (m_orderedDates.isEmpty()) {
+        // Add default entry to represent all dates
+        beginInsertRows(QModelIndex(), 0, 0);
+        m_orderedDates.append(QDate());
+        endInsertRows();
     }
+    QList<QDate>::iterator it = std::upper_bound(m_orderedDates.begin() + 1, m_orderedDates.end(),
+                                                 date, std::greater<QDate>());
+    int insertAt = it - m_orderedDates.begin();
+    beginInsertRows(QModelIndex(), insertAt, insertAt);
+    m_orderedDates.insert(insertAt, date);
+    endInsertRows();
+}
 
-    if (m_lastVisitDates.isEmpty()) {
+void HistoryLastVisitDateListModel::removeDate(const QDate& date)
+{
+    QHash<QDate, int>::iterator count = m_counts.find(date);
+    if ((count == m_counts.end()) || (--count.value() > 0)) {
+        return;
+    }
+    m_counts.erase(count);
+    QList<QDate>::iterator it = std::lower_bound(m_orderedDates.begin() + 1, m_orderedDates.end(),
+                                                 date, std::greater<QDate>());
+    int removeAt = it - m_orderedDates.begin();
+    beginRemoveRows(QModelIndex(), removeAt, removeAt);
+    m_orderedDates.removeAt(removeAt);
+    endRemoveRows();
+
+    if (m_counts.isEmpty()) {
         // Remove the default entry if model is empty
         beginRemoveRows(QModelIndex(), 0, 0);
         m_orderedDates.clear();
@@ -178,43 +245,73 @@ void HistoryLastVisitDateListModel::onRowsRemoved(const QModelIndex& parent, int
     }
 }
 
+void HistoryLastVisitDateListModel::onRowsInserted(const QModelIndex& parent, int start, int end)
+{
+    Q_UNUSED(parent);
+    if (m_sourceModelRole == -1) {
+        return;
+    }
+    QVector<QDate> dates;
+    dates.reserve(end - start + 1);
+    for (int i = start; i <= end; ++i) {
+        dates.append(sourceDate(i));
+    }
+    insertRowDates(start, dates);
+    Q_FOREACH(const QDate& lastVisitDate, dates) {
+        addDate(lastVisitDate);
+    }
+}
+
+void HistoryLastVisitDateListModel::onRowsRemoved(const QModelIndex& parent, int start, int end)
+{
+    Q_UNUSED(parent);
+    if (m_sourceModelRole == -1) {
+        return;
+    }
+    Q_FOREACH(const QDate& lastVisitDate, takeRowDates(start, end)) {
+        removeDate(lastVisitDate);
+    }
+}
+
 void HistoryLastVisitDateListModel::onRowsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int row)
 {
     Q_UNUSED(parent);
     Q_UNUSED(destination);
+    if (m_sourceModelRole == -1) {
+        return;
+    }
 
-    // Rows were moved in the source model, meaning that their last visit dates
-    // were potentially updated, so we remove all the dates corresponding to
-    // the rows before they were moved, and we add all the dates corresponding
-    // to the rows after they were moved.
-
-    // Determine a lower and upper bound for the dates that should be removed
-    // by looking at the indexes surrounding the rows before they were moved.
-    QDate lower = m_sourceModel->data(m_sourceModel->index((row < start) ? end + 1 : start, 0), m_sourceModelRole).toDate();
-    if (!lower.isValid()) {
-        // The last row was moved too, we don’t have a strict lower bound.
-        lower = m_orderedDates.last().addDays(-1);
+    QVector<QDate> dates = takeRowDates(start, end);
+    int first = (row < start) ? row : row - dates.count();
+    insertRowDates(first, dates);
+
+    // The dates of the rows may have been updated as they were moved
+    onDataChanged(m_sourceModel->index(first, 0),
+                  m_sourceModel->index(first + dates.count() - 1, 0));
+}
+
+void HistoryLastVisitDateListModel::onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+    if (m_sourceModelRole == -1) {
+        return;
     }
-    QDate upper = m_sourceModel->data(m_sourceModel->index((row < start) ? end : start - 1, 0), m_sourceModelRole).toDate();
-    for (QDate i = upper.addDays(-1); i > lower; i = i.addDays(-1)) {
-        if (m_orderedDates.contains(i)) {
-            int removeAt = m_orderedDates.indexOf(i);
-            beginRemoveRows(QModelIndex(), removeAt, removeAt);
-            m_orderedDates.removeAt(removeAt);
-            delete m_lastVisitDates.take(i);
-            endRemoveRows();
+    // The changed roles are not checked, as sources may not report the date
+    // role when only the role it is derived from was changed
+    for (int i = topLeft.row(); i <= bottomRight.row(); ++i) {
+        QDate& lastVisitDate = m_rowDates[i];
+        QDate newDate = sourceDate(i);
+        if (newDate != lastVisitDate) {
+            QDate oldDate = lastVisitDate;
+            lastVisitDate = newDate;
+            addDate(newDate);
+            removeDate(oldDate);
         }
     }
-
-    // Now add back dates for all the rows after they were moved.
-    for (int i = 0; i <= (end - start); ++i) {
-        int index = i + row + ((row < start) ? 0 : start - end);
-        insertNewHistoryEntry(new QPersistentModelIndex(m_sourceModel->index(index, 0)), true);
-    }
 }
 
 void HistoryLastVisitDateListModel::updateSourceModelRole()
 {
+  m_sourceModelRole = -1;
   if (m_sourceModel && m_sourceModel->roleNames().count() > 0) {
     m_sourceModelRole = m_sourceModel->roleNames().key("lastVisitDate", -1);
     if (m_sourceModelRole == -1) {
@@ -232,46 +329,3 @@ void HistoryLastVisitDateListModel::onModelReset()
     populateModel();
     endResetModel();
 }
-
-void HistoryLastVisitDateListModel::insertNewHistoryEntry(QPersistentModelIndex* index, bool notify)
-{
-    if (m_sourceModelRole == -1) {
-        return;
-    }
-
-    QDate lastVisitDate = index->data(m_sourceModelRole).toDate();
-    if (!m_lastVisitDates.contains(lastVisitDate)) {
-        if (m_orderedDates.isEmpty()) {
-            // Add default entry to represent all dates
-            if (notify) {
-                beginInsertRows(QModelIndex(), 0, 0);
-            }
-            m_orderedDates.append(QDate());
-            if (notify) {
-                endInsertRows();
-            }
-        }
-
-        int insertAt = 1;
-        QList<QPersistentModelIndex*> *entries = new QList<QPersistentModelIndex*>();
-        while (insertAt < m_orderedDates.count()) {
-            if (lastVisitDate > m_orderedDates.at(insertAt)) {
-                break;
-            }
-            ++insertAt;
-        }
-
-        if (notify) {
-            beginInsertRows(QModelIndex(), insertAt, insertAt);
-        }
-
-        m_orderedDates.insert(insertAt, lastVisitDate);
-        m_lastVisitDates.insert(lastVisitDate, entries);
-
-        if (notify) {
-            endInsertRows();
-        }
-    }
-
-    m_lastVisitDates[lastVisitDate]->append(index);
-}
@@ -21,9 +21,14 @@
 
 // Qt
 #include <QtCore/QAbstractListModel>
-#include <QtCore/QMap>
-#include <QtCore/QSortFilterProxyModel>
+#include <QtCore/QDate>
+#include <QtCore/QHash>
+#include <QtCore/QList>
 #include <QtCore/QString>
+#include <QtCore/QVector>
+
+// std
+#include <deque>
 
 class HistoryLastVisitDateListModel : public QAbstractListModel
 {
@@ -49,6 +54,8 @@ public:
     QVariant sourceModel() const;
     void setSourceModel(QVariant sourceModel);
 
+    Q_INVOKABLE int indexOf(const QVariant& date) const;
+
 Q_SIGNALS:
     void sourceModelChanged() const;
 
@@ -56,17 +63,25 @@ private Q_SLOTS:
     void onRowsInserted(const QModelIndex& parent, int start, int end);
     void onRowsRemoved(const QModelIndex& parent, int start, int end);
     void onRowsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int row);
+    void onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight);
     void onModelReset();
 
 private:
     QAbstractItemModel* m_sourceModel;
     int m_sourceModelRole;
-    QMap<QDate, QList<QPersistentModelIndex*>*> m_lastVisitDates;
+    // Number of rows of the source model for each date
+    QHash<QDate, int> m_counts;
     QList<QDate> m_orderedDates;
+    // Date of each row of the source model
+    std::deque<QDate> m_rowDates;
 
     void clearLastVisitDates();
     void populateModel();
-    void insertNewHistoryEntry(QPersistentModelIndex* index, bool notify);
+    QDate sourceDate(int row) const;
+    void insertRowDates(int start, const QVector<QDate>& dates);
+    QVector<QDate> takeRowDates(int start, int end);
+    void addDate(const QDate& date);
+    void removeDate(const QDate& date);
     void updateSourceModelRole();
 };
 
@@ -16,16 +16,39 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "../database-utils.h"
 #include "../domain-utils.h"
 #include "history-model.h"
 
 // Qt
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QTimeZone>
 #include <QtCore/QTimer>
 #include <QtCore/QWriteLocker>
+#include <QtSql/QSqlError>
 #include <QtSql/QSqlQuery>
 
+// std
+#include <algorithm>
+#include <cmath>
+
 #define SQL_DRIVER QStringLiteral("QSQLITE")
 #define CONNECTION_NAME QStringLiteral("morph-browser-history")
+#define FETCH_BATCH_SIZE 2000
+#define BACKFILL_BATCH_SIZE 500
+#define PRUNE_BATCH_SIZE 500
+#define PRUNE_INTERVAL 3600000
+#define TIME_ZONE_CHECK_INTERVAL 60000
+// In seconds: 30 days, 90 days, and one day
+#define FRECENCY_HALF_LIFE 2592000.0
+#define VISITS_RETENTION 7776000
+#define VISITS_AGGREGATION_PERIOD 86400
+// Added to the frecency of search results, that is a match at the start of
+// the address weighs as much as 8 times the visits, at the start of a word
+// in the address or title as much as twice the visits
+#define ADDRESS_PREFIX_BONUS 3.0
+#define WORD_PREFIX_BONUS 1.0
 
 /*!
     \class HistoryModel
@@ -40,24 +63,106 @@
     The information is persistently stored on disk in a SQLite database.
     The database is read at startup to populate the model, and whenever a new
     entry is added to the model the database is updated.
+    Entries are read from the database in batches, most recent first, so that
+    the first entries can be displayed before the entire history is loaded.
+    The model keeps requesting batches until all entries are loaded, at which
+    point the loaded() signal is emitted.
     However the model doesn’t monitor the database for external changes.
     All database operations are performed on a separate thread in order not to
-    block the UI thread.
+    block the UI thread. Write operations are queued and flushed to the
+    database in a single transaction; the flushed() signal reports how many
+    operations were queued, how many of them were made redundant by later
+    operations and skipped, and how long the flush took (in milliseconds).
+
+    Entries are stored in an array by id, and the order of the rows is kept in
+    a separate RankIndex, which maps rows to ids and back in logarithmic time.
+    Adding an entry, moving a revisited entry to the top and removing entries
+    thus never move or renumber other entries, and their cost barely depends
+    on the size of the history. Domains and icons, which many entries have in
+    common, are interned and referred to by id, and timestamps are stored as
+    integers, to keep the memory footprint of a large history small. The day
+    of the last visit (in local time) is computed once per entry and cached
+    together with its string representation, so that the date roles don’t
+    require any time zone conversion. The cache is refreshed when the system
+    time zone changes.
+
+    Entries are indexed by URL, so that looking up an existing entry doesn’t
+    require walking the whole list.
+    Entries are also indexed by domain and by day of last visit, so that
+    removing all the entries for a domain or a day doesn’t require walking
+    the whole list either, and removed rows are notified in contiguous
+    blocks.
+
+    The size of the history can be bounded by setting the maximum age of
+    entries (in days), the maximum number of entries, and the maximum size of
+    the database (in kilobytes). A value of 0 means no limit, which is the
+    default. The limits are enforced once the model is loaded, and then
+    periodically, by removing the least recently visited entries. As these
+    are at the end of the list, they are removed from the model in one go,
+    while they are deleted from the database in small batches.
+
+    Each entry also has a frecency, which ranks entries by how often and how
+    recently they were visited. Every visit counts for one, and its weight
+    halves every 30 days, so that frequent visits long ago don’t outrank
+    today’s visits. The frecency is the binary logarithm of the sum of the
+    weights of all visits, relative to the Unix epoch rather than to the
+    current date, so that it doesn’t change over time and entries can be
+    sorted by it. It is updated on the database thread when visits are
+    recorded. Individual visits are logged too, so that frecencies can be
+    recomputed; visits older than 90 days are aggregated by day.
+
+    The URLs and titles of all entries are mirrored in a full-text index,
+    which search() queries on the database thread. This is what
+    HistorySearchModel uses. Builds of SQLite without full-text search are
+    supported too, search() then scans all the entries, and the index is
+    created once SQLite supports it.
+
+    Entries can also be aggregated by domain or by day, and the entries of
+    one group read page by page, with queryGroups() and queryGroupEntries(),
+    which run on the database thread too. This is what
+    GroupedHistoryQueryModel uses to display grouped entries without
+    requiring the whole history to be loaded.
 */
 HistoryModel::HistoryModel(QObject* parent)
     : QAbstractListModel(parent)
+    , m_canFetchMore(false)
+    , m_fetching(false)
+    , m_maxAge(0)
+    , m_maxCount(0)
+    , m_maxDatabaseSize(0)
+    , m_lastRequestId(0)
+    , m_dayStart(0)
+    , m_dayEnd(0)
+    , m_day(0)
+    , m_timeZoneCheck(nullptr)
 {
+    m_icons.append(QUrl());
     m_dbWorker = new DbWorker;
     m_dbWorker->moveToThread(&m_dbWorkerThread);
-    connect(m_dbWorker, SIGNAL(hiddenEntryFetched(const QUrl&)),
-            SLOT(onHiddenEntryFetched(const QUrl&)), Qt::QueuedConnection);
+    connect(m_dbWorker, SIGNAL(hiddenEntriesFetched(const QList<QUrl>&)),
+            SLOT(onHiddenEntriesFetched(const QList<QUrl>&)), Qt::QueuedConnection);
+    connect(m_dbWorker,
+            SIGNAL(entriesFetched(const QVector<HistoryModel::HistoryEntry>&, bool)),
+            SLOT(onEntriesFetched(const QVector<HistoryModel::HistoryEntry>&, bool)),
+            Qt::QueuedConnection);
+    connect(m_dbWorker, SIGNAL(entriesPruned(const QDateTime&)),
+            SLOT(onEntriesPruned(const QDateTime&)), Qt::QueuedConnection);
+    connect(m_dbWorker, SIGNAL(flushed(int, int, qint64)),
+            SIGNAL(flushed(int, int, qint64)), Qt::QueuedConnection);
+    connect(m_dbWorker,
+            SIGNAL(searchResults(int, const QVector<HistoryModel::HistoryEntry>&)),
+            SLOT(onSearchResults(int, const QVector<HistoryModel::HistoryEntry>&)),
+            Qt::QueuedConnection);
+    connect(m_dbWorker,
+            SIGNAL(groupsQueried(int, const QVector<HistoryModel::HistoryGroup>&)),
+            SIGNAL(groupsReady(int, const QVector<HistoryModel::HistoryGroup>&)),
+            Qt::QueuedConnection);
     connect(m_dbWorker,
-            SIGNAL(entryFetched(const QUrl&, const QString&, const QString&,
-                                const QUrl&, int, const QDateTime&)),
-            SLOT(onEntryFetched(const QUrl&, const QString&, const QString&,
-                                const QUrl&, int, const QDateTime&)),
+            SIGNAL(groupEntriesQueried(int, const QVector<HistoryModel::HistoryEntry>&, const QVariantList&)),
+            SLOT(onGroupEntriesQueried(int, const QVector<HistoryModel::HistoryEntry>&, const QVariantList&)),
             Qt::QueuedConnection);
-    connect(m_dbWorker, SIGNAL(loaded()), SIGNAL(loaded()));
+    connect(m_dbWorker, SIGNAL(frecenciesUpdated(const QVariantHash&)),
+            SLOT(onFrecenciesUpdated(const QVariantHash&)), Qt::QueuedConnection);
     m_dbWorkerThread.start(QThread::LowPriority);
 }
 
@@ -68,40 +173,342 @@ HistoryModel::~HistoryModel()
     m_dbWorkerThread.wait();
 }
 
-void HistoryModel::resetDatabase(const QString& databaseName)
+void HistoryModel::clearEntries()
 {
-    beginResetModel();
     m_hiddenEntries.clear();
     m_entries.clear();
+    m_freeIds.clear();
+    m_rows.clear();
+    m_urlIndex.clear();
+    m_domainIndex.clear();
+    m_dateIndex.clear();
+    m_domains.clear();
+    m_domainIds.clear();
+    m_icons.resize(1);
+    m_iconIds.clear();
+    resetDayCache();
+    if (m_timeZoneCheck) {
+        m_timeZoneCheck->stop();
+    }
+}
+
+int HistoryModel::internDomain(const QString& domain)
+{
+    QHash<QString, int>::const_iterator i = m_domainIds.constFind(domain);
+    if (i != m_domainIds.constEnd()) {
+        return i.value();
+    }
+    int id = m_domains.count();
+    m_domains.append(domain);
+    m_domainIds.insert(domain, id);
+    return id;
+}
+
+int HistoryModel::internIcon(const QUrl& icon)
+{
+    if (icon.isEmpty()) {
+        return 0;
+    }
+    QHash<QUrl, int>::const_iterator i = m_iconIds.constFind(icon);
+    if (i != m_iconIds.constEnd()) {
+        return i.value();
+    }
+    int id = m_icons.count();
+    m_icons.append(icon);
+    m_iconIds.insert(icon, id);
+    return id;
+}
+
+/*
+    Return the Julian day number of a timestamp in milliseconds, in local time.
+    The bounds of the last day computed are remembered, so that consecutive
+    timestamps in the same day (entries are mostly handled in chronological
+    order) don’t require a time zone conversion.
+*/
+int HistoryModel::dayOf(qint64 msecs)
+{
+    if ((msecs < m_dayStart) || (msecs >= m_dayEnd)) {
+        QDate date = QDateTime::fromMSecsSinceEpoch(msecs).date();
+        m_day = date.toJulianDay();
+        m_dayStart = qMin(QDateTime(date).toMSecsSinceEpoch(), msecs);
+        m_dayEnd = qMax(QDateTime(date.addDays(1)).toMSecsSinceEpoch(), msecs + 1);
+        if (!m_dayStrings.contains(m_day)) {
+            m_dayStrings.insert(m_day, date.toString(Qt::ISODate));
+        }
+    }
+    return m_day;
+}
+
+void HistoryModel::resetDayCache()
+{
+    m_dayStart = 0;
+    m_dayEnd = 0;
+    m_dayStrings.clear();
+}
+
+/*
+    Start checking for time zone changes, which only matter once the model
+    has entries whose days are cached, so that empty models don’t wake up
+    periodically for nothing.
+*/
+void HistoryModel::watchTimeZone()
+{
+    if (m_timeZoneCheck && m_timeZoneCheck->isActive()) {
+        return;
+    }
+    if (!m_timeZoneCheck) {
+        m_timeZoneCheck = new QTimer(this);
+        m_timeZoneCheck->setInterval(TIME_ZONE_CHECK_INTERVAL);
+        connect(m_timeZoneCheck, SIGNAL(timeout()), SLOT(checkTimeZone()));
+    }
+    QByteArray timeZoneId = QTimeZone::systemTimeZoneId();
+    if (timeZoneId != m_timeZoneId) {
+        m_timeZoneId = timeZoneId;
+        resetDayCache();
+    }
+    m_timeZoneCheck->start();
+}
+
+void HistoryModel::checkTimeZone()
+{
+    QByteArray timeZoneId = QTimeZone::systemTimeZoneId();
+    if (timeZoneId == m_timeZoneId) {
+        return;
+    }
+    m_timeZoneId = timeZoneId;
+    resetDayCache();
+    m_dateIndex.clear();
+    Q_FOREACH(int id, m_urlIndex) {
+        StoredEntry& entry = m_entries[id];
+        entry.day = dayOf(entry.lastVisit);
+        indexDay(id);
+    }
+    if (m_rows.count() > 0) {
+        Q_EMIT dataChanged(index(0, 0), index(m_rows.count() - 1, 0),
+                           QVector<int>() << LastVisitDate << LastVisitDateString);
+    }
+}
+
+HistoryModel::StoredEntry HistoryModel::storeEntry(const HistoryEntry& entry)
+{
+    StoredEntry stored;
+    stored.url = entry.url;
+    stored.title = entry.title;
+    stored.lastVisit = entry.lastVisit.toMSecsSinceEpoch();
+    stored.frecency = entry.frecency;
+    stored.visits = entry.visits;
+    stored.domain = internDomain(entry.domain);
+    stored.icon = internIcon(entry.icon);
+    stored.day = dayOf(stored.lastVisit);
+    stored.domainSlot = -1;
+    stored.daySlot = -1;
+    stored.hidden = m_hiddenEntries.contains(entry.url);
+    return stored;
+}
+
+/*
+    Store a new entry and index it, and return its id. Adding it to the rows
+    is up to the caller.
+*/
+int HistoryModel::insertEntry(const StoredEntry& entry)
+{
+    int id;
+    if (m_freeIds.isEmpty()) {
+        id = m_entries.count();
+        m_entries.append(entry);
+    } else {
+        id = m_freeIds.takeLast();
+        m_entries[id] = entry;
+    }
+    m_urlIndex.insert(entry.url, id);
+    indexEntry(id);
+    return id;
+}
+
+/* Unindex a stored entry that is no longer in the rows, and free its id */
+void HistoryModel::releaseEntry(int id)
+{
+    unindexEntry(id);
+    StoredEntry& entry = m_entries[id];
+    m_urlIndex.remove(entry.url);
+    entry = StoredEntry();
+    m_freeIds.append(id);
+}
+
+void HistoryModel::resetDatabase(const QString& databaseName)
+{
+    beginResetModel();
+    clearEntries();
+    m_canFetchMore = true;
+    m_fetching = false;
     Q_EMIT m_dbWorker->resetDatabase(databaseName);
     endResetModel();
-    Q_EMIT m_dbWorker->fetchEntries();
+    fetchMore();
 }
 
-void HistoryModel::onHiddenEntryFetched(const QUrl& url)
+void HistoryModel::onHiddenEntriesFetched(const QList<QUrl>& urls)
 {
-    m_hiddenEntries.insert(url);
+    Q_FOREACH(const QUrl& url, urls) {
+        m_hiddenEntries.insert(url);
+    }
 }
 
-void HistoryModel::onEntryFetched(const QUrl& url, const QString& domain, const QString& title,
-                                  const QUrl& icon, int visits, const QDateTime& lastVisit)
+void HistoryModel::onEntriesFetched(const QVector<HistoryEntry>& entries, bool more)
 {
-    HistoryEntry entry;
-    entry.url = url;
-    if (domain.isEmpty()) {
-        entry.domain = DomainUtils::extractTopLevelDomainName(url);
+    m_fetching = false;
+    if (!entries.isEmpty()) {
+        watchTimeZone();
+    }
+
+    QVector<int> fetched;
+    fetched.reserve(entries.count());
+    Q_FOREACH(const HistoryEntry& entry, entries) {
+        if (m_urlIndex.contains(entry.url)) {
+            // The entry was added to the model before the batch that
+            // contains it was fetched.
+            continue;
+        }
+        // Indexing the entries right away also guards against duplicate
+        // URLs in the database, they only become rows once inserted below.
+        fetched.append(insertEntry(storeEntry(entry)));
+    }
+
+    if (!fetched.isEmpty()) {
+        int index = m_rows.count();
+        beginInsertRows(QModelIndex(), index, index + fetched.count() - 1);
+        Q_FOREACH(int id, fetched) {
+            m_rows.append(id);
+        }
+        endInsertRows();
+        Q_EMIT rowCountChanged();
+    }
+
+    if (more) {
+        // Keep loading in the background, one batch per event loop iteration
+        fetchMore();
+    } else {
+        m_canFetchMore = false;
+        Q_EMIT loaded();
+    }
+}
+
+void HistoryModel::onEntriesPruned(const QDateTime& cutoff)
+{
+    // Entries are sorted by last visit (most recent first), so the pruned
+    // entries are all at the end of the list.
+    qint64 msecs = cutoff.toMSecsSinceEpoch();
+    int first = 0;
+    int last = m_rows.count();
+    while (first < last) {
+        int middle = first + (last - first) / 2;
+        if (entryAt(middle).lastVisit < msecs) {
+            last = middle;
+        } else {
+            first = middle + 1;
+        }
+    }
+    if (first < m_rows.count()) {
+        removeRange(first, m_rows.count() - 1);
+        Q_EMIT rowCountChanged();
+    }
+}
+
+/*!
+    Search the history for entries whose URL or title contain words that
+    start with each of the terms, and return an identifier for the request.
+
+    The search is performed asynchronously, and at most \a limit entries
+    are reported through the searchResultsReady() signal, best first. Entries
+    are ranked by their frecency, increased by how well they match the terms:
+    the most for an address (URL without its scheme and leading “www.”) that
+    starts with each term, then for words that start with each term, the
+    least for terms that are only matched word by word or regardless of
+    diacritics by the full-text index.
+*/
+int HistoryModel::search(const QStringList& terms, int limit)
+{
+    Q_EMIT m_dbWorker->search(++m_lastRequestId, terms, limit);
+    return m_lastRequestId;
+}
+
+void HistoryModel::onSearchResults(int id, const QVector<HistoryEntry>& results)
+{
+    QVector<HistoryEntry> entries(results);
+    for (int i = 0; i < entries.count(); ++i) {
+        entries[i].hidden = m_hiddenEntries.contains(entries.at(i).url);
+    }
+    Q_EMIT searchResultsReady(id, entries);
+}
+
+/* Timestamps in seconds of the first and last instants of a day in local time */
+static QVariantList dayBounds(const QDate& date)
+{
+    QVariantList values;
+    QDateTime dateTime = QDateTime(date);
+    values << dateTime.toTime_t();
+    dateTime.setTime(QTime(23, 59, 59, 999));
+    values << dateTime.toTime_t();
+    return values;
+}
+
+/*!
+    Aggregate the entries of the history by domain or by day (in local
+    time), and return an identifier for the request.
+
+    The groups are reported asynchronously through the groupsReady() signal,
+    the group with the most recent visit first, each with its number of
+    entries and its most recently visited entry.
+*/
+int HistoryModel::queryGroups(Grouping grouping)
+{
+    Q_EMIT m_dbWorker->queryGroups(++m_lastRequestId, grouping);
+    return m_lastRequestId;
+}
+
+/*!
+    Read at most \a limit entries of a group, the most recent first, and
+    return an identifier for the request.
+
+    \a group is the domain (a string) or the day (a date) of the group.
+    \a cursor is empty to read the first entries of the group, or the
+    cursor reported with the previous page to read the next entries. The
+    entries are reported asynchronously through the groupEntriesReady()
+    signal, together with the cursor of the next page, which is empty if
+    there are no more entries.
+*/
+int HistoryModel::queryGroupEntries(Grouping grouping, const QVariant& group,
+                                    const QVariantList& cursor, int limit)
+{
+    QVariantList values;
+    if (grouping == GroupByDay) {
+        values = dayBounds(group.toDate());
     } else {
-        entry.domain = domain;
+        values << group.toString();
+    }
+    Q_EMIT m_dbWorker->queryGroupEntries(++m_lastRequestId, grouping, values, cursor, limit);
+    return m_lastRequestId;
+}
+
+void HistoryModel::onGroupEntriesQueried(int id, const QVector<HistoryEntry>& entries, const QVariantList& next)
+{
+    QVector<HistoryEntry> results(entries);
+    for (int i = 0; i < results.count(); ++i) {
+        results[i].hidden = m_hiddenEntries.contains(results.at(i).url);
+    }
+    Q_EMIT groupEntriesReady(id, results, next);
+}
+
+void HistoryModel::onFrecenciesUpdated(const QVariantHash& frecencies)
+{
+    QVariantHash::const_iterator i;
+    for (i = frecencies.constBegin(); i != frecencies.constEnd(); ++i) {
+        int index = getEntryIndex(QUrl(i.key()));
+        if (index != -1) {
+            entryAt(index).frecency = i.value().toDouble();
+            Q_EMIT dataChanged(this->index(index, 0), this->index(index, 0),
+                               QVector<int>() << Frecency);
+        }
     }
-    entry.title = title;
-    entry.icon = icon;
-    entry.visits = visits;
-    entry.lastVisit = lastVisit;
-    entry.hidden = m_hiddenEntries.contains(url);
-    int index = m_entries.count();
-    beginInsertRows(QModelIndex(), index, index);
-    m_entries.append(entry);
-    endInsertRows();
 }
 
 QHash<int, QByteArray> HistoryModel::roleNames() const
@@ -117,6 +524,7 @@ QHash<int, QByteArray> HistoryModel::roleNames() const
         roles[LastVisitDate] = "lastVisitDate";
         roles[LastVisitDateString] = "lastVisitDateString";
         roles[Hidden] = "hidden";
+        roles[Frecency] = "frecency";
     }
     return roles;
 }
@@ -124,7 +532,28 @@ QHash<int, QByteArray> HistoryModel::roleNames() const
 int HistoryModel::rowCount(const QModelIndex& parent) const
 {
     Q_UNUSED(parent);
-    return m_entries.count();
+    return m_rows.count();
+}
+
+bool HistoryModel::canFetchMore(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    return m_canFetchMore;
+}
+
+/*!
+    Request the next batch of entries from the database.
+
+    Entries are fetched asynchronously, so this returns immediately.
+    Requests made while a batch is already being fetched are ignored.
+*/
+void HistoryModel::fetchMore(const QModelIndex& parent)
+{
+    Q_UNUSED(parent);
+    if (m_canFetchMore && !m_fetching) {
+        m_fetching = true;
+        Q_EMIT m_dbWorker->fetchEntries(FETCH_BATCH_SIZE);
+    }
 }
 
 QVariant HistoryModel::data(const QModelIndex& index, int role) const
@@ -132,26 +561,28 @@ QVariant HistoryModel::data(const QModelIndex& index, int role) const
     if (!index.isValid()) {
         return QVariant();
     }
-    const HistoryEntry& entry = m_entries.at(index.row());
+    const StoredEntry& entry = entryAt(index.row());
     switch (role) {
     case Url:
         return entry.url;
     case Domain:
-        return entry.domain;
+        return m_domains.at(entry.domain);
     case Title:
         return entry.title;
     case Icon:
-        return entry.icon;
+        return m_icons.at(entry.icon);
     case Visits:
         return entry.visits;
     case LastVisit:
-        return entry.lastVisit;
+        return QDateTime::fromMSecsSinceEpoch(entry.lastVisit, Qt::UTC);
     case LastVisitDate:
-        return entry.lastVisit.toLocalTime().date();
+        return QDate::fromJulianDay(entry.day);
     case LastVisitDateString:
-        return entry.lastVisit.toLocalTime().date().toString(Qt::ISODate);
+        return m_dayStrings.value(entry.day);
     case Hidden:
         return entry.hidden;
+    case Frecency:
+        return entry.frecency;
     default:
         return QVariant();
     }
@@ -175,14 +606,157 @@ void HistoryModel::setDatabasePath(const QString& path)
     }
 }
 
+int HistoryModel::maxAge() const
+{
+    return m_maxAge;
+}
+
+void HistoryModel::setMaxAge(int days)
+{
+    if (days != m_maxAge) {
+        m_maxAge = days;
+        updateRetentionPolicy();
+        Q_EMIT maxAgeChanged();
+    }
+}
+
+int HistoryModel::maxCount() const
+{
+    return m_maxCount;
+}
+
+void HistoryModel::setMaxCount(int count)
+{
+    if (count != m_maxCount) {
+        m_maxCount = count;
+        updateRetentionPolicy();
+        Q_EMIT maxCountChanged();
+    }
+}
+
+int HistoryModel::maxDatabaseSize() const
+{
+    return m_maxDatabaseSize;
+}
+
+void HistoryModel::setMaxDatabaseSize(int kilobytes)
+{
+    if (kilobytes != m_maxDatabaseSize) {
+        m_maxDatabaseSize = kilobytes;
+        updateRetentionPolicy();
+        Q_EMIT maxDatabaseSizeChanged();
+    }
+}
+
+void HistoryModel::updateRetentionPolicy()
+{
+    Q_EMIT m_dbWorker->setRetentionPolicy(m_maxAge, m_maxCount, m_maxDatabaseSize);
+}
+
+HistoryModel::StoredEntry& HistoryModel::entryAt(int row)
+{
+    return m_entries[m_rows.itemAt(row)];
+}
+
+const HistoryModel::StoredEntry& HistoryModel::entryAt(int row) const
+{
+    return m_entries.at(m_rows.itemAt(row));
+}
+
+/*!
+    Return the row of the entry for \a url, or -1 if there is none.
+*/
 int HistoryModel::getEntryIndex(const QUrl& url) const
 {
-    for (int i = 0; i < m_entries.count(); ++i) {
-        if (m_entries.at(i).url == url) {
-            return i;
-        }
+    QHash<QUrl, int>::const_iterator i = m_urlIndex.constFind(url);
+    if (i == m_urlIndex.constEnd()) {
+        return -1;
+    }
+    return m_rows.rankOf(i.value());
+}
+
+/*
+    Remove the id at the given position of a group of an index, by moving the
+    last id of the group in its place, and return the id that was moved, or
+    -1 if the removed id was the last one.
+*/
+static int removeFromIndex(QHash<int, QVector<int>>& index, int key, int slot)
+{
+    QHash<int, QVector<int>>::iterator group = index.find(key);
+    if ((group == index.end()) || (slot < 0) || (slot >= group->count())) {
+        return -1;
+    }
+    int moved = group->takeLast();
+    if (slot < group->count()) {
+        (*group)[slot] = moved;
+    } else {
+        moved = -1;
+    }
+    if (group->isEmpty()) {
+        index.erase(group);
+    }
+    return moved;
+}
+
+void HistoryModel::indexEntry(int id)
+{
+    StoredEntry& entry = m_entries[id];
+    QVector<int>& domain = m_domainIndex[entry.domain];
+    entry.domainSlot = domain.count();
+    domain.append(id);
+    indexDay(id);
+}
+
+void HistoryModel::unindexEntry(int id)
+{
+    StoredEntry& entry = m_entries[id];
+    int moved = removeFromIndex(m_domainIndex, entry.domain, entry.domainSlot);
+    if (moved != -1) {
+        m_entries[moved].domainSlot = entry.domainSlot;
+    }
+    entry.domainSlot = -1;
+    unindexDay(id);
+}
+
+void HistoryModel::indexDay(int id)
+{
+    StoredEntry& entry = m_entries[id];
+    QVector<int>& date = m_dateIndex[entry.day];
+    entry.daySlot = date.count();
+    date.append(id);
+}
+
+void HistoryModel::unindexDay(int id)
+{
+    StoredEntry& entry = m_entries[id];
+    int moved = removeFromIndex(m_dateIndex, entry.day, entry.daySlot);
+    if (moved != -1) {
+        m_entries[moved].daySlot = entry.daySlot;
+    }
+    entry.daySlot = -1;
+}
+
+/*
+    Rebuild the domain and date indexes and cached days from scratch, and sort
+    the rows by last visit again, for subclasses that modify entries in place.
+*/
+void HistoryModel::rebuildIndexes()
+{
+    m_domainIndex.clear();
+    m_dateIndex.clear();
+    QVector<int> rows;
+    rows.reserve(m_rows.count());
+    for (int i = 0; i < m_rows.count(); ++i) {
+        int id = m_rows.itemAt(i);
+        StoredEntry& entry = m_entries[id];
+        entry.day = dayOf(entry.lastVisit);
+        indexEntry(id);
+        rows.append(id);
     }
-    return -1;
+    std::stable_sort(rows.begin(), rows.end(), [this] (int a, int b) {
+        return m_entries.at(a).lastVisit > m_entries.at(b).lastVisit;
+    });
+    m_rows.reset(rows);
 }
 
 /*!
@@ -198,70 +772,67 @@ int HistoryModel::add(const QUrl& url, const QString& title, const QUrl& icon)
     if (url.isEmpty()) {
         return 0;
     }
+    watchTimeZone();
     int count = 1;
-    QDateTime now = QDateTime::currentDateTimeUtc();
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
     int index = getEntryIndex(url);
     if (index == -1) {
-        HistoryEntry entry;
+        StoredEntry entry;
         entry.url = url;
-        entry.domain = DomainUtils::extractTopLevelDomainName(url);
         entry.title = title;
-        entry.icon = icon;
-        entry.visits = 1;
         entry.lastVisit = now;
+        // Until the visit is recorded, see onFrecenciesUpdated()
+        entry.frecency = 0;
+        entry.visits = 1;
+        entry.domain = internDomain(DomainUtils::extractTopLevelDomainName(url));
+        entry.icon = internIcon(icon);
+        entry.day = dayOf(now);
+        entry.domainSlot = -1;
+        entry.daySlot = -1;
         entry.hidden = m_hiddenEntries.contains(entry.url);
+        int id = insertEntry(entry);
         beginInsertRows(QModelIndex(), 0, 0);
-        m_entries.prepend(entry);
+        m_rows.prepend(id);
         endInsertRows();
         insertNewEntryInDatabase(entry);
+        recordVisitInDatabase(entry);
         Q_EMIT rowCountChanged();
     } else {
         QVector<int> roles;
         roles << Visits;
-        if (index == 0) {
-            HistoryEntry& entry = m_entries.first();
-            if (title != entry.title) {
-                entry.title = title;
-                roles << Title;
-            }
-            if (icon != entry.icon) {
-                entry.icon = icon;
-                roles << Icon;
-            }
-            count = ++entry.visits;
-            if (now != entry.lastVisit) {
-                if (now.date() != entry.lastVisit.date()) {
-                    roles << LastVisitDate;
-                    roles << LastVisitDateString;
-                }
-                entry.lastVisit = now;
-                roles << LastVisit;
-            }
-        } else {
+        int id = m_urlIndex.value(url);
+        if (index != 0) {
             beginMoveRows(QModelIndex(), index, index, QModelIndex(), 0);
-            HistoryEntry entry = m_entries.takeAt(index);
-            if (title != entry.title) {
-                entry.title = title;
-                roles << Title;
-            }
-            if (icon != entry.icon) {
-                entry.icon = icon;
-                roles << Icon;
-            }
-            count = ++entry.visits;
-            if (now != entry.lastVisit) {
-                if (now.date() != entry.lastVisit.date()) {
-                    roles << LastVisitDate;
-                    roles << LastVisitDateString;
-                }
-                entry.lastVisit = now;
-                roles << LastVisit;
+            m_rows.moveToFront(id);
+        }
+        StoredEntry& entry = m_entries[id];
+        if (title != entry.title) {
+            entry.title = title;
+            roles << Title;
+        }
+        if (icon != m_icons.at(entry.icon)) {
+            entry.icon = internIcon(icon);
+            roles << Icon;
+        }
+        count = ++entry.visits;
+        if (now != entry.lastVisit) {
+            int day = dayOf(now);
+            if (day != entry.day) {
+                roles << LastVisitDate;
+                roles << LastVisitDateString;
+                unindexDay(id);
+                entry.day = day;
+                indexDay(id);
             }
-            m_entries.prepend(entry);
+            entry.lastVisit = now;
+            roles << LastVisit;
+        }
+        if (index != 0) {
             endMoveRows();
         }
         Q_EMIT dataChanged(this->index(0, 0), this->index(0, 0), roles);
-        updateExistingEntryInDatabase(m_entries.first());
+        updateExistingEntryInDatabase(entry);
+        recordVisitInDatabase(entry);
     }
     return count;
 }
@@ -285,13 +856,13 @@ bool HistoryModel::update(const QUrl& url, const QString& title, const QUrl& ico
         return false;
     }
     QVector<int> roles;
-    const HistoryEntry& entry = m_entries.at(index);
+    StoredEntry& entry = entryAt(index);
     if (title != entry.title) {
-        m_entries[index].title = title;
+        entry.title = title;
         roles << Title;
     }
-    if (icon != entry.icon) {
-        m_entries[index].icon = icon;
+    if (icon != m_icons.at(entry.icon)) {
+        entry.icon = internIcon(icon);
         roles << Icon;
     }
     if (roles.isEmpty()) {
@@ -327,11 +898,7 @@ void HistoryModel::removeEntriesByDate(const QDate& date)
         return;
     }
 
-    for (int i = m_entries.count() - 1; i >= 0; --i) {
-        if (m_entries.at(i).lastVisit.toLocalTime().date() == date) {
-            removeByIndex(i);
-        }
-    }
+    removeEntries(m_dateIndex.value(date.toJulianDay()));
     removeEntriesFromDatabaseByDate(date);
     Q_EMIT rowCountChanged();
 }
@@ -345,10 +912,9 @@ void HistoryModel::removeEntriesByDomain(const QString& domain)
         return;
     }
 
-    for (int i = m_entries.count() - 1; i >= 0; --i) {
-        if (m_entries.at(i).domain == domain) {
-            removeByIndex(i);
-        }
+    QHash<QString, int>::const_iterator i = m_domainIds.constFind(domain);
+    if (i != m_domainIds.constEnd()) {
+        removeEntries(m_domainIndex.value(i.value()));
     }
     removeEntriesFromDatabaseByDomain(domain);
     Q_EMIT rowCountChanged();
@@ -357,20 +923,64 @@ void HistoryModel::removeEntriesByDomain(const QString& domain)
 void HistoryModel::removeByIndex(int index)
 {
     if (index >= 0) {
-        beginRemoveRows(QModelIndex(), index, index);
-        m_entries.removeAt(index);
-        endRemoveRows();
+        removeRange(index, index);
+    }
+}
+
+void HistoryModel::removeRange(int first, int last)
+{
+    QVector<int> ids;
+    ids.reserve(last - first + 1);
+    for (int row = first; row <= last; ++row) {
+        ids.append(m_rows.itemAt(row));
+    }
+    beginRemoveRows(QModelIndex(), first, last);
+    Q_FOREACH(int id, ids) {
+        m_rows.remove(id);
+        releaseEntry(id);
+    }
+    endRemoveRows();
+}
+
+/*
+    Remove the entries with the given ids, with one notification for each
+    block of contiguous rows rather than one for each row.
+*/
+void HistoryModel::removeEntries(const QVector<int>& ids)
+{
+    QVector<int> rows;
+    rows.reserve(ids.count());
+    Q_FOREACH(int id, ids) {
+        rows.append(m_rows.rankOf(id));
+    }
+    if (rows.isEmpty()) {
+        return;
+    }
+    std::sort(rows.begin(), rows.end());
+
+    QVector<QPair<int, int>> blocks;
+    Q_FOREACH(int row, rows) {
+        if (!blocks.isEmpty() && (blocks.last().second == row - 1)) {
+            blocks.last().second = row;
+        } else {
+            blocks.append(qMakePair(row, row));
+        }
+    }
+    // Remove the blocks from the last one, so that the rows of the blocks
+    // that remain to be removed don’t change
+    for (int i = blocks.count() - 1; i >= 0; --i) {
+        removeRange(blocks.at(i).first, blocks.at(i).second);
     }
 }
 
-void HistoryModel::insertNewEntryInDatabase(const HistoryEntry& entry)
+void HistoryModel::insertNewEntryInDatabase(const StoredEntry& entry)
 {
     QVariantList values;
     values << entry.url.toString();
-    values << entry.domain;
+    values << m_domains.at(entry.domain);
     values << entry.title;
-    values << entry.icon.toString();
-    values << entry.lastVisit.toTime_t();
+    values << m_icons.at(entry.icon).toString();
+    values << entry.lastVisit / 1000;
     Q_EMIT m_dbWorker->enqueue(DbWorker::InsertNewEntry, values);
 }
 
@@ -379,18 +989,26 @@ void HistoryModel::insertNewEntryInHiddenDatabase(const QUrl& url)
     Q_EMIT m_dbWorker->enqueue(DbWorker::InsertNewHiddenEntry, QVariantList() << url.toString());
 }
 
-void HistoryModel::updateExistingEntryInDatabase(const HistoryEntry& entry)
+void HistoryModel::updateExistingEntryInDatabase(const StoredEntry& entry)
 {
     QVariantList values;
-    values << entry.domain;
+    values << m_domains.at(entry.domain);
     values << entry.title;
-    values << entry.icon.toString();
+    values << m_icons.at(entry.icon).toString();
     values << entry.visits;
-    values << entry.lastVisit.toTime_t();
+    values << entry.lastVisit / 1000;
     values << entry.url.toString();
     Q_EMIT m_dbWorker->enqueue(DbWorker::UpdateExistingEntry, values);
 }
 
+void HistoryModel::recordVisitInDatabase(const StoredEntry& entry)
+{
+    QVariantList values;
+    values << entry.url.toString();
+    values << entry.lastVisit / 1000;
+    Q_EMIT m_dbWorker->enqueue(DbWorker::RecordVisit, values);
+}
+
 void HistoryModel::removeEntryFromDatabaseByUrl(const QUrl& url)
 {
     Q_EMIT m_dbWorker->enqueue(DbWorker::RemoveEntryByUrl, QVariantList() << url.toString());
@@ -403,12 +1021,7 @@ void HistoryModel::removeEntryFromHiddenDatabaseByUrl(const QUrl& url)
 
 void HistoryModel::removeEntriesFromDatabaseByDate(const QDate& date)
 {
-    QVariantList values;
-    QDateTime dateTime = QDateTime(date);
-    values << dateTime.toTime_t();
-    dateTime.setTime(QTime(23, 59, 59, 999));
-    values << dateTime.toTime_t();
-    Q_EMIT m_dbWorker->enqueue(DbWorker::RemoveEntriesByDate, values);
+    Q_EMIT m_dbWorker->enqueue(DbWorker::RemoveEntriesByDate, dayBounds(date));
 }
 
 void HistoryModel::removeEntriesFromDatabaseByDomain(const QString& domain)
@@ -418,10 +1031,9 @@ void HistoryModel::removeEntriesFromDatabaseByDomain(const QString& domain)
 
 void HistoryModel::clearAll()
 {
-    if (!m_entries.isEmpty()) {
+    if (m_rows.count() > 0) {
         beginResetModel();
-        m_hiddenEntries.clear();
-        m_entries.clear();
+        clearEntries();
         endResetModel();
         clearDatabase();
         Q_EMIT rowCountChanged();
@@ -448,16 +1060,12 @@ void HistoryModel::hide(const QUrl& url)
 
     m_hiddenEntries.insert(url);
 
-    QVector<int> roles;
-    roles << Hidden;
-
-    for (int i = 0; i < m_entries.count(); ++i) {
-        HistoryEntry& entry = m_entries[i];
-        if (entry.url == url) {
-            entry.hidden = true;
-            Q_EMIT dataChanged(this->index(i, 0), this->index(i, 0), roles);
-        }
-    }                                                                   
+    int index = getEntryIndex(url);
+    if (index != -1) {
+        entryAt(index).hidden = true;
+        Q_EMIT dataChanged(this->index(index, 0), this->index(index, 0),
+                           QVector<int>() << Hidden);
+    }
 
     insertNewEntryInHiddenDatabase(url);
 }
@@ -476,16 +1084,12 @@ void HistoryModel::unHide(const QUrl& url)
 
     m_hiddenEntries.remove(url);
 
-    QVector<int> roles;
-    roles << Hidden;
-
-    for (int i = 0; i < m_entries.count(); ++i) {
-        HistoryEntry& entry = m_entries[i];
-        if (entry.url == url) {
-            entry.hidden = false;
-            Q_EMIT dataChanged(this->index(i, 0), this->index(i, 0), roles);
-        }
-    }                                                                   
+    int index = getEntryIndex(url);
+    if (index != -1) {
+        entryAt(index).hidden = false;
+        Q_EMIT dataChanged(this->index(index, 0), this->index(index, 0),
+                           QVector<int>() << Hidden);
+    }
 
     removeEntryFromHiddenDatabaseByUrl(url);
 }
@@ -505,18 +1109,191 @@ QVariantMap HistoryModel::get(int i) const
     return item;
 }
 
+static bool createHistorySchema(QSqlDatabase& database)
+{
+    // Databases created before the schema was versioned may already have the
+    // tables, and the first version of the schema didn’t have a 'domain'
+    // column. Filling it in for all existing entries is done lazily.
+    return DatabaseUtils::exec(database, QStringList()
+               << QStringLiteral("CREATE TABLE IF NOT EXISTS history "
+                                 "(url VARCHAR, domain VARCHAR, title VARCHAR,"
+                                 " icon VARCHAR, visits INTEGER, lastVisit DATETIME);")
+               << QStringLiteral("CREATE TABLE IF NOT EXISTS history_hidden (url VARCHAR);"))
+        && DatabaseUtils::addColumnIfMissing(database, QStringLiteral("history"),
+                                             QStringLiteral("domain"), QStringLiteral("VARCHAR"));
+}
+
+static double visitFrecency(qint64 timestamp)
+{
+    return timestamp / FRECENCY_HALF_LIFE;
+}
+
+// Add frecencies, which are logarithms of sums of visit weights
+static double addFrecencies(double a, double b)
+{
+    double max = qMax(a, b);
+    return max + std::log2(1 + std::exp2(qMin(a, b) - max));
+}
+
+static bool indexHistory(QSqlDatabase& database)
+{
+    // The search index and the pagination cursors refer to entries by id,
+    // VACUUM may renumber rowids unless they are an explicit INTEGER PRIMARY
+    // KEY, so the table is rebuilt with one. Older versions of the model
+    // could store the same URL several times, only the most recent entry is
+    // kept before enforcing unique URLs.
+    if (!DatabaseUtils::exec(database, QStringList()
+            << QStringLiteral("CREATE TABLE history_new (id INTEGER PRIMARY KEY, url VARCHAR,"
+                              " domain VARCHAR, title VARCHAR, icon VARCHAR, visits INTEGER,"
+                              " lastVisit DATETIME, frecency REAL);")
+            << QStringLiteral("INSERT INTO history_new (id, url, domain, title, icon, visits, lastVisit) "
+                              "SELECT rowid, url, domain, title, icon, visits, lastVisit FROM history "
+                              "WHERE rowid IN (SELECT id FROM (SELECT rowid AS id, MAX(lastVisit) "
+                              "FROM history GROUP BY url));")
+            << QStringLiteral("DROP TABLE history;")
+            << QStringLiteral("ALTER TABLE history_new RENAME TO history;"))) {
+        return false;
+    }
+
+    // Only the number of visits and the last one are known for existing
+    // entries, assume that they all happened last.
+    QSqlQuery selectQuery(database);
+    selectQuery.setForwardOnly(true);
+    if (!selectQuery.exec(QStringLiteral("SELECT id, visits, lastVisit FROM history;"))) {
+        return false;
+    }
+    QSqlQuery updateQuery(database);
+    updateQuery.prepare(QStringLiteral("UPDATE history SET frecency=? WHERE id=?;"));
+    while (selectQuery.next()) {
+        int visits = qMax(selectQuery.value(1).toInt(), 1);
+        updateQuery.bindValue(0, visitFrecency(selectQuery.value(2).toLongLong()) + std::log2(visits));
+        updateQuery.bindValue(1, selectQuery.value(0));
+        if (!updateQuery.exec()) {
+            return false;
+        }
+    }
+
+    // Pages of the entries for a domain are read in the order of their
+    // last visit.
+    return DatabaseUtils::exec(database, QStringList()
+               << QStringLiteral("DELETE FROM history_hidden WHERE rowid NOT IN "
+                                 "(SELECT MIN(rowid) FROM history_hidden GROUP BY url);")
+               << QStringLiteral("CREATE UNIQUE INDEX history_url ON history (url);")
+               << QStringLiteral("CREATE INDEX history_lastVisit ON history (lastVisit);")
+               << QStringLiteral("CREATE INDEX history_domain_lastVisit ON history (domain, lastVisit);")
+               << QStringLiteral("CREATE INDEX history_frecency ON history (frecency);")
+               << QStringLiteral("CREATE UNIQUE INDEX history_hidden_url ON history_hidden (url);"));
+}
+
+/*
+    Create the full-text index of the URLs and titles of the entries, keyed
+    on their ids, and the triggers that keep it in sync with the history.
+    Return false if it couldn’t be created, which is the case when SQLite
+    has neither FTS5 nor FTS4, or if it couldn’t be filled.
+*/
+static bool createHistoryFullTextIndex(QSqlDatabase& database)
+{
+    // FTS5 is preferred, but older versions of SQLite only have FTS4. Both
+    // tokenize URLs and titles into words, ignoring case and diacritics.
+    if (!DatabaseUtils::exec(database, QStringLiteral("CREATE VIRTUAL TABLE history_fts "
+                                                      "USING fts5(url, title);")) &&
+        !DatabaseUtils::exec(database, QStringLiteral("CREATE VIRTUAL TABLE history_fts "
+                                                      "USING fts4(url, title, tokenize=unicode61);"))) {
+        return false;
+    }
+    // Entries are updated in place on every visit, they are only reindexed
+    // when their URL or title actually changes.
+    return DatabaseUtils::exec(database, QStringList()
+               << QStringLiteral("INSERT INTO history_fts (rowid, url, title) "
+                                 "SELECT id, url, title FROM history;")
+               << QStringLiteral("CREATE TRIGGER history_fts_insert AFTER INSERT ON history BEGIN "
+                                 "INSERT INTO history_fts (rowid, url, title) "
+                                 "VALUES (new.id, new.url, new.title); END;")
+               << QStringLiteral("CREATE TRIGGER history_fts_delete AFTER DELETE ON history BEGIN "
+                                 "DELETE FROM history_fts WHERE rowid = old.id; END;")
+               << QStringLiteral("CREATE TRIGGER history_fts_update AFTER UPDATE OF url, title ON history "
+                                 "WHEN old.url IS NOT new.url OR old.title IS NOT new.title BEGIN "
+                                 "UPDATE history_fts SET url = new.url, title = new.title "
+                                 "WHERE rowid = old.id; END;"));
+}
+
+static bool createHistorySearchIndex(QSqlDatabase& database)
+{
+    // Builds of SQLite without full-text search go without the index, rather
+    // than failing the migration and all the later ones. It is created once
+    // they have it, see DbWorker::doCreateOrAlterDatabaseSchema().
+    return createHistoryFullTextIndex(database) ||
+        !DatabaseUtils::hasTable(database, QStringLiteral("history_fts"));
+}
+
+static bool logHistoryVisits(QSqlDatabase& database)
+{
+    // Each row stands for a number of visits to a URL, one for the recent
+    // visits, more once they are aggregated by day, see
+    // DbWorker::aggregateVisits().
+    return DatabaseUtils::exec(database, QStringList()
+               << QStringLiteral("CREATE TABLE history_visits "
+                                 "(url VARCHAR, timestamp INTEGER, visits INTEGER NOT NULL DEFAULT 1);")
+               << QStringLiteral("CREATE INDEX history_visits_url ON history_visits (url);")
+               << QStringLiteral("CREATE INDEX history_visits_timestamp ON history_visits (timestamp);")
+               << QStringLiteral("CREATE TRIGGER history_visits_delete AFTER DELETE ON history BEGIN "
+                                 "DELETE FROM history_visits WHERE url = old.url; END;"));
+}
+
+// Read an entry from the columns url, domain, title, icon, visits, lastVisit
+// and frecency, starting at the given column.
+static HistoryModel::HistoryEntry readEntry(const QSqlQuery& query, int column)
+{
+    HistoryModel::HistoryEntry entry;
+    entry.url = query.value(column).toUrl();
+    entry.domain = query.value(column + 1).toString();
+    entry.title = query.value(column + 2).toString();
+    entry.icon = query.value(column + 3).toUrl();
+    if (entry.domain.isEmpty()) {
+        // Not backfilled yet, see DbWorker::doBackfillDomains()
+        entry.domain = DomainUtils::extractTopLevelDomainName(entry.url);
+    }
+    entry.visits = query.value(column + 4).toInt();
+    entry.lastVisit = QDateTime::fromTime_t(query.value(column + 5).toInt());
+    entry.hidden = false;
+    entry.frecency = query.value(column + 6).toDouble();
+    return entry;
+}
+
 DbWorker::DbWorker()
     : QObject()
+    , m_fetchStarted(false)
+    , m_fetchId(0)
     , m_flush(nullptr)
+    , m_backfill(nullptr)
+    , m_backfillId(0)
+    , m_maxAge(0)
+    , m_maxCount(0)
+    , m_maxDatabaseSize(0)
+    , m_pruneCutoff(0)
+    , m_prune(nullptr)
+    , m_searchAvailable(false)
 {
+    qRegisterMetaType<QList<QUrl> >("QList<QUrl>");
+    qRegisterMetaType<QVector<HistoryModel::HistoryEntry> >("QVector<HistoryModel::HistoryEntry>");
+    qRegisterMetaType<QVector<HistoryModel::HistoryGroup> >("QVector<HistoryModel::HistoryGroup>");
     // Ensure all database operations are performed on the same thread
     connect(this, SIGNAL(resetDatabase(const QString&)),
             SLOT(doResetDatabase(const QString&)), Qt::QueuedConnection);
-    connect(this, SIGNAL(fetchEntries()),
-            SLOT(doFetchEntries()), Qt::QueuedConnection);
+    connect(this, SIGNAL(fetchEntries(int)),
+            SLOT(doFetchEntries(int)), Qt::QueuedConnection);
     qRegisterMetaType<Operation>("Operation");
     connect(this, SIGNAL(enqueue(Operation, QVariantList)),
             SLOT(doEnqueue(Operation, QVariantList)), Qt::QueuedConnection);
+    connect(this, SIGNAL(setRetentionPolicy(int, int, int)),
+            SLOT(doSetRetentionPolicy(int, int, int)), Qt::QueuedConnection);
+    connect(this, SIGNAL(search(int, const QStringList&, int)),
+            SLOT(doSearch(int, const QStringList&, int)), Qt::QueuedConnection);
+    connect(this, SIGNAL(queryGroups(int, int)),
+            SLOT(doQueryGroups(int, int)), Qt::QueuedConnection);
+    connect(this, SIGNAL(queryGroupEntries(int, int, const QVariantList&, const QVariantList&, int)),
+            SLOT(doQueryGroupEntries(int, int, const QVariantList&, const QVariantList&, int)),
+            Qt::QueuedConnection);
 }
 
 DbWorker::~DbWorker()
@@ -526,7 +1303,19 @@ DbWorker::~DbWorker()
         delete m_flush;
         m_flush = nullptr;
     }
+    if (m_backfill) {
+        m_backfill->stop();
+        delete m_backfill;
+        m_backfill = nullptr;
+    }
+    if (m_prune) {
+        m_prune->stop();
+        delete m_prune;
+        m_prune = nullptr;
+    }
     doFlush();
+    discardPending();
+    m_statements.clear();
     if (m_database.isOpen()) {
         m_database.close();
     }
@@ -541,7 +1330,18 @@ void DbWorker::doResetDatabase(const QString& databaseName)
         delete m_flush;
         m_flush = nullptr;
     }
+    if (m_backfill) {
+        m_backfill->stop();
+    }
+    m_backfillId = 0;
+    if (m_prune) {
+        m_prune->stop();
+    }
+    m_pruneCutoff = 0;
     doFlush();
+    // Operations that could not be written don’t belong in the new database
+    discardPending();
+    m_statements.clear();
     if (m_database.isOpen()) {
         m_database.close();
     }
@@ -550,68 +1350,623 @@ void DbWorker::doResetDatabase(const QString& databaseName)
     }
     m_database.setDatabaseName(databaseName);
     m_database.open();
+    m_fetchStarted = false;
+    m_fetchLastVisit = QVariant();
+    m_fetchId = 0;
     doCreateOrAlterDatabaseSchema();
 }
 
 void DbWorker::doCreateOrAlterDatabaseSchema()
 {
-    QSqlQuery createQuery(m_database);
-    QString query = QStringLiteral("CREATE TABLE IF NOT EXISTS history "
-                                   "(url VARCHAR, domain VARCHAR, title VARCHAR,"
-                                   " icon VARCHAR, visits INTEGER, lastVisit DATETIME);");
-    createQuery.prepare(query);
-    createQuery.exec();
-
-    // The first version of the database schema didn't have a 'domain' column
-    QSqlQuery tableInfoQuery(m_database);
-    query = QStringLiteral("PRAGMA TABLE_INFO(history);");
-    tableInfoQuery.prepare(query);
-    tableInfoQuery.exec();
-    while (tableInfoQuery.next()) {
-        if (tableInfoQuery.value(QStringLiteral("name")).toString() == QStringLiteral("domain")) {
-            break;
+    // This only takes effect on new databases, existing ones are converted
+    // the next time they are vacuumed, see compact().
+    DatabaseUtils::exec(m_database, QStringLiteral("PRAGMA auto_vacuum=INCREMENTAL;"));
+    DatabaseUtils::enableWriteAheadLog(m_database);
+    DatabaseUtils::migrate(m_database, QList<DatabaseUtils::Migration>()
+                           << createHistorySchema
+                           << indexHistory
+                           << createHistorySearchIndex
+                           << logHistoryVisits);
+    m_searchAvailable = DatabaseUtils::hasTable(m_database, QStringLiteral("history_fts"));
+    if (!m_searchAvailable && DatabaseUtils::hasColumn(m_database, QStringLiteral("history"),
+                                                       QStringLiteral("id"))) {
+        // SQLite may have gained full-text search since the database was
+        // migrated, for example with a system upgrade
+        m_database.transaction();
+        m_searchAvailable = createHistoryFullTextIndex(m_database) && m_database.commit();
+        if (!m_searchAvailable) {
+            m_database.rollback();
+            qWarning() << "Full-text search is not available, history search scans all entries";
         }
     }
-    if (!tableInfoQuery.isValid()) {
-        QSqlQuery addDomainColumnQuery(m_database);
-        query = QStringLiteral("ALTER TABLE history ADD COLUMN domain VARCHAR;");
-        addDomainColumnQuery.prepare(query);
-        addDomainColumnQuery.exec();
-        // Updating all the entries in the database to add the domain is a
-        // costly operation that would slow down the application startup,
-        // do not do it here.
-    }
-
-    QSqlQuery createHiddenQuery(m_database);
-    query = QStringLiteral("CREATE TABLE IF NOT EXISTS history_hidden (url VARCHAR);");
-    createHiddenQuery.prepare(query);
-    createHiddenQuery.exec();
 }
 
-void DbWorker::doFetchEntries()
+void DbWorker::doFetchEntries(int count)
 {
-    QSqlQuery populateHiddenQuery(m_database);
-    QString query = QStringLiteral("SELECT url FROM history_hidden;");
-    populateHiddenQuery.prepare(query);
-    populateHiddenQuery.exec();
-    while (populateHiddenQuery.next()) {
-        Q_EMIT hiddenEntryFetched(populateHiddenQuery.value(0).toUrl());
+    // Pending removals must hit the database before the next batch is read,
+    // lest removed entries that were not loaded yet reappear in the model.
+    doFlush();
+
+    QString query;
+    if (!m_fetchStarted) {
+        QSqlQuery populateHiddenQuery(m_database);
+        query = QStringLiteral("SELECT url FROM history_hidden;");
+        populateHiddenQuery.prepare(query);
+        populateHiddenQuery.exec();
+        QList<QUrl> hidden;
+        while (populateHiddenQuery.next()) {
+            hidden.append(populateHiddenQuery.value(0).toUrl());
+        }
+        Q_EMIT hiddenEntriesFetched(hidden);
     }
 
+    // Paginate on (lastVisit, id) rather than with an offset, so that
+    // entries inserted, updated or removed in the meantime don’t shift the
+    // rows that remain to be fetched. The index on lastVisit implicitly ends
+    // with the id, so each batch is a range scan on that index.
     QSqlQuery populateQuery(m_database);
-    query = QStringLiteral("SELECT url, domain, title, icon, visits, lastVisit "
-                           "FROM history ORDER BY lastVisit DESC;");
-    populateQuery.prepare(query);
+    if (m_fetchStarted) {
+        query = QStringLiteral("SELECT id, url, domain, title, icon, visits, lastVisit, frecency "
+                               "FROM history WHERE lastVisit <= ? AND (lastVisit < ? OR id < ?) "
+                               "ORDER BY lastVisit DESC, id DESC LIMIT ?;");
+        populateQuery.prepare(query);
+        populateQuery.addBindValue(m_fetchLastVisit);
+        populateQuery.addBindValue(m_fetchLastVisit);
+        populateQuery.addBindValue(m_fetchId);
+    } else {
+        query = QStringLiteral("SELECT id, url, domain, title, icon, visits, lastVisit, frecency "
+                               "FROM history ORDER BY lastVisit DESC, id DESC LIMIT ?;");
+        populateQuery.prepare(query);
+    }
+    populateQuery.addBindValue(count);
+    populateQuery.setForwardOnly(true);
     populateQuery.exec();
+    m_fetchStarted = true;
+
+    QVector<HistoryModel::HistoryEntry> entries;
+    entries.reserve(count);
     while (populateQuery.next()) {
-        Q_EMIT entryFetched(populateQuery.value(0).toUrl(),
-                            populateQuery.value(1).toString(),
-                            populateQuery.value(2).toString(),
-                            populateQuery.value(3).toUrl(),
-                            populateQuery.value(4).toInt(),
-                            QDateTime::fromTime_t(populateQuery.value(5).toInt()));
+        entries.append(readEntry(populateQuery, 1));
+        m_fetchId = populateQuery.value(0).toLongLong();
+        m_fetchLastVisit = populateQuery.value(6);
+    }
+    bool more = (entries.count() == count);
+    Q_EMIT entriesFetched(entries, more);
+
+    if (!more) {
+        // Start filling in missing domains only once the model is populated
+        if (!m_backfill) {
+            m_backfill = new QTimer;
+            m_backfill->setInterval(0);
+            m_backfill->setSingleShot(true);
+            connect(m_backfill, SIGNAL(timeout()), SLOT(doBackfillDomains()));
+        }
+        m_backfill->start();
+        if (!m_prune) {
+            m_prune = new QTimer;
+            m_prune->setSingleShot(true);
+            connect(m_prune, SIGNAL(timeout()), SLOT(doPrune()));
+        }
+        m_prune->start(0);
+    }
+}
+
+/*
+    Fill in the domain of entries created by the first version of the schema,
+    which didn’t have a 'domain' column. This is done in small batches, each
+    in its own transaction, returning to the event loop between batches so
+    that other database operations are not delayed. Entries that were already
+    processed are not selected again, so after an interruption the work
+    resumes where it was left off, and it stops once all entries have a
+    domain.
+*/
+void DbWorker::doBackfillDomains()
+{
+    QSqlQuery selectQuery(m_database);
+    QString query = QStringLiteral("SELECT id, url FROM history "
+                                   "WHERE (domain IS NULL OR domain = '') AND id > ? "
+                                   "ORDER BY id LIMIT ?;");
+    selectQuery.prepare(query);
+    selectQuery.addBindValue(m_backfillId);
+    selectQuery.addBindValue(BACKFILL_BATCH_SIZE);
+    selectQuery.setForwardOnly(true);
+    selectQuery.exec();
+    QList<QPair<qint64, QString>> domains;
+    while (selectQuery.next()) {
+        m_backfillId = selectQuery.value(0).toLongLong();
+        QUrl url = selectQuery.value(1).toUrl();
+        domains.append(qMakePair(m_backfillId, DomainUtils::extractTopLevelDomainName(url)));
+    }
+    selectQuery.finish();
+    if (domains.isEmpty()) {
+        return;
+    }
+
+    m_database.transaction();
+    QSqlQuery* updateQuery = preparedStatement(QStringLiteral("UPDATE history SET domain=? WHERE id=?;"));
+    if (updateQuery) {
+        for (int i = 0; i < domains.count(); ++i) {
+            updateQuery->bindValue(0, domains.at(i).second);
+            updateQuery->bindValue(1, domains.at(i).first);
+            updateQuery->exec();
+        }
+    }
+    m_database.commit();
+
+    if (domains.count() == BACKFILL_BATCH_SIZE) {
+        m_backfill->start();
+    }
+}
+
+void DbWorker::doSetRetentionPolicy(int maxAge, int maxCount, int maxDatabaseSize)
+{
+    m_maxAge = maxAge;
+    m_maxCount = maxCount;
+    m_maxDatabaseSize = maxDatabaseSize;
+    // Pruning starts once the model is loaded, see doFetchEntries()
+    if (m_prune) {
+        m_pruneCutoff = 0;
+        m_prune->start(0);
+    }
+}
+
+/*
+    Return the timestamp before which entries must be removed to keep only
+    the given number of most recently visited entries, or 0 if there are
+    not more entries than that. Entries that share the timestamp of the
+    first entry to remove are removed as well.
+*/
+qint64 DbWorker::lastVisitAfter(int count)
+{
+    QSqlQuery query(m_database);
+    query.prepare(QStringLiteral("SELECT lastVisit FROM history "
+                                 "ORDER BY lastVisit DESC LIMIT 1 OFFSET ?;"));
+    query.addBindValue(count);
+    if (query.exec() && query.next()) {
+        return query.value(0).toLongLong() + 1;
+    }
+    return 0;
+}
+
+/*
+    Return the timestamp before which entries must be removed to satisfy the
+    retention policy, or 0 if no entry needs to be removed.
+*/
+qint64 DbWorker::pruneCutoff()
+{
+    qint64 cutoff = 0;
+    if (m_maxAge > 0) {
+        cutoff = QDateTime::currentDateTimeUtc().addDays(-m_maxAge).toTime_t();
+    }
+    if (m_maxCount > 0) {
+        cutoff = qMax(cutoff, lastVisitAfter(m_maxCount));
+    }
+    if (m_maxDatabaseSize > 0) {
+        // Free pages are reclaimed by compact(), they don’t count
+        qint64 pages = DatabaseUtils::pragmaValue(m_database, QStringLiteral("page_count")).toLongLong() -
+                       DatabaseUtils::pragmaValue(m_database, QStringLiteral("freelist_count")).toLongLong();
+        qint64 size = pages * DatabaseUtils::pragmaValue(m_database, QStringLiteral("page_size")).toLongLong();
+        qint64 maxSize = qint64(m_maxDatabaseSize) * 1024;
+        if (size > maxSize) {
+            QSqlQuery query(m_database);
+            if (query.exec(QStringLiteral("SELECT COUNT(*) FROM history;")) && query.next()) {
+                // Assume that all entries take up the same space
+                qint64 count = query.value(0).toLongLong();
+                cutoff = qMax(cutoff, lastVisitAfter(int(count * maxSize / size)));
+            }
+        }
+    }
+    if (cutoff > 0) {
+        QSqlQuery query(m_database);
+        if (!query.exec(QStringLiteral("SELECT MIN(lastVisit) FROM history;")) || !query.next() ||
+            query.value(0).isNull() || (query.value(0).toLongLong() >= cutoff)) {
+            return 0;
+        }
+    }
+    return cutoff;
+}
+
+/*
+    Remove the entries that don’t satisfy the retention policy.
+
+    The model is notified of the entries to remove right away, and they are
+    then deleted from the database in small batches, each in its own
+    transaction, returning to the event loop between batches so that other
+    database operations are not delayed. Once done, the free space is
+    reclaimed if there is a lot of it, and the policy is checked again
+    periodically.
+*/
+void DbWorker::doPrune()
+{
+    // Entries visited again since they were last written are not pruned
+    doFlush();
+
+    if (m_pruneCutoff == 0) {
+        m_pruneCutoff = pruneCutoff();
+        if (m_pruneCutoff > 0) {
+            Q_EMIT entriesPruned(QDateTime::fromTime_t(m_pruneCutoff));
+        }
+    }
+
+    int removed = 0;
+    if (m_pruneCutoff > 0) {
+        m_database.transaction();
+        QSqlQuery* query = preparedStatement(QStringLiteral("DELETE FROM history WHERE id IN "
+                                                            "(SELECT id FROM history WHERE lastVisit < ? LIMIT ?);"));
+        if (query) {
+            query->bindValue(0, m_pruneCutoff);
+            query->bindValue(1, PRUNE_BATCH_SIZE);
+            query->exec();
+            removed = query->numRowsAffected();
+        }
+        m_database.commit();
+    }
+
+    if (removed == PRUNE_BATCH_SIZE) {
+        m_prune->start(0);
+    } else {
+        m_pruneCutoff = 0;
+        aggregateVisits();
+        compact();
+        m_prune->start(PRUNE_INTERVAL);
+    }
+}
+
+/*
+    Merge the logged visits older than 90 days into one row per URL and per
+    day (in UTC), dated at the start of the day. Only the days that ended
+    before the cutoff are merged, so that each of them is merged once, and
+    rows dated at the start of a day are taken as already merged. Visits
+    of removed entries are removed with them by a trigger.
+*/
+void DbWorker::aggregateVisits()
+{
+    qint64 cutoff = QDateTime::currentDateTimeUtc().toTime_t() - VISITS_RETENTION;
+    cutoff -= cutoff % VISITS_AGGREGATION_PERIOD;
+    QString condition = QStringLiteral("timestamp < %1 AND timestamp % %2 != 0")
+        .arg(cutoff).arg(VISITS_AGGREGATION_PERIOD);
+    m_database.transaction();
+    bool aggregated = DatabaseUtils::exec(m_database, QStringList()
+        << QStringLiteral("INSERT INTO history_visits (url, timestamp, visits) "
+                          "SELECT url, timestamp - timestamp % %1, SUM(visits) FROM history_visits "
+                          "WHERE %2 GROUP BY url, timestamp / %1;")
+               .arg(VISITS_AGGREGATION_PERIOD).arg(condition)
+        << QStringLiteral("DELETE FROM history_visits WHERE %1;").arg(condition));
+    if (!aggregated || !m_database.commit()) {
+        m_database.rollback();
+    }
+}
+
+/*
+    Log a visit and update the frecency of the visited entry, which is
+    reported to the model once the flush completes.
+*/
+void DbWorker::recordVisit(const QVariantList& values)
+{
+    QString url = values.at(0).toString();
+    qint64 timestamp = values.at(1).toLongLong();
+    QSqlQuery* insertQuery = preparedStatement(QStringLiteral("INSERT INTO history_visits "
+                                                              "(url, timestamp) VALUES (?, ?);"));
+    QSqlQuery* selectQuery = preparedStatement(QStringLiteral("SELECT frecency FROM history WHERE url=?;"));
+    QSqlQuery* updateQuery = preparedStatement(QStringLiteral("UPDATE history SET frecency=? WHERE url=?;"));
+    if (!insertQuery || !selectQuery || !updateQuery) {
+        return;
+    }
+    insertQuery->bindValue(0, url);
+    insertQuery->bindValue(1, timestamp);
+    insertQuery->exec();
+
+    selectQuery->bindValue(0, url);
+    if (!selectQuery->exec() || !selectQuery->next()) {
+        selectQuery->finish();
+        return;
+    }
+    double frecency = visitFrecency(timestamp);
+    if (!selectQuery->value(0).isNull()) {
+        frecency = addFrecencies(selectQuery->value(0).toDouble(), frecency);
+    }
+    selectQuery->finish();
+    updateQuery->bindValue(0, frecency);
+    updateQuery->bindValue(1, url);
+    updateQuery->exec();
+    m_frecencies.insert(url, frecency);
+}
+
+/*
+    Return free pages to the file system once they make up a significant
+    part of the database. Databases created with incremental auto-vacuum
+    release them cheaply, others are vacuumed in full, which also converts
+    them to incremental auto-vacuum.
+*/
+void DbWorker::compact()
+{
+    qint64 pages = DatabaseUtils::pragmaValue(m_database, QStringLiteral("page_count")).toLongLong();
+    qint64 free = DatabaseUtils::pragmaValue(m_database, QStringLiteral("freelist_count")).toLongLong();
+    if ((free == 0) || (free * 4 < pages)) {
+        return;
+    }
+    // Vacuuming fails while statements are pending
+    m_statements.clear();
+    if (DatabaseUtils::pragmaValue(m_database, QStringLiteral("auto_vacuum")).toInt() == 2) {
+        // Each step of the statement releases one page
+        QSqlQuery query(m_database);
+        query.exec(QStringLiteral("PRAGMA incremental_vacuum;"));
+        while (query.next()) {}
+    } else {
+        DatabaseUtils::exec(m_database, QStringLiteral("VACUUM;"));
+    }
+}
+
+/* Whether text contains term at the start of a word, ignoring case */
+static bool containsWordPrefix(const QString& text, const QString& term)
+{
+    for (int i = text.indexOf(term, 0, Qt::CaseInsensitive); i != -1;
+         i = text.indexOf(term, i + 1, Qt::CaseInsensitive)) {
+        if ((i == 0) || !text.at(i - 1).isLetterOrNumber()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+    How well an entry matches the terms, as a bonus added to its frecency.
+    All the terms match, so the weakest match counts.
+*/
+static double matchBonus(const HistoryModel::HistoryEntry& entry, const QStringList& terms)
+{
+    QString url = entry.url.toString();
+    int start = url.indexOf(QLatin1String("://"));
+    start = (start == -1) ? 0 : start + 3;
+    if (url.midRef(start).startsWith(QLatin1String("www."), Qt::CaseInsensitive)) {
+        start += 4;
+    }
+    QStringRef address = url.midRef(start);
+    double bonus = ADDRESS_PREFIX_BONUS;
+    Q_FOREACH(const QString& term, terms) {
+        if (address.startsWith(term, Qt::CaseInsensitive)) {
+            continue;
+        } else if (containsWordPrefix(url, term) || containsWordPrefix(entry.title, term)) {
+            bonus = qMin(bonus, WORD_PREFIX_BONUS);
+        } else {
+            return 0;
+        }
+    }
+    return bonus;
+}
+
+struct ScoredEntry {
+    double score;
+    // Rank by frecency, which breaks ties
+    int rank;
+    HistoryModel::HistoryEntry entry;
+};
+
+static bool isBetter(const ScoredEntry& a, const ScoredEntry& b)
+{
+    return (a.score > b.score) || ((a.score == b.score) && (a.rank < b.rank));
+}
+
+void DbWorker::doSearch(int id, const QStringList& terms, int limit)
+{
+    // Searches must take into account the latest changes
+    doFlush();
+
+    // Match words that start with each of the terms. Terms are split the
+    // same way the index splits words, which also keeps characters that
+    // have a meaning in the full-text query syntax out of the query.
+    static const QRegularExpression separators(QStringLiteral("[\\W_]+"),
+                                               QRegularExpression::UseUnicodePropertiesOption);
+    QStringList words;
+    QStringList matchedTerms;
+    Q_FOREACH(const QString& term, terms) {
+        QStringList termWords = term.toLower().split(separators, QString::SkipEmptyParts);
+        words.append(termWords);
+        if (!termWords.isEmpty()) {
+            matchedTerms.append(term.trimmed());
+        }
+    }
+
+    QSqlQuery* query = nullptr;
+    if (words.isEmpty() || (limit <= 0)) {
+        // Nothing to search for
+    } else if (m_searchAvailable) {
+        query = preparedStatement(QStringLiteral(
+            "SELECT history.url, domain, history.title, icon, visits, lastVisit, frecency "
+            "FROM history_fts JOIN history ON history.id = history_fts.rowid "
+            "WHERE history_fts MATCH ? ORDER BY frecency DESC;"));
+        if (query) {
+            QStringList tokens;
+            Q_FOREACH(const QString& word, words) {
+                tokens.append(word + QLatin1Char('*'));
+            }
+            query->bindValue(0, tokens.join(QLatin1Char(' ')));
+        }
+    } else {
+        // Without the index, scan all the entries for the words anywhere in
+        // their URL or title, ignoring case for ASCII characters only. Words
+        // are made of letters and digits, so they contain no wildcard.
+        QStringList conditions;
+        for (int i = 0; i < words.count(); ++i) {
+            conditions.append(QStringLiteral("(url LIKE ? OR title LIKE ?)"));
+        }
+        query = preparedStatement(QStringLiteral(
+            "SELECT url, domain, title, icon, visits, lastVisit, frecency FROM history "
+            "WHERE %1 ORDER BY frecency DESC;").arg(conditions.join(QStringLiteral(" AND "))));
+        if (query) {
+            for (int i = 0; i < words.count(); ++i) {
+                QString pattern = QLatin1Char('%') + words.at(i) + QLatin1Char('%');
+                query->bindValue(2 * i, pattern);
+                query->bindValue(2 * i + 1, pattern);
+            }
+        }
+    }
+
+    // Candidates are read by decreasing frecency, and the best results so
+    // far kept in a heap, the worst on top. No candidate can make it to the
+    // results once the worst of them beats the frecency of the next
+    // candidate plus the highest bonus, so the remaining ones are skipped.
+    QVector<ScoredEntry> heap;
+    if (query) {
+        query->exec();
+        heap.reserve(limit);
+        for (int rank = 0; query->next(); ++rank) {
+            double frecency = query->value(6).toDouble();
+            if ((heap.count() == limit) &&
+                (heap.first().score >= frecency + ADDRESS_PREFIX_BONUS)) {
+                break;
+            }
+            ScoredEntry candidate;
+            candidate.entry = readEntry(*query, 0);
+            candidate.score = frecency + matchBonus(candidate.entry, matchedTerms);
+            candidate.rank = rank;
+            if (heap.count() < limit) {
+                heap.append(candidate);
+                std::push_heap(heap.begin(), heap.end(), isBetter);
+            } else if (isBetter(candidate, heap.first())) {
+                std::pop_heap(heap.begin(), heap.end(), isBetter);
+                heap.last() = candidate;
+                std::push_heap(heap.begin(), heap.end(), isBetter);
+            }
+        }
+        query->finish();
+    }
+    std::sort(heap.begin(), heap.end(), isBetter);
+    QVector<HistoryModel::HistoryEntry> results;
+    results.reserve(heap.count());
+    Q_FOREACH(const ScoredEntry& result, heap) {
+        results.append(result.entry);
+    }
+    Q_EMIT searchResults(id, results);
+}
+
+void DbWorker::doQueryGroups(int id, int grouping)
+{
+    // Queries must take into account the latest changes
+    doFlush();
+
+    // Groups are read in one query, the most recent first, each with the
+    // most recently visited of its entries, which is looked up the same way
+    // as the first page of its entries so that ties are broken consistently.
+    // Days are computed in local time, as in the model. Rather than grouping
+    // all entries by an expression, which no index covers, the query skips
+    // from the most recent visit of a day to the most recent visit before
+    // its start, so that the days, their counts and their entries are all
+    // read from the index on the last visit.
+    QSqlQuery* query = preparedStatement((grouping == HistoryModel::GroupByDay)
+        ? QStringLiteral("WITH RECURSIVE days(lastVisit) AS ("
+                         " SELECT MAX(lastVisit) FROM history"
+                         " UNION ALL"
+                         " SELECT (SELECT MAX(lastVisit) FROM history WHERE lastVisit < "
+                         "  CAST(strftime('%s', days.lastVisit, 'unixepoch', 'localtime', 'start of day', 'utc') AS INTEGER))"
+                         " FROM days WHERE days.lastVisit IS NOT NULL"
+                         "), bounds AS ("
+                         " SELECT lastVisit,"
+                         "  CAST(strftime('%s', lastVisit, 'unixepoch', 'localtime', 'start of day', 'utc') AS INTEGER) AS dayStart,"
+                         "  CAST(strftime('%s', lastVisit, 'unixepoch', 'localtime', 'start of day', '+1 day', 'utc') AS INTEGER) - 1 AS dayEnd"
+                         " FROM days WHERE lastVisit IS NOT NULL"
+                         ") "
+                         "SELECT bounds.dayStart,"
+                         " (SELECT COUNT(*) FROM history WHERE lastVisit BETWEEN bounds.dayStart AND bounds.dayEnd),"
+                         " url, domain, title, icon, visits, history.lastVisit, frecency "
+                         "FROM bounds JOIN history ON history.id = "
+                         " (SELECT id FROM history AS latest WHERE latest.lastVisit = bounds.lastVisit "
+                         "  ORDER BY id DESC LIMIT 1) "
+                         "ORDER BY bounds.lastVisit DESC;")
+        : QStringLiteral("SELECT grouped.domain, grouped.count,"
+                         " url, history.domain, title, icon, visits, lastVisit, frecency "
+                         "FROM (SELECT domain, COUNT(*) AS count FROM history GROUP BY domain) AS grouped "
+                         "JOIN history ON history.id = "
+                         " (SELECT id FROM history AS latest WHERE latest.domain IS grouped.domain "
+                         "  ORDER BY latest.lastVisit DESC, latest.id DESC LIMIT 1) "
+                         "ORDER BY history.lastVisit DESC, history.id DESC;"));
+    QVector<HistoryModel::HistoryGroup> groups;
+    int unknownDomain = -1;
+    if (query) {
+        query->exec();
+        while (query->next()) {
+            HistoryModel::HistoryGroup group;
+            group.count = query->value(1).toInt();
+            if (grouping == HistoryModel::GroupByDay) {
+                group.lastVisitDate = QDateTime::fromTime_t(query->value(0).toUInt()).date();
+            } else {
+                group.domain = query->value(0).toString();
+                if (group.domain.isEmpty()) {
+                    // NULL and empty domains (not backfilled yet) are one
+                    // group, which comes where the most recent of them does
+                    if (unknownDomain != -1) {
+                        groups[unknownDomain].count += group.count;
+                        continue;
+                    }
+                    unknownDomain = groups.count();
+                }
+            }
+            group.lastVisited = readEntry(*query, 2);
+            groups.append(group);
+        }
+        query->finish();
+    }
+    Q_EMIT groupsQueried(id, groups);
+}
+
+void DbWorker::doQueryGroupEntries(int id, int grouping, const QVariantList& group,
+                                   const QVariantList& cursor, int limit)
+{
+    doFlush();
+
+    QVariantList next;
+    QVector<HistoryModel::HistoryEntry> entries =
+        readGroupEntries(grouping, group, cursor, limit, &next);
+    if (entries.count() < limit) {
+        next.clear();
     }
-    Q_EMIT loaded();
+    Q_EMIT groupEntriesQueried(id, entries, next);
+}
+
+/*
+    Read at most limit entries of a group (given by the bounds of a day or by
+    a domain), the most recent first, starting after the given cursor. The
+    cursor of the last entry read is stored in last.
+*/
+QVector<HistoryModel::HistoryEntry> DbWorker::readGroupEntries(int grouping, const QVariantList& group,
+                                                               const QVariantList& cursor, int limit,
+                                                               QVariantList* last)
+{
+    QVariantList values;
+    QString condition;
+    if (grouping == HistoryModel::GroupByDay) {
+        condition = QStringLiteral("lastVisit BETWEEN ? AND ?");
+        values << group;
+    } else if (group.first().toString().isEmpty()) {
+        // Entries whose domain was not backfilled yet
+        condition = QStringLiteral("(domain IS NULL OR domain = '')");
+    } else {
+        condition = QStringLiteral("domain = ?");
+        values << group;
+    }
+    if (!cursor.isEmpty()) {
+        // Same keyset pagination as doFetchEntries()
+        condition += QStringLiteral(" AND lastVisit <= ? AND (lastVisit < ? OR id < ?)");
+        values << cursor.at(0) << cursor.at(0) << cursor.at(1);
+    }
+    values << limit;
+
+    QVector<HistoryModel::HistoryEntry> entries;
+    QSqlQuery* query = preparedStatement(QStringLiteral(
+        "SELECT id, url, domain, title, icon, visits, lastVisit, frecency FROM history "
+        "WHERE %1 ORDER BY lastVisit DESC, id DESC LIMIT ?;").arg(condition));
+    if (query) {
+        for (int i = 0; i < values.count(); ++i) {
+            query->bindValue(i, values.at(i));
+        }
+        query->exec();
+        while (query->next()) {
+            entries.append(readEntry(*query, 1));
+            *last = QVariantList() << query->value(6) << query->value(0);
+        }
+        query->finish();
+    }
+    return entries;
 }
 
 void DbWorker::doEnqueue(DbWorker::Operation operation, QVariantList values)
@@ -627,19 +1982,175 @@ void DbWorker::doEnqueue(DbWorker::Operation operation, QVariantList values)
     m_flush->start();
 }
 
+static QString affectedTable(const QPair<DbWorker::Operation, QVariantList>& operation)
+{
+    switch (operation.first) {
+    case DbWorker::InsertNewHiddenEntry:
+    case DbWorker::RemoveHiddenEntryByUrl:
+        return QStringLiteral("history_hidden");
+    case DbWorker::Clear:
+        return operation.second.first().toString();
+    default:
+        return QStringLiteral("history");
+    }
+}
+
+/*
+    Drop pending operations whose effect is cancelled or superseded by a later
+    operation in the queue, and return the number of operations dropped.
+*/
+int DbWorker::coalescePending()
+{
+    QVector<bool> dropped(m_pending.count(), false);
+    QHash<QString, int> inserts;
+    QHash<QString, int> updates;
+    QHash<QString, int> hiddenInserts;
+    QMultiHash<QString, int> visits;
+    for (int i = 0; i < m_pending.count(); ++i) {
+        const QPair<Operation, QVariantList>& operation = m_pending.at(i);
+        switch (operation.first) {
+        case InsertNewEntry:
+            inserts.insert(operation.second.at(0).toString(), i);
+            break;
+        case UpdateExistingEntry: {
+            // An update overwrites all the columns of an entry, so it
+            // supersedes any previous update to the same URL.
+            QString url = operation.second.at(5).toString();
+            if (updates.contains(url)) {
+                dropped[updates.value(url)] = true;
+            }
+            updates.insert(url, i);
+            break;
+        }
+        case RemoveEntryByUrl: {
+            // The removal itself is kept, as the database may already
+            // contain entries for the URL.
+            QString url = operation.second.at(0).toString();
+            if (updates.contains(url)) {
+                dropped[updates.take(url)] = true;
+            }
+            if (inserts.contains(url)) {
+                dropped[inserts.take(url)] = true;
+            }
+            // Visits to an entry that was not written yet would be left
+            // dangling in the log.
+            Q_FOREACH(int j, visits.values(url)) {
+                dropped[j] = true;
+            }
+            visits.remove(url);
+            break;
+        }
+        case InsertNewHiddenEntry:
+            hiddenInserts.insert(operation.second.at(0).toString(), i);
+            break;
+        case RemoveHiddenEntryByUrl: {
+            QString url = operation.second.at(0).toString();
+            if (hiddenInserts.contains(url)) {
+                dropped[hiddenInserts.take(url)] = true;
+            }
+            break;
+        }
+        case RemoveEntriesByDate:
+        case RemoveEntriesByDomain:
+            // Which entries match depends on the updates that precede the
+            // removal, so updates must not be coalesced across it.
+            inserts.clear();
+            updates.clear();
+            visits.clear();
+            break;
+        case Clear: {
+            QString table = operation.second.at(0).toString();
+            for (int j = 0; j < i; ++j) {
+                if (affectedTable(m_pending.at(j)) == table) {
+                    dropped[j] = true;
+                }
+            }
+            if (table == QStringLiteral("history_hidden")) {
+                hiddenInserts.clear();
+            } else {
+                inserts.clear();
+                updates.clear();
+                visits.clear();
+            }
+            break;
+        }
+        case RecordVisit:
+            visits.insert(operation.second.at(0).toString(), i);
+            break;
+        default:
+            Q_UNREACHABLE();
+        }
+    }
+
+    int count = 0;
+    QQueue<QPair<Operation, QVariantList>> pending;
+    for (int i = 0; i < m_pending.count(); ++i) {
+        if (dropped.at(i)) {
+            ++count;
+        } else {
+            pending.enqueue(m_pending.at(i));
+        }
+    }
+    m_pending.swap(pending);
+    return count;
+}
+
+/*
+    Drop the operations left over by a flush that failed, reporting them.
+*/
+void DbWorker::discardPending()
+{
+    QWriteLocker locker(&m_lock);
+    if (!m_pending.isEmpty()) {
+        qWarning() << "Discarding" << m_pending.count() << "history operations"
+                   << "that could not be written to" << m_database.databaseName();
+        m_pending.clear();
+    }
+}
+
+QSqlQuery* DbWorker::preparedStatement(const QString& statement)
+{
+    QHash<QString, QSqlQuery>::iterator i = m_statements.find(statement);
+    if (i == m_statements.end()) {
+        QSqlQuery query(m_database);
+        if (!query.prepare(statement)) {
+            return nullptr;
+        }
+        i = m_statements.insert(statement, query);
+    }
+    return &i.value();
+}
+
 void DbWorker::doFlush()
 {
     QWriteLocker locker(&m_lock);
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    int queued = m_pending.count();
+    int coalesced = coalescePending();
+
+    // Group all the operations in one transaction, so that the journal is
+    // synced to disk once per flush rather than once per operation. If it
+    // can’t be committed, the operations are queued again for the next
+    // flush.
+    bool transaction = m_database.transaction();
+    bool cleared = false;
+    QQueue<QPair<Operation, QVariantList>> flushed;
     while (!m_pending.isEmpty()) {
         QPair<Operation, QVariantList> args = m_pending.dequeue();
+        flushed.enqueue(args);
         QString statement;
         switch (args.first) {
         case InsertNewEntry:
-            statement = QStringLiteral("INSERT INTO history (url, domain, title, icon, "
+            statement = QStringLiteral("INSERT OR IGNORE INTO history (url, domain, title, icon, "
                                        "visits, lastVisit) VALUES (?, ?, ?, ?, 1, ?);");
             break;
         case InsertNewHiddenEntry:
-            statement = QStringLiteral("INSERT INTO history_hidden (url) VALUES (?);");
+            statement = QStringLiteral("INSERT OR IGNORE INTO history_hidden (url) VALUES (?);");
             break;
         case UpdateExistingEntry:
             statement = QStringLiteral("UPDATE history SET domain=?, title=?, icon=?, "
@@ -659,20 +2170,71 @@ void DbWorker::doFlush()
             break;
         case Clear:
             statement = QStringLiteral("DELETE FROM %1;").arg(args.second.takeFirst().toString());
+            cleared = true;
             break;
+        case RecordVisit:
+            recordVisit(args.second);
+            continue;
         default:
             Q_UNREACHABLE();
         }
-        if (statement.isEmpty()) {
-            return;
-        }
-        QSqlQuery query(m_database);
-        if (!query.prepare(statement)) {
+        QSqlQuery* query = preparedStatement(statement);
+        if (!query) {
             continue;
         }
-        Q_FOREACH(const QVariant& value, args.second) {
-            query.addBindValue(value);
+        for (int i = 0; i < args.second.count(); ++i) {
+            query->bindValue(i, args.second.at(i));
         }
-        query.exec();
+        query->exec();
+        if ((args.first == InsertNewEntry) && (query->numRowsAffected() == 0)) {
+            // URLs are unique, and the model may insert an entry that exists
+            // in the database but was not fetched yet. Update it in place,
+            // replacing the row would drop its visits and frecency.
+            QSqlQuery* updateQuery = preparedStatement(QStringLiteral(
+                "UPDATE history SET domain=?, title=?, icon=?, visits=visits+1, "
+                "lastVisit=? WHERE url=?;"));
+            if (updateQuery) {
+                for (int i = 1; i < args.second.count(); ++i) {
+                    updateQuery->bindValue(i - 1, args.second.at(i));
+                }
+                updateQuery->bindValue(args.second.count() - 1, args.second.at(0));
+                updateQuery->exec();
+            }
+        } else if ((args.first == UpdateExistingEntry) && (query->numRowsAffected() == 0)) {
+            // The entry was pruned from the database after it was visited
+            // again, write it back.
+            QSqlQuery* insertQuery = preparedStatement(QStringLiteral(
+                "INSERT INTO history (domain, title, icon, visits, lastVisit, url) "
+                "VALUES (?, ?, ?, ?, ?, ?);"));
+            if (insertQuery) {
+                for (int i = 0; i < args.second.count(); ++i) {
+                    insertQuery->bindValue(i, args.second.at(i));
+                }
+                insertQuery->exec();
+            }
+        }
+    }
+    if (transaction && !m_database.commit()) {
+        qWarning() << "Failed to write" << flushed.count() << "history operations,"
+                   << "will retry:" << m_database.lastError().text();
+        m_database.rollback();
+        // The frecencies are computed again when the visits are retried
+        m_frecencies.clear();
+        flushed.append(m_pending);
+        m_pending = flushed;
+        if (m_flush) {
+            m_flush->start();
+        }
+        return;
+    }
+    if (!m_frecencies.isEmpty()) {
+        Q_EMIT frecenciesUpdated(m_frecencies);
+        m_frecencies.clear();
     }
+    if (cleared && m_prune) {
+        // Reclaim the space freed by clearing the history
+        m_prune->start(0);
+    }
+
+    Q_EMIT flushed(queued, coalesced, timer.elapsed());
 }
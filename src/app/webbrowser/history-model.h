@@ -21,17 +21,25 @@
 
 // Qt
 #include <QtCore/QAbstractListModel>
+#include <QtCore/QByteArray>
+#include <QtCore/QDate>
 #include <QtCore/QDateTime>
+#include <QtCore/QHash>
 #include <QtCore/QList>
 #include <QtCore/QPair>
 #include <QtCore/QQueue>
 #include <QtCore/QReadWriteLock>
 #include <QtCore/QSet>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 #include <QtCore/QThread>
 #include <QtCore/QUrl>
 #include <QtCore/QVariant>
+#include <QtCore/QVector>
 #include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
+
+#include "rank-index.h"
 
 class QTimer;
 
@@ -43,8 +51,11 @@ class HistoryModel : public QAbstractListModel
 
     Q_PROPERTY(QString databasePath READ databasePath WRITE setDatabasePath NOTIFY databasePathChanged)
     Q_PROPERTY(int count READ rowCount NOTIFY rowCountChanged)
+    Q_PROPERTY(int maxAge READ maxAge WRITE setMaxAge NOTIFY maxAgeChanged)
+    Q_PROPERTY(int maxCount READ maxCount WRITE setMaxCount NOTIFY maxCountChanged)
+    Q_PROPERTY(int maxDatabaseSize READ maxDatabaseSize WRITE setMaxDatabaseSize NOTIFY maxDatabaseSizeChanged)
 
-    Q_ENUMS(Roles)
+    Q_ENUMS(Roles Grouping)
 
 public:
     HistoryModel(QObject* parent=0);
@@ -60,16 +71,70 @@ public:
         LastVisitDate,
         LastVisitDateString,
         Hidden,
+        Frecency,
+    };
+
+    enum Grouping {
+        GroupByDomain,
+        GroupByDay,
+    };
+
+    struct HistoryEntry {
+        QUrl url;
+        QString domain;
+        QString title;
+        QUrl icon;
+        uint visits;
+        QDateTime lastVisit;
+        bool hidden;
+        double frecency;
+    };
+
+    // Aggregate of the entries for one domain or one day (in local time)
+    struct HistoryGroup {
+        QString domain;
+        QDate lastVisitDate;
+        int count;
+        HistoryEntry lastVisited;
+    };
+
+    // In-memory representation of an entry: the domain and icon are ids in
+    // tables shared by all the entries, the last visit is a timestamp in
+    // milliseconds since the Unix epoch, and its day (in local time) is
+    // cached as a Julian day number. The positions of the entry in the
+    // domain and date indexes are kept so that it can be unindexed in
+    // constant time.
+    struct StoredEntry {
+        QUrl url;
+        QString title;
+        qint64 lastVisit;
+        double frecency;
+        uint visits;
+        int domain;
+        int icon;
+        int day;
+        int domainSlot;
+        int daySlot;
+        bool hidden;
     };
 
     // reimplemented from QAbstractListModel
     QHash<int, QByteArray> roleNames() const;
     int rowCount(const QModelIndex& parent=QModelIndex()) const;
     QVariant data(const QModelIndex& index, int role) const;
+    bool canFetchMore(const QModelIndex& parent=QModelIndex()) const;
+    void fetchMore(const QModelIndex& parent=QModelIndex());
 
     const QString databasePath() const;
     void setDatabasePath(const QString& path);
 
+    int maxAge() const;
+    void setMaxAge(int days);
+    int maxCount() const;
+    void setMaxCount(int count);
+    int maxDatabaseSize() const;
+    void setMaxDatabaseSize(int kilobytes);
+
     Q_INVOKABLE int add(const QUrl& url, const QString& title, const QUrl& icon);
     Q_INVOKABLE bool update(const QUrl& url, const QString& title, const QUrl& icon);
     Q_INVOKABLE void removeEntryByUrl(const QUrl& url);
@@ -80,43 +145,100 @@ public:
     Q_INVOKABLE void unHide(const QUrl& url);
     Q_INVOKABLE QVariantMap get(int index) const;
 
+    int getEntryIndex(const QUrl& url) const;
+    int search(const QStringList& terms, int limit);
+    int queryGroups(Grouping grouping);
+    int queryGroupEntries(Grouping grouping, const QVariant& group, const QVariantList& cursor, int limit);
+
 Q_SIGNALS:
     void databasePathChanged() const;
     void rowCountChanged();
+    void maxAgeChanged() const;
+    void maxCountChanged() const;
+    void maxDatabaseSizeChanged() const;
     void loaded() const;
+    void flushed(int queued, int coalesced, qint64 elapsed) const;
+    void searchResultsReady(int id, const QVector<HistoryModel::HistoryEntry>& results) const;
+    void groupsReady(int id, const QVector<HistoryModel::HistoryGroup>& groups) const;
+    void groupEntriesReady(int id, const QVector<HistoryModel::HistoryEntry>& entries, const QVariantList& next) const;
 
 protected:
-    struct HistoryEntry {
-        QUrl url;
-        QString domain;
-        QString title;
-        QUrl icon;
-        uint visits;
-        QDateTime lastVisit;
-        bool hidden;
-    };
-    QList<HistoryEntry> m_entries;
-    int getEntryIndex(const QUrl& url) const;
-    void updateExistingEntryInDatabase(const HistoryEntry& entry);
+    // Entries are stored by id, the ids of removed entries being reused,
+    // and the order of the rows is kept in m_rows, so that moving or
+    // removing a row doesn’t move any other entry.
+    QVector<StoredEntry> m_entries;
+    QVector<int> m_freeIds;
+    RankIndex m_rows;
+    // Id of each entry
+    QHash<QUrl, int> m_urlIndex;
+    // Ids of the entries for each domain id, and for each day, in no
+    // particular order
+    QHash<int, QVector<int>> m_domainIndex;
+    QHash<int, QVector<int>> m_dateIndex;
+    StoredEntry& entryAt(int row);
+    const StoredEntry& entryAt(int row) const;
+    void indexEntry(int id);
+    void unindexEntry(int id);
+    void indexDay(int id);
+    void unindexDay(int id);
+    void rebuildIndexes();
+    void removeRange(int first, int last);
+    void removeEntries(const QVector<int>& ids);
+    void updateExistingEntryInDatabase(const StoredEntry& entry);
 
 private Q_SLOTS:
-    void onHiddenEntryFetched(const QUrl& url);
-    void onEntryFetched(const QUrl& url, const QString& domain, const QString& title,
-                        const QUrl& icon, int visits, const QDateTime& lastVisit);
+    void onHiddenEntriesFetched(const QList<QUrl>& urls);
+    void onEntriesFetched(const QVector<HistoryModel::HistoryEntry>& entries, bool more);
+    void onEntriesPruned(const QDateTime& cutoff);
+    void onSearchResults(int id, const QVector<HistoryModel::HistoryEntry>& results);
+    void onGroupEntriesQueried(int id, const QVector<HistoryModel::HistoryEntry>& entries, const QVariantList& next);
+    void onFrecenciesUpdated(const QVariantHash& frecencies);
+    void checkTimeZone();
 
 private:
     QString m_databasePath;
     QSet<QUrl> m_hiddenEntries;
+    bool m_canFetchMore;
+    bool m_fetching;
+    int m_maxAge;
+    int m_maxCount;
+    int m_maxDatabaseSize;
+    int m_lastRequestId;
+    // Interned domains and icons, the icon with id 0 is the empty URL
+    QVector<QString> m_domains;
+    QHash<QString, int> m_domainIds;
+    QVector<QUrl> m_icons;
+    QHash<QUrl, int> m_iconIds;
+    // Bounds of the last day computed by dayOf(), and the ISO 8601 string of
+    // each day, both valid for the system time zone at the time
+    qint64 m_dayStart;
+    qint64 m_dayEnd;
+    int m_day;
+    QHash<int, QString> m_dayStrings;
+    QByteArray m_timeZoneId;
+    // Created and started once the model has entries, see watchTimeZone()
+    QTimer* m_timeZoneCheck;
 
+    int internDomain(const QString& domain);
+    int internIcon(const QUrl& icon);
+    StoredEntry storeEntry(const HistoryEntry& entry);
+    int insertEntry(const StoredEntry& entry);
+    void releaseEntry(int id);
+    int dayOf(qint64 msecs);
+    void resetDayCache();
+    void watchTimeZone();
+    void clearEntries();
     void resetDatabase(const QString& databaseName);
     void removeByIndex(int index);
-    void insertNewEntryInDatabase(const HistoryEntry& entry);
+    void insertNewEntryInDatabase(const StoredEntry& entry);
     void insertNewEntryInHiddenDatabase(const QUrl& url);
     void removeEntryFromDatabaseByUrl(const QUrl& url);
     void removeEntryFromHiddenDatabaseByUrl(const QUrl& url);
     void removeEntriesFromDatabaseByDate(const QDate& date);
     void removeEntriesFromDatabaseByDomain(const QString& domain);
     void clearDatabase();
+    void recordVisitInDatabase(const StoredEntry& entry);
+    void updateRetentionPolicy();
 
     QThread m_dbWorkerThread;
     DbWorker* m_dbWorker;
@@ -140,29 +262,77 @@ public:
         RemoveEntriesByDate,
         RemoveEntriesByDomain,
         Clear,
+        RecordVisit,
     };
 
 Q_SIGNALS:
     void resetDatabase(const QString& databaseName);
-    void fetchEntries();
-    void hiddenEntryFetched(const QUrl& url);
-    void entryFetched(const QUrl& url, const QString& domain, const QString& title,
-                      const QUrl& icon, int visits, const QDateTime& lastVisit);
-    void loaded();
+    void fetchEntries(int count);
+    void hiddenEntriesFetched(const QList<QUrl>& urls);
+    void entriesFetched(const QVector<HistoryModel::HistoryEntry>& entries, bool more);
     void enqueue(Operation operation, QVariantList values);
+    void flushed(int queued, int coalesced, qint64 elapsed);
+    void setRetentionPolicy(int maxAge, int maxCount, int maxDatabaseSize);
+    void entriesPruned(const QDateTime& cutoff);
+    void search(int id, const QStringList& terms, int limit);
+    void searchResults(int id, const QVector<HistoryModel::HistoryEntry>& results);
+    void queryGroups(int id, int grouping);
+    void groupsQueried(int id, const QVector<HistoryModel::HistoryGroup>& groups);
+    void queryGroupEntries(int id, int grouping, const QVariantList& group, const QVariantList& cursor, int limit);
+    void groupEntriesQueried(int id, const QVector<HistoryModel::HistoryEntry>& entries, const QVariantList& next);
+    void frecenciesUpdated(const QVariantHash& frecencies);
 
 private Q_SLOTS:
     void doResetDatabase(const QString& databaseName);
     void doCreateOrAlterDatabaseSchema();
-    void doFetchEntries();
+    void doFetchEntries(int count);
     void doEnqueue(Operation operation, QVariantList values);
     void doFlush();
+    void doBackfillDomains();
+    void doSetRetentionPolicy(int maxAge, int maxCount, int maxDatabaseSize);
+    void doPrune();
+    void doSearch(int id, const QStringList& terms, int limit);
+    void doQueryGroups(int id, int grouping);
+    void doQueryGroupEntries(int id, int grouping, const QVariantList& group, const QVariantList& cursor, int limit);
 
 private:
     QSqlDatabase m_database;
+    // Keyset pagination cursor, pointing at the last fetched row
+    bool m_fetchStarted;
+    QVariant m_fetchLastVisit;
+    qint64 m_fetchId;
     QReadWriteLock m_lock;
     QQueue<QPair<Operation, QVariantList>> m_pending;
+    QHash<QString, QSqlQuery> m_statements;
     QTimer* m_flush;
+    QTimer* m_backfill;
+    qint64 m_backfillId;
+    int m_maxAge;
+    int m_maxCount;
+    int m_maxDatabaseSize;
+    // Entries last visited before this timestamp are being pruned
+    qint64 m_pruneCutoff;
+    QTimer* m_prune;
+    // Frecencies updated by the current flush, by URL
+    QVariantHash m_frecencies;
+    // Whether the full-text index exists, see createHistorySearchIndex()
+    bool m_searchAvailable;
+
+    int coalescePending();
+    void discardPending();
+    QSqlQuery* preparedStatement(const QString& statement);
+    qint64 lastVisitAfter(int count);
+    QVector<HistoryModel::HistoryEntry> readGroupEntries(int grouping, const QVariantList& group,
+                                                         const QVariantList& cursor, int limit,
+                                                         QVariantList* last);
+    qint64 pruneCutoff();
+    void compact();
+    void recordVisit(const QVariantList& values);
+    void aggregateVisits();
 };
 
+Q_DECLARE_TYPEINFO(HistoryModel::StoredEntry, Q_MOVABLE_TYPE);
+Q_DECLARE_METATYPE(QVector<HistoryModel::HistoryEntry>)
+Q_DECLARE_METATYPE(QVector<HistoryModel::HistoryGroup>)
+
 #endif // __HISTORY_MODEL_H__
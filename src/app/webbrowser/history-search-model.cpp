@@ -0,0 +1,132 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "history-search-model.h"
+
+/*!
+    \class HistorySearchModel
+    \brief List model that exposes the results of a search in the history
+
+    HistorySearchModel is a list model that holds the history entries whose
+    URL or title contain words that start with each of the search terms,
+    the best matches first, up to a given limit. Matches are ranked by the
+    frecency of the entries, increased for entries whose address starts with
+    the terms, and to a lesser extent for those where words start with the
+    terms, see HistoryModel::search().
+
+    Unlike a TextSearchFilterModel applied to a HistoryModel, it doesn’t
+    walk through all the entries of the history: the search is run against
+    a full-text index of the history database, on the database thread, so
+    its cost depends on the number of matches rather than on the size of the
+    history. Results are published asynchronously, see SearchResultsModel.
+
+    The search is run again when the history database is updated.
+*/
+HistorySearchModel::HistorySearchModel(QObject* parent)
+    : SearchResultsModel(parent)
+{
+}
+
+QHash<int, QByteArray> HistorySearchModel::roleNames() const
+{
+    static QHash<int, QByteArray> roles;
+    if (roles.isEmpty()) {
+        roles[HistoryModel::Url] = "url";
+        roles[HistoryModel::Domain] = "domain";
+        roles[HistoryModel::Title] = "title";
+        roles[HistoryModel::Icon] = "icon";
+        roles[HistoryModel::Visits] = "visits";
+        roles[HistoryModel::LastVisit] = "lastVisit";
+        roles[HistoryModel::Hidden] = "hidden";
+        roles[HistoryModel::Frecency] = "frecency";
+    }
+    return roles;
+}
+
+int HistorySearchModel::rowCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    return m_results.count();
+}
+
+QVariant HistorySearchModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+    const HistoryModel::HistoryEntry& entry = m_results.at(index.row());
+    switch (role) {
+    case HistoryModel::Url:
+        return entry.url;
+    case HistoryModel::Domain:
+        return entry.domain;
+    case HistoryModel::Title:
+        return entry.title;
+    case HistoryModel::Icon:
+        return entry.icon;
+    case HistoryModel::Visits:
+        return entry.visits;
+    case HistoryModel::LastVisit:
+        return entry.lastVisit;
+    case HistoryModel::Hidden:
+        return entry.hidden;
+    case HistoryModel::Frecency:
+        return entry.frecency;
+    default:
+        return QVariant();
+    }
+}
+
+HistoryModel* HistorySearchModel::sourceModel() const
+{
+    return m_sourceModel;
+}
+
+void HistorySearchModel::setSourceModel(HistoryModel* sourceModel)
+{
+    if (sourceModel != m_sourceModel) {
+        if (m_sourceModel) {
+            m_sourceModel->disconnect(this);
+        }
+        m_sourceModel = sourceModel;
+        if (m_sourceModel) {
+            connect(m_sourceModel,
+                    SIGNAL(searchResultsReady(int, const QVector<HistoryModel::HistoryEntry>&)),
+                    SLOT(onSearchResultsReady(int, const QVector<HistoryModel::HistoryEntry>&)));
+            connect(m_sourceModel, SIGNAL(flushed(int, int, qint64)), SLOT(search()));
+            connect(m_sourceModel, SIGNAL(modelReset()), SLOT(search()));
+        }
+        search();
+        Q_EMIT sourceModelChanged();
+    }
+}
+
+int HistorySearchModel::startSearch()
+{
+    return m_sourceModel ? m_sourceModel->search(terms(), limit()) : 0;
+}
+
+void HistorySearchModel::clearResults()
+{
+    setResults(m_results, QVector<HistoryModel::HistoryEntry>());
+}
+
+void HistorySearchModel::onSearchResultsReady(int id, const QVector<HistoryModel::HistoryEntry>& results)
+{
+    publishResults(id, m_results, results);
+}
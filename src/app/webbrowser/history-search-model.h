@@ -0,0 +1,61 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HISTORY_SEARCH_MODEL_H__
+#define __HISTORY_SEARCH_MODEL_H__
+
+// Qt
+#include <QtCore/QPointer>
+#include <QtCore/QVector>
+
+#include "history-model.h"
+#include "search-results-model.h"
+
+class HistorySearchModel : public SearchResultsModel
+{
+    Q_OBJECT
+
+    Q_PROPERTY(HistoryModel* sourceModel READ sourceModel WRITE setSourceModel NOTIFY sourceModelChanged)
+
+public:
+    HistorySearchModel(QObject* parent=0);
+
+    // reimplemented from QAbstractListModel
+    QHash<int, QByteArray> roleNames() const;
+    int rowCount(const QModelIndex& parent=QModelIndex()) const;
+    QVariant data(const QModelIndex& index, int role) const;
+
+    HistoryModel* sourceModel() const;
+    void setSourceModel(HistoryModel* sourceModel);
+
+Q_SIGNALS:
+    void sourceModelChanged() const;
+
+protected:
+    int startSearch();
+    void clearResults();
+
+private Q_SLOTS:
+    void onSearchResultsReady(int id, const QVector<HistoryModel::HistoryEntry>& results);
+
+private:
+    QPointer<HistoryModel> m_sourceModel;
+    QVector<HistoryModel::HistoryEntry> m_results;
+};
+
+#endif // __HISTORY_SEARCH_MODEL_H__
@@ -20,14 +20,19 @@
 #include "bookmarks-folderlist-model.h"
 #include "config.h"
 #include "downloads-model.h"
+#include "fuzzy-search-model.h"
+#include "grouped-history-query-model.h"
 #include "history-domainlist-model.h"
 #include "history-lastvisitdatelist-model.h"
 #include "history-model.h"
+#include "history-search-model.h"
 #include "limit-proxy-model.h"
 #include "reparenter.h"
 #include "searchengine.h"
 #include "text-search-filter-model.h"
 #include "tabs-model.h"
+#include "top-sites-model.h"
+#include "window-proxy-model.h"
 #include "morph-browser.h"
 
 // Qt
@@ -68,7 +73,12 @@ bool WebbrowserApp::initialize()
     qmlRegisterSingletonType<HistoryModel>(uri, 0, 1, "HistoryModel", HistoryModel_singleton_factory);
     qmlRegisterType<HistoryDomainListModel>(uri, 0, 1, "HistoryDomainListModel");
     qmlRegisterType<HistoryLastVisitDateListModel>(uri, 0, 1, "HistoryLastVisitDateListModel");
+    qmlRegisterType<HistorySearchModel>(uri, 0, 1, "HistorySearchModel");
+    qmlRegisterType<GroupedHistoryQueryModel>(uri, 0, 1, "GroupedHistoryQueryModel");
+    qmlRegisterType<FuzzySearchModel>(uri, 0, 1, "FuzzySearchModel");
     qmlRegisterType<LimitProxyModel>(uri, 0 , 1, "LimitProxyModel");
+    qmlRegisterType<TopSitesModel>(uri, 0, 1, "TopSitesModel");
+    qmlRegisterType<WindowProxyModel>(uri, 0, 1, "WindowProxyModel");
     qmlRegisterType<TabsModel>(uri, 0, 1, "TabsModel");
     qmlRegisterSingletonType<BookmarksModel>(uri, 0, 1, "BookmarksModel", BookmarksModel_singleton_factory);
     qmlRegisterType<BookmarksFolderListModel>(uri, 0, 1, "BookmarksFolderListModel");
@@ -0,0 +1,241 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rank-index.h"
+
+#define MIN_ROOM 16
+
+/*!
+    \class RankIndex
+    \brief Ordered list of integer items with logarithmic rank queries
+
+    RankIndex keeps a list of small non-negative integers (typically
+    stable ids into a separate storage vector) in a given order, and
+    answers both “which item is at this rank” and “what is the rank of
+    this item” in O(log n).
+
+    Items occupy slots in a sparse array, the first item in the highest
+    used slot, and a Fenwick tree counts the used slots. Prepending or
+    appending takes the next free slot at either end, and moving an item
+    to the front or removing it only frees its slot, so none of these
+    operations renumber the other items. When either end runs out of
+    free slots the used ones are compacted into a new array with room
+    proportional to the number of items, which keeps the amortized cost
+    of every update logarithmic.
+*/
+RankIndex::RankIndex()
+    : m_bottom(0)
+    , m_top(0)
+    , m_count(0)
+{
+}
+
+int RankIndex::count() const
+{
+    return m_count;
+}
+
+bool RankIndex::contains(int item) const
+{
+    return (item >= 0) && (item < m_slots.count()) && (m_slots.at(item) != -1);
+}
+
+/*!
+    Return the position of \a item in the list, or -1 if it is not in
+    the index.
+*/
+int RankIndex::rankOf(int item) const
+{
+    if (!contains(item)) {
+        return -1;
+    }
+    return m_count - usedUpTo(m_slots.at(item));
+}
+
+/*!
+    Return the item at position \a rank, or -1 if \a rank is out of
+    range.
+*/
+int RankIndex::itemAt(int rank) const
+{
+    if ((rank < 0) || (rank >= m_count)) {
+        return -1;
+    }
+    return m_items.at(findUsed(m_count - rank));
+}
+
+void RankIndex::prepend(int item)
+{
+    Q_ASSERT(!contains(item));
+    if (m_top == m_items.count()) {
+        int room = qMax(m_count, MIN_ROOM);
+        relayout(qMin(m_bottom, room), room);
+    }
+    use(m_top++, item);
+}
+
+void RankIndex::append(int item)
+{
+    Q_ASSERT(!contains(item));
+    if (m_bottom == 0) {
+        int room = qMax(m_count, MIN_ROOM);
+        relayout(room, qMin(m_items.count() - m_top, room));
+    }
+    use(--m_bottom, item);
+}
+
+void RankIndex::moveToFront(int item)
+{
+    Q_ASSERT(contains(item));
+    int slot = m_slots.at(item);
+    if (slot == m_top - 1) {
+        return;
+    }
+    release(slot);
+    prepend(item);
+}
+
+void RankIndex::remove(int item)
+{
+    if (!contains(item)) {
+        return;
+    }
+    release(m_slots.at(item));
+    if (m_count == 0) {
+        clear();
+    } else if ((m_items.count() > 8 * MIN_ROOM) && (m_count < m_items.count() / 8)) {
+        int room = qMax(m_count, MIN_ROOM);
+        relayout(room, room);
+    }
+}
+
+/*!
+    Replace the contents of the index with \a items, in that order.
+*/
+void RankIndex::reset(const QVector<int>& items)
+{
+    clear();
+    int maxItem = -1;
+    Q_FOREACH(int item, items) {
+        maxItem = qMax(maxItem, item);
+    }
+    m_slots.fill(-1, maxItem + 1);
+    m_items.fill(-1, MIN_ROOM + items.count() + MIN_ROOM);
+    m_tree.fill(0, m_items.count() + 1);
+    m_bottom = MIN_ROOM;
+    m_top = MIN_ROOM;
+    // Fill from the bottom up so that the first item ends up on top
+    for (int i = items.count() - 1; i >= 0; --i) {
+        use(m_top++, items.at(i));
+    }
+}
+
+void RankIndex::clear()
+{
+    m_items.clear();
+    m_slots.clear();
+    m_tree.clear();
+    m_bottom = 0;
+    m_top = 0;
+    m_count = 0;
+}
+
+void RankIndex::use(int slot, int item)
+{
+    if (item >= m_slots.count()) {
+        int size = m_slots.count();
+        m_slots.resize(qMax(item + 1, size * 2));
+        for (int i = size; i < m_slots.count(); ++i) {
+            m_slots[i] = -1;
+        }
+    }
+    m_items[slot] = item;
+    m_slots[item] = slot;
+    ++m_count;
+    for (int i = slot + 1; i < m_tree.count(); i += (i & -i)) {
+        ++m_tree[i];
+    }
+}
+
+void RankIndex::release(int slot)
+{
+    m_slots[m_items.at(slot)] = -1;
+    m_items[slot] = -1;
+    --m_count;
+    for (int i = slot + 1; i < m_tree.count(); i += (i & -i)) {
+        --m_tree[i];
+    }
+}
+
+/* Number of used slots in [0, slot] */
+int RankIndex::usedUpTo(int slot) const
+{
+    int used = 0;
+    for (int i = slot + 1; i > 0; i -= (i & -i)) {
+        used += m_tree.at(i);
+    }
+    return used;
+}
+
+/* Lowest slot such that [0, slot] holds n used slots */
+int RankIndex::findUsed(int n) const
+{
+    int size = m_tree.count() - 1;
+    int step = 1;
+    while ((step << 1) <= size) {
+        step <<= 1;
+    }
+    int position = 0;
+    for (; step > 0; step >>= 1) {
+        int next = position + step;
+        if ((next <= size) && (m_tree.at(next) < n)) {
+            position = next;
+            n -= m_tree.at(next);
+        }
+    }
+    return position;
+}
+
+/* Compact the used slots, leaving the given number of free slots below
+   and above them. */
+void RankIndex::relayout(int bottomRoom, int topRoom)
+{
+    int capacity = bottomRoom + m_count + topRoom;
+    QVector<int> items(capacity, -1);
+    QVector<int> tree(capacity + 1, 0);
+    int slot = bottomRoom;
+    for (int i = m_bottom; i < m_top; ++i) {
+        int item = m_items.at(i);
+        if (item != -1) {
+            items[slot] = item;
+            m_slots[item] = slot;
+            tree[slot + 1] = 1;
+            ++slot;
+        }
+    }
+    for (int i = 1; i <= capacity; ++i) {
+        int parent = i + (i & -i);
+        if (parent <= capacity) {
+            tree[parent] += tree.at(i);
+        }
+    }
+    m_items.swap(items);
+    m_tree.swap(tree);
+    m_bottom = bottomRoom;
+    m_top = slot;
+}
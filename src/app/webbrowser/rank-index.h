@@ -0,0 +1,62 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RANK_INDEX_H__
+#define __RANK_INDEX_H__
+
+// Qt
+#include <QtCore/QVector>
+
+class RankIndex
+{
+public:
+    RankIndex();
+
+    int count() const;
+    bool contains(int item) const;
+    int rankOf(int item) const;
+    int itemAt(int rank) const;
+
+    void prepend(int item);
+    void append(int item);
+    void moveToFront(int item);
+    void remove(int item);
+    void reset(const QVector<int>& items);
+    void clear();
+
+private:
+    // Item in each slot, or -1 for a free slot. Items are laid out in
+    // reverse order, the first one in the highest used slot.
+    QVector<int> m_items;
+    // Slot of each item, or -1 for items that are not in the index
+    QVector<int> m_slots;
+    // Fenwick tree of the number of used slots, one-based
+    QVector<int> m_tree;
+    // Slots below m_bottom and from m_top up are free
+    int m_bottom;
+    int m_top;
+    int m_count;
+
+    void use(int slot, int item);
+    void release(int slot);
+    int usedUpTo(int slot) const;
+    int findUsed(int n) const;
+    void relayout(int bottomRoom, int topRoom);
+};
+
+#endif // __RANK_INDEX_H__
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "search-results-model.h"
+
+/*!
+    \class SearchResultsModel
+    \brief Base class of the list models that expose the results of an
+           asynchronous search
+
+    SearchResultsModel holds the search terms and the maximum number of
+    results, and runs the search again when they change. Subclasses start
+    the search, and hand its results back with publishResults() once they
+    are available. The searching property is true while they are pending,
+    and the results of a search superseded by a later one are discarded.
+*/
+SearchResultsModel::SearchResultsModel(QObject* parent)
+    : QAbstractListModel(parent)
+    , m_limit(10)
+    , m_searchId(0)
+{
+}
+
+const QStringList& SearchResultsModel::terms() const
+{
+    return m_terms;
+}
+
+void SearchResultsModel::setTerms(const QStringList& terms)
+{
+    if (terms != m_terms) {
+        m_terms = terms;
+        search();
+        Q_EMIT termsChanged();
+    }
+}
+
+int SearchResultsModel::limit() const
+{
+    return m_limit;
+}
+
+void SearchResultsModel::setLimit(int limit)
+{
+    if (limit != m_limit) {
+        m_limit = limit;
+        search();
+        Q_EMIT limitChanged();
+    }
+}
+
+bool SearchResultsModel::searching() const
+{
+    return (m_searchId != 0);
+}
+
+void SearchResultsModel::search()
+{
+    bool wasSearching = searching();
+    // Results of a previous search still pending will be discarded
+    m_searchId = (!m_terms.isEmpty() && (m_limit > 0)) ? startSearch() : 0;
+    if (m_searchId == 0) {
+        clearResults();
+    }
+    if (searching() != wasSearching) {
+        Q_EMIT searchingChanged();
+    }
+}
+
+QVariantMap SearchResultsModel::get(int i) const
+{
+    QVariantMap item;
+    QHash<int, QByteArray> roles = roleNames();
+
+    QModelIndex modelIndex = index(i, 0);
+    if (modelIndex.isValid()) {
+        Q_FOREACH(int role, roles.keys()) {
+            QString roleName = QString::fromUtf8(roles.value(role));
+            item.insert(roleName, data(modelIndex, role));
+        }
+    }
+    return item;
+}
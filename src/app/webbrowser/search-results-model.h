@@ -0,0 +1,104 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SEARCH_RESULTS_MODEL_H__
+#define __SEARCH_RESULTS_MODEL_H__
+
+// Qt
+#include <QtCore/QAbstractListModel>
+#include <QtCore/QStringList>
+#include <QtCore/QVariantMap>
+#include <QtCore/QVector>
+
+class SearchResultsModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+    Q_PROPERTY(QStringList terms READ terms WRITE setTerms NOTIFY termsChanged)
+    Q_PROPERTY(int limit READ limit WRITE setLimit NOTIFY limitChanged)
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    Q_PROPERTY(bool searching READ searching NOTIFY searchingChanged)
+
+public:
+    const QStringList& terms() const;
+    void setTerms(const QStringList& terms);
+
+    int limit() const;
+    void setLimit(int limit);
+
+    bool searching() const;
+
+    Q_INVOKABLE QVariantMap get(int index) const;
+
+Q_SIGNALS:
+    void termsChanged() const;
+    void limitChanged() const;
+    void countChanged() const;
+    void searchingChanged() const;
+
+protected Q_SLOTS:
+    virtual void search();
+
+protected:
+    SearchResultsModel(QObject* parent=0);
+
+    /* Start a search for the terms and the limit, and return its id, or 0
+       if there is nothing to search. The results are expected to be passed
+       to publishResults() with the same id. */
+    virtual int startSearch() = 0;
+    /* Remove all the results */
+    virtual void clearResults() = 0;
+
+    template <typename T>
+    void setResults(QVector<T>& current, const QVector<T>& results);
+    template <typename T>
+    void publishResults(int id, QVector<T>& current, const QVector<T>& results);
+
+private:
+    QStringList m_terms;
+    int m_limit;
+    int m_searchId;
+};
+
+template <typename T>
+void SearchResultsModel::setResults(QVector<T>& current, const QVector<T>& results)
+{
+    if (results.isEmpty() && current.isEmpty()) {
+        return;
+    }
+    beginResetModel();
+    current = results;
+    endResetModel();
+    // Notify even if the number of results is unchanged, as views that
+    // collect the results through get() only watch the count.
+    Q_EMIT countChanged();
+}
+
+/* Replace the results with those of a search, unless it was superseded */
+template <typename T>
+void SearchResultsModel::publishResults(int id, QVector<T>& current, const QVector<T>& results)
+{
+    if (id != m_searchId) {
+        return;
+    }
+    m_searchId = 0;
+    setResults(current, results);
+    Q_EMIT searchingChanged();
+}
+
+#endif // __SEARCH_RESULTS_MODEL_H__
@@ -19,7 +19,11 @@
 #include "text-search-filter-model.h"
 
 #include <QtCore/QDebug>
-#include <QtCore/QSet>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMetaObject>
+
+// std
+#include <algorithm>
 
 /*!
     \class TextSearchFilterModel
@@ -37,10 +41,99 @@
 
     If no searchTerms and/or no searchFields are present, all entries from the
     source model are returned.
+
+    Matching ignores case and diacritics. Terms are normalized once when they
+    are set, and the contents of the search fields of each row are normalized
+    the first time the row is filtered, then cached until the row changes.
+
+    When the terms only narrow the previous ones (a term got longer or a term
+    was added, as when typing), rows that didn’t match before can’t match
+    now, so only the rows that matched are searched again.
+
+    All the terms are looked for in a single pass over each row, see
+    TextSearchMatcher.
+
+    When asynchronous is true, changing the terms doesn’t filter the rows
+    right away: they are filtered on a worker thread, over a snapshot of the
+    search fields, and the results are published at once with a single
+    layout change. The snapshot is read from the source model a few
+    milliseconds at a time, only for the rows whose search key isn’t cached
+    yet, so that large models don’t block the UI thread. Until then, pending is true and the results for the
+    previous terms remain. Filtering for terms that are changed again before
+    the results are published is cancelled.
 */
 TextSearchFilterModel::TextSearchFilterModel(QObject* parent)
     : QSortFilterProxyModel(parent)
+    , m_asynchronous(false)
+    , m_pending(false)
+    , m_restartQueued(false)
+    , m_requestId(0)
+    , m_snapshotRow(0)
+    , m_collecting(false)
+    , m_worker(nullptr)
 {
+    qRegisterMetaType<QVector<TextSearchFilterModel::SearchKey>>();
+    qRegisterMetaType<QVector<QStringList>>();
+}
+
+TextSearchFilterModel::~TextSearchFilterModel()
+{
+    if (m_worker) {
+        m_worker->setLatestRequest(-1);
+        m_worker->deleteLater();
+        m_workerThread.quit();
+        m_workerThread.wait();
+    }
+}
+
+// Source model signals that invalidate the cached search keys, and the
+// corresponding slots
+static const char* const SOURCE_CONNECTIONS[][2] = {
+    { SIGNAL(rowsInserted(const QModelIndex&, int, int)),
+      SLOT(onSourceRowsInserted(const QModelIndex&, int, int)) },
+    { SIGNAL(rowsRemoved(const QModelIndex&, int, int)),
+      SLOT(onSourceRowsRemoved(const QModelIndex&, int, int)) },
+    { SIGNAL(rowsMoved(const QModelIndex&, int, int, const QModelIndex&, int)),
+      SLOT(onSourceRowsMoved(const QModelIndex&, int, int, const QModelIndex&, int)) },
+    { SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)),
+      SLOT(onSourceDataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)) },
+    { SIGNAL(modelReset()), SLOT(resetSearchKeys()) },
+    { SIGNAL(layoutChanged(QList<QPersistentModelIndex>, QAbstractItemModel::LayoutChangeHint)),
+      SLOT(resetSearchKeys()) },
+};
+
+/*
+    The normalized fields, each followed by a character that terms can’t
+    contain, so that a term can’t match across two fields.
+*/
+static QString searchKeyFromFields(const QStringList& fields)
+{
+    QString key(QLatin1String(""));
+    Q_FOREACH(const QString& field, fields) {
+        key.append(TextSearchMatcher::normalized(field));
+        key.append(QChar(QChar::Null));
+    }
+    return key;
+}
+
+/* Matchers for normalized terms, as many as needed to look for all of them */
+static QVector<TextSearchMatcher> matchersFor(const QStringList& terms)
+{
+    QVector<TextSearchMatcher> matchers;
+    for (int i = 0; i < terms.count(); i += TextSearchMatcher::MaxTerms) {
+        matchers.append(TextSearchMatcher(terms.mid(i, TextSearchMatcher::MaxTerms)));
+    }
+    return matchers;
+}
+
+static bool matchesAll(const QVector<TextSearchMatcher>& matchers, const QString& key)
+{
+    Q_FOREACH(const TextSearchMatcher& matcher, matchers) {
+        if (matcher.match(key) != matcher.allTerms()) {
+            return false;
+        }
+    }
+    return true;
 }
 
 QVariant TextSearchFilterModel::sourceModel() const
@@ -55,19 +148,78 @@ void TextSearchFilterModel::setSourceModel(QVariant sourceModel)
     QAbstractItemModel* newSource = qvariant_cast<QAbstractItemModel*>(sourceModel);
     if (newSource != currentSource) {
         updateSearchRoles(newSource);
+        // The search keys must be up to date before the proxy model filters
+        // new or changed rows, so connect before it does
+        for (const auto& connection : SOURCE_CONNECTIONS) {
+            if (currentSource) {
+                disconnect(currentSource, connection[0], this, connection[1]);
+            }
+            if (newSource) {
+                connect(newSource, connection[0], this, connection[1]);
+            }
+        }
         QSortFilterProxyModel::setSourceModel(newSource);
+        resetSearchKeys();
         Q_EMIT sourceModelChanged();
         Q_EMIT countChanged();
     }
 }
 
+/*
+    Whether all the rows that match terms also match previous terms, that is
+    whether each of the previous terms is contained in one of the terms.
+*/
+static bool narrows(const QStringList& terms, const QStringList& previous)
+{
+    Q_FOREACH(const QString& previousTerm, previous) {
+        bool contained = false;
+        Q_FOREACH(const QString& term, terms) {
+            if (term.contains(previousTerm)) {
+                contained = true;
+                break;
+            }
+        }
+        if (!contained) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void TextSearchFilterModel::setTerms(const QStringList& terms)
 {
     if (terms != m_terms) {
+        QStringList previousTerms = m_searchTerms;
         m_terms = terms;
-        invalidateFilter();
+        m_searchTerms.clear();
+        Q_FOREACH(const QString& term, m_terms) {
+            QString searchTerm = TextSearchMatcher::normalized(term);
+            if (!searchTerm.isEmpty() && !m_searchTerms.contains(searchTerm)) {
+                m_searchTerms.append(searchTerm);
+            }
+        }
+        // Longer terms are less likely to match, try them first. Terms
+        // contained in other terms are redundant, as all terms must match.
+        std::stable_sort(m_searchTerms.begin(), m_searchTerms.end(),
+                         [] (const QString& a, const QString& b) { return a.size() > b.size(); });
+        for (int i = m_searchTerms.count() - 1; i > 0; --i) {
+            for (int j = 0; j < i; ++j) {
+                if (m_searchTerms.at(j).contains(m_searchTerms.at(i))) {
+                    m_searchTerms.removeAt(i);
+                    break;
+                }
+            }
+        }
+        m_matchers = matchersFor(m_searchTerms);
+        // Rows rejected so far may match now, unless the terms narrow
+        bool narrowing = narrows(m_searchTerms, previousTerms);
+        for (int i = 0; i < m_searchKeys.count(); ++i) {
+            SearchKey& key = m_searchKeys[i];
+            key.rejected = key.rejected && narrowing;
+            key.accepted = false;
+        }
         Q_EMIT termsChanged();
-        Q_EMIT countChanged();
+        refilter();
     }
 }
 
@@ -81,9 +233,9 @@ void TextSearchFilterModel::setSearchFields(const QStringList& searchFields)
     if (searchFields != m_searchFields) {
         m_searchFields = searchFields;
         updateSearchRoles(QSortFilterProxyModel::sourceModel());
-        invalidateFilter();
+        resetSearchKeys();
         Q_EMIT searchFieldsChanged();
-        Q_EMIT countChanged();
+        refilter();
     }
 }
 
@@ -106,33 +258,313 @@ void TextSearchFilterModel::updateSearchRoles(const QAbstractItemModel* model) {
     }
 }
 
+QString TextSearchFilterModel::searchKey(int row, const QModelIndex& parent) const
+{
+    bool cached = !parent.isValid() && (row < m_searchKeys.count());
+    if (cached && !m_searchKeys.at(row).text.isNull()) {
+        return m_searchKeys.at(row).text;
+    }
+
+    QAbstractItemModel* source = QSortFilterProxyModel::sourceModel();
+    QModelIndex index = source->index(row, 0, parent);
+    QStringList fields;
+    Q_FOREACH(int role, m_searchRoles) {
+        fields.append(source->data(index, role).toString());
+    }
+    QString key = searchKeyFromFields(fields);
+    if (cached) {
+        m_searchKeys[row].text = key;
+    }
+    return key;
+}
+
+void TextSearchFilterModel::resetSearchKeys()
+{
+    QAbstractItemModel* source = QSortFilterProxyModel::sourceModel();
+    m_searchKeys.fill(SearchKey(), source ? source->rowCount() : 0);
+    restartFiltering();
+}
+
+void TextSearchFilterModel::onSourceRowsInserted(const QModelIndex& parent, int start, int end)
+{
+    if (parent.isValid()) {
+        return;
+    }
+    if (start > m_searchKeys.count()) {
+        resetSearchKeys();
+        return;
+    }
+    m_searchKeys.insert(start, end - start + 1, SearchKey());
+    restartFiltering();
+}
+
+void TextSearchFilterModel::onSourceRowsRemoved(const QModelIndex& parent, int start, int end)
+{
+    if (parent.isValid()) {
+        return;
+    }
+    if (end >= m_searchKeys.count()) {
+        resetSearchKeys();
+        return;
+    }
+    m_searchKeys.remove(start, end - start + 1);
+    restartFiltering();
+}
+
+void TextSearchFilterModel::onSourceRowsMoved(const QModelIndex& parent, int start, int end,
+                                              const QModelIndex& destination, int row)
+{
+    if (parent.isValid() || destination.isValid() || (end >= m_searchKeys.count())) {
+        resetSearchKeys();
+        return;
+    }
+    int count = end - start + 1;
+    QVector<SearchKey> moved = m_searchKeys.mid(start, count);
+    m_searchKeys.remove(start, count);
+    int to = (row > start) ? row - count : row;
+    for (int i = 0; i < count; ++i) {
+        m_searchKeys.insert(to + i, moved.at(i));
+    }
+    restartFiltering();
+}
+
+void TextSearchFilterModel::onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight,
+                                                const QVector<int>& roles)
+{
+    if (topLeft.parent().isValid()) {
+        return;
+    }
+    bool changed = roles.isEmpty();
+    Q_FOREACH(int role, roles) {
+        changed = changed || m_searchRoles.contains(role);
+    }
+    if (changed) {
+        int last = qMin(bottomRight.row(), m_searchKeys.count() - 1);
+        for (int i = topLeft.row(); i <= last; ++i) {
+            m_searchKeys[i] = SearchKey();
+        }
+        restartFiltering();
+    }
+}
+
 bool TextSearchFilterModel::filterAcceptsRow(int source_row, const QModelIndex& source_parent) const
 {
     if (m_terms.isEmpty() || m_searchFields.isEmpty()) {
         return true;
     }
 
-    QAbstractItemModel* source = QSortFilterProxyModel::sourceModel();
-    QModelIndex index = source->index(source_row, 0, source_parent);
+    bool cached = !source_parent.isValid() && (source_row < m_searchKeys.count());
+    if (cached && m_searchKeys.at(source_row).rejected) {
+        return false;
+    } else if (cached && m_searchKeys.at(source_row).accepted) {
+        return true;
+    }
+    bool accepted = matchesAll(m_matchers, searchKey(source_row, source_parent));
+    if (cached) {
+        m_searchKeys[source_row].rejected = !accepted;
+        m_searchKeys[source_row].accepted = accepted;
+    }
+    return accepted;
+}
 
-    QSet<QString> foundTerms;
-    int searchTermsCount = QSet<QString>::fromList(m_terms).count();
+int TextSearchFilterModel::count() const
+{
+    return rowCount();
+}
 
-    Q_FOREACH(int role, m_searchRoles) {
-        QString value = source->data(index, role).toString();
-        Q_FOREACH (const QString& term, m_terms) {
-            if (value.contains(term, Qt::CaseInsensitive)) {
-                foundTerms.insert(term);
-            }
-            if (foundTerms.count() == searchTermsCount) {
-                return true;
+bool TextSearchFilterModel::asynchronous() const
+{
+    return m_asynchronous;
+}
+
+void TextSearchFilterModel::setAsynchronous(bool asynchronous)
+{
+    if (asynchronous != m_asynchronous) {
+        m_asynchronous = asynchronous;
+        Q_EMIT asynchronousChanged();
+        if (!m_asynchronous && m_pending) {
+            refilter();
+        }
+    }
+}
+
+bool TextSearchFilterModel::pending() const
+{
+    return m_pending;
+}
+
+/*
+    Filter the rows again after the terms or the search fields changed,
+    right away or on the worker thread.
+*/
+void TextSearchFilterModel::refilter()
+{
+    if (m_asynchronous && !m_matchers.isEmpty() && QSortFilterProxyModel::sourceModel()) {
+        startFiltering();
+    } else {
+        cancelFiltering();
+        invalidateFilter();
+        Q_EMIT countChanged();
+    }
+}
+
+void TextSearchFilterModel::startFiltering()
+{
+    m_restartQueued = false;
+    if (!m_worker) {
+        m_worker = new TextSearchWorker;
+        m_worker->moveToThread(&m_workerThread);
+        connect(m_worker,
+                SIGNAL(filtered(int, const QVector<TextSearchFilterModel::SearchKey>&)),
+                SLOT(onFiltered(int, const QVector<TextSearchFilterModel::SearchKey>&)),
+                Qt::QueuedConnection);
+        m_workerThread.start(QThread::LowPriority);
+    }
+
+    // The worker can’t read from the source model, so it is given the search
+    // fields of the rows whose search key isn’t known yet. Fields already
+    // read for previous terms are still valid, as the source model didn’t
+    // change since (see restartFiltering()).
+    if (m_snapshotFields.count() != m_searchKeys.count()) {
+        m_snapshotFields = QVector<QStringList>(m_searchKeys.count());
+        m_snapshotRow = 0;
+    }
+
+    m_worker->setLatestRequest(++m_requestId);
+    if (!m_pending) {
+        m_pending = true;
+        Q_EMIT pendingChanged();
+    }
+    if (!m_collecting) {
+        collectFields();
+    }
+}
+
+/*
+    Read the search fields of the next rows of the snapshot, and hand the
+    snapshot over to the worker once complete. Reading stops after a few
+    milliseconds and resumes from the event loop.
+*/
+void TextSearchFilterModel::collectFields()
+{
+    // How long to read from the source model before returning to the event
+    // loop, and how many rows to read between checks of the time spent
+    static const int SLICE_DURATION_MS = 4;
+    static const int SLICE_CHECK_INTERVAL = 64;
+
+    m_collecting = false;
+    if (!m_pending || m_restartQueued) {
+        return;
+    }
+
+    QAbstractItemModel* source = QSortFilterProxyModel::sourceModel();
+    QElapsedTimer timer;
+    timer.start();
+    while (m_snapshotRow < m_searchKeys.count()) {
+        if (m_searchKeys.at(m_snapshotRow).text.isNull()) {
+            QModelIndex index = source->index(m_snapshotRow, 0);
+            QStringList& fields = m_snapshotFields[m_snapshotRow];
+            Q_FOREACH(int role, m_searchRoles) {
+                fields.append(source->data(index, role).toString());
             }
         }
+        ++m_snapshotRow;
+        if (((m_snapshotRow % SLICE_CHECK_INTERVAL) == 0) && (timer.elapsed() >= SLICE_DURATION_MS)) {
+            m_collecting = true;
+            QMetaObject::invokeMethod(this, "collectFields", Qt::QueuedConnection);
+            return;
+        }
     }
-    return false;
+
+    Q_EMIT m_worker->filter(m_requestId, m_searchKeys, m_snapshotFields, m_searchTerms);
+    m_snapshotFields.clear();
+    m_snapshotRow = 0;
 }
 
-int TextSearchFilterModel::count() const
+/*
+    The search keys sent to the worker no longer match the source model,
+    filter again from a new snapshot once the source model is done changing.
+*/
+void TextSearchFilterModel::restartFiltering()
 {
-    return rowCount();
+    m_snapshotFields.clear();
+    m_snapshotRow = 0;
+    if (m_pending && !m_restartQueued) {
+        m_restartQueued = true;
+        m_worker->setLatestRequest(++m_requestId);
+        QMetaObject::invokeMethod(this, "onRestartQueued", Qt::QueuedConnection);
+    }
+}
+
+void TextSearchFilterModel::onRestartQueued()
+{
+    if (m_restartQueued) {
+        startFiltering();
+    }
+}
+
+void TextSearchFilterModel::cancelFiltering()
+{
+    m_restartQueued = false;
+    m_snapshotFields.clear();
+    m_snapshotRow = 0;
+    if (m_pending) {
+        m_worker->setLatestRequest(++m_requestId);
+        m_pending = false;
+        Q_EMIT pendingChanged();
+    }
+}
+
+void TextSearchFilterModel::onFiltered(int id, const QVector<TextSearchFilterModel::SearchKey>& keys)
+{
+    if ((id != m_requestId) || m_restartQueued || !m_pending) {
+        // Results for outdated terms or an outdated snapshot
+        return;
+    }
+    m_searchKeys = keys;
+    m_pending = false;
+    // Rows are accepted or rejected according to the cached results, this
+    // rebuilds the mapping at once
+    invalidate();
+    Q_EMIT pendingChanged();
+    Q_EMIT countChanged();
+}
+
+TextSearchWorker::TextSearchWorker()
+{
+    connect(this,
+            SIGNAL(filter(int, const QVector<TextSearchFilterModel::SearchKey>&, const QVector<QStringList>&, const QStringList&)),
+            SLOT(doFilter(int, const QVector<TextSearchFilterModel::SearchKey>&, const QVector<QStringList>&, const QStringList&)),
+            Qt::QueuedConnection);
+}
+
+void TextSearchWorker::setLatestRequest(int id)
+{
+    m_latestRequest.store(id);
+}
+
+void TextSearchWorker::doFilter(int id, const QVector<TextSearchFilterModel::SearchKey>& keys,
+                                const QVector<QStringList>& fields, const QStringList& terms)
+{
+    // How many rows to filter between checks for cancellation
+    static const int CANCELLATION_CHECK_INTERVAL = 256;
+
+    QVector<TextSearchMatcher> matchers = matchersFor(terms);
+    QVector<TextSearchFilterModel::SearchKey> results(keys);
+    for (int i = 0; i < results.count(); ++i) {
+        if (((i % CANCELLATION_CHECK_INTERVAL) == 0) && (m_latestRequest.load() != id)) {
+            return;
+        }
+        TextSearchFilterModel::SearchKey& key = results[i];
+        if (key.text.isNull()) {
+            key.text = searchKeyFromFields(fields.at(i));
+        }
+        if (!key.rejected && !key.accepted) {
+            key.accepted = matchesAll(matchers, key.text);
+            key.rejected = !key.accepted;
+        }
+    }
+    if (m_latestRequest.load() == id) {
+        Q_EMIT filtered(id, results);
+    }
 }
@@ -21,11 +21,19 @@
 
 // Qt
 #include <QtCore/QAbstractItemModel>
+#include <QtCore/QAtomicInt>
 #include <QtCore/QList>
+#include <QtCore/QMetaType>
 #include <QtCore/QSortFilterProxyModel>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
+#include <QtCore/QThread>
 #include <QtCore/QVariant>
+#include <QtCore/QVector>
+
+#include "text-search-matcher.h"
+
+class TextSearchWorker;
 
 class TextSearchFilterModel : public QSortFilterProxyModel
 {
@@ -35,9 +43,22 @@ class TextSearchFilterModel : public QSortFilterProxyModel
     Q_PROPERTY(QStringList terms READ terms WRITE setTerms NOTIFY termsChanged)
     Q_PROPERTY(QStringList searchFields READ searchFields WRITE setSearchFields NOTIFY searchFieldsChanged)
     Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(bool asynchronous READ asynchronous WRITE setAsynchronous NOTIFY asynchronousChanged)
+    Q_PROPERTY(bool pending READ pending NOTIFY pendingChanged)
 
 public:
     TextSearchFilterModel(QObject* parent=0);
+    ~TextSearchFilterModel();
+
+    struct SearchKey {
+        // Normalized contents of the search fields, null until first needed
+        QString text;
+        // Whether the row was rejected by the current terms, or by terms
+        // that they narrow
+        bool rejected;
+        // Whether the row is known to match the current terms
+        bool accepted;
+    };
 
     QVariant sourceModel() const;
     void setSourceModel(QVariant sourceModel);
@@ -50,22 +71,91 @@ public:
     const QStringList& searchFields() const;
     void setSearchFields(const QStringList&);
 
+    bool asynchronous() const;
+    void setAsynchronous(bool asynchronous);
+
+    bool pending() const;
+
 Q_SIGNALS:
     void sourceModelChanged() const;
     void termsChanged() const;
     void searchFieldsChanged() const;
     void countChanged() const;
+    void asynchronousChanged() const;
+    void pendingChanged() const;
 
 protected:
     // reimplemented from QSortFilterProxyModel
     bool filterAcceptsRow(int source_row, const QModelIndex& source_parent) const;
 
+private Q_SLOTS:
+    void onSourceRowsInserted(const QModelIndex& parent, int start, int end);
+    void onSourceRowsRemoved(const QModelIndex& parent, int start, int end);
+    void onSourceRowsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int row);
+    void onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles);
+    void resetSearchKeys();
+    void onRestartQueued();
+    void collectFields();
+    void onFiltered(int id, const QVector<TextSearchFilterModel::SearchKey>& keys);
+
 private:
     void updateSearchRoles(const QAbstractItemModel* model);
+    QString searchKey(int row, const QModelIndex& parent) const;
+    void refilter();
+    void startFiltering();
+    void restartFiltering();
+    void cancelFiltering();
 
     QStringList m_terms;
     QStringList m_searchFields;
     QList<int> m_searchRoles;
+    // Normalized and deduplicated terms
+    QStringList m_searchTerms;
+    // Matchers for the search terms, each looking for up to
+    // TextSearchMatcher::MaxTerms of them
+    QVector<TextSearchMatcher> m_matchers;
+    // Search key of each top-level row of the source model
+    mutable QVector<SearchKey> m_searchKeys;
+    bool m_asynchronous;
+    bool m_pending;
+    // Whether the source model changed while filtering, and filtering is
+    // about to start over
+    bool m_restartQueued;
+    int m_requestId;
+    // Search fields of the rows whose search key isn’t known yet, read from
+    // the source model a slice at a time, up to the snapshot row
+    QVector<QStringList> m_snapshotFields;
+    int m_snapshotRow;
+    // Whether reading the next slice is queued
+    bool m_collecting;
+    QThread m_workerThread;
+    TextSearchWorker* m_worker;
+};
+
+Q_DECLARE_TYPEINFO(TextSearchFilterModel::SearchKey, Q_MOVABLE_TYPE);
+Q_DECLARE_METATYPE(QVector<TextSearchFilterModel::SearchKey>)
+Q_DECLARE_METATYPE(QVector<QStringList>)
+
+class TextSearchWorker : public QObject {
+    Q_OBJECT
+
+public:
+    TextSearchWorker();
+
+    // Thread safe, filtering for earlier requests stops as soon as possible
+    void setLatestRequest(int id);
+
+Q_SIGNALS:
+    void filter(int id, const QVector<TextSearchFilterModel::SearchKey>& keys,
+                const QVector<QStringList>& fields, const QStringList& terms);
+    void filtered(int id, const QVector<TextSearchFilterModel::SearchKey>& keys);
+
+private Q_SLOTS:
+    void doFilter(int id, const QVector<TextSearchFilterModel::SearchKey>& keys,
+                  const QVector<QStringList>& fields, const QStringList& terms);
+
+private:
+    QAtomicInt m_latestRequest;
 };
 
 
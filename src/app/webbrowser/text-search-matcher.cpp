@@ -0,0 +1,285 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "text-search-matcher.h"
+
+// std
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TEXT_SEARCH_MATCHER_X86
+#include <immintrin.h>
+#endif
+
+typedef TextSearchMatcher::Term Term;
+
+/* Whether term occurs in text at position */
+static inline bool occursAt(const ushort* text, int position, const Term& term)
+{
+    return (text[position] == term.data[0]) &&
+           (text[position + term.length - 1] == term.data[term.length - 1]) &&
+           (std::memcmp(text + position, term.data, term.length * sizeof(ushort)) == 0);
+}
+
+/* Whether term occurs in text at a position in [from, to) */
+static inline bool occursBetween(const ushort* text, int length, int from, int to, const Term& term)
+{
+    to = qMin(to, length - term.length + 1);
+    for (int i = from; i < to; ++i) {
+        if (occursAt(text, i, term)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static quint64 matchScalar(const ushort* text, int length, const Term* terms, int count,
+                           quint64 found, quint64 all)
+{
+    for (int t = 0; (t < count) && (found != all); ++t) {
+        const quint64 bit = Q_UINT64_C(1) << t;
+        if (!(found & bit) && occursBetween(text, length, 0, length, terms[t])) {
+            found |= bit;
+        }
+    }
+    return found;
+}
+
+#if defined(TEXT_SEARCH_MATCHER_X86)
+
+/*
+    The vectorized matchers walk the text once, one block of code units at a
+    time, and look for all the terms not found yet in each block. Candidate
+    positions are those where both the first and the last code units of a
+    term match, they are then compared in full. Near the end of the text,
+    where a block plus the length of a term would overrun it, positions are
+    checked one by one.
+*/
+__attribute__((target("sse2")))
+static quint64 matchSse2(const ushort* text, int length, const Term* terms, int count,
+                         quint64 found, quint64 all)
+{
+    const int width = 8;
+    for (int i = 0; (i < length) && (found != all); i += width) {
+        for (int t = 0; t < count; ++t) {
+            const quint64 bit = Q_UINT64_C(1) << t;
+            if (found & bit) {
+                continue;
+            }
+            const Term& term = terms[t];
+            const int last = term.length - 1;
+            if (i + last + width > length) {
+                if (occursBetween(text, length, i, i + width, term)) {
+                    found |= bit;
+                }
+                continue;
+            }
+            __m128i first = _mm_cmpeq_epi16(_mm_set1_epi16(term.data[0]),
+                                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i)));
+            __m128i lastMatch = _mm_cmpeq_epi16(_mm_set1_epi16(term.data[last]),
+                                                _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + last)));
+            // Two bits per code unit
+            unsigned mask = _mm_movemask_epi8(_mm_and_si128(first, lastMatch));
+            while (mask) {
+                int lane = __builtin_ctz(mask);
+                if (occursAt(text, i + lane / 2, term)) {
+                    found |= bit;
+                    break;
+                }
+                mask &= ~(3u << lane);
+            }
+        }
+    }
+    return found;
+}
+
+__attribute__((target("avx2")))
+static quint64 matchAvx2(const ushort* text, int length, const Term* terms, int count,
+                         quint64 found, quint64 all)
+{
+    const int width = 16;
+    for (int i = 0; (i < length) && (found != all); i += width) {
+        for (int t = 0; t < count; ++t) {
+            const quint64 bit = Q_UINT64_C(1) << t;
+            if (found & bit) {
+                continue;
+            }
+            const Term& term = terms[t];
+            const int last = term.length - 1;
+            if (i + last + width > length) {
+                if (occursBetween(text, length, i, i + width, term)) {
+                    found |= bit;
+                }
+                continue;
+            }
+            __m256i first = _mm256_cmpeq_epi16(_mm256_set1_epi16(term.data[0]),
+                                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i)));
+            __m256i lastMatch = _mm256_cmpeq_epi16(_mm256_set1_epi16(term.data[last]),
+                                                   _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + last)));
+            // Two bits per code unit
+            unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(first, lastMatch));
+            while (mask) {
+                int lane = __builtin_ctz(mask);
+                if (occursAt(text, i + lane / 2, term)) {
+                    found |= bit;
+                    break;
+                }
+                mask &= ~(3u << lane);
+            }
+        }
+    }
+    return found;
+}
+
+#endif
+
+/*!
+    \class TextSearchMatcher
+    \brief Finds which of a set of terms occur in a text
+
+    TextSearchMatcher looks for up to 64 terms at once in a text, and reports
+    the terms found as a bit mask, bit i being set if the term at index i
+    occurs in the text. Comparisons are exact: texts and terms are expected to
+    be normalized beforehand, see normalized().
+
+    On x86 processors, the text is scanned with SSE2 or AVX2 instructions,
+    whichever is the best supported by the processor at runtime, otherwise
+    with a portable implementation.
+*/
+TextSearchMatcher::TextSearchMatcher(const QStringList& terms)
+    : m_terms(terms)
+{
+    init(bestImplementation());
+}
+
+TextSearchMatcher::TextSearchMatcher(const QStringList& terms, Implementation implementation)
+    : m_terms(terms)
+{
+    init(isSupported(implementation) ? implementation : Scalar);
+}
+
+void TextSearchMatcher::init(Implementation implementation)
+{
+    // Empty terms occur in any text, they are not looked for
+    m_all = 0;
+    m_empty = 0;
+    for (int i = 0; (i < m_terms.count()) && (i < MaxTerms); ++i) {
+        const QString& term = m_terms.at(i);
+        m_all |= (Q_UINT64_C(1) << i);
+        if (term.isEmpty()) {
+            m_empty |= (Q_UINT64_C(1) << i);
+        }
+        Term data;
+        data.data = reinterpret_cast<const ushort*>(term.constData());
+        data.length = term.length();
+        m_termData.append(data);
+    }
+    m_implementation = implementation;
+    switch (implementation) {
+#if defined(TEXT_SEARCH_MATCHER_X86)
+    case Sse2:
+        m_match = matchSse2;
+        break;
+    case Avx2:
+        m_match = matchAvx2;
+        break;
+#endif
+    default:
+        m_match = matchScalar;
+        break;
+    }
+}
+
+TextSearchMatcher::Implementation TextSearchMatcher::bestImplementation()
+{
+    static const Implementation best = isSupported(Avx2) ? Avx2 : (isSupported(Sse2) ? Sse2 : Scalar);
+    return best;
+}
+
+bool TextSearchMatcher::isSupported(Implementation implementation)
+{
+    switch (implementation) {
+    case Scalar:
+        return true;
+#if defined(TEXT_SEARCH_MATCHER_X86)
+    case Sse2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+    case Avx2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+/*!
+    Case fold \a text and strip its diacritics, so that matching is
+    insensitive to both. Null characters are dropped, so that they can be
+    used to separate fields.
+*/
+QString TextSearchMatcher::normalized(const QString& text)
+{
+    bool ascii = true;
+    for (int i = 0; ascii && (i < text.size()); ++i) {
+        ascii = (text.at(i).unicode() < 0x80);
+    }
+    const QString decomposed = ascii ? text : text.normalized(QString::NormalizationForm_KD);
+    QString result;
+    result.reserve(decomposed.size());
+    for (int i = 0; i < decomposed.size(); ++i) {
+        QChar c = decomposed.at(i);
+        ushort u = c.unicode();
+        if (u == 0) {
+            continue;
+        } else if (u < 0x80) {
+            result.append(((u >= 'A') && (u <= 'Z')) ? QChar(u + ('a' - 'A')) : c);
+        } else if (c.category() != QChar::Mark_NonSpacing) {
+            result.append(c.toCaseFolded());
+        }
+    }
+    return result;
+}
+
+TextSearchMatcher::Implementation TextSearchMatcher::implementation() const
+{
+    return m_implementation;
+}
+
+const QStringList& TextSearchMatcher::terms() const
+{
+    return m_terms;
+}
+
+/*!
+    The bit mask with a bit set for each of the terms.
+*/
+quint64 TextSearchMatcher::allTerms() const
+{
+    return m_all;
+}
+
+/*!
+    Find which of the terms occur in \a text, and return them as a bit mask.
+*/
+quint64 TextSearchMatcher::match(const QString& text) const
+{
+    return m_match(reinterpret_cast<const ushort*>(text.constData()), text.length(),
+                   m_termData.constData(), m_termData.count(), m_empty, m_all);
+}
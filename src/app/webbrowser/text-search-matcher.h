@@ -0,0 +1,74 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TEXT_SEARCH_MATCHER_H__
+#define __TEXT_SEARCH_MATCHER_H__
+
+// Qt
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+class TextSearchMatcher
+{
+public:
+    enum Implementation {
+        Scalar,
+        Sse2,
+        Avx2,
+    };
+
+    // Maximum number of terms, one bit each in a match result
+    static const int MaxTerms = 64;
+
+    TextSearchMatcher(const QStringList& terms=QStringList());
+    TextSearchMatcher(const QStringList& terms, Implementation implementation);
+
+    static Implementation bestImplementation();
+    static bool isSupported(Implementation implementation);
+
+    static QString normalized(const QString& text);
+
+    Implementation implementation() const;
+    const QStringList& terms() const;
+    quint64 allTerms() const;
+
+    quint64 match(const QString& text) const;
+
+    struct Term {
+        const ushort* data;
+        int length;
+    };
+    typedef quint64 (*MatchFunction)(const ushort* text, int length,
+                                     const Term* terms, int count,
+                                     quint64 found, quint64 all);
+
+private:
+    QStringList m_terms;
+    QVector<Term> m_termData;
+    quint64 m_all;
+    quint64 m_empty;
+    Implementation m_implementation;
+    MatchFunction m_match;
+
+    void init(Implementation implementation);
+};
+
+Q_DECLARE_TYPEINFO(TextSearchMatcher::Term, Q_PRIMITIVE_TYPE);
+
+#endif // __TEXT_SEARCH_MATCHER_H__
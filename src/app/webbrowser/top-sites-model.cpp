@@ -0,0 +1,368 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "top-sites-model.h"
+
+// Qt
+#include <QtCore/QCryptographicHash>
+
+#define DEFAULT_LIMIT 10
+
+/* Same as Qt.md5() in QML */
+static QString hashOf(const QUrl& url)
+{
+    return QCryptographicHash::hash(url.toString().toUtf8(), QCryptographicHash::Md5).toHex();
+}
+
+/*!
+    \class TopSitesModel
+    \brief List model that exposes the most frecent entries of a HistoryModel
+
+    TopSitesModel lists the entries of a HistoryModel that are not hidden by
+    decreasing frecency, up to a limit (10 by default, a negative limit means
+    no limit). Entries with the same frecency are listed in the order in which
+    they were first seen, like a sort proxy would.
+
+    The URLs of all the entries that are not hidden are kept ranked in a map,
+    so when an entry of the source model is inserted, updated or removed it
+    only has to be moved to its new rank, and the next entry in the ranking
+    fills the place of a top entry that leaves. Row moves in the source model
+    don’t change the ranking and are ignored. Only URLs are kept, the roles
+    of the top entries are read from the source model.
+
+    contains() and containsHash() tell whether a URL, or the MD5 hash of a
+    URL, is one of the top entries.
+*/
+TopSitesModel::TopSitesModel(QObject* parent)
+    : QAbstractListModel(parent)
+    , m_sourceModel(0)
+    , m_limit(DEFAULT_LIMIT)
+    , m_sequence(0)
+{
+    connect(this, SIGNAL(modelReset()), SIGNAL(countChanged()));
+    connect(this, SIGNAL(rowsInserted(QModelIndex,int,int)), SIGNAL(countChanged()));
+    connect(this, SIGNAL(rowsRemoved(QModelIndex,int,int)), SIGNAL(countChanged()));
+}
+
+bool TopSitesModel::Rank::operator<(const Rank& other) const
+{
+    if (frecency != other.frecency) {
+        return frecency > other.frecency;
+    }
+    return sequence < other.sequence;
+}
+
+QHash<int, QByteArray> TopSitesModel::roleNames() const
+{
+    static QHash<int, QByteArray> roles;
+    if (roles.isEmpty()) {
+        roles[HistoryModel::Url] = "url";
+        roles[HistoryModel::Domain] = "domain";
+        roles[HistoryModel::Title] = "title";
+        roles[HistoryModel::Icon] = "icon";
+        roles[HistoryModel::Visits] = "visits";
+        roles[HistoryModel::LastVisit] = "lastVisit";
+        roles[HistoryModel::LastVisitDate] = "lastVisitDate";
+        roles[HistoryModel::LastVisitDateString] = "lastVisitDateString";
+        roles[HistoryModel::Hidden] = "hidden";
+        roles[HistoryModel::Frecency] = "frecency";
+    }
+    return roles;
+}
+
+int TopSitesModel::rowCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    return m_top.count();
+}
+
+QVariant TopSitesModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+    return sourceData(m_sourceModel->getEntryIndex(m_top.at(index.row())), role);
+}
+
+HistoryModel* TopSitesModel::sourceModel() const
+{
+    return m_sourceModel;
+}
+
+void TopSitesModel::setSourceModel(HistoryModel* sourceModel)
+{
+    if (sourceModel != m_sourceModel) {
+        beginResetModel();
+        if (m_sourceModel != 0) {
+            m_sourceModel->disconnect(this);
+        }
+        m_sourceModel = sourceModel;
+        populateModel();
+        if (m_sourceModel != 0) {
+            connect(m_sourceModel, SIGNAL(rowsInserted(const QModelIndex&, int, int)),
+                    SLOT(onRowsInserted(const QModelIndex&, int, int)));
+            connect(m_sourceModel, SIGNAL(rowsAboutToBeRemoved(const QModelIndex&, int, int)),
+                    SLOT(onRowsAboutToBeRemoved(const QModelIndex&, int, int)));
+            connect(m_sourceModel, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&)),
+                    SLOT(onDataChanged(const QModelIndex&, const QModelIndex&)));
+            connect(m_sourceModel, SIGNAL(modelReset()), SLOT(onModelReset()));
+            connect(m_sourceModel, SIGNAL(layoutChanged(QList<QPersistentModelIndex>, QAbstractItemModel::LayoutChangeHint)),
+                    SLOT(onModelReset()));
+        }
+        endResetModel();
+        Q_EMIT sourceModelChanged();
+    }
+}
+
+int TopSitesModel::limit() const
+{
+    return m_limit;
+}
+
+void TopSitesModel::setLimit(int limit)
+{
+    if (limit != m_limit) {
+        m_limit = limit;
+        if ((m_limit >= 0) && (m_top.count() > m_limit)) {
+            beginRemoveRows(QModelIndex(), m_limit, m_top.count() - 1);
+            for (int i = m_limit; i < m_top.count(); ++i) {
+                m_topRows.remove(m_top.at(i));
+                m_topHashes.remove(hashOf(m_top.at(i)));
+            }
+            m_top.resize(m_limit);
+            endRemoveRows();
+        } else {
+            fillTop();
+        }
+        Q_EMIT limitChanged();
+    }
+}
+
+QVariantMap TopSitesModel::get(int i) const
+{
+    QVariantMap item;
+    QHash<int, QByteArray> roles = roleNames();
+
+    QModelIndex modelIndex = index(i, 0);
+    if (modelIndex.isValid()) {
+        Q_FOREACH(int role, roles.keys()) {
+            QString roleName = QString::fromUtf8(roles.value(role));
+            item.insert(roleName, data(modelIndex, role));
+        }
+    }
+    return item;
+}
+
+/*!
+    Return true if \a url is one of the top entries.
+*/
+bool TopSitesModel::contains(const QUrl& url) const
+{
+    return m_topRows.contains(url);
+}
+
+/*!
+    Return true if \a hash is the MD5 hash (as computed by Qt.md5()) of the
+    URL of one of the top entries.
+*/
+bool TopSitesModel::containsHash(const QString& hash) const
+{
+    return m_topHashes.contains(hash);
+}
+
+void TopSitesModel::populateModel()
+{
+    m_ranking.clear();
+    m_ranks.clear();
+    m_top.clear();
+    m_topRows.clear();
+    m_topHashes.clear();
+    if (m_sourceModel != 0) {
+        int count = m_sourceModel->rowCount();
+        for (int i = 0; i < count; ++i) {
+            QUrl url = sourceData(i, HistoryModel::Url).toUrl();
+            if (!sourceData(i, HistoryModel::Hidden).toBool() && !m_ranks.contains(url)) {
+                Rank rank;
+                rank.frecency = sourceData(i, HistoryModel::Frecency).toDouble();
+                rank.sequence = m_sequence++;
+                m_ranking.insert(rank, url);
+                m_ranks.insert(url, rank);
+            }
+        }
+        QMap<Rank, QUrl>::const_iterator i;
+        for (i = m_ranking.constBegin(); i != m_ranking.constEnd(); ++i) {
+            if ((m_limit >= 0) && (m_top.count() >= m_limit)) {
+                break;
+            }
+            m_topRows.insert(i.value(), m_top.count());
+            m_top.append(i.value());
+            m_topHashes.insert(hashOf(i.value()));
+        }
+    }
+}
+
+QVariant TopSitesModel::sourceData(int row, int role) const
+{
+    return m_sourceModel->data(m_sourceModel->index(row, 0), role);
+}
+
+/*
+    Move the entry for \a url to its new rank (or out of the ranking if
+    \a row is -1 or if the entry at that row of the source model is hidden),
+    and update the top entries accordingly.
+*/
+void TopSitesModel::updateEntry(const QUrl& url, int row)
+{
+    int from = m_topRows.value(url, -1);
+
+    QHash<QUrl, Rank>::iterator ranked = m_ranks.find(url);
+    if (ranked != m_ranks.end()) {
+        m_ranking.remove(ranked.value());
+    }
+    if ((row == -1) || sourceData(row, HistoryModel::Hidden).toBool()) {
+        if (ranked != m_ranks.end()) {
+            m_ranks.erase(ranked);
+        }
+        if (from != -1) {
+            removeTop(from);
+            fillTop();
+        }
+        return;
+    }
+
+    // An entry keeps its place among the entries with the same frecency
+    // when its other roles change
+    double frecency = sourceData(row, HistoryModel::Frecency).toDouble();
+    if ((ranked == m_ranks.end()) || (ranked.value().frecency != frecency)) {
+        Rank rank;
+        rank.frecency = frecency;
+        rank.sequence = m_sequence++;
+        ranked = m_ranks.insert(url, rank);
+    }
+    QMap<Rank, QUrl>::const_iterator i = m_ranking.insert(ranked.value(), url);
+
+    // Only the first entries of the ranking need to be looked at to know
+    // whether the entry is one of the top entries
+    int to = 0;
+    QMap<Rank, QUrl>::const_iterator j = m_ranking.constBegin();
+    while ((j != i) && ((m_limit < 0) || (to < m_limit))) {
+        ++j;
+        ++to;
+    }
+    if ((m_limit >= 0) && (to >= m_limit)) {
+        to = -1;
+    }
+
+    if ((from == -1) && (to != -1)) {
+        if ((m_limit >= 0) && (m_top.count() >= m_limit)) {
+            removeTop(m_top.count() - 1);
+        }
+        insertTop(to, url);
+    } else if ((from != -1) && (to == -1)) {
+        removeTop(from);
+        fillTop();
+    } else if (from != -1) {
+        if (from != to) {
+            beginMoveRows(QModelIndex(), from, from, QModelIndex(), (to > from) ? to + 1 : to);
+            m_top.move(from, to);
+            for (int k = qMin(from, to); k <= qMax(from, to); ++k) {
+                m_topRows.insert(m_top.at(k), k);
+            }
+            endMoveRows();
+        }
+        Q_EMIT dataChanged(index(to, 0), index(to, 0));
+    }
+}
+
+TopSitesModel::Rank TopSitesModel::rankOf(const QUrl& url) const
+{
+    return m_ranks.value(url);
+}
+
+void TopSitesModel::insertTop(int index, const QUrl& url)
+{
+    beginInsertRows(QModelIndex(), index, index);
+    m_top.insert(index, url);
+    for (int i = index; i < m_top.count(); ++i) {
+        m_topRows.insert(m_top.at(i), i);
+    }
+    m_topHashes.insert(hashOf(url));
+    endInsertRows();
+}
+
+void TopSitesModel::removeTop(int index)
+{
+    beginRemoveRows(QModelIndex(), index, index);
+    const QUrl url = m_top.at(index);
+    m_topRows.remove(url);
+    m_topHashes.remove(hashOf(url));
+    m_top.remove(index);
+    for (int i = index; i < m_top.count(); ++i) {
+        m_topRows.insert(m_top.at(i), i);
+    }
+    endRemoveRows();
+}
+
+/*
+    Append the next entries of the ranking to the top entries, up to the limit.
+*/
+void TopSitesModel::fillTop()
+{
+    while ((m_limit < 0) || (m_top.count() < m_limit)) {
+        QMap<Rank, QUrl>::const_iterator next;
+        if (m_top.isEmpty()) {
+            next = m_ranking.constBegin();
+        } else {
+            next = m_ranking.upperBound(rankOf(m_top.last()));
+        }
+        if (next == m_ranking.constEnd()) {
+            break;
+        }
+        insertTop(m_top.count(), next.value());
+    }
+}
+
+void TopSitesModel::onRowsInserted(const QModelIndex& parent, int start, int end)
+{
+    Q_UNUSED(parent);
+    for (int i = start; i <= end; ++i) {
+        updateEntry(sourceData(i, HistoryModel::Url).toUrl(), i);
+    }
+}
+
+void TopSitesModel::onRowsAboutToBeRemoved(const QModelIndex& parent, int start, int end)
+{
+    Q_UNUSED(parent);
+    for (int i = start; i <= end; ++i) {
+        updateEntry(sourceData(i, HistoryModel::Url).toUrl(), -1);
+    }
+}
+
+void TopSitesModel::onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+    for (int i = topLeft.row(); i <= bottomRight.row(); ++i) {
+        updateEntry(sourceData(i, HistoryModel::Url).toUrl(), i);
+    }
+}
+
+void TopSitesModel::onModelReset()
+{
+    beginResetModel();
+    populateModel();
+    endResetModel();
+}
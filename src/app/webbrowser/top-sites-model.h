@@ -0,0 +1,101 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TOP_SITES_MODEL_H__
+#define __TOP_SITES_MODEL_H__
+
+// Qt
+#include <QtCore/QAbstractListModel>
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QUrl>
+#include <QtCore/QVector>
+
+#include "history-model.h"
+
+class TopSitesModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+    Q_PROPERTY(HistoryModel* sourceModel READ sourceModel WRITE setSourceModel NOTIFY sourceModelChanged)
+    Q_PROPERTY(int limit READ limit WRITE setLimit NOTIFY limitChanged)
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+public:
+    TopSitesModel(QObject* parent=0);
+
+    // reimplemented from QAbstractListModel
+    QHash<int, QByteArray> roleNames() const;
+    int rowCount(const QModelIndex& parent=QModelIndex()) const;
+    QVariant data(const QModelIndex& index, int role) const;
+
+    HistoryModel* sourceModel() const;
+    void setSourceModel(HistoryModel* sourceModel);
+
+    int limit() const;
+    void setLimit(int limit);
+
+    Q_INVOKABLE QVariantMap get(int index) const;
+    Q_INVOKABLE bool contains(const QUrl& url) const;
+    Q_INVOKABLE bool containsHash(const QString& hash) const;
+
+Q_SIGNALS:
+    void sourceModelChanged() const;
+    void limitChanged() const;
+    void countChanged();
+
+private Q_SLOTS:
+    void onRowsInserted(const QModelIndex& parent, int start, int end);
+    void onRowsAboutToBeRemoved(const QModelIndex& parent, int start, int end);
+    void onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight);
+    void onModelReset();
+
+private:
+    // Position of an entry in the ranking: by decreasing frecency, and for
+    // entries with the same frecency in the order in which they were ranked
+    struct Rank {
+        double frecency;
+        quint64 sequence;
+        bool operator<(const Rank& other) const;
+    };
+
+    HistoryModel* m_sourceModel;
+    int m_limit;
+    quint64 m_sequence;
+    // The URLs of all the entries that are not hidden, and the rank of each
+    // one by URL
+    QMap<Rank, QUrl> m_ranking;
+    QHash<QUrl, Rank> m_ranks;
+    // The URLs of the first entries of the ranking, up to the limit, whose
+    // roles are read from the source model, and the row of each one
+    QVector<QUrl> m_top;
+    QHash<QUrl, int> m_topRows;
+    QSet<QString> m_topHashes;
+
+    void populateModel();
+    QVariant sourceData(int row, int role) const;
+    void updateEntry(const QUrl& url, int row);
+    Rank rankOf(const QUrl& url) const;
+    void insertTop(int index, const QUrl& url);
+    void removeTop(int index);
+    void fillTop();
+};
+
+#endif // __TOP_SITES_MODEL_H__
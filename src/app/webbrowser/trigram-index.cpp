@@ -0,0 +1,290 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "text-search-matcher.h"
+#include "trigram-index.h"
+
+// std
+#include <algorithm>
+
+/* The distinct trigrams of a word, padded with two spaces before and one after */
+static QVector<quint64> trigrams(const QString& word)
+{
+    QString padded = QLatin1String("  ") + word + QLatin1Char(' ');
+    QVector<quint64> result;
+    result.reserve(padded.size() - 2);
+    for (int i = 0; i + 2 < padded.size(); ++i) {
+        result.append((quint64(padded.at(i).unicode()) << 32) |
+                      (quint64(padded.at(i + 1).unicode()) << 16) |
+                      quint64(padded.at(i + 2).unicode()));
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+/* Ratio of the trigrams two words share to the trigrams of either */
+static double jaccard(int shared, int a, int b)
+{
+    return double(shared) / (a + b - shared);
+}
+
+/*!
+    \class TrigramIndex
+    \brief Index of the words of documents by trigrams, for fuzzy matching
+
+    TrigramIndex splits documents into normalized words (see
+    TextSearchMatcher::normalized()), and indexes the distinct words by
+    their trigrams. Searching looks up the trigrams of each word of the
+    query, and scores the words that share enough of them, so that
+    misspelled or incomplete words still match: “gthub” matches “github”
+    with a similarity of 4/9.
+
+    Documents are identified by integers chosen by the caller. Removing a
+    document doesn’t go through the lists of documents of its words right
+    away, they are compacted once half of their entries are stale.
+*/
+TrigramIndex::TrigramIndex()
+{
+}
+
+int TrigramIndex::count() const
+{
+    return m_documents.count();
+}
+
+int TrigramIndex::wordCount() const
+{
+    return m_wordIds.count();
+}
+
+/*!
+    Split \a text into distinct normalized words, that is sequences of letters
+    and digits.
+*/
+QStringList TrigramIndex::words(const QString& text)
+{
+    QString normalized = TextSearchMatcher::normalized(text);
+    QStringList result;
+    int start = -1;
+    for (int i = 0; i <= normalized.size(); ++i) {
+        bool inWord = (i < normalized.size()) && normalized.at(i).isLetterOrNumber();
+        if (inWord && (start == -1)) {
+            start = i;
+        } else if (!inWord && (start != -1)) {
+            QString word = normalized.mid(start, i - start);
+            if (!result.contains(word)) {
+                result.append(word);
+            }
+            start = -1;
+        }
+    }
+    return result;
+}
+
+/*!
+    The similarity of two normalized words, from 0 (no trigram in common) to
+    1 (the same trigrams).
+*/
+double TrigramIndex::similarity(const QString& a, const QString& b)
+{
+    QVector<quint64> x = trigrams(a);
+    QVector<quint64> y = trigrams(b);
+    QVector<quint64> shared;
+    std::set_intersection(x.constBegin(), x.constEnd(), y.constBegin(), y.constEnd(),
+                          std::back_inserter(shared));
+    return jaccard(shared.count(), x.count(), y.count());
+}
+
+/*!
+    Index \a text as the contents of \a document, replacing its previous
+    contents if any.
+*/
+void TrigramIndex::insert(int document, const QString& text)
+{
+    remove(document);
+    QVector<int> ids;
+    Q_FOREACH(const QString& word, words(text)) {
+        int id = addWord(word);
+        m_words[id].documents.append(document);
+        ids.append(id);
+    }
+    m_documents.insert(document, ids);
+}
+
+void TrigramIndex::remove(int document)
+{
+    QHash<int, QVector<int>>::iterator i = m_documents.find(document);
+    if (i == m_documents.end()) {
+        return;
+    }
+    QVector<int> ids = i.value();
+    m_documents.erase(i);
+    Q_FOREACH(int id, ids) {
+        Word& word = m_words[id];
+        if (++word.stale * 2 < word.documents.count()) {
+            continue;
+        }
+        // Also drops the duplicates left by documents indexed again
+        QVector<int> documents;
+        Q_FOREACH(int other, word.documents) {
+            if (m_documents.value(other).contains(id)) {
+                documents.append(other);
+            }
+        }
+        std::sort(documents.begin(), documents.end());
+        documents.erase(std::unique(documents.begin(), documents.end()), documents.end());
+        word.documents = documents;
+        word.stale = 0;
+        if (documents.isEmpty()) {
+            removeWord(id);
+        }
+    }
+}
+
+void TrigramIndex::clear()
+{
+    m_words.clear();
+    m_freeWords.clear();
+    m_wordIds.clear();
+    m_postings.clear();
+    m_documents.clear();
+}
+
+int TrigramIndex::addWord(const QString& text)
+{
+    int id = m_wordIds.value(text, -1);
+    if (id != -1) {
+        return id;
+    }
+    if (m_freeWords.isEmpty()) {
+        id = m_words.count();
+        m_words.append(Word());
+    } else {
+        id = m_freeWords.takeLast();
+    }
+    QVector<quint64> grams = trigrams(text);
+    Word& word = m_words[id];
+    word.text = text;
+    word.trigramCount = grams.count();
+    word.stale = 0;
+    Q_FOREACH(quint64 trigram, grams) {
+        m_postings[trigram].append(id);
+    }
+    m_wordIds.insert(text, id);
+    return id;
+}
+
+void TrigramIndex::removeWord(int id)
+{
+    Word& word = m_words[id];
+    Q_FOREACH(quint64 trigram, trigrams(word.text)) {
+        QHash<quint64, QVector<int>>::iterator i = m_postings.find(trigram);
+        if (i == m_postings.end()) {
+            continue;
+        }
+        QVector<int>& ids = i.value();
+        int index = ids.indexOf(id);
+        if (index != -1) {
+            ids[index] = ids.last();
+            ids.removeLast();
+        }
+        if (ids.isEmpty()) {
+            m_postings.erase(i);
+        }
+    }
+    m_wordIds.remove(word.text);
+    word = Word();
+    m_freeWords.append(id);
+}
+
+/*!
+    Find the documents that have, for each word of \a query, a word whose
+    similarity to it is at least \a threshold. Their similarity to the query
+    is the average of the best similarities for each word. At most \a limit
+    documents are returned, the most similar first.
+*/
+QVector<TrigramIndex::Match> TrigramIndex::search(const QString& query, double threshold, int limit) const
+{
+    QVector<Match> matches;
+    QStringList queryWords = words(query);
+    if (queryWords.isEmpty() || (limit <= 0)) {
+        return matches;
+    }
+
+    // Sum of the best similarities for the query words so far, for the
+    // documents that match all of them
+    QHash<int, double> scores;
+    for (int q = 0; q < queryWords.count(); ++q) {
+        QVector<quint64> grams = trigrams(queryWords.at(q));
+        QHash<int, int> shared;
+        Q_FOREACH(quint64 trigram, grams) {
+            QHash<quint64, QVector<int>>::const_iterator i = m_postings.constFind(trigram);
+            if (i != m_postings.constEnd()) {
+                Q_FOREACH(int id, i.value()) {
+                    ++shared[id];
+                }
+            }
+        }
+
+        QHash<int, double> best;
+        for (QHash<int, int>::const_iterator i = shared.constBegin(); i != shared.constEnd(); ++i) {
+            const Word& word = m_words.at(i.key());
+            double similarity = jaccard(i.value(), grams.count(), word.trigramCount);
+            if (similarity < threshold) {
+                continue;
+            }
+            Q_FOREACH(int document, word.documents) {
+                if ((q > 0) && !scores.contains(document)) {
+                    continue;
+                }
+                // Skip stale entries
+                if (!m_documents.value(document).contains(i.key())) {
+                    continue;
+                }
+                double& score = best[document];
+                score = qMax(score, similarity);
+            }
+        }
+
+        QHash<int, double> next;
+        for (QHash<int, double>::const_iterator i = best.constBegin(); i != best.constEnd(); ++i) {
+            next.insert(i.key(), scores.value(i.key()) + i.value());
+        }
+        scores.swap(next);
+        if (scores.isEmpty()) {
+            return matches;
+        }
+    }
+
+    matches.reserve(scores.count());
+    for (QHash<int, double>::const_iterator i = scores.constBegin(); i != scores.constEnd(); ++i) {
+        Match match;
+        match.document = i.key();
+        match.similarity = i.value() / queryWords.count();
+        matches.append(match);
+    }
+    std::sort(matches.begin(), matches.end(), [] (const Match& a, const Match& b) {
+        return (a.similarity > b.similarity) ||
+               ((a.similarity == b.similarity) && (a.document < b.document));
+    });
+    if (matches.count() > limit) {
+        matches.resize(limit);
+    }
+    return matches;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TRIGRAM_INDEX_H__
+#define __TRIGRAM_INDEX_H__
+
+// Qt
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+class TrigramIndex
+{
+public:
+    TrigramIndex();
+
+    struct Match {
+        int document;
+        double similarity;
+    };
+
+    int count() const;
+    int wordCount() const;
+
+    void insert(int document, const QString& text);
+    void remove(int document);
+    void clear();
+
+    QVector<Match> search(const QString& query, double threshold, int limit) const;
+
+    static QStringList words(const QString& text);
+    static double similarity(const QString& a, const QString& b);
+
+private:
+    struct Word {
+        QString text;
+        int trigramCount;
+        // Documents that contain the word, including stale entries for
+        // documents that were removed or indexed again since
+        QVector<int> documents;
+        int stale;
+    };
+
+    QVector<Word> m_words;
+    QVector<int> m_freeWords;
+    QHash<QString, int> m_wordIds;
+    // Ids of the words that contain each trigram
+    QHash<quint64, QVector<int>> m_postings;
+    // Ids of the words of each document
+    QHash<int, QVector<int>> m_documents;
+
+    int addWord(const QString& text);
+    void removeWord(int id);
+};
+
+Q_DECLARE_TYPEINFO(TrigramIndex::Match, Q_PRIMITIVE_TYPE);
+
+#endif // __TRIGRAM_INDEX_H__
@@ -0,0 +1,451 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "window-proxy-model.h"
+
+/* Number of rows in a window over a model with sourceCount rows */
+static int windowCount(int sourceCount, int offset, int limit)
+{
+    int count = qMax(0, sourceCount - offset);
+    return (limit < 0) ? count : qMin(count, limit);
+}
+
+/*!
+    \class WindowProxyModel
+    \brief Proxy model that exposes a window of the rows of a list model
+
+    WindowProxyModel exposes the rows of a list model from 'offset', up to
+    'limit' rows (a negative limit means all the rows after the offset), so
+    that views over very long lists only deal with the rows they show.
+
+    Source rows inserted, removed or moved after the window don’t cause any
+    signal. When the rows of the window change because rows were inserted,
+    removed or moved before it or across its bounds, only rows that actually
+    appear or disappear are inserted or removed, the other rows of the
+    window are reported with a single dataChanged() signal.
+
+    Moving the window with setWindow() or setOffset() emits a single layout
+    change when the number of rows stays the same, and resets the model
+    otherwise.
+
+    get() only reads the roles it is given, and getRole() reads a single
+    role, looking up role names in a table built once per source model.
+*/
+WindowProxyModel::WindowProxyModel(QObject* parent)
+    : QAbstractProxyModel(parent)
+    , m_offset(0)
+    , m_limit(-1)
+    , m_sourceInserting(false)
+    , m_sourceRemoving(false)
+    , m_sourceMoving(false)
+    , m_dataChangedBegin(-1)
+    , m_dataChangedEnd(-1)
+{
+    connect(this, SIGNAL(modelReset()), SIGNAL(countChanged()));
+    connect(this, SIGNAL(rowsInserted(QModelIndex,int,int)), SIGNAL(countChanged()));
+    connect(this, SIGNAL(rowsRemoved(QModelIndex,int,int)), SIGNAL(countChanged()));
+}
+
+QAbstractItemModel* WindowProxyModel::sourceModel() const
+{
+    return QAbstractProxyModel::sourceModel();
+}
+
+void WindowProxyModel::setSourceModel(QObject* sourceModel)
+{
+    QAbstractItemModel* model = qobject_cast<QAbstractItemModel*>(sourceModel);
+    if (model != this->sourceModel()) {
+        beginResetModel();
+        if (this->sourceModel() != 0) {
+            this->sourceModel()->disconnect(this);
+        }
+        QAbstractProxyModel::setSourceModel(model);
+        updateRoles();
+        if (model != 0) {
+            connect(model, SIGNAL(rowsAboutToBeInserted(const QModelIndex&, int, int)),
+                    SLOT(onSourceRowsAboutToBeInserted(const QModelIndex&, int, int)));
+            connect(model, SIGNAL(rowsInserted(const QModelIndex&, int, int)),
+                    SLOT(onSourceRowsInserted(const QModelIndex&, int, int)));
+            connect(model, SIGNAL(rowsAboutToBeRemoved(const QModelIndex&, int, int)),
+                    SLOT(onSourceRowsAboutToBeRemoved(const QModelIndex&, int, int)));
+            connect(model, SIGNAL(rowsRemoved(const QModelIndex&, int, int)),
+                    SLOT(onSourceRowsRemoved(const QModelIndex&, int, int)));
+            connect(model, SIGNAL(rowsAboutToBeMoved(const QModelIndex&, int, int, const QModelIndex&, int)),
+                    SLOT(onSourceRowsAboutToBeMoved(const QModelIndex&, int, int, const QModelIndex&, int)));
+            connect(model, SIGNAL(rowsMoved(const QModelIndex&, int, int, const QModelIndex&, int)),
+                    SLOT(onSourceRowsMoved(const QModelIndex&, int, int, const QModelIndex&, int)));
+            connect(model, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)),
+                    SLOT(onSourceDataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)));
+            connect(model, SIGNAL(modelAboutToBeReset()), SLOT(onSourceModelAboutToBeReset()));
+            connect(model, SIGNAL(modelReset()), SLOT(onSourceModelReset()));
+            connect(model, SIGNAL(layoutAboutToBeChanged(QList<QPersistentModelIndex>, QAbstractItemModel::LayoutChangeHint)),
+                    SLOT(onSourceModelAboutToBeReset()));
+            connect(model, SIGNAL(layoutChanged(QList<QPersistentModelIndex>, QAbstractItemModel::LayoutChangeHint)),
+                    SLOT(onSourceModelReset()));
+        }
+        endResetModel();
+        Q_EMIT sourceModelChanged();
+        Q_EMIT totalCountChanged();
+    }
+}
+
+int WindowProxyModel::offset() const
+{
+    return m_offset;
+}
+
+void WindowProxyModel::setOffset(int offset)
+{
+    setWindow(offset, m_limit);
+}
+
+int WindowProxyModel::limit() const
+{
+    return m_limit;
+}
+
+void WindowProxyModel::setLimit(int limit)
+{
+    if (limit != m_limit) {
+        int count = rowCount();
+        int newCount = windowCount(totalCount(), m_offset, limit);
+        if (newCount > count) {
+            beginInsertRows(QModelIndex(), count, newCount - 1);
+            m_limit = limit;
+            endInsertRows();
+        } else if (newCount < count) {
+            beginRemoveRows(QModelIndex(), newCount, count - 1);
+            m_limit = limit;
+            endRemoveRows();
+        } else {
+            m_limit = limit;
+        }
+        Q_EMIT limitChanged();
+    }
+}
+
+int WindowProxyModel::totalCount() const
+{
+    return (sourceModel() != 0) ? sourceModel()->rowCount() : 0;
+}
+
+/*!
+    Move the window to start at \a offset and to contain up to \a limit rows.
+*/
+void WindowProxyModel::setWindow(int offset, int limit)
+{
+    offset = qMax(0, offset);
+    if (offset == m_offset) {
+        setLimit(limit);
+        return;
+    }
+
+    bool limitChanged = (limit != m_limit);
+    int count = rowCount();
+    int newCount = windowCount(totalCount(), offset, limit);
+    if (newCount == count) {
+        Q_EMIT layoutAboutToBeChanged();
+        // Rows that remain in the window keep their persistent indexes
+        QModelIndexList from = persistentIndexList();
+        QModelIndexList to;
+        Q_FOREACH(const QModelIndex& index, from) {
+            int row = index.row() + m_offset - offset;
+            if ((row >= 0) && (row < newCount)) {
+                to.append(createIndex(row, index.column()));
+            } else {
+                to.append(QModelIndex());
+            }
+        }
+        m_offset = offset;
+        m_limit = limit;
+        changePersistentIndexList(from, to);
+        Q_EMIT layoutChanged();
+    } else {
+        beginResetModel();
+        m_offset = offset;
+        m_limit = limit;
+        endResetModel();
+    }
+
+    Q_EMIT offsetChanged();
+    if (limitChanged) {
+        Q_EMIT this->limitChanged();
+    }
+}
+
+QModelIndex WindowProxyModel::index(int row, int column, const QModelIndex& parent) const
+{
+    if (!hasIndex(row, column, parent)) {
+        return QModelIndex();
+    }
+    return createIndex(row, column);
+}
+
+QModelIndex WindowProxyModel::parent(const QModelIndex& child) const
+{
+    Q_UNUSED(child);
+    return QModelIndex();
+}
+
+int WindowProxyModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return windowCount(totalCount(), m_offset, m_limit);
+}
+
+int WindowProxyModel::columnCount(const QModelIndex& parent) const
+{
+    if (parent.isValid() || (sourceModel() == 0)) {
+        return 0;
+    }
+    return 1;
+}
+
+QModelIndex WindowProxyModel::mapToSource(const QModelIndex& proxyIndex) const
+{
+    if (!proxyIndex.isValid() || (sourceModel() == 0)) {
+        return QModelIndex();
+    }
+    return sourceModel()->index(proxyIndex.row() + m_offset, proxyIndex.column());
+}
+
+QModelIndex WindowProxyModel::mapFromSource(const QModelIndex& sourceIndex) const
+{
+    if (!sourceIndex.isValid()) {
+        return QModelIndex();
+    }
+    return index(sourceIndex.row() - m_offset, sourceIndex.column());
+}
+
+/*!
+    Return the values of \a roles for the row at \a index, or of all the roles
+    if \a roles is empty.
+*/
+QVariantMap WindowProxyModel::get(int i, const QStringList& roles) const
+{
+    QVariantMap item;
+    QModelIndex modelIndex = index(i, 0);
+    if (modelIndex.isValid()) {
+        if (roles.isEmpty()) {
+            QHash<QString, int>::const_iterator role;
+            for (role = m_roles.constBegin(); role != m_roles.constEnd(); ++role) {
+                item.insert(role.key(), data(modelIndex, role.value()));
+            }
+        } else {
+            Q_FOREACH(const QString& name, roles) {
+                QHash<QString, int>::const_iterator role = m_roles.constFind(name);
+                if (role != m_roles.constEnd()) {
+                    item.insert(name, data(modelIndex, role.value()));
+                }
+            }
+        }
+    }
+    return item;
+}
+
+/*!
+    Return the value of \a role for the row at \a index.
+*/
+QVariant WindowProxyModel::getRole(int i, const QString& role) const
+{
+    QHash<QString, int>::const_iterator id = m_roles.constFind(role);
+    if (id == m_roles.constEnd()) {
+        return QVariant();
+    }
+    return data(index(i, 0), id.value());
+}
+
+void WindowProxyModel::updateRoles()
+{
+    m_roles.clear();
+    if (sourceModel() != 0) {
+        QHash<int, QByteArray> names = sourceModel()->roleNames();
+        QHash<int, QByteArray>::const_iterator i;
+        for (i = names.constBegin(); i != names.constEnd(); ++i) {
+            m_roles.insert(QString::fromUtf8(i.value()), i.key());
+        }
+    }
+}
+
+void WindowProxyModel::setDataChanged(int begin, int end)
+{
+    if (begin <= end) {
+        m_dataChangedBegin = begin;
+        m_dataChangedEnd = end;
+    }
+}
+
+void WindowProxyModel::emitDataChanged()
+{
+    if ((m_dataChangedBegin != -1) && (m_dataChangedEnd != -1)) {
+        Q_EMIT dataChanged(index(m_dataChangedBegin, 0), index(m_dataChangedEnd, 0));
+        m_dataChangedBegin = -1;
+        m_dataChangedEnd = -1;
+    }
+}
+
+void WindowProxyModel::onSourceRowsAboutToBeInserted(const QModelIndex& parent, int start, int end)
+{
+    if (parent.isValid()) {
+        return;
+    }
+    int inserted = end - start + 1;
+    int count = rowCount();
+    int newCount = windowCount(totalCount() + inserted, m_offset, m_limit);
+    int row = start - m_offset;
+    if (row < 0) {
+        // The rows of the window are pushed down, rows that were before it
+        // take their place
+        if (newCount > count) {
+            beginInsertRows(QModelIndex(), count, newCount - 1);
+            m_sourceInserting = true;
+        }
+        setDataChanged(0, count - 1);
+    } else if ((row <= count) && ((m_limit < 0) || (row < m_limit))) {
+        int added = newCount - count;
+        if (added > 0) {
+            beginInsertRows(QModelIndex(), row, row + added - 1);
+            m_sourceInserting = true;
+        }
+        if (added < inserted) {
+            // The window is full, the rows after the inserted ones are
+            // pushed down and the last ones out of it
+            setDataChanged(row + added, newCount - 1);
+        }
+    }
+}
+
+void WindowProxyModel::onSourceRowsInserted(const QModelIndex& parent, int start, int end)
+{
+    Q_UNUSED(start);
+    Q_UNUSED(end);
+    if (parent.isValid()) {
+        return;
+    }
+    if (m_sourceInserting) {
+        endInsertRows();
+        m_sourceInserting = false;
+    }
+    emitDataChanged();
+    Q_EMIT totalCountChanged();
+}
+
+void WindowProxyModel::onSourceRowsAboutToBeRemoved(const QModelIndex& parent, int start, int end)
+{
+    if (parent.isValid()) {
+        return;
+    }
+    int count = rowCount();
+    int newCount = windowCount(totalCount() - (end - start + 1), m_offset, m_limit);
+    int row = start - m_offset;
+    if (row < 0) {
+        // The rows of the window are pulled up, rows that were after it
+        // take their place
+        if (newCount < count) {
+            beginRemoveRows(QModelIndex(), newCount, count - 1);
+            m_sourceRemoving = true;
+        }
+        setDataChanged(0, newCount - 1);
+    } else if (row < count) {
+        int removed = count - newCount;
+        if (removed > 0) {
+            beginRemoveRows(QModelIndex(), row, row + removed - 1);
+            m_sourceRemoving = true;
+        }
+        if (removed < qMin(end - m_offset, count - 1) - row + 1) {
+            // Rows that were after the window take the place of the
+            // removed ones
+            setDataChanged(row, newCount - 1);
+        }
+    }
+}
+
+void WindowProxyModel::onSourceRowsRemoved(const QModelIndex& parent, int start, int end)
+{
+    Q_UNUSED(start);
+    Q_UNUSED(end);
+    if (parent.isValid()) {
+        return;
+    }
+    if (m_sourceRemoving) {
+        endRemoveRows();
+        m_sourceRemoving = false;
+    }
+    emitDataChanged();
+    Q_EMIT totalCountChanged();
+}
+
+void WindowProxyModel::onSourceRowsAboutToBeMoved(const QModelIndex& sourceParent, int start, int end,
+                                                  const QModelIndex& destinationParent, int destination)
+{
+    if (sourceParent.isValid() || destinationParent.isValid()) {
+        return;
+    }
+    int first = m_offset;
+    int last = m_offset + rowCount() - 1;
+    if ((start >= first) && (end <= last) && (destination >= first) && (destination <= last + 1)) {
+        m_sourceMoving = beginMoveRows(QModelIndex(), start - m_offset, end - m_offset,
+                                       QModelIndex(), destination - m_offset);
+    } else {
+        // Rows move in or out of the window, the rows that change are
+        // those between the moved rows and their destination
+        int begin = qMin(start, destination);
+        int stop = (destination > end) ? destination - 1 : end;
+        setDataChanged(qMax(begin, first) - m_offset, qMin(stop, last) - m_offset);
+    }
+}
+
+void WindowProxyModel::onSourceRowsMoved(const QModelIndex& sourceParent, int start, int end,
+                                         const QModelIndex& destinationParent, int destination)
+{
+    Q_UNUSED(start);
+    Q_UNUSED(end);
+    Q_UNUSED(destination);
+    if (sourceParent.isValid() || destinationParent.isValid()) {
+        return;
+    }
+    if (m_sourceMoving) {
+        endMoveRows();
+        m_sourceMoving = false;
+    }
+    emitDataChanged();
+}
+
+void WindowProxyModel::onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight,
+                                           const QVector<int>& roles)
+{
+    int begin = qMax(topLeft.row() - m_offset, 0);
+    int end = qMin(bottomRight.row() - m_offset, rowCount() - 1);
+    if (begin <= end) {
+        Q_EMIT dataChanged(index(begin, 0), index(end, 0), roles);
+    }
+}
+
+void WindowProxyModel::onSourceModelAboutToBeReset()
+{
+    beginResetModel();
+}
+
+void WindowProxyModel::onSourceModelReset()
+{
+    updateRoles();
+    endResetModel();
+    Q_EMIT totalCountChanged();
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __WINDOW_PROXY_MODEL_H__
+#define __WINDOW_PROXY_MODEL_H__
+
+// Qt
+#include <QtCore/QAbstractProxyModel>
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+class WindowProxyModel : public QAbstractProxyModel
+{
+    Q_OBJECT
+
+    Q_PROPERTY(QObject* sourceModel READ sourceModel WRITE setSourceModel NOTIFY sourceModelChanged)
+    Q_PROPERTY(int offset READ offset WRITE setOffset NOTIFY offsetChanged)
+    Q_PROPERTY(int limit READ limit WRITE setLimit NOTIFY limitChanged)
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    Q_PROPERTY(int totalCount READ totalCount NOTIFY totalCountChanged)
+
+public:
+    WindowProxyModel(QObject* parent=0);
+
+    QAbstractItemModel* sourceModel() const;
+    void setSourceModel(QObject* sourceModel);
+
+    int offset() const;
+    void setOffset(int offset);
+
+    int limit() const;
+    void setLimit(int limit);
+
+    int totalCount() const;
+
+    Q_INVOKABLE void setWindow(int offset, int limit);
+
+    // reimplemented from QAbstractProxyModel
+    QModelIndex index(int row, int column, const QModelIndex& parent=QModelIndex()) const;
+    QModelIndex parent(const QModelIndex& child) const;
+    int rowCount(const QModelIndex& parent=QModelIndex()) const;
+    int columnCount(const QModelIndex& parent=QModelIndex()) const;
+    QModelIndex mapToSource(const QModelIndex& proxyIndex) const;
+    QModelIndex mapFromSource(const QModelIndex& sourceIndex) const;
+
+    Q_INVOKABLE QVariantMap get(int index, const QStringList& roles=QStringList()) const;
+    Q_INVOKABLE QVariant getRole(int index, const QString& role) const;
+
+Q_SIGNALS:
+    void sourceModelChanged() const;
+    void offsetChanged() const;
+    void limitChanged() const;
+    void countChanged();
+    void totalCountChanged();
+
+private Q_SLOTS:
+    void onSourceRowsAboutToBeInserted(const QModelIndex& parent, int start, int end);
+    void onSourceRowsInserted(const QModelIndex& parent, int start, int end);
+    void onSourceRowsAboutToBeRemoved(const QModelIndex& parent, int start, int end);
+    void onSourceRowsRemoved(const QModelIndex& parent, int start, int end);
+    void onSourceRowsAboutToBeMoved(const QModelIndex& sourceParent, int start, int end,
+                                    const QModelIndex& destinationParent, int destination);
+    void onSourceRowsMoved(const QModelIndex& sourceParent, int start, int end,
+                           const QModelIndex& destinationParent, int destination);
+    void onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight,
+                             const QVector<int>& roles);
+    void onSourceModelAboutToBeReset();
+    void onSourceModelReset();
+
+private:
+    int m_offset;
+    int m_limit;
+    // Role of each role name of the source model
+    QHash<QString, int> m_roles;
+    bool m_sourceInserting;
+    bool m_sourceRemoving;
+    bool m_sourceMoving;
+    int m_dataChangedBegin;
+    int m_dataChangedEnd;
+
+    void updateRoles();
+    void setDataChanged(int begin, int end);
+    void emitDataChanged();
+};
+
+#endif // __WINDOW_PROXY_MODEL_H__
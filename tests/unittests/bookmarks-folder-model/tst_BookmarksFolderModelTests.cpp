@@ -120,6 +120,43 @@ private Q_SLOTS:
         model->setFolder("SaMpLe");
         QCOMPARE(model->rowCount(), 0);
     }
+
+    void shouldFollowEntriesMovedBetweenFolders()
+    {
+        bookmarks->add(QUrl("http://example.org/"), "Example Domain Org", QUrl(), "SampleFolder");
+        bookmarks->add(QUrl("http://example.com/"), "Example Domain Com", QUrl(), "");
+        bookmarks->add(QUrl("http://example.net/"), "Example Domain Net", QUrl(), "SampleFolder");
+        model->setFolder("SampleFolder");
+        QCOMPARE(model->rowCount(), 2);
+
+        QSignalSpy spyInserted(model, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
+        QSignalSpy spyRemoved(model, SIGNAL(rowsRemoved(const QModelIndex&, int, int)));
+        QSignalSpy spyCount(model, SIGNAL(countChanged()));
+        qRegisterMetaType<QVector<int> >();
+        QSignalSpy spyChanged(model, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)));
+
+        bookmarks->update(QUrl("http://example.com/"), "Example Domain Com", "SampleFolder");
+        QCOMPARE(spyInserted.count(), 1);
+        QCOMPARE(spyInserted.first().at(1).toInt(), 1);
+        QCOMPARE(spyCount.count(), 1);
+        QCOMPARE(model->rowCount(), 3);
+        QCOMPARE(model->data(model->index(1, 0), BookmarksModel::Url).toUrl(), QUrl("http://example.com/"));
+
+        spyChanged.clear();
+        bookmarks->update(QUrl("http://example.org/"), "Org", "SampleFolder");
+        QCOMPARE(spyChanged.count(), 1);
+        QCOMPARE(spyChanged.first().at(0).toModelIndex().row(), 2);
+        QCOMPARE(model->get(2).value("title").toString(), QString("Org"));
+
+        bookmarks->update(QUrl("http://example.net/"), "Example Domain Net", "");
+        QCOMPARE(spyRemoved.count(), 1);
+        QCOMPARE(spyRemoved.first().at(1).toInt(), 0);
+        bookmarks->remove(QUrl("http://example.org/"));
+        QCOMPARE(spyRemoved.count(), 2);
+        QCOMPARE(model->rowCount(), 1);
+        QCOMPARE(model->data(model->index(0, 0), BookmarksModel::Url).toUrl(), QUrl("http://example.com/"));
+        QVERIFY(!model->data(model->index(1, 0), BookmarksModel::Url).isValid());
+    }
 };
 
 QTEST_MAIN(BookmarksFolderModelTests)
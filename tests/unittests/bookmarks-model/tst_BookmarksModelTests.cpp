@@ -19,6 +19,8 @@
 // Qt
 #include <QtCore/QDir>
 #include <QtCore/QTemporaryFile>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
 #include <QtTest/QSignalSpy>
 #include <QtTest/QtTest>
 
@@ -32,6 +34,13 @@ class BookmarksModelTests : public QObject
 private:
     BookmarksModel* model;
 
+    void setDatabasePath(BookmarksModel* bookmarks, const QString& fileName)
+    {
+        QSignalSpy spyLoaded(bookmarks, SIGNAL(loaded()));
+        bookmarks->setDatabasePath(fileName);
+        QTRY_COMPARE(spyLoaded.count(), 1);
+    }
+
 private Q_SLOTS:
     void init()
     {
@@ -112,6 +121,27 @@ private Q_SLOTS:
         QVERIFY(spy.isEmpty());
     }
 
+    void shouldKeepOrderWhenRemovingAndAddingEntries()
+    {
+        for (int i = 0; i < 5; ++i) {
+            model->add(QUrl(QString("http://example.org/%1").arg(i)), "Example", QUrl(), "");
+        }
+        model->remove(QUrl("http://example.org/3"));
+        model->remove(QUrl("http://example.org/1"));
+        // The ids of removed entries are reused
+        model->add(QUrl("http://example.org/5"), "Example", QUrl(), "");
+        QCOMPARE(model->rowCount(), 4);
+        QStringList urls;
+        for (int i = 0; i < model->rowCount(); ++i) {
+            urls.append(model->data(model->index(i, 0), BookmarksModel::Url).toString());
+        }
+        QCOMPARE(urls, QStringList() << "http://example.org/5" << "http://example.org/4"
+                                     << "http://example.org/2" << "http://example.org/0");
+        QCOMPARE(model->mapToFolder(2), 2);
+        QCOMPARE(model->mapFromFolder("", 3), 3);
+        QVERIFY(!model->contains(QUrl("http://example.org/1")));
+    }
+
     void shouldUpdateEntries()
     {
         QSignalSpy spy(model, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)));
@@ -205,7 +235,7 @@ private Q_SLOTS:
         model->add(QUrl("http://ubuntu.com/"), "Ubuntu", QUrl(), "");
         delete model;
         model = new BookmarksModel;
-        model->setDatabasePath(fileName);
+        setDatabasePath(model, fileName);
         QCOMPARE(model->rowCount(), 2);
     }
 
@@ -241,10 +271,222 @@ private Q_SLOTS:
         delete model;
         model = new BookmarksModel;
         QSignalSpy spyPopulate(model, SIGNAL(folderAdded(QString)));
-        model->setDatabasePath(fileName);
+        setDatabasePath(model, fileName);
         QCOMPARE(spyPopulate.count(), 3);
         QCOMPARE(model->folders().count(), 3);
     }
+
+    void shouldGroupEntriesByFolder()
+    {
+        QSignalSpy spyInserted(model, SIGNAL(folderRowAboutToBeInserted(const QString&, int)));
+        QSignalSpy spyRemoved(model, SIGNAL(folderRowAboutToBeRemoved(const QString&, int)));
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl(), "SampleFolder");
+        model->add(QUrl("http://ubuntu.com/"), "Ubuntu", QUrl(), "");
+        model->add(QUrl("http://example.com/"), "Example Domain", QUrl(), "SampleFolder");
+        QCOMPARE(spyInserted.count(), 3);
+        QCOMPARE(spyInserted.at(2).at(0).toString(), QString("SampleFolder"));
+        QCOMPARE(spyInserted.at(2).at(1).toInt(), 0);
+        QCOMPARE(model->folderRowCount("SampleFolder"), 2);
+        QCOMPARE(model->folderRowCount(""), 1);
+        QCOMPARE(model->folderRowCount("AnotherFolder"), 0);
+        QCOMPARE(model->mapFromFolder("SampleFolder", 0), 0);
+        QCOMPARE(model->mapFromFolder("SampleFolder", 1), 2);
+        QCOMPARE(model->mapFromFolder("SampleFolder", 2), -1);
+        QCOMPARE(model->mapFromFolder("AnotherFolder", 0), -1);
+        QCOMPARE(model->mapToFolder(2), 1);
+        QCOMPARE(model->mapToFolder(1), 0);
+        QCOMPARE(model->mapToFolder(3), -1);
+
+        // Moving an entry to another folder keeps the order of the model
+        spyInserted.clear();
+        model->update(QUrl("http://ubuntu.com/"), "Ubuntu", "SampleFolder");
+        QCOMPARE(spyRemoved.count(), 1);
+        QCOMPARE(spyRemoved.first().at(0).toString(), QString(""));
+        QCOMPARE(spyRemoved.first().at(1).toInt(), 0);
+        QCOMPARE(spyInserted.count(), 1);
+        QCOMPARE(spyInserted.first().at(1).toInt(), 1);
+        QCOMPARE(model->folderRowCount(""), 0);
+        QCOMPARE(model->mapFromFolder("SampleFolder", 1), 1);
+
+        spyRemoved.clear();
+        model->remove(QUrl("http://example.com/"));
+        QCOMPARE(spyRemoved.count(), 1);
+        QCOMPARE(spyRemoved.first().at(1).toInt(), 0);
+        QCOMPARE(model->folderRowCount("SampleFolder"), 2);
+        QCOMPARE(model->mapFromFolder("SampleFolder", 0), 0);
+        QCOMPARE(model->mapFromFolder("SampleFolder", 1), 1);
+        QCOMPARE(model->data(model->index(1, 0), BookmarksModel::Url).toUrl(), QUrl("http://example.org/"));
+        QVERIFY(model->contains(QUrl("http://example.org/")));
+        QVERIFY(!model->contains(QUrl("http://example.com/")));
+    }
+
+    void shouldSerializeFoldersOfEntriesOnDisk()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        QTemporaryFile otherFile;
+        otherFile.open();
+        model->setDatabasePath(fileName);
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl(), "SampleFolder");
+        model->add(QUrl("http://ubuntu.com/"), "Ubuntu", QUrl(), "");
+        model->add(QUrl("http://wikipedia.org/"), "Wikipedia", QUrl(), "");
+        model->update(QUrl("http://ubuntu.com/"), "Ubuntu", "AnotherFolder");
+        model->update(QUrl("http://example.org/"), "Example Domain", "");
+        model->remove(QUrl("http://wikipedia.org/"));
+        // Pending changes are written before switching to another database
+        setDatabasePath(model, otherFile.fileName());
+        QCOMPARE(model->rowCount(), 0);
+        setDatabasePath(model, fileName);
+        QCOMPARE(model->rowCount(), 2);
+        QCOMPARE(model->folders().count(), 3);
+        QVERIFY(!model->contains(QUrl("http://wikipedia.org/")));
+        for (int i = 0; i < model->rowCount(); ++i) {
+            QModelIndex index = model->index(i, 0);
+            QString folder = model->data(index, BookmarksModel::Folder).toString();
+            if (model->data(index, BookmarksModel::Url).toUrl() == QUrl("http://ubuntu.com/")) {
+                QCOMPARE(folder, QString("AnotherFolder"));
+            } else {
+                QCOMPARE(folder, QString(""));
+            }
+        }
+    }
+
+    void shouldPopulateWithASingleReset()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        model->setDatabasePath(fileName);
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl(), "SampleFolder");
+        model->add(QUrl("http://ubuntu.com/"), "Ubuntu", QUrl(), "");
+        delete model;
+        model = new BookmarksModel;
+        QSignalSpy spyReset(model, SIGNAL(modelReset()));
+        QSignalSpy spyInserted(model, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
+        QSignalSpy spyCount(model, SIGNAL(rowCountChanged()));
+        model->setDatabasePath(fileName);
+        // The database is read without blocking
+        QCOMPARE(model->rowCount(), 0);
+        QVERIFY(spyReset.isEmpty());
+        QSignalSpy spyLoaded(model, SIGNAL(loaded()));
+        QTRY_COMPARE(spyLoaded.count(), 1);
+        QCOMPARE(spyReset.count(), 1);
+        QVERIFY(spyInserted.isEmpty());
+        QCOMPARE(spyCount.count(), 1);
+        QCOMPARE(model->rowCount(), 2);
+        QCOMPARE(model->folderRowCount("SampleFolder"), 1);
+    }
+
+    void shouldKeepEntriesAddedWhileLoading()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        model->setDatabasePath(fileName);
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl(), "SampleFolder");
+        model->add(QUrl("http://ubuntu.com/"), "Ubuntu", QUrl(), "");
+        delete model;
+        model = new BookmarksModel;
+        QSignalSpy spyLoaded(model, SIGNAL(loaded()));
+        model->setDatabasePath(fileName);
+        model->add(QUrl("http://wikipedia.org/"), "Wikipedia", QUrl(), "SampleFolder");
+        model->add(QUrl("http://ubuntu.com/"), "Ubuntu Home", QUrl(), "");
+        QCOMPARE(model->rowCount(), 2);
+        QTRY_COMPARE(spyLoaded.count(), 1);
+        QCOMPARE(model->rowCount(), 3);
+        QCOMPARE(model->data(model->index(0, 0), BookmarksModel::Url).toUrl(), QUrl("http://ubuntu.com/"));
+        QCOMPARE(model->data(model->index(0, 0), BookmarksModel::Title).toString(), QString("Ubuntu Home"));
+        QCOMPARE(model->data(model->index(1, 0), BookmarksModel::Url).toUrl(), QUrl("http://wikipedia.org/"));
+        QCOMPARE(model->data(model->index(2, 0), BookmarksModel::Url).toUrl(), QUrl("http://example.org/"));
+        QCOMPARE(model->folderRowCount("SampleFolder"), 2);
+        QCOMPARE(model->mapFromFolder("SampleFolder", 1), 2);
+        QCOMPARE(model->mapToFolder(1), 0);
+        model->remove(QUrl("http://wikipedia.org/"));
+        QCOMPARE(model->mapFromFolder("SampleFolder", 0), 1);
+
+        // The entry bookmarked again replaces the one in the database
+        delete model;
+        model = new BookmarksModel;
+        setDatabasePath(model, fileName);
+        QCOMPARE(model->rowCount(), 2);
+        QCOMPARE(model->data(model->index(0, 0), BookmarksModel::Title).toString(), QString("Ubuntu Home"));
+    }
+
+    void shouldIgnoreDatabasesReadAfterThePathChanged()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        model->setDatabasePath(fileName);
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl(), "");
+        QTemporaryFile otherFile;
+        otherFile.open();
+        setDatabasePath(model, otherFile.fileName());
+        delete model;
+        model = new BookmarksModel;
+        QSignalSpy spyLoaded(model, SIGNAL(loaded()));
+        model->setDatabasePath(fileName);
+        model->setDatabasePath(otherFile.fileName());
+        QTRY_COMPARE(spyLoaded.count(), 1);
+        // Give a stale result a chance to be delivered
+        QTest::qWait(100);
+        QCOMPARE(spyLoaded.count(), 1);
+        QCOMPARE(model->rowCount(), 0);
+    }
+
+    void benchmarkPopulate_data()
+    {
+        QTest::addColumn<int>("size");
+        QTest::newRow("1k") << 1000;
+        QTest::newRow("10k") << 10000;
+    }
+
+    void benchmarkPopulate()
+    {
+        QFETCH(int, size);
+
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "benchmark");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            query.exec("CREATE TABLE bookmarks (url VARCHAR, title VARCHAR, icon VARCHAR,"
+                       " created INTEGER, folderId INTEGER);");
+            query.exec("CREATE TABLE folders (folderId INTEGER PRIMARY KEY, folder VARCHAR);");
+            database.transaction();
+            query.prepare("INSERT INTO folders (folderId, folder) VALUES (?, ?);");
+            for (int i = 1; i <= 10; ++i) {
+                query.addBindValue(i);
+                query.addBindValue(QString("Folder %1").arg(i));
+                query.exec();
+            }
+            query.prepare("INSERT INTO bookmarks VALUES (?, ?, '', ?, ?);");
+            for (int i = 0; i < size; ++i) {
+                query.addBindValue(QString("http://example%1.org/page").arg(i));
+                query.addBindValue(QString("Page %1").arg(i));
+                query.addBindValue(i);
+                // One bookmark out of eleven isn’t in any folder
+                query.addBindValue((i % 11) ? QVariant(i % 11) : QVariant());
+                query.exec();
+            }
+            database.commit();
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("benchmark");
+
+        delete model;
+        model = 0;
+        QBENCHMARK {
+            BookmarksModel bookmarks;
+            setDatabasePath(&bookmarks, fileName);
+            QCOMPARE(bookmarks.rowCount(), size);
+        }
+        model = new BookmarksModel;
+    }
 };
 
 QTEST_MAIN(BookmarksModelTests)
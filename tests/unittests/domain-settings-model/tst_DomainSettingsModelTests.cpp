@@ -0,0 +1,134 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Qt
+#include <QtCore/QTemporaryFile>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+// std
+#include <cmath>
+
+// local
+#include "domain-settings-model.h"
+
+class DomainSettingsModelTests : public QObject
+{
+    Q_OBJECT
+
+private:
+    DomainSettingsModel* model;
+
+private Q_SLOTS:
+    void init()
+    {
+        model = new DomainSettingsModel;
+        model->setDatabasePath(":memory:");
+    }
+
+    void cleanup()
+    {
+        delete model;
+    }
+
+    void shouldBeInitiallyEmpty()
+    {
+        QCOMPARE(model->rowCount(), 0);
+    }
+
+    void shouldPopulateWithASingleReset()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        model->setDatabasePath(fileName);
+        model->allowLocation("example.org", true);
+        model->setZoomFactor("www.ubuntu.com", 1.5);
+        // Entries with default settings only aren’t kept
+        model->insertEntry("example.com");
+        QCOMPARE(model->rowCount(), 3);
+        delete model;
+
+        model = new DomainSettingsModel;
+        QSignalSpy spyReset(model, SIGNAL(modelReset()));
+        QSignalSpy spyInserted(model, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
+        QSignalSpy spyCount(model, SIGNAL(rowCountChanged()));
+        model->setDatabasePath(fileName);
+        QCOMPARE(spyReset.count(), 1);
+        QVERIFY(spyInserted.isEmpty());
+        QCOMPARE(spyCount.count(), 1);
+        QCOMPARE(model->rowCount(), 2);
+        QVERIFY(model->isLocationAllowed("example.org"));
+        QVERIFY(std::isnan(model->getZoomFactor("example.org")));
+        QCOMPARE(model->getZoomFactor("www.ubuntu.com"), 1.5);
+        QVERIFY(!model->contains("example.com"));
+    }
+
+    void benchmarkPopulate_data()
+    {
+        QTest::addColumn<int>("size");
+        QTest::newRow("1k") << 1000;
+        QTest::newRow("5k") << 5000;
+    }
+
+    void benchmarkPopulate()
+    {
+        QFETCH(int, size);
+
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "benchmark");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            query.exec("CREATE TABLE domainsettings (domain VARCHAR NOT NULL UNIQUE,"
+                       " domainWithoutSubdomain VARCHAR, allowCustomUrlSchemes BOOL,"
+                       " allowLocation BOOL, userAgentId INTEGER, zoomFactor REAL,"
+                       " PRIMARY KEY(domain));");
+            database.transaction();
+            query.prepare("INSERT INTO domainsettings VALUES (?, ?, 0, ?, NULL, ?);");
+            for (int i = 0; i < size; ++i) {
+                query.addBindValue(QString("www.example%1.org").arg(i));
+                query.addBindValue(QString("example%1.org").arg(i));
+                query.addBindValue(i % 2 == 0);
+                query.addBindValue((i % 2) ? QVariant(1.5) : QVariant());
+                query.exec();
+            }
+            database.commit();
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("benchmark");
+
+        // The model uses a named connection, only one instance can exist at a time
+        delete model;
+        model = 0;
+        QBENCHMARK {
+            DomainSettingsModel settings;
+            settings.setDatabasePath(fileName);
+            QCOMPARE(settings.rowCount(), size);
+        }
+        model = new DomainSettingsModel;
+    }
+};
+
+QTEST_MAIN(DomainSettingsModelTests)
+#include "tst_DomainSettingsModelTests.moc"
@@ -268,9 +268,46 @@ private Q_SLOTS:
         QCOMPARE(model->rowCount(), 3);
         delete model;
         model = new DownloadsModel;
+        QSignalSpy spyReset(model, SIGNAL(modelReset()));
+        QSignalSpy spyInserted(model, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
         model->setDatabasePath(fileName);
+        QCOMPARE(model->rowCount(), 2);
+        QCOMPARE(spyReset.count(), 1);
+        QVERIFY(spyInserted.isEmpty());
         model->fetchMore();
         QCOMPARE(model->rowCount(), 2);
+        QCOMPARE(spyReset.count(), 1);
+        QVERIFY(spyInserted.isEmpty());
+        QVERIFY(!model->canFetchMore());
+    }
+
+    void shouldInsertFurtherPages()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        delete model;
+        model = new DownloadsModel;
+        model->setDatabasePath(fileName);
+        for (int i = 0; i < 150; ++i) {
+            model->add(QString("testid%1").arg(i), QUrl(QString("http://example.org/%1").arg(i)),
+                       QString("/tmp/%1.txt").arg(i), QStringLiteral("text/plain"), false);
+        }
+        delete model;
+        model = new DownloadsModel;
+        QSignalSpy spyReset(model, SIGNAL(modelReset()));
+        QSignalSpy spyInserted(model, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
+        model->setDatabasePath(fileName);
+        QCOMPARE(model->rowCount(), 100);
+        QCOMPARE(spyReset.count(), 1);
+        QVERIFY(spyInserted.isEmpty());
+        model->fetchMore();
+        QCOMPARE(model->rowCount(), 150);
+        QCOMPARE(spyReset.count(), 1);
+        QCOMPARE(spyInserted.count(), 1);
+        QVariantList args = spyInserted.takeFirst();
+        QCOMPARE(args.at(1).toInt(), 100);
+        QCOMPARE(args.at(2).toInt(), 149);
     }
 
     void shouldCountNumberOfEntries()
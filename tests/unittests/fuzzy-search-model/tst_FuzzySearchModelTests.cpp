@@ -0,0 +1,189 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Qt
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+// local
+#include "bookmarks-model.h"
+#include "fuzzy-search-model.h"
+#include "history-model.h"
+
+class FuzzySearchModelTests : public QObject
+{
+    Q_OBJECT
+
+private:
+    HistoryModel* history;
+    BookmarksModel* bookmarks;
+    FuzzySearchModel* model;
+
+    void search(const QStringList& terms)
+    {
+        model->setTerms(terms);
+        waitForResults();
+    }
+
+    void waitForResults()
+    {
+        QTRY_VERIFY(!model->searching());
+    }
+
+    QUrl url(int row) const
+    {
+        return model->data(model->index(row, 0), FuzzySearchModel::Url).toUrl();
+    }
+
+private Q_SLOTS:
+    void init()
+    {
+        history = new HistoryModel;
+        history->setDatabasePath(":memory:");
+        bookmarks = new BookmarksModel;
+        bookmarks->setDatabasePath(":memory:");
+        history->add(QUrl("https://github.com/"), "GitHub: Where the world builds software", QUrl());
+        history->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        bookmarks->add(QUrl("https://ubports.com/"), "UBports", QUrl(), "");
+        model = new FuzzySearchModel;
+        model->setHistoryModel(history);
+        model->setBookmarksModel(bookmarks);
+    }
+
+    void cleanup()
+    {
+        delete model;
+        delete bookmarks;
+        delete history;
+    }
+
+    void shouldBeInitiallyEmpty()
+    {
+        QCOMPARE(model->rowCount(), 0);
+        QVERIFY(!model->searching());
+        QCOMPARE(model->limit(), 10);
+        QCOMPARE(model->threshold(), 0.3);
+    }
+
+    void shouldMatchMisspelledTerms()
+    {
+        search(QStringList() << "gthub");
+        QCOMPARE(model->rowCount(), 1);
+        QCOMPARE(url(0), QUrl("https://github.com/"));
+        QModelIndex index = model->index(0, 0);
+        QCOMPARE(model->data(index, FuzzySearchModel::Title).toString(),
+                 QString("GitHub: Where the world builds software"));
+        QCOMPARE(model->data(index, FuzzySearchModel::Source).toInt(), int(FuzzySearchModel::History));
+        QVERIFY(model->data(index, FuzzySearchModel::Similarity).toDouble() >= 0.3);
+
+        search(QStringList() << "ubprts");
+        QCOMPARE(model->rowCount(), 1);
+        QCOMPARE(url(0), QUrl("https://ubports.com/"));
+        QCOMPARE(model->data(model->index(0, 0), FuzzySearchModel::Source).toInt(),
+                 int(FuzzySearchModel::Bookmarks));
+
+        search(QStringList() << "exmple" << "domain");
+        QCOMPARE(model->rowCount(), 1);
+        search(QStringList() << "exmple" << "gthub");
+        QCOMPARE(model->rowCount(), 0);
+    }
+
+    void shouldNotSearchWithoutTermsOrLimit()
+    {
+        search(QStringList() << "gthub");
+        QCOMPARE(model->rowCount(), 1);
+        model->setLimit(0);
+        QVERIFY(!model->searching());
+        QCOMPARE(model->rowCount(), 0);
+        model->setLimit(10);
+        waitForResults();
+        QCOMPARE(model->rowCount(), 1);
+        model->setTerms(QStringList());
+        QVERIFY(!model->searching());
+        QCOMPARE(model->rowCount(), 0);
+    }
+
+    void shouldApplyThreshold()
+    {
+        model->setThreshold(0.5);
+        search(QStringList() << "gthub");
+        QCOMPARE(model->rowCount(), 0);
+        model->setThreshold(0.3);
+        waitForResults();
+        QCOMPARE(model->rowCount(), 1);
+    }
+
+    void shouldReturnEntriesBothInHistoryAndBookmarksOnce()
+    {
+        bookmarks->add(QUrl("https://github.com/"), "GitHub", QUrl(), "");
+        search(QStringList() << "gthub");
+        QCOMPARE(model->rowCount(), 1);
+        QCOMPARE(url(0), QUrl("https://github.com/"));
+    }
+
+    void shouldUpdateResultsWhenModelsChange()
+    {
+        search(QStringList() << "gthub");
+        QCOMPARE(model->rowCount(), 1);
+
+        history->add(QUrl("https://gist.github.com/"), "Discover gists", QUrl());
+        QTRY_COMPARE(model->rowCount(), 2);
+
+        history->update(QUrl("https://github.com/"), "Code hosting", QUrl());
+        history->removeEntryByUrl(QUrl("https://gist.github.com/"));
+        QTRY_COMPARE(model->rowCount(), 1);
+
+        // The URL still matches
+        history->hide(QUrl("https://github.com/"));
+        QTRY_COMPARE(model->rowCount(), 0);
+        history->unHide(QUrl("https://github.com/"));
+        QTRY_COMPARE(model->rowCount(), 1);
+
+        bookmarks->add(QUrl("https://github.com/ubports"), "UBports on GitHub", QUrl(), "");
+        QTRY_COMPARE(model->rowCount(), 2);
+        bookmarks->remove(QUrl("https://github.com/ubports"));
+        QTRY_COMPARE(model->rowCount(), 1);
+
+        history->clearAll();
+        QTRY_COMPARE(model->rowCount(), 0);
+    }
+
+    void shouldStopIndexingModelsThatAreUnset()
+    {
+        model->setHistoryModel(nullptr);
+        search(QStringList() << "gthub");
+        QCOMPARE(model->rowCount(), 0);
+        history->add(QUrl("https://github.com/about"), "About GitHub", QUrl());
+        search(QStringList() << "gthub" << "about");
+        QCOMPARE(model->rowCount(), 0);
+        model->setHistoryModel(history);
+        QTRY_COMPARE(model->rowCount(), 1);
+    }
+
+    void shouldReturnItemsWithGet()
+    {
+        search(QStringList() << "gthub");
+        QVariantMap item = model->get(0);
+        QCOMPARE(item.value("url").toUrl(), QUrl("https://github.com/"));
+        QCOMPARE(item.value("source").toInt(), int(FuzzySearchModel::History));
+        QVERIFY(model->get(1).isEmpty());
+    }
+};
+
+QTEST_MAIN(FuzzySearchModelTests)
+#include "tst_FuzzySearchModelTests.moc"
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Qt
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+// local
+#include "grouped-history-query-model.h"
+#include "history-model.h"
+
+class GroupedHistoryQueryModelTests : public QObject
+{
+    Q_OBJECT
+
+private:
+    HistoryModel* history;
+    GroupedHistoryQueryModel* model;
+
+    GroupedHistoryEntriesModel* entries(int row)
+    {
+        QVariant value = model->data(model->index(row, 0), GroupedHistoryQueryModel::Entries);
+        return value.value<GroupedHistoryEntriesModel*>();
+    }
+
+private Q_SLOTS:
+    void init()
+    {
+        history = new HistoryModel;
+        history->setDatabasePath(":memory:");
+        model = new GroupedHistoryQueryModel;
+        model->setSourceModel(history);
+        QTRY_VERIFY(!model->loading());
+    }
+
+    void cleanup()
+    {
+        delete model;
+        delete history;
+    }
+
+    void shouldBeInitiallyEmpty()
+    {
+        QCOMPARE(model->rowCount(), 0);
+        QCOMPARE(model->groupBy(), HistoryModel::GroupByDomain);
+    }
+
+    void shouldGroupEntriesByDomain()
+    {
+        history->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        history->add(QUrl("http://ubports.com/"), "UBports", QUrl());
+        history->add(QUrl("http://example.org/test"), "Example Test", QUrl("image://example"));
+        QTRY_COMPARE(model->rowCount(), 2);
+
+        QModelIndex index = model->index(0, 0);
+        QCOMPARE(model->data(index, GroupedHistoryQueryModel::Domain).toString(), QString("example.org"));
+        QCOMPARE(model->data(index, GroupedHistoryQueryModel::EntryCount).toInt(), 2);
+        QCOMPARE(model->data(index, GroupedHistoryQueryModel::LastVisitedTitle).toString(),
+                 QString("Example Test"));
+        QCOMPARE(model->data(index, GroupedHistoryQueryModel::LastVisitedIcon).toUrl(),
+                 QUrl("image://example"));
+        index = model->index(1, 0);
+        QCOMPARE(model->data(index, GroupedHistoryQueryModel::Domain).toString(), QString("ubports.com"));
+        QCOMPARE(model->data(index, GroupedHistoryQueryModel::EntryCount).toInt(), 1);
+    }
+
+    void shouldGroupEntriesByDay()
+    {
+        QSignalSpy spy(model, SIGNAL(groupByChanged()));
+        model->setGroupBy(HistoryModel::GroupByDay);
+        QCOMPARE(spy.count(), 1);
+        history->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        history->add(QUrl("http://ubports.com/"), "UBports", QUrl());
+        QTRY_COMPARE(model->rowCount(), 1);
+        QModelIndex index = model->index(0, 0);
+        QCOMPARE(model->data(index, GroupedHistoryQueryModel::LastVisitDate).toDate(),
+                 QDate::currentDate());
+        QCOMPARE(model->data(index, GroupedHistoryQueryModel::EntryCount).toInt(), 2);
+
+        GroupedHistoryEntriesModel* day = entries(0);
+        QTRY_COMPARE(day->rowCount(), 2);
+        QCOMPARE(day->data(day->index(0, 0), HistoryModel::Url).toUrl(), QUrl("http://ubports.com/"));
+        QCOMPARE(day->data(day->index(1, 0), HistoryModel::Url).toUrl(), QUrl("http://example.org/"));
+    }
+
+    void shouldFetchEntriesPageByPage()
+    {
+        model->setPageSize(2);
+        for (int i = 0; i < 5; ++i) {
+            history->add(QUrl(QString("http://example.org/%1").arg(i)), "Example", QUrl());
+        }
+        QTRY_COMPARE(model->rowCount(), 1);
+
+        GroupedHistoryEntriesModel* domain = entries(0);
+        QVERIFY(domain);
+        QCOMPARE(entries(0), domain);
+        QTRY_COMPARE(domain->rowCount(), 2);
+        QVERIFY(domain->canFetchMore());
+        domain->fetchMore();
+        QVERIFY(!domain->canFetchMore());
+        QTRY_COMPARE(domain->rowCount(), 4);
+        domain->fetchMore();
+        QTRY_COMPARE(domain->rowCount(), 5);
+        QVERIFY(!domain->canFetchMore());
+
+        // Entries visited in the same second are paged in a stable order
+        QSet<QUrl> urls;
+        for (int i = 0; i < domain->rowCount(); ++i) {
+            urls.insert(domain->data(domain->index(i, 0), HistoryModel::Url).toUrl());
+        }
+        QCOMPARE(urls.count(), 5);
+        QCOMPARE(domain->data(domain->index(0, 0), HistoryModel::Url).toUrl(),
+                 QUrl("http://example.org/4"));
+    }
+
+    void shouldUpdateWhenHistoryChanges()
+    {
+        history->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        history->add(QUrl("http://example.org/test"), "Example Test", QUrl());
+        history->add(QUrl("http://ubports.com/"), "UBports", QUrl());
+        QTRY_COMPARE(model->rowCount(), 2);
+        GroupedHistoryEntriesModel* domain = entries(1);
+        QTRY_COMPARE(domain->rowCount(), 2);
+
+        history->removeEntryByUrl(QUrl("http://example.org/test"));
+        QTRY_COMPARE(domain->rowCount(), 1);
+        QCOMPARE(model->data(model->index(1, 0), GroupedHistoryQueryModel::EntryCount).toInt(), 1);
+
+        history->removeEntriesByDomain("ubports.com");
+        QTRY_COMPARE(model->rowCount(), 1);
+        QCOMPARE(model->data(model->index(0, 0), GroupedHistoryQueryModel::Domain).toString(),
+                 QString("example.org"));
+
+        history->clearAll();
+        QTRY_COMPARE(model->rowCount(), 0);
+    }
+
+    void shouldUpdateGroupsInPlace()
+    {
+        history->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        history->add(QUrl("http://ubports.com/"), "UBports", QUrl());
+        QTRY_COMPARE(model->rowCount(), 2);
+        GroupedHistoryEntriesModel* example = entries(1);
+        GroupedHistoryEntriesModel* ubports = entries(0);
+        QTRY_COMPARE(example->rowCount(), 1);
+        QTRY_COMPARE(ubports->rowCount(), 1);
+
+        QSignalSpy resetSpy(model, SIGNAL(modelReset()));
+        QSignalSpy movedSpy(model, SIGNAL(rowsMoved(const QModelIndex&, int, int, const QModelIndex&, int)));
+        QSignalSpy exampleResetSpy(example, SIGNAL(modelReset()));
+        QSignalSpy exampleInsertedSpy(example, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
+        QSignalSpy ubportsSpy(ubports, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
+        history->add(QUrl("http://example.org/test"), "Example Test", QUrl());
+        QTRY_COMPARE(model->data(model->index(0, 0), GroupedHistoryQueryModel::Domain).toString(),
+                     QString("example.org"));
+        QCOMPARE(entries(0), example);
+        QCOMPARE(movedSpy.count(), 1);
+        QTRY_COMPARE(example->rowCount(), 2);
+        QCOMPARE(example->data(example->index(0, 0), HistoryModel::Url).toUrl(),
+                 QUrl("http://example.org/test"));
+        QCOMPARE(exampleInsertedSpy.count(), 1);
+        QVERIFY(resetSpy.isEmpty());
+        QVERIFY(exampleResetSpy.isEmpty());
+        // The group that didn’t change isn’t read again
+        QVERIFY(!ubports->loading());
+        QVERIFY(ubportsSpy.isEmpty());
+    }
+
+    void shouldReturnItemsWithGet()
+    {
+        history->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        QTRY_COMPARE(model->rowCount(), 1);
+        QVariantMap item = model->get(0);
+        QCOMPARE(item.value("domain").toString(), QString("example.org"));
+        QCOMPARE(item.value("entryCount").toInt(), 1);
+        QVERIFY(model->get(1).isEmpty());
+    }
+};
+
+QTEST_MAIN(GroupedHistoryQueryModelTests)
+#include "tst_GroupedHistoryQueryModelTests.moc"
@@ -99,6 +99,43 @@ private Q_SLOTS:
         model->setDomain("");
         QCOMPARE(model->rowCount(), 2);
     }
+
+    void shouldUpdateWhenSourceModelChanges()
+    {
+        model->setDomain("example.org");
+        history->add(QUrl("http://example.org/1"), "Example 1", QUrl());
+        history->add(QUrl("http://example.com/"), "Example Domain", QUrl());
+        history->add(QUrl("http://example.org/2"), "Example 2", QUrl());
+        QCOMPARE(model->rowCount(), 2);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Url).toUrl(), QUrl("http://example.org/2"));
+        QCOMPARE(model->data(model->index(1, 0), HistoryModel::Url).toUrl(), QUrl("http://example.org/1"));
+        QCOMPARE(model->lastVisitedTitle(), QString("Example 2"));
+
+        QSignalSpy spyRowsMoved(model, SIGNAL(rowsMoved(const QModelIndex&, int, int, const QModelIndex&, int)));
+        history->add(QUrl("http://example.org/1"), "Example 1", QUrl());
+        QCOMPARE(spyRowsMoved.count(), 1);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Url).toUrl(), QUrl("http://example.org/1"));
+        QCOMPARE(model->data(model->index(1, 0), HistoryModel::Url).toUrl(), QUrl("http://example.org/2"));
+        QCOMPARE(model->lastVisitedTitle(), QString("Example 1"));
+
+        // Moving an entry that doesn’t match past no matching entry
+        spyRowsMoved.clear();
+        history->add(QUrl("http://example.com/"), "Example Domain", QUrl());
+        QVERIFY(spyRowsMoved.isEmpty());
+        QCOMPARE(model->rowCount(), 2);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Url).toUrl(), QUrl("http://example.org/1"));
+
+        QSignalSpy spyRowsRemoved(model, SIGNAL(rowsRemoved(const QModelIndex&, int, int)));
+        history->removeEntryByUrl(QUrl("http://example.com/"));
+        QVERIFY(spyRowsRemoved.isEmpty());
+        history->removeEntryByUrl(QUrl("http://example.org/1"));
+        QCOMPARE(spyRowsRemoved.count(), 1);
+        QCOMPARE(model->rowCount(), 1);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Url).toUrl(), QUrl("http://example.org/2"));
+
+        history->clearAll();
+        QCOMPARE(model->rowCount(), 0);
+    }
 };
 
 QTEST_MAIN(HistoryDomainModelTests)
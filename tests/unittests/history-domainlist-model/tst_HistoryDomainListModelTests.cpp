@@ -86,8 +86,8 @@ private Q_SLOTS:
         QVERIFY(spyDataChanged.isEmpty());
         QCOMPARE(spyRowsInserted.count(), 1);
         args = spyRowsInserted.takeFirst();
-        QCOMPARE(args.at(1).toInt(), 0);
-        QCOMPARE(args.at(2).toInt(), 0);
+        QCOMPARE(args.at(1).toInt(), 1);
+        QCOMPARE(args.at(2).toInt(), 1);
         QCOMPARE(model->rowCount(), 2);
         QCOMPARE(model->data(model->index(1, 0), HistoryDomainListModel::Domain).toString(), QString("example.com"));
 
@@ -112,6 +112,40 @@ private Q_SLOTS:
         QCOMPARE(model->rowCount(), 1);
     }
 
+    void shouldUpdateMostRecentEntryOfDomains()
+    {
+        history->add(QUrl("http://example.org/1"), "Example 1", QUrl());
+        history->add(QUrl("http://example.com/"), "Example Domain", QUrl());
+        history->add(QUrl("http://example.org/2"), "Example 2", QUrl());
+        history->add(QUrl("http://ubuntu.com/"), "Ubuntu", QUrl());
+        QCOMPARE(model->rowCount(), 3);
+        QCOMPARE(model->data(model->index(0, 0), HistoryDomainListModel::LastVisitedTitle).toString(),
+                 QString("Example 2"));
+
+        qRegisterMetaType<QVector<int> >();
+        QSignalSpy spyDataChanged(model, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)));
+        history->add(QUrl("http://example.org/1"), "Example 1", QUrl());
+        verifyDataChanged(spyDataChanged, 0);
+        QCOMPARE(model->data(model->index(0, 0), HistoryDomainListModel::LastVisitedTitle).toString(),
+                 QString("Example 1"));
+
+        spyDataChanged.clear();
+        history->removeEntryByUrl(QUrl("http://example.org/1"));
+        verifyDataChanged(spyDataChanged, 0);
+        QCOMPARE(model->data(model->index(0, 0), HistoryDomainListModel::LastVisitedTitle).toString(),
+                 QString("Example 2"));
+
+        history->removeEntriesByDomain("example.com");
+        QCOMPARE(model->rowCount(), 2);
+        QCOMPARE(model->data(model->index(0, 0), HistoryDomainListModel::Domain).toString(), QString("example.org"));
+        QCOMPARE(model->data(model->index(1, 0), HistoryDomainListModel::Domain).toString(), QString("ubuntu.com"));
+        QCOMPARE(model->data(model->index(1, 0), HistoryDomainListModel::LastVisitedTitle).toString(),
+                 QString("Ubuntu"));
+        HistoryDomainModel* entries = model->data(model->index(0, 0), HistoryDomainListModel::Entries).value<HistoryDomainModel*>();
+        QCOMPARE(entries->rowCount(), 1);
+        QCOMPARE(entries->data(entries->index(0, 0), HistoryModel::Url).toUrl(), QUrl("http://example.org/2"));
+    }
+
     void shouldUpdateDataWhenMovingEntries()
     {
         history->add(QUrl("http://example.org/"), "Example Domain", QUrl());
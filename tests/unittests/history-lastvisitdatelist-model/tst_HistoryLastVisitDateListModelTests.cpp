@@ -276,6 +276,24 @@ private Q_SLOTS:
         QCOMPARE(model->rowCount(), 2);
     }
 
+    void shouldUpdateDateOfEntryChangedInPlace()
+    {
+        QSignalSpy spyRowsInserted(model, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
+        QSignalSpy spyRowsRemoved(model, SIGNAL(rowsRemoved(const QModelIndex&, int, int)));
+        QDateTime dt1 = QDateTime(QDate(1970, 1, 1), QTime(6, 0, 0));
+        QDateTime dt2 = QDateTime(QDate(1970, 1, 2), QTime(6, 0, 0));
+
+        mockHistory->add(QUrl("http://example.com/"), "Example Domain", "example.com", QUrl(), dt1);
+        QCOMPARE(spyRowsInserted.count(), 2);
+        // The entry is already the first one, only its data changes
+        mockHistory->add(QUrl("http://example.com/"), "Example Domain", "example.com", QUrl(), dt2);
+        QCOMPARE(spyRowsInserted.count(), 3);
+        QCOMPARE(spyRowsRemoved.count(), 1);
+        QCOMPARE(model->rowCount(), 2);
+        QCOMPARE(model->data(model->index(1, 0), HistoryLastVisitDateListModel::LastVisitDate).toDate(),
+                 QDate(1970, 1, 2));
+    }
+
     void shouldUpdateWhenChangingSourceModel()
     {
         QDateTime dt1 = QDateTime(QDate(1970, 1, 1), QTime(6, 0, 0));
@@ -361,6 +379,21 @@ private Q_SLOTS:
         QCOMPARE(model->data(model->index(1, 0), HistoryLastVisitDateListModel::LastVisitDate).toDate(), dt1.date());
         QVERIFY(!model->data(model->index(1, 0), HistoryLastVisitDateListModel::LastVisitDate + 1).isValid());
     }
+
+    void shouldReturnIndexOfDate()
+    {
+        QDateTime dt1 = QDateTime(QDate(1970, 1, 1), QTime(6, 0, 0));
+        QDateTime dt2 = QDateTime(QDate(1970, 1, 2), QTime(6, 0, 0));
+        QCOMPARE(model->indexOf(QDate()), -1);
+        mockHistory->add(QUrl("http://example.com/"), "Example Domain", "example.com", QUrl(), dt1);
+        mockHistory->add(QUrl("http://example.org/"), "Example Domain", "example.org", QUrl(), dt2);
+        QCOMPARE(model->indexOf(QVariant()), 0);
+        QCOMPARE(model->indexOf(QDate()), 0);
+        QCOMPARE(model->indexOf(dt2.date()), 1);
+        QCOMPARE(model->indexOf(dt1.date()), 2);
+        QCOMPARE(model->indexOf(dt2), 1);
+        QCOMPARE(model->indexOf(QDate(1970, 1, 3)), -1);
+    }
 };
 
 QTEST_MAIN(HistoryLastVisitDateListModelTests)
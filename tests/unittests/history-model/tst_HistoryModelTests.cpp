@@ -19,12 +19,36 @@
 // Qt
 #include <QtCore/QDir>
 #include <QtCore/QTemporaryFile>
+#include <QtCore/QTimer>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
 #include <QtTest/QSignalSpy>
 #include <QtTest/QtTest>
 
+// std
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
 // local
 #include "history-model.h"
 
+// Number of bytes currently allocated on the heap, by all threads (the
+// statistics cover all arenas), including the large blocks that are
+// allocated with mmap() rather than from an arena
+static qint64 heapSize()
+{
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#elif defined(__GLIBC__)
+    struct mallinfo info = mallinfo();
+    return qint64(info.uordblks) + info.hblkhd;
+#else
+    return -1;
+#endif
+}
+
 class HistoryModelTests : public QObject
 {
     Q_OBJECT
@@ -32,6 +56,44 @@ class HistoryModelTests : public QObject
 private:
     HistoryModel* model;
 
+    // Fill a database with the given number of entries, spread over the
+    // given number of domains with one icon each, the most recent last
+    void createDatabase(const QString& fileName, int size, int domains)
+    {
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "benchmark");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            query.exec("CREATE TABLE history (url VARCHAR, domain VARCHAR, title VARCHAR,"
+                       " icon VARCHAR, visits INTEGER, lastVisit DATETIME);");
+            database.transaction();
+            query.prepare("INSERT INTO history VALUES (?, ?, ?, ?, 1, ?);");
+            for (int i = 0; i < size; ++i) {
+                QString domain = QString("example%1.org").arg(i % domains);
+                query.addBindValue(QString("http://%1/page/%2").arg(domain).arg(i));
+                query.addBindValue(domain);
+                query.addBindValue(QString("Page %1").arg(i));
+                query.addBindValue(QString("http://%1/favicon.ico").arg(domain));
+                query.addBindValue(i);
+                query.exec();
+            }
+            database.commit();
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("benchmark");
+    }
+
+    void loadDatabase(const QString& fileName, int size)
+    {
+        delete model;
+        model = new HistoryModel;
+        QSignalSpy spyLoaded(model, SIGNAL(loaded()));
+        model->setDatabasePath(fileName);
+        QTRY_VERIFY_WITH_TIMEOUT(spyLoaded.count() == 1, 600000);
+        QCOMPARE(model->rowCount(), size);
+    }
+
 private Q_SLOTS:
     void init()
     {
@@ -232,7 +294,59 @@ private Q_SLOTS:
         QCOMPARE(model->data(model->index(0, 0), HistoryModel::Icon).toUrl(), QUrl("image://webicon/123"));
         QCOMPARE(model->data(model->index(0, 0), HistoryModel::Visits).toInt(), 1);
         QVERIFY(model->data(model->index(0, 0), HistoryModel::LastVisit).toDateTime() >= now);
-        QVERIFY(!model->data(model->index(0, 0), HistoryModel::LastVisit + 4).isValid());
+        QVERIFY(!model->data(model->index(0, 0), HistoryModel::Frecency + 1).isValid());
+    }
+
+    void shouldReturnLocalDateOfLastVisit()
+    {
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        QDate date = model->data(model->index(0, 0), HistoryModel::LastVisit).toDateTime().toLocalTime().date();
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::LastVisitDate).toDate(), date);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::LastVisitDateString).toString(),
+                 date.toString(Qt::ISODate));
+    }
+
+    void shouldUpdateDatesWhenTimeZoneChanges()
+    {
+        QByteArray timeZone = qgetenv("TZ");
+        qputenv("TZ", "Pacific/Kiritimati");
+        QMetaObject::invokeMethod(model, "checkTimeZone", Qt::DirectConnection);
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        QDateTime lastVisit = model->data(model->index(0, 0), HistoryModel::LastVisit).toDateTime();
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::LastVisitDate).toDate(),
+                 lastVisit.toLocalTime().date());
+
+        QSignalSpy spyChanged(model, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)));
+        qputenv("TZ", "Pacific/Pago_Pago");
+        QMetaObject::invokeMethod(model, "checkTimeZone", Qt::DirectConnection);
+        QCOMPARE(spyChanged.count(), 1);
+        QVector<int> roles = spyChanged.first().at(2).value<QVector<int> >();
+        QVERIFY(roles.contains(HistoryModel::LastVisitDate));
+        QVERIFY(roles.contains(HistoryModel::LastVisitDateString));
+        QDate date = lastVisit.toLocalTime().date();
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::LastVisitDate).toDate(), date);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::LastVisitDateString).toString(),
+                 date.toString(Qt::ISODate));
+
+        model->removeEntriesByDate(date);
+        QCOMPARE(model->rowCount(), 0);
+
+        if (timeZone.isNull()) {
+            qunsetenv("TZ");
+        } else {
+            qputenv("TZ", timeZone);
+        }
+    }
+
+    void shouldOnlyWatchTimeZoneWithEntries()
+    {
+        QVERIFY(model->findChildren<QTimer*>().isEmpty());
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        QList<QTimer*> timers = model->findChildren<QTimer*>();
+        QCOMPARE(timers.count(), 1);
+        QVERIFY(timers.first()->isActive());
+        model->clearAll();
+        QVERIFY(!timers.first()->isActive());
     }
 
     void shouldReturnDatabasePath()
@@ -333,6 +447,65 @@ private Q_SLOTS:
         QCOMPARE(model->rowCount(), 0);
     }
 
+    void shouldRemoveByDomainInContiguousBlocks()
+    {
+        // Rows, from the top: c/4, b/3, a/3, a/2, b/2, c/2, a/1, b/1, c/1
+        for (int i = 1; i <= 2; ++i) {
+            model->add(QUrl(QString("http://c.org/%1").arg(i)), QString(), QUrl());
+            model->add(QUrl(QString("http://b.org/%1").arg(i)), QString(), QUrl());
+            model->add(QUrl(QString("http://a.org/%1").arg(i)), QString(), QUrl());
+        }
+        model->add(QUrl("http://a.org/3"), QString(), QUrl());
+        model->add(QUrl("http://b.org/3"), QString(), QUrl());
+        model->add(QUrl("http://c.org/4"), QString(), QUrl());
+        QCOMPARE(model->rowCount(), 9);
+        QSignalSpy spyRemoved(model, SIGNAL(rowsRemoved(const QModelIndex&, int, int)));
+        model->removeEntriesByDomain("a.org");
+        QCOMPARE(model->rowCount(), 6);
+        // Rows 6, then 2 to 3
+        QCOMPARE(spyRemoved.count(), 2);
+        QList<QVariant> args = spyRemoved.takeFirst();
+        QCOMPARE(args.at(1).toInt(), 6);
+        QCOMPARE(args.at(2).toInt(), 6);
+        args = spyRemoved.takeFirst();
+        QCOMPARE(args.at(1).toInt(), 2);
+        QCOMPARE(args.at(2).toInt(), 3);
+        QStringList urls;
+        for (int i = 0; i < model->rowCount(); ++i) {
+            QUrl url = model->data(model->index(i, 0), HistoryModel::Url).toUrl();
+            urls.append(url.toString());
+            // Remaining entries can still be looked up by URL
+            QVERIFY(model->update(url, QString("title %1").arg(i), QUrl()));
+            QCOMPARE(model->data(model->index(i, 0), HistoryModel::Title).toString(),
+                     QString("title %1").arg(i));
+        }
+        QCOMPARE(urls, QStringList() << "http://c.org/4" << "http://b.org/3" << "http://b.org/2"
+                                     << "http://c.org/2" << "http://b.org/1" << "http://c.org/1");
+        QVERIFY(!model->update(QUrl("http://a.org/1"), QString("title"), QUrl()));
+        model->removeEntriesByDomain("c.org");
+        QCOMPARE(model->rowCount(), 3);
+        model->add(QUrl("http://c.org/1"), QString(), QUrl());
+        QCOMPARE(model->rowCount(), 4);
+        model->removeEntriesByDomain("c.org");
+        QCOMPARE(model->rowCount(), 3);
+    }
+
+    void shouldRemoveByDateInOneBlock()
+    {
+        for (int i = 0; i < 100; ++i) {
+            model->add(QUrl(QString("http://example.org/%1").arg(i)), QString(), QUrl());
+        }
+        QSignalSpy spyRemoved(model, SIGNAL(rowsRemoved(const QModelIndex&, int, int)));
+        model->removeEntriesByDate(QDate::currentDate().addDays(-1));
+        QCOMPARE(spyRemoved.count(), 0);
+        QCOMPARE(model->rowCount(), 100);
+        model->removeEntriesByDate(QDate::currentDate());
+        // The test may run across midnight
+        QVERIFY(spyRemoved.count() >= 1);
+        QVERIFY(spyRemoved.count() <= 2);
+        QVERIFY(model->rowCount() < 100);
+    }
+
     void shouldCountNumberOfEntries()
     {
         QSignalSpy spyCount(model, SIGNAL(rowCountChanged()));
@@ -348,6 +521,708 @@ private Q_SLOTS:
         QCOMPARE(spyCount.count(), 3);
     }
 
+    void shouldIgnoreDuplicateUrlsInDatabase()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "duplicates");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            query.exec("CREATE TABLE history (url VARCHAR, domain VARCHAR, title VARCHAR,"
+                       " icon VARCHAR, visits INTEGER, lastVisit DATETIME);");
+            query.exec("INSERT INTO history VALUES ('http://example.org/', 'example.org', 'new', '', 2, 2000);");
+            query.exec("INSERT INTO history VALUES ('http://example.org/', 'example.org', 'old', '', 1, 1000);");
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("duplicates");
+        delete model;
+        model = new HistoryModel;
+        QSignalSpy spyLoaded(model, SIGNAL(loaded()));
+        model->setDatabasePath(fileName);
+        QTRY_COMPARE(spyLoaded.count(), 1);
+        QCOMPARE(model->rowCount(), 1);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Title).toString(), QString("new"));
+        model->removeEntryByUrl(QUrl("http://example.org/"));
+        QCOMPARE(model->rowCount(), 0);
+    }
+
+    void shouldMigrateLegacyDatabase()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "legacy");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            // The first version of the schema didn't have a 'domain' column
+            query.exec("CREATE TABLE history (url VARCHAR, title VARCHAR,"
+                       " icon VARCHAR, visits INTEGER, lastVisit DATETIME);");
+            query.exec("INSERT INTO history VALUES ('http://example.org/', 'old', '', 1, 1000);");
+            query.exec("INSERT INTO history VALUES ('http://example.org/', 'new', '', 2, 2000);");
+            query.exec("INSERT INTO history VALUES ('http://example.com/', 'Example', '', 1, 1500);");
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("legacy");
+        delete model;
+        model = new HistoryModel;
+        QSignalSpy spyLoaded(model, SIGNAL(loaded()));
+        model->setDatabasePath(fileName);
+        QTRY_COMPARE(spyLoaded.count(), 1);
+        QCOMPARE(model->rowCount(), 2);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Title).toString(), QString("new"));
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Domain).toString(), QString("example.org"));
+        delete model;
+        model = nullptr;
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "legacy");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            query.exec("PRAGMA user_version;");
+            QVERIFY(query.next());
+            QCOMPARE(query.value(0).toInt(), 4);
+            query.exec("SELECT COUNT(*) FROM history_fts JOIN history ON history.id = history_fts.rowid "
+                       "WHERE history_fts MATCH 'example';");
+            QVERIFY(query.next());
+            QCOMPARE(query.value(0).toInt(), 2);
+            query.exec("SELECT name FROM sqlite_master WHERE type='index' AND tbl_name='history';");
+            QStringList indexes;
+            while (query.next()) {
+                indexes.append(query.value(0).toString());
+            }
+            QVERIFY(indexes.contains("history_url"));
+            QVERIFY(indexes.contains("history_lastVisit"));
+            QVERIFY(indexes.contains("history_domain_lastVisit"));
+            QVERIFY(!indexes.contains("history_domain"));
+            QVERIFY(indexes.contains("history_frecency"));
+            query.exec("SELECT COUNT(*) FROM history_visits;");
+            QVERIFY(query.next());
+            QCOMPARE(query.value(0).toInt(), 0);
+            query.exec("SELECT COUNT(*) FROM history;");
+            QVERIFY(query.next());
+            QCOMPARE(query.value(0).toInt(), 2);
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("legacy");
+        model = new HistoryModel;
+    }
+
+    void shouldCreateMissingSearchIndex()
+    {
+        // What a database ends up like when SQLite has no full-text search,
+        // the index is created once it does
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "nosearch");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            query.exec("CREATE TABLE history (id INTEGER PRIMARY KEY, url VARCHAR, domain VARCHAR,"
+                       " title VARCHAR, icon VARCHAR, visits INTEGER, lastVisit DATETIME, frecency REAL);");
+            query.exec("CREATE TABLE history_hidden (url VARCHAR);");
+            query.exec("CREATE TABLE history_visits (url VARCHAR, timestamp INTEGER,"
+                       " visits INTEGER NOT NULL DEFAULT 1);");
+            query.exec("CREATE UNIQUE INDEX history_url ON history (url);");
+            query.exec("CREATE INDEX history_lastVisit ON history (lastVisit);");
+            query.exec("CREATE INDEX history_domain_lastVisit ON history (domain, lastVisit);");
+            query.exec("CREATE INDEX history_frecency ON history (frecency);");
+            query.exec("CREATE UNIQUE INDEX history_hidden_url ON history_hidden (url);");
+            query.exec("INSERT INTO history VALUES (1, 'http://example.org/', 'example.org',"
+                       " 'Example', '', 3, 2000, 1.0);");
+            query.exec("PRAGMA user_version=4;");
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("nosearch");
+        delete model;
+        model = new HistoryModel;
+        QSignalSpy spyLoaded(model, SIGNAL(loaded()));
+        model->setDatabasePath(fileName);
+        QTRY_COMPARE(spyLoaded.count(), 1);
+        QCOMPARE(model->rowCount(), 1);
+
+        QSignalSpy spyResults(model, SIGNAL(searchResultsReady(int, const QVector<HistoryModel::HistoryEntry>&)));
+        int id = model->search(QStringList() << "example", 10);
+        QTRY_COMPARE(spyResults.count(), 1);
+        QCOMPARE(spyResults.first().at(0).toInt(), id);
+        QVector<HistoryModel::HistoryEntry> results =
+            spyResults.first().at(1).value<QVector<HistoryModel::HistoryEntry>>();
+        QCOMPARE(results.count(), 1);
+        QCOMPARE(results.first().url, QUrl("http://example.org/"));
+        delete model;
+        model = nullptr;
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "nosearch");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            query.exec("PRAGMA user_version;");
+            QVERIFY(query.next());
+            QCOMPARE(query.value(0).toInt(), 4);
+            query.exec("SELECT COUNT(*) FROM history_fts WHERE history_fts MATCH 'example';");
+            QVERIFY(query.next());
+            QCOMPARE(query.value(0).toInt(), 1);
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("nosearch");
+        model = new HistoryModel;
+    }
+
+    void shouldKeepSearchIndexInSyncAfterVacuum()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        delete model;
+        model = new HistoryModel;
+        model->setDatabasePath(fileName);
+        for (int i = 0; i < 10; ++i) {
+            model->add(QUrl(QString("http://example%1.org/").arg(i)), QString("Page %1").arg(i), QUrl());
+        }
+        for (int i = 0; i < 10; i += 2) {
+            model->removeEntryByUrl(QUrl(QString("http://example%1.org/").arg(i)));
+        }
+        delete model;
+        model = nullptr;
+        {
+            // Vacuuming renumbers rowids, but not explicit ids
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "vacuum");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            QVERIFY(query.exec("VACUUM;"));
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("vacuum");
+        model = new HistoryModel;
+        QSignalSpy spyLoaded(model, SIGNAL(loaded()));
+        model->setDatabasePath(fileName);
+        QTRY_COMPARE(spyLoaded.count(), 1);
+        QSignalSpy spyResults(model, SIGNAL(searchResultsReady(int, const QVector<HistoryModel::HistoryEntry>&)));
+        model->search(QStringList() << "example7", 10);
+        QTRY_COMPARE(spyResults.count(), 1);
+        QVector<HistoryModel::HistoryEntry> results =
+            spyResults.first().at(1).value<QVector<HistoryModel::HistoryEntry>>();
+        QCOMPARE(results.count(), 1);
+        QCOMPARE(results.first().url, QUrl("http://example7.org/"));
+        QCOMPARE(results.first().title, QString("Page 7"));
+    }
+
+    void shouldBackfillMissingDomains()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "backfill");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            query.exec("CREATE TABLE history (url VARCHAR, title VARCHAR,"
+                       " icon VARCHAR, visits INTEGER, lastVisit DATETIME);");
+            database.transaction();
+            query.prepare("INSERT INTO history VALUES (?, '', '', 1, ?);");
+            for (int i = 0; i < 1200; ++i) {
+                query.addBindValue(QString("http://example%1.org/").arg(i));
+                query.addBindValue(i);
+                query.exec();
+            }
+            database.commit();
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("backfill");
+        delete model;
+        model = new HistoryModel;
+        QSignalSpy spyLoaded(model, SIGNAL(loaded()));
+        model->setDatabasePath(fileName);
+        QTRY_COMPARE(spyLoaded.count(), 1);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Domain).toString(),
+                 QString("example1199.org"));
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "backfill");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            QTRY_VERIFY(query.exec("SELECT COUNT(*) FROM history WHERE domain IS NULL OR domain = '';") &&
+                        query.next() && (query.value(0).toInt() == 0));
+            query.exec("SELECT domain FROM history WHERE url = 'http://example42.org/';");
+            QVERIFY(query.next());
+            QCOMPARE(query.value(0).toString(), QString("example42.org"));
+            query.finish();
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("backfill");
+    }
+
+    void shouldFetchEntriesInBatches()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "batches");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            query.exec("CREATE TABLE history (url VARCHAR, domain VARCHAR, title VARCHAR,"
+                       " icon VARCHAR, visits INTEGER, lastVisit DATETIME);");
+            database.transaction();
+            query.prepare("INSERT INTO history VALUES (?, 'example.org', '', '', 1, ?);");
+            for (int i = 0; i < 5000; ++i) {
+                query.addBindValue(QString("http://example.org/%1").arg(i));
+                // Several entries share the same timestamp
+                query.addBindValue(i / 10);
+                query.exec();
+            }
+            database.commit();
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("batches");
+        delete model;
+        model = new HistoryModel;
+        QSignalSpy spyInserted(model, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
+        QSignalSpy spyLoaded(model, SIGNAL(loaded()));
+        model->setDatabasePath(fileName);
+        QVERIFY(model->canFetchMore());
+        QTRY_COMPARE(spyLoaded.count(), 1);
+        QVERIFY(!model->canFetchMore());
+        QCOMPARE(model->rowCount(), 5000);
+        QVERIFY(spyInserted.count() > 1);
+        QVERIFY(spyInserted.count() < 10);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Url).toString(),
+                 QString("http://example.org/4999"));
+        for (int i = 1; i < model->rowCount(); ++i) {
+            QVERIFY(model->data(model->index(i - 1, 0), HistoryModel::LastVisit).toDateTime() >=
+                    model->data(model->index(i, 0), HistoryModel::LastVisit).toDateTime());
+        }
+    }
+
+    void shouldCoalesceOperationsWhenFlushing()
+    {
+        QSignalSpy spyFlushed(model, SIGNAL(flushed(int, int, qint64)));
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        model->add(QUrl("http://example.com/"), "Example Domain", QUrl());
+        model->removeEntryByUrl(QUrl("http://example.com/"));
+        QTRY_COMPARE_WITH_TIMEOUT(spyFlushed.count(), 1, 5000);
+        QList<QVariant> args = spyFlushed.takeFirst();
+        // 1 insert + 2 updates + 3 visits for example.org,
+        // 1 insert + 1 visit + 1 removal for example.com
+        QCOMPARE(args.at(0).toInt(), 9);
+        // The first update to example.org, and the insert and visit of
+        // example.com are dropped
+        QCOMPARE(args.at(1).toInt(), 3);
+    }
+
+    void shouldPersistCoalescedOperations()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        delete model;
+        model = new HistoryModel;
+        model->setDatabasePath(fileName);
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        model->add(QUrl("http://example.org/"), "Example Domain 2", QUrl());
+        model->add(QUrl("http://example.org/"), "Example Domain 3", QUrl());
+        model->add(QUrl("http://example.com/"), "Example Domain", QUrl());
+        model->removeEntryByUrl(QUrl("http://example.com/"));
+        model->add(QUrl("http://example.net/"), "Example Domain", QUrl());
+        model->hide(QUrl("http://example.net/"));
+        model->unHide(QUrl("http://example.net/"));
+        delete model;
+        model = new HistoryModel;
+        model->setDatabasePath(fileName);
+        QTRY_COMPARE(model->rowCount(), 2);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Url).toUrl(), QUrl("http://example.net/"));
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Hidden).toBool(), false);
+        QCOMPARE(model->data(model->index(1, 0), HistoryModel::Url).toUrl(), QUrl("http://example.org/"));
+        QCOMPARE(model->data(model->index(1, 0), HistoryModel::Title).toString(), QString("Example Domain 3"));
+        QCOMPARE(model->data(model->index(1, 0), HistoryModel::Visits).toInt(), 3);
+    }
+
+    void shouldKeepVisitsOfEntriesNotFetchedYet()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        delete model;
+        model = new HistoryModel;
+        model->setDatabasePath(fileName);
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        delete model;
+        model = new HistoryModel;
+        model->setDatabasePath(fileName);
+        // The entry is visited again before the database is read
+        model->add(QUrl("http://example.org/"), "Example Domain 2", QUrl());
+        delete model;
+        model = new HistoryModel;
+        model->setDatabasePath(fileName);
+        QTRY_COMPARE(model->rowCount(), 1);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Title).toString(), QString("Example Domain 2"));
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Visits).toInt(), 3);
+        // Three visits count for three, more than the two previous ones
+        double lastVisit = model->data(model->index(0, 0), HistoryModel::LastVisit).toDateTime().toTime_t();
+        double frecency = model->data(model->index(0, 0), HistoryModel::Frecency).toDouble();
+        QVERIFY(frecency > lastVisit / 2592000 + 1.5);
+    }
+
+    void shouldUpdateFrecencyOnVisit()
+    {
+        QSignalSpy spyChanged(model, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)));
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Frecency).toDouble(), 0.0);
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        spyChanged.clear();
+        QTRY_COMPARE(spyChanged.count(), 1);
+        QList<QVariant> args = spyChanged.takeFirst();
+        QCOMPARE(args.at(0).toModelIndex().row(), 0);
+        QVERIFY(args.at(2).value<QVector<int>>().contains(HistoryModel::Frecency));
+        // Two visits count for two, whose binary logarithm is 1
+        double lastVisit = model->data(model->index(0, 0), HistoryModel::LastVisit).toDateTime().toTime_t();
+        double frecency = model->data(model->index(0, 0), HistoryModel::Frecency).toDouble();
+        QVERIFY(qAbs(frecency - (lastVisit / 2592000 + 1)) < 0.001);
+    }
+
+    void shouldRankRecentVisitsAboveOldOnes()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        uint now = QDateTime::currentDateTimeUtc().toTime_t();
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "frecency");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            query.exec("CREATE TABLE history (url VARCHAR, domain VARCHAR, title VARCHAR,"
+                       " icon VARCHAR, visits INTEGER, lastVisit DATETIME);");
+            query.prepare("INSERT INTO history VALUES (?, '', '', '', ?, ?);");
+            // Visited 500 times two years ago
+            query.addBindValue("http://example.org/");
+            query.addBindValue(500);
+            query.addBindValue(now - 2 * 365 * 86400);
+            query.exec();
+            // Visited 20 times a week ago
+            query.addBindValue("http://example.com/");
+            query.addBindValue(20);
+            query.addBindValue(now - 7 * 86400);
+            query.exec();
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("frecency");
+        delete model;
+        model = new HistoryModel;
+        QSignalSpy spyLoaded(model, SIGNAL(loaded()));
+        model->setDatabasePath(fileName);
+        QTRY_COMPARE(spyLoaded.count(), 1);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Url).toUrl(), QUrl("http://example.com/"));
+        double frecent = model->data(model->index(0, 0), HistoryModel::Frecency).toDouble();
+        double frequent = model->data(model->index(1, 0), HistoryModel::Frecency).toDouble();
+        QVERIFY(frecent > frequent);
+
+        // A single visit today outranks hundreds of visits two years ago
+        model->add(QUrl("http://example.net/"), "Example Domain", QUrl());
+        QTRY_VERIFY(model->data(model->index(0, 0), HistoryModel::Frecency).toDouble() > frequent);
+    }
+
+    void shouldAggregateOldVisits()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        delete model;
+        model = new HistoryModel;
+        model->setDatabasePath(fileName);
+        model->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        delete model;
+        model = nullptr;
+        uint day = QDateTime::currentDateTimeUtc().toTime_t() / 86400 - 200;
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "visits");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            query.prepare("INSERT INTO history_visits (url, timestamp) VALUES ('http://example.org/', ?);");
+            // Two visits 200 days ago, and one yesterday
+            Q_FOREACH(uint timestamp, QList<uint>() << (day * 86400 + 3600) << (day * 86400 + 7200)
+                                                    << ((day + 199) * 86400 + 3600)) {
+                query.addBindValue(timestamp);
+                query.exec();
+            }
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("visits");
+        model = new HistoryModel;
+        QSignalSpy spyLoaded(model, SIGNAL(loaded()));
+        model->setDatabasePath(fileName);
+        QTRY_COMPARE(spyLoaded.count(), 1);
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "visits");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            QTRY_VERIFY(query.exec("SELECT COUNT(*) FROM history_visits;") &&
+                        query.next() && (query.value(0).toInt() == 3));
+            query.exec("SELECT timestamp, visits FROM history_visits ORDER BY timestamp LIMIT 1;");
+            QVERIFY(query.next());
+            QCOMPARE(query.value(0).toUInt(), day * 86400);
+            QCOMPARE(query.value(1).toInt(), 2);
+            query.finish();
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("visits");
+
+        // Removing the entry removes its visits
+        model->removeEntryByUrl(QUrl("http://example.org/"));
+        delete model;
+        model = new HistoryModel;
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "visits");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            query.exec("SELECT COUNT(*) FROM history_visits;");
+            QVERIFY(query.next());
+            QCOMPARE(query.value(0).toInt(), 0);
+            query.finish();
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("visits");
+    }
+
+    void shouldKeepUrlIndexConsistent()
+    {
+        for (int i = 0; i < 10; ++i) {
+            model->add(QUrl(QString("http://example.org/%1").arg(i)), QString(), QUrl());
+        }
+        // Move entries to the top, and remove entries on both halves
+        model->add(QUrl("http://example.org/2"), QString(), QUrl());
+        model->removeEntryByUrl(QUrl("http://example.org/8"));
+        model->removeEntryByUrl(QUrl("http://example.org/1"));
+        model->add(QUrl("http://example.org/0"), QString(), QUrl());
+        QCOMPARE(model->rowCount(), 8);
+        for (int i = 0; i < model->rowCount(); ++i) {
+            QUrl url = model->data(model->index(i, 0), HistoryModel::Url).toUrl();
+            QVERIFY(model->update(url, QString("title %1").arg(i), QUrl()));
+            QCOMPARE(model->data(model->index(i, 0), HistoryModel::Title).toString(),
+                     QString("title %1").arg(i));
+        }
+        model->hide(QUrl("http://example.org/3"));
+        for (int i = 0; i < model->rowCount(); ++i) {
+            QModelIndex index = model->index(i, 0);
+            bool hidden = (model->data(index, HistoryModel::Url).toUrl() == QUrl("http://example.org/3"));
+            QCOMPARE(model->data(index, HistoryModel::Hidden).toBool(), hidden);
+        }
+    }
+
+    void shouldPruneEntriesOlderThanMaxAge()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        uint now = QDateTime::currentDateTimeUtc().toTime_t();
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "prune");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            query.exec("CREATE TABLE history (url VARCHAR, domain VARCHAR, title VARCHAR,"
+                       " icon VARCHAR, visits INTEGER, lastVisit DATETIME);");
+            database.transaction();
+            query.prepare("INSERT INTO history VALUES (?, 'example.org', '', '', 1, ?);");
+            for (int i = 0; i < 1200; ++i) {
+                // One entry every hour, the most recent one half an hour ago
+                query.addBindValue(QString("http://example.org/%1").arg(i));
+                query.addBindValue(now - i * 3600 - 1800);
+                query.exec();
+            }
+            database.commit();
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("prune");
+        delete model;
+        model = new HistoryModel;
+        model->setMaxAge(10);
+        QSignalSpy spyLoaded(model, SIGNAL(loaded()));
+        QSignalSpy spyRemoved(model, SIGNAL(rowsAboutToBeRemoved(const QModelIndex&, int, int)));
+        model->setDatabasePath(fileName);
+        QTRY_COMPARE(spyLoaded.count(), 1);
+        QTRY_COMPARE(model->rowCount(), 240);
+        QCOMPARE(spyRemoved.count(), 1);
+        QList<QVariant> args = spyRemoved.takeFirst();
+        QCOMPARE(args.at(1).toInt(), 240);
+        QCOMPARE(args.at(2).toInt(), 1199);
+        // The remaining entries can still be looked up by URL
+        QVERIFY(model->update(QUrl("http://example.org/0"), "Example Domain", QUrl()));
+        QVERIFY(!model->update(QUrl("http://example.org/240"), "Example Domain", QUrl()));
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "prune");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            QTRY_VERIFY(query.exec("SELECT COUNT(*) FROM history;") &&
+                        query.next() && (query.value(0).toInt() == 240));
+            query.finish();
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("prune");
+    }
+
+    void shouldPruneEntriesBeyondMaxCount()
+    {
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "prune");
+            database.setDatabaseName(fileName);
+            database.open();
+            QSqlQuery query(database);
+            query.exec("CREATE TABLE history (url VARCHAR, domain VARCHAR, title VARCHAR,"
+                       " icon VARCHAR, visits INTEGER, lastVisit DATETIME);");
+            database.transaction();
+            query.prepare("INSERT INTO history VALUES (?, 'example.org', '', '', 1, ?);");
+            for (int i = 0; i < 100; ++i) {
+                query.addBindValue(QString("http://example.org/%1").arg(i));
+                query.addBindValue(i);
+                query.exec();
+            }
+            database.commit();
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("prune");
+        delete model;
+        model = new HistoryModel;
+        QSignalSpy spyLoaded(model, SIGNAL(loaded()));
+        model->setDatabasePath(fileName);
+        QTRY_COMPARE(spyLoaded.count(), 1);
+        QCOMPARE(model->rowCount(), 100);
+        model->setMaxCount(200);
+        QTest::qWait(100);
+        QCOMPARE(model->rowCount(), 100);
+        model->setMaxCount(60);
+        QTRY_COMPARE(model->rowCount(), 60);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Url).toString(),
+                 QString("http://example.org/99"));
+        QCOMPARE(model->data(model->index(59, 0), HistoryModel::Url).toString(),
+                 QString("http://example.org/40"));
+        delete model;
+        model = new HistoryModel;
+        model->setDatabasePath(fileName);
+        QTRY_COMPARE(model->rowCount(), 60);
+    }
+
+    void benchmarkAdd_data()
+    {
+        QTest::addColumn<int>("size");
+        QTest::newRow("1k") << 1000;
+        QTest::newRow("10k") << 10000;
+        QTest::newRow("100k") << 100000;
+        QTest::newRow("1M") << 1000000;
+    }
+
+    void benchmarkAdd()
+    {
+        QFETCH(int, size);
+
+        QTemporaryFile tempFile;
+        tempFile.open();
+        createDatabase(tempFile.fileName(), size, size);
+        loadDatabase(tempFile.fileName(), size);
+
+        int i = 0;
+        QBENCHMARK {
+            model->add(QUrl(QString("http://example.com/%1").arg(i++)), "Example Domain", QUrl());
+        }
+        QVERIFY(model->rowCount() > size);
+    }
+
+    void benchmarkLoad_data()
+    {
+        QTest::addColumn<int>("size");
+        QTest::newRow("100k") << 100000;
+        QTest::newRow("1M") << 1000000;
+    }
+
+    void benchmarkLoad()
+    {
+        QFETCH(int, size);
+
+        QTemporaryFile tempFile;
+        tempFile.open();
+        createDatabase(tempFile.fileName(), size, 1000);
+        // Migrate the database first, so that only loading is measured
+        loadDatabase(tempFile.fileName(), size);
+
+        // Each batch is appended at the bottom of the list, which shouldn’t
+        // cost more as more entries are loaded.
+        QBENCHMARK_ONCE {
+            loadDatabase(tempFile.fileName(), size);
+        }
+    }
+
+    void benchmarkRevisit_data()
+    {
+        QTest::addColumn<int>("size");
+        QTest::newRow("10k") << 10000;
+        QTest::newRow("100k") << 100000;
+        QTest::newRow("1M") << 1000000;
+    }
+
+    void benchmarkRevisit()
+    {
+        QFETCH(int, size);
+
+        QTemporaryFile tempFile;
+        tempFile.open();
+        createDatabase(tempFile.fileName(), size, size);
+        loadDatabase(tempFile.fileName(), size);
+
+        // Revisiting the least recently visited entry moves it from the
+        // bottom of the list to the top, which shouldn’t get any slower
+        // as the history grows.
+        QBENCHMARK {
+            QUrl url = model->data(model->index(size - 1, 0), HistoryModel::Url).toUrl();
+            model->add(url, "Example Domain", QUrl());
+        }
+        QCOMPARE(model->rowCount(), size);
+    }
+
+    void benchmarkMemory()
+    {
+        if (heapSize() < 0) {
+            QSKIP("Heap statistics are not available on this platform");
+        }
+
+        // Entries spread over 1000 domains with one icon each, which is
+        // what makes interning worthwhile in real histories.
+        const int size = 100000;
+        QTemporaryFile tempFile;
+        tempFile.open();
+        QString fileName = tempFile.fileName();
+        createDatabase(fileName, size, 1000);
+
+        delete model;
+        model = new HistoryModel;
+        QSignalSpy spyLoaded(model, SIGNAL(loaded()));
+        // This includes the database connection and its page cache,
+        // which are small compared to the entries at this size.
+        qint64 before = heapSize();
+        model->setDatabasePath(fileName);
+        QTRY_VERIFY_WITH_TIMEOUT(spyLoaded.count() == 1, 600000);
+        QCOMPARE(model->rowCount(), size);
+        qint64 after = heapSize();
+        QTest::setBenchmarkResult(qreal(after - before) / size, QTest::BytesAllocated);
+    }
 };
 
 QTEST_MAIN(HistoryModelTests)
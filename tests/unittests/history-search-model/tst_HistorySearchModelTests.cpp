@@ -0,0 +1,209 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Qt
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+// local
+#include "history-model.h"
+#include "history-search-model.h"
+
+class HistorySearchModelTests : public QObject
+{
+    Q_OBJECT
+
+private:
+    HistoryModel* history;
+    HistorySearchModel* model;
+
+    void search(const QStringList& terms)
+    {
+        model->setTerms(terms);
+        if (model->searching()) {
+            QTRY_VERIFY(!model->searching());
+        }
+    }
+
+private Q_SLOTS:
+    void init()
+    {
+        history = new HistoryModel;
+        history->setDatabasePath(":memory:");
+        model = new HistorySearchModel;
+        model->setSourceModel(history);
+    }
+
+    void cleanup()
+    {
+        delete model;
+        delete history;
+    }
+
+    void shouldBeInitiallyEmpty()
+    {
+        QCOMPARE(model->rowCount(), 0);
+        QVERIFY(!model->searching());
+    }
+
+    void shouldNotSearchWithoutTerms()
+    {
+        history->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        model->setTerms(QStringList());
+        QVERIFY(!model->searching());
+        QCOMPARE(model->rowCount(), 0);
+    }
+
+    void shouldMatchWordPrefixesInUrlAndTitle()
+    {
+        history->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        history->add(QUrl("http://ubports.com/"), "Welcome to UBports", QUrl());
+        history->add(QUrl("http://wikipedia.org/wiki/Ubuntu"), "Ubuntu - Wikipedia", QUrl());
+
+        search(QStringList() << "exam");
+        QCOMPARE(model->rowCount(), 1);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Url).toUrl(),
+                 QUrl("http://example.org/"));
+
+        search(QStringList() << "UB");
+        QCOMPARE(model->rowCount(), 2);
+
+        // All terms must match
+        search(QStringList() << "ub" << "wiki");
+        QCOMPARE(model->rowCount(), 1);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Title).toString(),
+                 QString("Ubuntu - Wikipedia"));
+
+        // Only the beginning of words is matched
+        search(QStringList() << "ample");
+        QCOMPARE(model->rowCount(), 0);
+    }
+
+    void shouldIgnoreQuerySyntax()
+    {
+        history->add(QUrl("http://example.org/"), "Example \"Domain\"", QUrl());
+        search(QStringList() << "\"domain" << "(" << "*" << "-");
+        QCOMPARE(model->rowCount(), 1);
+        search(QStringList() << "\"domain\"*");
+        QCOMPARE(model->rowCount(), 1);
+        search(QStringList() << "*");
+        QCOMPARE(model->rowCount(), 0);
+    }
+
+    void shouldRankByVisitsAndLimitResults()
+    {
+        history->add(QUrl("http://example.org/1"), "Example", QUrl());
+        history->add(QUrl("http://example.org/2"), "Example", QUrl());
+        history->add(QUrl("http://example.org/2"), "Example", QUrl());
+        history->add(QUrl("http://example.org/3"), "Example", QUrl());
+        history->add(QUrl("http://example.org/3"), "Example", QUrl());
+        history->add(QUrl("http://example.org/3"), "Example", QUrl());
+        model->setLimit(2);
+        search(QStringList() << "example");
+        QCOMPARE(model->rowCount(), 2);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Url).toUrl(),
+                 QUrl("http://example.org/3"));
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Visits).toInt(), 3);
+        QCOMPARE(model->data(model->index(1, 0), HistoryModel::Url).toUrl(),
+                 QUrl("http://example.org/2"));
+    }
+
+    void shouldRankBetterMatchesFirst()
+    {
+        // Visits weigh less than the address starting with the terms, the
+        // scheme and a leading “www.” aside
+        history->add(QUrl("http://example.com/"), "Home", QUrl());
+        for (int i = 0; i < 10; ++i) {
+            QUrl url(QString("http://www.site%1.org/page").arg(i));
+            history->add(url, "Example", QUrl());
+            history->add(url, "Example", QUrl());
+        }
+        model->setLimit(2);
+        search(QStringList() << "example");
+        QCOMPARE(model->rowCount(), 2);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Url).toUrl(),
+                 QUrl("http://example.com/"));
+        QCOMPARE(model->data(model->index(1, 0), HistoryModel::Visits).toInt(), 2);
+
+        // Words that start with the terms are better matches than terms
+        // matched regardless of diacritics
+        history->add(QUrl("http://example.org/ecole"), "Ecole", QUrl());
+        history->add(QUrl("http://example.org/école"), "École", QUrl());
+        search(QStringList() << "école");
+        QCOMPARE(model->rowCount(), 2);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Title).toString(), QString("École"));
+    }
+
+    void shouldReflectChangesToTheHistory()
+    {
+        history->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        search(QStringList() << "example");
+        QCOMPARE(model->rowCount(), 1);
+
+        history->update(QUrl("http://example.org/"), "Changed Title", QUrl());
+        history->add(QUrl("http://example.com/"), "Example Domain", QUrl());
+        QTRY_COMPARE(model->rowCount(), 2);
+        history->removeEntryByUrl(QUrl("http://example.org/"));
+        QTRY_COMPARE(model->rowCount(), 1);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Url).toUrl(),
+                 QUrl("http://example.com/"));
+
+        search(QStringList() << "changed");
+        QCOMPARE(model->rowCount(), 0);
+
+        history->clearAll();
+        search(QStringList() << "example");
+        QCOMPARE(model->rowCount(), 0);
+    }
+
+    void shouldReportHiddenEntries()
+    {
+        history->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        history->hide(QUrl("http://example.org/"));
+        search(QStringList() << "example");
+        QCOMPARE(model->rowCount(), 1);
+        QVERIFY(model->data(model->index(0, 0), HistoryModel::Hidden).toBool());
+    }
+
+    void shouldDiscardSupersededResults()
+    {
+        history->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        history->add(QUrl("http://ubports.com/"), "UBports", QUrl());
+        QSignalSpy spyCount(model, SIGNAL(countChanged()));
+        model->setTerms(QStringList() << "example");
+        model->setTerms(QStringList() << "ubports");
+        QTRY_VERIFY(!model->searching());
+        QCOMPARE(spyCount.count(), 1);
+        QCOMPARE(model->rowCount(), 1);
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Url).toUrl(),
+                 QUrl("http://ubports.com/"));
+    }
+
+    void shouldReturnItemsWithGet()
+    {
+        history->add(QUrl("http://example.org/"), "Example Domain", QUrl());
+        search(QStringList() << "example");
+        QVariantMap item = model->get(0);
+        QCOMPARE(item.value("url").toUrl(), QUrl("http://example.org/"));
+        QCOMPARE(item.value("title").toString(), QString("Example Domain"));
+        QVERIFY(model->get(1).isEmpty());
+    }
+};
+
+QTEST_MAIN(HistorySearchModelTests)
+#include "tst_HistorySearchModelTests.moc"
@@ -30,15 +30,20 @@
 #include "bookmarks-folderlist-model.h"
 #include "favicon-fetcher.h"
 #include "file-operations.h"
+#include "fuzzy-search-model.h"
+#include "grouped-history-query-model.h"
 #include "history-domain-model.h"
 #include "history-domainlist-model.h"
 #include "history-model.h"
 #include "history-lastvisitdatelist-model.h"
+#include "history-search-model.h"
 #include "limit-proxy-model.h"
 #include "reparenter.h"
 #include "searchengine.h"
 #include "tabs-model.h"
 #include "text-search-filter-model.h"
+#include "top-sites-model.h"
+#include "window-proxy-model.h"
 
 class TestContext : public QObject
 {
@@ -124,10 +129,6 @@ class HistoryModelMock : public HistoryModel {
     Q_OBJECT
 
 public:
-    static bool compareHistoryEntries(const HistoryEntry& a, const HistoryEntry& b) {
-        return a.lastVisit < b.lastVisit;
-    }
-
     Q_INVOKABLE int addByDate(const QUrl& url, const QString& title, const QDateTime& date)
     {
         int index = getEntryIndex(url);
@@ -142,16 +143,16 @@ public:
         // we reorder the model and reset it every time we add a new item by date
         // to keep things simple.
         beginResetModel();
-        HistoryEntry entry = m_entries.takeAt(index);
-        entry.lastVisit = date;
+        StoredEntry& entry = entryAt(index);
+        entry.lastVisit = date.toMSecsSinceEpoch();
         entry.visits = entry.visits + visitsToAdd;
-        m_entries.append(entry);
-        std::sort(m_entries.begin(), m_entries.end(), compareHistoryEntries);
+        rebuildIndexes();
         endResetModel();
 
-        updateExistingEntryInDatabase(entry);
+        const StoredEntry& sorted = entryAt(getEntryIndex(url));
+        updateExistingEntryInDatabase(sorted);
 
-        return entry.visits;
+        return sorted.visits;
     }
 };
 
@@ -182,7 +183,12 @@ int main(int argc, char** argv)
     qmlRegisterType<HistoryDomainModel>(browserUri, 0, 1, "HistoryDomainModel");
     qmlRegisterType<HistoryDomainListModel>(browserUri, 0, 1, "HistoryDomainListModel");
     qmlRegisterType<HistoryLastVisitDateListModel>(browserUri, 0, 1, "HistoryLastVisitDateListModel");
+    qmlRegisterType<HistorySearchModel>(browserUri, 0, 1, "HistorySearchModel");
+    qmlRegisterType<GroupedHistoryQueryModel>(browserUri, 0, 1, "GroupedHistoryQueryModel");
+    qmlRegisterType<FuzzySearchModel>(browserUri, 0, 1, "FuzzySearchModel");
     qmlRegisterType<LimitProxyModel>(browserUri, 0, 1, "LimitProxyModel");
+    qmlRegisterType<TopSitesModel>(browserUri, 0, 1, "TopSitesModel");
+    qmlRegisterType<WindowProxyModel>(browserUri, 0, 1, "WindowProxyModel");
     qmlRegisterType<TextSearchFilterModel>(browserUri, 0, 1, "TextSearchFilterModel");
     qmlRegisterSingletonType<FileOperations>(browserUri, 0, 1, "FileOperations", FileOperations_singleton_factory);
     qmlRegisterSingletonType<Reparenter>(browserUri, 0, 1, "Reparenter", Reparenter_singleton_factory);
@@ -36,7 +36,9 @@ Item {
     ListModel {
         id: model3
         readonly property bool displayUrl: true
-        readonly property url icon: ""
+        function iconOf(item) {
+            return (item.url.indexOf("item1") !== -1) ? "history" : "non-starred"
+        }
     }
 
     Suggestions {
@@ -103,6 +105,12 @@ Item {
             compare(delegate.title, data.title)
         }
 
+        function test_icons() {
+            compare(findChild(suggestions, "suggestionDelegate_0").icon, "")
+            compare(findChild(suggestions, "suggestionDelegate_5").icon, "history")
+            compare(findChild(suggestions, "suggestionDelegate_6").icon, "non-starred")
+        }
+
         function test_mouseActivation() {
             var delegate = findChild(suggestions, "suggestionDelegate_4")
             var center = centerOf(delegate)
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Qt
+#include <QtTest/QtTest>
+
+// local
+#include "rank-index.h"
+
+class RankIndexTests : public QObject
+{
+    Q_OBJECT
+
+private:
+    RankIndex* index;
+
+    QList<int> items() const
+    {
+        QList<int> result;
+        for (int i = 0; i < index->count(); ++i) {
+            result.append(index->itemAt(i));
+        }
+        return result;
+    }
+
+    void verifyRanks(const QList<int>& expected)
+    {
+        QCOMPARE(index->count(), expected.count());
+        QCOMPARE(items(), expected);
+        for (int i = 0; i < expected.count(); ++i) {
+            QCOMPARE(index->rankOf(expected.at(i)), i);
+        }
+    }
+
+private Q_SLOTS:
+    void init()
+    {
+        index = new RankIndex;
+    }
+
+    void cleanup()
+    {
+        delete index;
+    }
+
+    void shouldBeInitiallyEmpty()
+    {
+        QCOMPARE(index->count(), 0);
+        QCOMPARE(index->itemAt(0), -1);
+        QCOMPARE(index->rankOf(0), -1);
+        QVERIFY(!index->contains(0));
+    }
+
+    void shouldPrependAndAppendItems()
+    {
+        index->prepend(1);
+        index->append(2);
+        index->prepend(3);
+        index->append(4);
+        verifyRanks(QList<int>() << 3 << 1 << 2 << 4);
+        QCOMPARE(index->itemAt(4), -1);
+        QCOMPARE(index->itemAt(-1), -1);
+    }
+
+    void shouldMoveItemsToFront()
+    {
+        for (int i = 0; i < 5; ++i) {
+            index->append(i);
+        }
+        index->moveToFront(3);
+        verifyRanks(QList<int>() << 3 << 0 << 1 << 2 << 4);
+        index->moveToFront(3);
+        verifyRanks(QList<int>() << 3 << 0 << 1 << 2 << 4);
+        index->moveToFront(4);
+        verifyRanks(QList<int>() << 4 << 3 << 0 << 1 << 2);
+    }
+
+    void shouldRemoveItems()
+    {
+        for (int i = 0; i < 5; ++i) {
+            index->append(i);
+        }
+        index->remove(0);
+        index->remove(3);
+        index->remove(7);
+        verifyRanks(QList<int>() << 1 << 2 << 4);
+        QVERIFY(!index->contains(3));
+        QCOMPARE(index->rankOf(3), -1);
+        index->prepend(3);
+        verifyRanks(QList<int>() << 3 << 1 << 2 << 4);
+    }
+
+    void shouldResetItems()
+    {
+        index->append(9);
+        index->reset(QVector<int>() << 5 << 0 << 2);
+        verifyRanks(QList<int>() << 5 << 0 << 2);
+        QVERIFY(!index->contains(9));
+        index->clear();
+        verifyRanks(QList<int>());
+    }
+
+    void shouldStayConsistentWhenRelaidOut()
+    {
+        // Enough operations to exhaust the free slots at both ends many
+        // times, and to shrink the index again
+        QList<int> expected;
+        qsrand(42);
+        for (int i = 0; i < 5000; ++i) {
+            switch (qrand() % 4) {
+            case 0:
+                index->prepend(i);
+                expected.prepend(i);
+                break;
+            case 1:
+                index->append(i);
+                expected.append(i);
+                break;
+            case 2:
+                if (!expected.isEmpty()) {
+                    int item = expected.takeAt(qrand() % expected.count());
+                    index->moveToFront(item);
+                    expected.prepend(item);
+                }
+                break;
+            default:
+                if (!expected.isEmpty()) {
+                    index->remove(expected.takeAt(qrand() % expected.count()));
+                }
+            }
+        }
+        verifyRanks(expected);
+        while (expected.count() > 10) {
+            index->remove(expected.takeLast());
+        }
+        verifyRanks(expected);
+    }
+};
+
+QTEST_MAIN(RankIndexTests)
+#include "tst_RankIndexTests.moc"
@@ -178,6 +178,156 @@ private Q_SLOTS:
         QCOMPARE(matches->rowCount(), 1);
     }
 
+    void shouldIgnoreCaseAndDiacritics()
+    {
+        model->add(QUrl("http://example.org"), QString::fromUtf8("Café Crème"), QUrl());
+        model->add(QUrl("http://example.com"), "Example Domain", QUrl());
+        matches->setSearchFields(QStringList({"url", "title"}));
+        matches->setTerms(QStringList({"CAFE"}));
+        QCOMPARE(matches->rowCount(), 1);
+        matches->setTerms(QStringList({QString::fromUtf8("crème"), "cafe"}));
+        QCOMPARE(matches->rowCount(), 1);
+        matches->setTerms(QStringList({QString::fromUtf8("ÉXAMPLE")}));
+        QCOMPARE(matches->rowCount(), 2);
+    }
+
+    void shouldNotMatchTermsAcrossFields()
+    {
+        model->add(QUrl("http://example.org"), "Example Domain", QUrl());
+        matches->setSearchFields(QStringList({"url", "title"}));
+        matches->setTerms(QStringList({"orgexample"}));
+        QCOMPARE(matches->rowCount(), 0);
+    }
+
+    void shouldUpdateResultsWhenSourceDataChanges()
+    {
+        model->add(QUrl("http://example.org"), "Example Domain", QUrl());
+        matches->setSearchFields(QStringList({"url", "title"}));
+        matches->setTerms(QStringList({"example"}));
+        QCOMPARE(matches->rowCount(), 1);
+        model->update(QUrl("http://example.org"), "Changed Title", QUrl());
+        matches->setTerms(QStringList({"changed"}));
+        QCOMPARE(matches->rowCount(), 1);
+        matches->setTerms(QStringList({"domain"}));
+        QCOMPARE(matches->rowCount(), 0);
+    }
+
+    void shouldRefineResultsWhenTermsNarrow()
+    {
+        model->add(QUrl("http://example.org"), "Example Domain", QUrl());
+        model->add(QUrl("http://ubuntu.com"), "Home | Ubuntu", QUrl());
+        model->add(QUrl("http://ubuntu.com/download"), "Download Ubuntu | Ubuntu", QUrl());
+        matches->setSearchFields(QStringList({"url", "title"}));
+        matches->setTerms(QStringList({"u"}));
+        QCOMPARE(matches->rowCount(), 2);
+        matches->setTerms(QStringList({"ub"}));
+        QCOMPARE(matches->rowCount(), 2);
+        matches->setTerms(QStringList({"ub", "down"}));
+        QCOMPARE(matches->rowCount(), 1);
+
+        // A row rejected by the current terms that changes is searched again
+        model->update(QUrl("http://ubuntu.com"), "Ubuntu downloads", QUrl());
+        QCOMPARE(matches->rowCount(), 2);
+        model->add(QUrl("http://ubuntu.com/downloads"), "Downloads", QUrl());
+        QCOMPARE(matches->rowCount(), 3);
+
+        // Rows rejected before may match terms that don’t narrow the previous ones
+        matches->setTerms(QStringList({"ex"}));
+        QCOMPARE(matches->rowCount(), 1);
+        matches->setTerms(QStringList());
+        QCOMPARE(matches->rowCount(), 4);
+    }
+
+    void shouldFilterAsynchronously()
+    {
+        model->add(QUrl("http://example.org"), "Example Domain", QUrl());
+        model->add(QUrl("http://ubuntu.com"), "Home | Ubuntu", QUrl());
+        model->add(QUrl("http://ubuntu.com/download"), "Download Ubuntu | Ubuntu", QUrl());
+        matches->setSearchFields(QStringList({"url", "title"}));
+        QSignalSpy asynchronousSpy(matches, SIGNAL(asynchronousChanged()));
+        matches->setAsynchronous(true);
+        QVERIFY(matches->asynchronous());
+        QCOMPARE(asynchronousSpy.count(), 1);
+
+        QSignalSpy pendingSpy(matches, SIGNAL(pendingChanged()));
+        QSignalSpy layoutSpy(matches, SIGNAL(layoutChanged(QList<QPersistentModelIndex>, QAbstractItemModel::LayoutChangeHint)));
+        QSignalSpy removedSpy(matches, SIGNAL(rowsRemoved(const QModelIndex&, int, int)));
+        matches->setTerms(QStringList({"ubuntu"}));
+        QVERIFY(matches->pending());
+        QCOMPARE(pendingSpy.count(), 1);
+        QCOMPARE(matches->rowCount(), 3);
+        QTRY_VERIFY(!matches->pending());
+        QCOMPARE(pendingSpy.count(), 2);
+        QCOMPARE(matches->rowCount(), 2);
+        QCOMPARE(layoutSpy.count(), 1);
+        QVERIFY(removedSpy.isEmpty());
+
+        // Rows added once the results are published are filtered right away
+        model->add(QUrl("http://ubuntu.com/phone"), "Ubuntu Phone", QUrl());
+        QCOMPARE(matches->rowCount(), 3);
+        QVERIFY(!matches->pending());
+    }
+
+    void shouldCancelOutdatedAsynchronousFiltering()
+    {
+        model->add(QUrl("http://example.org"), "Example Domain", QUrl());
+        model->add(QUrl("http://ubuntu.com"), "Home | Ubuntu", QUrl());
+        matches->setSearchFields(QStringList({"url", "title"}));
+        matches->setAsynchronous(true);
+        QSignalSpy pendingSpy(matches, SIGNAL(pendingChanged()));
+        matches->setTerms(QStringList({"example"}));
+        matches->setTerms(QStringList({"home"}));
+        QTRY_VERIFY(!matches->pending());
+        QCOMPARE(pendingSpy.count(), 2);
+        QCOMPARE(matches->rowCount(), 1);
+        QCOMPARE(matches->data(matches->index(0, 0), HistoryModel::Url).toUrl(), QUrl("http://ubuntu.com"));
+    }
+
+    void shouldRestartAsynchronousFilteringWhenSourceModelUpdates()
+    {
+        model->add(QUrl("http://example.org"), "Example Domain", QUrl());
+        matches->setSearchFields(QStringList({"url", "title"}));
+        matches->setAsynchronous(true);
+        matches->setTerms(QStringList({"ubuntu"}));
+        QVERIFY(matches->pending());
+        model->add(QUrl("http://ubuntu.com"), "Home | Ubuntu", QUrl());
+        model->update(QUrl("http://example.org"), "Ubuntu Example", QUrl());
+        QTRY_VERIFY(!matches->pending());
+        QCOMPARE(matches->rowCount(), 2);
+    }
+
+    void shouldFilterLargeModelsAsynchronously()
+    {
+        // Enough rows for the search fields to be read over several slices
+        for (int i = 0; i < 5000; ++i) {
+            model->add(QUrl(QString("http://example.org/%1").arg(i)), QString("Example %1").arg(i), QUrl());
+        }
+        matches->setSearchFields(QStringList({"url", "title"}));
+        matches->setAsynchronous(true);
+        matches->setTerms(QStringList({"example", "123"}));
+        QVERIFY(matches->pending());
+        model->add(QUrl("http://example.org/new"), "Example 1234", QUrl());
+        matches->setTerms(QStringList({"example", "1234"}));
+        QTRY_VERIFY(!matches->pending());
+        QCOMPARE(matches->rowCount(), 2);
+    }
+
+    void shouldFilterSynchronouslyWhenNoLongerAsynchronous()
+    {
+        model->add(QUrl("http://example.org"), "Example Domain", QUrl());
+        model->add(QUrl("http://ubuntu.com"), "Home | Ubuntu", QUrl());
+        matches->setSearchFields(QStringList({"url", "title"}));
+        matches->setAsynchronous(true);
+        matches->setTerms(QStringList({"ubuntu"}));
+        QVERIFY(matches->pending());
+        matches->setAsynchronous(false);
+        QVERIFY(!matches->pending());
+        QCOMPARE(matches->rowCount(), 1);
+        matches->setTerms(QStringList({"example"}));
+        QVERIFY(!matches->pending());
+        QCOMPARE(matches->rowCount(), 1);
+    }
+
     void shouldWarnOnInvalidFields()
     {
         QTest::ignoreMessage(QtWarningMsg, "Source model does not have role matching field: \"foo\"");
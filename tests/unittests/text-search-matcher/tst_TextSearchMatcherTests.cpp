@@ -0,0 +1,232 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Qt
+#include <QtTest/QtTest>
+
+// local
+#include "text-search-matcher.h"
+
+Q_DECLARE_METATYPE(TextSearchMatcher::Implementation)
+
+class TextSearchMatcherTests : public QObject
+{
+    Q_OBJECT
+
+private:
+    static quint64 expectedMatch(const QStringList& terms, const QString& text)
+    {
+        quint64 found = 0;
+        for (int i = 0; i < terms.count(); ++i) {
+            if (text.contains(terms.at(i))) {
+                found |= (Q_UINT64_C(1) << i);
+            }
+        }
+        return found;
+    }
+
+    static void addImplementationColumn()
+    {
+        QTest::addColumn<TextSearchMatcher::Implementation>("implementation");
+        QTest::newRow("scalar") << TextSearchMatcher::Scalar;
+        QTest::newRow("sse2") << TextSearchMatcher::Sse2;
+        QTest::newRow("avx2") << TextSearchMatcher::Avx2;
+    }
+
+    static void skipUnsupported(TextSearchMatcher::Implementation implementation)
+    {
+        if (!TextSearchMatcher::isSupported(implementation)) {
+            QSKIP("Implementation not supported on this processor");
+        }
+    }
+
+    /*
+        Search keys as TextSearchFilterModel builds them for history entries:
+        normalized title and URL, each followed by a null character.
+    */
+    static QStringList corpus(int size)
+    {
+        static const char* const words[] = {
+            "news", "weather", "the", "ubports", "browser", "morph", "wiki",
+            "forum", "release", "notes", "download", "phone", "tablet", "video",
+            "mail", "calendar", "maps", "search", "how", "to", "install", "linux",
+        };
+        static const int wordCount = sizeof(words) / sizeof(words[0]);
+        qsrand(42);
+        QStringList keys;
+        for (int i = 0; i < size; ++i) {
+            QString title;
+            int length = 2 + qrand() % 8;
+            for (int j = 0; j < length; ++j) {
+                title.append(QLatin1String(words[qrand() % wordCount]));
+                title.append(QLatin1Char(' '));
+            }
+            QString url = QString("https://www.%1%2.org/%3/%4?id=%5")
+                .arg(words[qrand() % wordCount]).arg(qrand() % 100)
+                .arg(words[qrand() % wordCount]).arg(words[qrand() % wordCount])
+                .arg(qrand());
+            keys.append(title + QChar(QChar::Null) + url + QChar(QChar::Null));
+        }
+        return keys;
+    }
+
+private Q_SLOTS:
+    void shouldFallBackToScalarWhenUnsupported()
+    {
+        QVERIFY(TextSearchMatcher::isSupported(TextSearchMatcher::Scalar));
+        QVERIFY(TextSearchMatcher::isSupported(TextSearchMatcher::bestImplementation()));
+        TextSearchMatcher matcher(QStringList() << "foo", TextSearchMatcher::Avx2);
+        if (TextSearchMatcher::isSupported(TextSearchMatcher::Avx2)) {
+            QCOMPARE(matcher.implementation(), TextSearchMatcher::Avx2);
+        } else {
+            QCOMPARE(matcher.implementation(), TextSearchMatcher::Scalar);
+        }
+    }
+
+    void shouldHaveABitPerTerm()
+    {
+        QCOMPARE(TextSearchMatcher().allTerms(), Q_UINT64_C(0));
+        QCOMPARE(TextSearchMatcher(QStringList() << "a" << "b" << "c").allTerms(), Q_UINT64_C(7));
+        QStringList terms;
+        for (int i = 0; i < TextSearchMatcher::MaxTerms; ++i) {
+            terms.append(QString::number(i));
+        }
+        QCOMPARE(TextSearchMatcher(terms).allTerms(), ~Q_UINT64_C(0));
+    }
+
+    void shouldMatchLikeContains_data()
+    {
+        addImplementationColumn();
+    }
+
+    void shouldMatchLikeContains()
+    {
+        QFETCH(TextSearchMatcher::Implementation, implementation);
+        skipUnsupported(implementation);
+
+        // Terms at the start, in the middle, at the end of texts of all
+        // lengths around the block sizes, and terms longer than the blocks.
+        QStringList terms;
+        terms << "a" << "ab" << "ba" << "xyz" << "" << "abcdefghijklmnopq"
+              << "qrstuvwxyz0123456789" << "été" << "zz";
+        TextSearchMatcher matcher(terms, implementation);
+        QString alphabet("abcdefghijklmnopqrstuvwxyz0123456789été");
+        for (int length = 0; length <= alphabet.size(); ++length) {
+            for (int start = 0; start + length <= alphabet.size(); ++start) {
+                QString text = alphabet.mid(start, length);
+                QCOMPARE(matcher.match(text), expectedMatch(terms, text));
+            }
+        }
+        QString text("zbzbzbzbzbzbzbzbzbzbzbzbzbzbzbzbzbzz");
+        QCOMPARE(matcher.match(text), expectedMatch(terms, text));
+        QCOMPARE(matcher.match(QString()), expectedMatch(terms, QString()));
+    }
+
+    void shouldMatchRandomTextsLikeContains_data()
+    {
+        addImplementationColumn();
+    }
+
+    void shouldMatchRandomTextsLikeContains()
+    {
+        QFETCH(TextSearchMatcher::Implementation, implementation);
+        skipUnsupported(implementation);
+
+        // A small alphabet, so that partial matches are frequent
+        qsrand(1234);
+        for (int i = 0; i < 2000; ++i) {
+            QStringList terms;
+            int count = 1 + qrand() % 6;
+            for (int j = 0; j < count; ++j) {
+                QString term;
+                int length = 1 + qrand() % 20;
+                for (int k = 0; k < length; ++k) {
+                    term.append(QChar('a' + qrand() % 3));
+                }
+                terms.append(term);
+            }
+            QString text;
+            int length = qrand() % 100;
+            for (int k = 0; k < length; ++k) {
+                text.append(QChar('a' + qrand() % 3));
+            }
+            TextSearchMatcher matcher(terms, implementation);
+            QCOMPARE(matcher.match(text), expectedMatch(terms, text));
+        }
+    }
+
+    void benchmarkMatch_data()
+    {
+        QTest::addColumn<int>("implementation");
+        // -1 stands for the filtering that TextSearchFilterModel did before,
+        // one case insensitive QString::contains() call per term and field
+        QTest::newRow("QString::contains") << -1;
+        QTest::newRow("scalar") << int(TextSearchMatcher::Scalar);
+        QTest::newRow("sse2") << int(TextSearchMatcher::Sse2);
+        QTest::newRow("avx2") << int(TextSearchMatcher::Avx2);
+    }
+
+    void benchmarkMatch()
+    {
+        QFETCH(int, implementation);
+        if (implementation != -1) {
+            skipUnsupported(TextSearchMatcher::Implementation(implementation));
+        }
+
+        QStringList keys = corpus(10000);
+        // The fields of each key, as the source model returned them
+        QVector<QStringList> fields;
+        Q_FOREACH(const QString& key, keys) {
+            fields.append(key.split(QChar(QChar::Null), QString::SkipEmptyParts));
+        }
+        QStringList terms;
+        terms << "release" << "ubports" << "notes";
+        TextSearchMatcher matcher(terms, TextSearchMatcher::Implementation(qMax(implementation, 0)));
+        int matches = 0;
+        QBENCHMARK {
+            matches = 0;
+            for (int i = 0; i < keys.count(); ++i) {
+                const QString& key = keys.at(i);
+                bool match = false;
+                if (implementation == -1) {
+                    QSet<QString> foundTerms;
+                    Q_FOREACH(const QString& field, fields.at(i)) {
+                        Q_FOREACH(const QString& term, terms) {
+                            if (field.contains(term, Qt::CaseInsensitive)) {
+                                foundTerms.insert(term);
+                            }
+                        }
+                        if (foundTerms.count() == terms.count()) {
+                            match = true;
+                            break;
+                        }
+                    }
+                } else {
+                    match = (matcher.match(key) == matcher.allTerms());
+                }
+                if (match) {
+                    ++matches;
+                }
+            }
+        }
+        QVERIFY(matches > 0);
+    }
+};
+
+QTEST_MAIN(TextSearchMatcherTests)
+#include "tst_TextSearchMatcherTests.moc"
@@ -0,0 +1,234 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Qt
+#include <QtCore/QCryptographicHash>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+// local
+#include "history-model.h"
+#include "top-sites-model.h"
+
+class FrecencyHistoryModel : public HistoryModel {
+public:
+    // Frecencies are otherwise updated asynchronously once visits are
+    // recorded in the database
+    void setFrecency(const QUrl& url, double frecency)
+    {
+        int index = getEntryIndex(url);
+        entryAt(index).frecency = frecency;
+        Q_EMIT dataChanged(this->index(index, 0), this->index(index, 0),
+                           QVector<int>() << Frecency);
+    }
+};
+
+class TopSitesModelTests : public QObject
+{
+    Q_OBJECT
+
+private:
+    FrecencyHistoryModel* history;
+    TopSitesModel* model;
+
+    QStringList urls() const
+    {
+        QStringList result;
+        for (int i = 0; i < model->rowCount(); ++i) {
+            result.append(model->data(model->index(i, 0), HistoryModel::Url).toString());
+        }
+        return result;
+    }
+
+    void add(const QString& url, double frecency)
+    {
+        history->add(QUrl(url), QString(), QUrl());
+        history->setFrecency(QUrl(url), frecency);
+    }
+
+private Q_SLOTS:
+    void init()
+    {
+        history = new FrecencyHistoryModel;
+        history->setDatabasePath(":memory:");
+        model = new TopSitesModel;
+        model->setSourceModel(history);
+    }
+
+    void cleanup()
+    {
+        delete model;
+        delete history;
+    }
+
+    void shouldBeInitiallyEmpty()
+    {
+        QCOMPARE(model->rowCount(), 0);
+        QCOMPARE(model->limit(), 10);
+    }
+
+    void shouldListEntriesByDecreasingFrecency()
+    {
+        add("http://a/", 1);
+        add("http://b/", 3);
+        add("http://c/", 2);
+        QCOMPARE(urls(), QStringList() << "http://b/" << "http://c/" << "http://a/");
+
+        history->setFrecency(QUrl("http://a/"), 4);
+        QCOMPARE(urls(), QStringList() << "http://a/" << "http://b/" << "http://c/");
+        history->setFrecency(QUrl("http://b/"), 1);
+        QCOMPARE(urls(), QStringList() << "http://a/" << "http://c/" << "http://b/");
+    }
+
+    void shouldListEntriesWithTheSameFrecencyInOrderOfArrival()
+    {
+        history->add(QUrl("http://a/"), QString(), QUrl());
+        history->add(QUrl("http://b/"), QString(), QUrl());
+        QCOMPARE(urls(), QStringList() << "http://a/" << "http://b/");
+
+        // Visiting an entry again doesn’t change its frecency right away
+        history->add(QUrl("http://a/"), "A", QUrl());
+        QCOMPARE(urls(), QStringList() << "http://a/" << "http://b/");
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Title).toString(), QString("A"));
+        QCOMPARE(model->data(model->index(0, 0), HistoryModel::Visits).toInt(), 2);
+
+        // Existing entries are ranked in the order of the source model
+        TopSitesModel other;
+        other.setSourceModel(history);
+        QCOMPARE(other.data(other.index(0, 0), HistoryModel::Url).toUrl(), QUrl("http://a/"));
+        QCOMPARE(other.data(other.index(1, 0), HistoryModel::Url).toUrl(), QUrl("http://b/"));
+    }
+
+    void shouldMoveRowsWhenRankChanges()
+    {
+        add("http://a/", 3);
+        add("http://b/", 2);
+        add("http://c/", 1);
+        QSignalSpy spyMoved(model, SIGNAL(rowsMoved(const QModelIndex&, int, int, const QModelIndex&, int)));
+        QSignalSpy spyInserted(model, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
+        QSignalSpy spyRemoved(model, SIGNAL(rowsRemoved(const QModelIndex&, int, int)));
+        history->setFrecency(QUrl("http://c/"), 4);
+        QCOMPARE(spyMoved.count(), 1);
+        QList<QVariant> args = spyMoved.takeFirst();
+        QCOMPARE(args.at(1).toInt(), 2);
+        QCOMPARE(args.at(4).toInt(), 0);
+        QVERIFY(spyInserted.isEmpty());
+        QVERIFY(spyRemoved.isEmpty());
+        QCOMPARE(urls(), QStringList() << "http://c/" << "http://a/" << "http://b/");
+    }
+
+    void shouldExcludeHiddenEntries()
+    {
+        add("http://a/", 2);
+        add("http://b/", 1);
+        history->hide(QUrl("http://a/"));
+        QCOMPARE(urls(), QStringList() << "http://b/");
+        history->unHide(QUrl("http://a/"));
+        QCOMPARE(urls(), QStringList() << "http://a/" << "http://b/");
+
+        history->hide(QUrl("http://c/"));
+        add("http://c/", 3);
+        QCOMPARE(urls(), QStringList() << "http://a/" << "http://b/");
+    }
+
+    void shouldLimitTheNumberOfEntries()
+    {
+        model->setLimit(2);
+        add("http://a/", 3);
+        add("http://b/", 2);
+        add("http://c/", 1);
+        QCOMPARE(urls(), QStringList() << "http://a/" << "http://b/");
+
+        history->setFrecency(QUrl("http://c/"), 4);
+        QCOMPARE(urls(), QStringList() << "http://c/" << "http://a/");
+
+        // The next entry in the ranking takes the place of one that leaves
+        history->setFrecency(QUrl("http://c/"), 0);
+        QCOMPARE(urls(), QStringList() << "http://a/" << "http://b/");
+        history->removeEntryByUrl(QUrl("http://a/"));
+        QCOMPARE(urls(), QStringList() << "http://b/" << "http://c/");
+
+        QSignalSpy spyCount(model, SIGNAL(countChanged()));
+        model->setLimit(1);
+        QCOMPARE(urls(), QStringList() << "http://b/");
+        QCOMPARE(spyCount.count(), 1);
+        model->setLimit(-1);
+        QCOMPARE(urls(), QStringList() << "http://b/" << "http://c/");
+        model->setLimit(0);
+        QCOMPARE(model->rowCount(), 0);
+    }
+
+    void shouldUpdateWhenEntriesAreRemoved()
+    {
+        add("http://a/", 2);
+        add("http://b/", 1);
+        history->removeEntryByUrl(QUrl("http://b/"));
+        QCOMPARE(urls(), QStringList() << "http://a/");
+        history->clearAll();
+        QCOMPARE(model->rowCount(), 0);
+        QVERIFY(!model->contains(QUrl("http://a/")));
+    }
+
+    void shouldTellWhetherAUrlIsATopSite()
+    {
+        model->setLimit(1);
+        add("http://a/", 2);
+        add("http://b/", 1);
+        QString hashA = QCryptographicHash::hash("http://a/", QCryptographicHash::Md5).toHex();
+        QString hashB = QCryptographicHash::hash("http://b/", QCryptographicHash::Md5).toHex();
+        QVERIFY(model->contains(QUrl("http://a/")));
+        QVERIFY(model->containsHash(hashA));
+        QVERIFY(!model->contains(QUrl("http://b/")));
+        QVERIFY(!model->containsHash(hashB));
+
+        history->setFrecency(QUrl("http://b/"), 3);
+        QVERIFY(!model->contains(QUrl("http://a/")));
+        QVERIFY(!model->containsHash(hashA));
+        QVERIFY(model->contains(QUrl("http://b/")));
+        QVERIFY(model->containsHash(hashB));
+    }
+
+    void shouldReturnItemsWithGet()
+    {
+        history->add(QUrl("http://example.org/"), "Example Domain", QUrl("http://example.org/favicon.ico"));
+        QVariantMap item = model->get(0);
+        QCOMPARE(item.value("url").toUrl(), QUrl("http://example.org/"));
+        QCOMPARE(item.value("title").toString(), QString("Example Domain"));
+        QCOMPARE(item.value("icon").toUrl(), QUrl("http://example.org/favicon.ico"));
+        QCOMPARE(item.value("visits").toInt(), 1);
+        QCOMPARE(item.value("domain").toString(), QString("example.org"));
+        QCOMPARE(item.value("hidden").toBool(), false);
+        QVERIFY(model->get(1).isEmpty());
+    }
+
+    void shouldFollowTheSourceModel()
+    {
+        add("http://a/", 1);
+        QSignalSpy spyReset(model, SIGNAL(modelReset()));
+        model->setSourceModel(0);
+        QCOMPARE(spyReset.count(), 1);
+        QCOMPARE(model->rowCount(), 0);
+        add("http://b/", 2);
+        QCOMPARE(model->rowCount(), 0);
+        model->setSourceModel(history);
+        QCOMPARE(urls(), QStringList() << "http://b/" << "http://a/");
+    }
+};
+
+QTEST_MAIN(TopSitesModelTests)
+#include "tst_TopSitesModelTests.moc"
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Qt
+#include <QtTest/QtTest>
+
+// local
+#include "trigram-index.h"
+
+class TrigramIndexTests : public QObject
+{
+    Q_OBJECT
+
+private:
+    TrigramIndex* index;
+
+    QList<int> documents(const QString& query, double threshold=0.3, int limit=10)
+    {
+        QList<int> result;
+        Q_FOREACH(const TrigramIndex::Match& match, index->search(query, threshold, limit)) {
+            result.append(match.document);
+        }
+        return result;
+    }
+
+private Q_SLOTS:
+    void init()
+    {
+        index = new TrigramIndex;
+        index->insert(1, "GitHub: Where the world builds software github.com/");
+        index->insert(2, "The GitLab DevSecOps Platform gitlab.com/");
+        index->insert(3, "Example Domain example.org/");
+    }
+
+    void cleanup()
+    {
+        delete index;
+    }
+
+    void shouldSplitTextIntoNormalizedWords()
+    {
+        QCOMPARE(TrigramIndex::words("Hello, Wörld! hello 42"),
+                 QStringList() << "hello" << "world" << "42");
+        QVERIFY(TrigramIndex::words(" -- ").isEmpty());
+    }
+
+    void shouldComputeSimilarityOfWords()
+    {
+        QCOMPARE(TrigramIndex::similarity("github", "github"), 1.0);
+        QCOMPARE(TrigramIndex::similarity("gthub", "github"), 4.0 / 9);
+        QCOMPARE(TrigramIndex::similarity("abc", "xyz"), 0.0);
+    }
+
+    void shouldCountDocumentsAndWords()
+    {
+        QCOMPARE(index->count(), 3);
+        index->insert(4, "");
+        QCOMPARE(index->count(), 4);
+        int words = index->wordCount();
+        index->insert(5, "github example");
+        QCOMPARE(index->wordCount(), words);
+    }
+
+    void shouldMatchMisspelledWords()
+    {
+        QCOMPARE(documents("gthub"), QList<int>() << 1);
+        QVector<TrigramIndex::Match> matches = index->search("gthub", 0.3, 10);
+        QCOMPARE(matches.first().similarity, 4.0 / 9);
+        QCOMPARE(documents("EXMPLE"), QList<int>() << 3);
+        QVERIFY(documents("gthub", 0.5).isEmpty());
+    }
+
+    void shouldMatchAllWordsOfTheQuery()
+    {
+        QCOMPARE(documents("exmple domain"), QList<int>() << 3);
+        QCOMPARE(index->search("exmple domain", 0.3, 10).first().similarity, (0.5 + 1.0) / 2);
+        QVERIFY(documents("exmple gthub").isEmpty());
+        QVERIFY(documents("").isEmpty());
+    }
+
+    void shouldReturnTheMostSimilarFirst()
+    {
+        index->insert(4, "githubs");
+        QCOMPARE(documents("github"), QList<int>() << 1 << 4);
+        QCOMPARE(documents("github", 0.3, 1), QList<int>() << 1);
+        QVERIFY(documents("github", 0.3, 0).isEmpty());
+    }
+
+    void shouldRemoveDocuments()
+    {
+        int words = index->wordCount();
+        index->remove(1);
+        QCOMPARE(index->count(), 2);
+        QVERIFY(documents("gthub").isEmpty());
+        QVERIFY(index->wordCount() < words);
+        index->remove(1);
+        QCOMPARE(index->count(), 2);
+        index->clear();
+        QCOMPARE(index->count(), 0);
+        QCOMPARE(index->wordCount(), 0);
+        QVERIFY(documents("example").isEmpty());
+    }
+
+    void shouldReplaceDocumentsIndexedAgain()
+    {
+        index->insert(3, "Something else");
+        QCOMPARE(index->count(), 3);
+        QVERIFY(documents("example").isEmpty());
+        QCOMPARE(documents("somthing"), QList<int>() << 3);
+        index->insert(3, "Example again");
+        index->insert(3, "Example again");
+        QCOMPARE(documents("example"), QList<int>() << 3);
+    }
+
+    void shouldKeepMatchingWhileDocumentsAreRemoved()
+    {
+        for (int i = 10; i < 110; ++i) {
+            index->insert(i, QString("common word%1").arg(i));
+        }
+        for (int i = 10; i < 109; ++i) {
+            index->remove(i);
+        }
+        QCOMPARE(documents("common"), QList<int>() << 109);
+        index->insert(20, "common");
+        QCOMPARE(documents("common"), QList<int>() << 20 << 109);
+        index->remove(109);
+        index->remove(20);
+        QVERIFY(documents("common").isEmpty());
+        QCOMPARE(index->wordCount(), TrigramIndex::words(
+            "GitHub: Where the world builds software github.com/ "
+            "The GitLab DevSecOps Platform gitlab.com/ "
+            "Example Domain example.org/").count());
+    }
+};
+
+QTEST_MAIN(TrigramIndexTests)
+#include "tst_TrigramIndexTests.moc"
@@ -0,0 +1,335 @@
+/*
+ * Copyright 2026 UBports Foundation
+ *
+ * This file is part of morph-browser.
+ *
+ * morph-browser is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * morph-browser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Qt
+#include <QtCore/QAbstractListModel>
+#include <QtCore/QStringList>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+// local
+#include "window-proxy-model.h"
+
+class SimpleListModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    enum Roles {
+        Index = Qt::UserRole + 1,
+        String
+    };
+
+    QHash<int, QByteArray> roleNames() const
+    {
+        static QHash<int, QByteArray> roles;
+        if (roles.isEmpty()) {
+            roles[Index] = "index";
+            roles[String] = "string";
+        }
+        return roles;
+    }
+
+    int rowCount(const QModelIndex& parent=QModelIndex()) const
+    {
+        return m_strings.count();
+    }
+
+    QVariant data(const QModelIndex& index, int role) const
+    {
+        if (!index.isValid()) {
+            return QVariant();
+        }
+        switch (role) {
+        case Index:
+            return index.row();
+        case String:
+            return m_strings.at(index.row());
+        default:
+            return QVariant();
+        }
+    }
+
+    void insert(int index, const QStringList& strings)
+    {
+        beginInsertRows(QModelIndex(), index, index + strings.count() - 1);
+        for (int i = 0; i < strings.count(); ++i) {
+            m_strings.insert(index + i, strings.at(i));
+        }
+        endInsertRows();
+    }
+
+    void remove(int index, int count=1)
+    {
+        beginRemoveRows(QModelIndex(), index, index + count - 1);
+        for (int i = 0; i < count; ++i) {
+            m_strings.removeAt(index);
+        }
+        endRemoveRows();
+    }
+
+    void move(int from, int to)
+    {
+        beginMoveRows(QModelIndex(), from, from, QModelIndex(), (to > from) ? to + 1 : to);
+        m_strings.move(from, to);
+        endMoveRows();
+    }
+
+    void set(int index, const QString& string)
+    {
+        m_strings[index] = string;
+        Q_EMIT dataChanged(this->index(index, 0), this->index(index, 0));
+    }
+
+private:
+    QStringList m_strings;
+};
+
+class WindowProxyModelTests : public QObject
+{
+    Q_OBJECT
+
+private:
+    SimpleListModel* strings;
+    WindowProxyModel* model;
+    QSignalSpy* spyInserted;
+    QSignalSpy* spyRemoved;
+    QSignalSpy* spyMoved;
+    QSignalSpy* spyChanged;
+
+    QStringList window() const
+    {
+        QStringList result;
+        for (int i = 0; i < model->rowCount(); ++i) {
+            result.append(model->data(model->index(i, 0), SimpleListModel::String).toString());
+        }
+        return result;
+    }
+
+    void clearSpies()
+    {
+        spyInserted->clear();
+        spyRemoved->clear();
+        spyMoved->clear();
+        spyChanged->clear();
+    }
+
+    bool noSignals() const
+    {
+        return spyInserted->isEmpty() && spyRemoved->isEmpty() &&
+               spyMoved->isEmpty() && spyChanged->isEmpty();
+    }
+
+private Q_SLOTS:
+    void init()
+    {
+        strings = new SimpleListModel;
+        strings->insert(0, {"a", "b", "c", "d", "e", "f", "g", "h"});
+        model = new WindowProxyModel;
+        model->setSourceModel(strings);
+        model->setWindow(2, 3);
+        spyInserted = new QSignalSpy(model, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
+        spyRemoved = new QSignalSpy(model, SIGNAL(rowsRemoved(const QModelIndex&, int, int)));
+        spyMoved = new QSignalSpy(model, SIGNAL(rowsMoved(const QModelIndex&, int, int, const QModelIndex&, int)));
+        spyChanged = new QSignalSpy(model, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)));
+    }
+
+    void cleanup()
+    {
+        delete spyInserted;
+        delete spyRemoved;
+        delete spyMoved;
+        delete spyChanged;
+        delete model;
+        delete strings;
+    }
+
+    void shouldExposeAllRowsByDefault()
+    {
+        WindowProxyModel all;
+        QCOMPARE(all.offset(), 0);
+        QCOMPARE(all.limit(), -1);
+        QCOMPARE(all.rowCount(), 0);
+        all.setSourceModel(strings);
+        QCOMPARE(all.rowCount(), 8);
+        QCOMPARE(all.totalCount(), 8);
+    }
+
+    void shouldExposeTheRowsOfTheWindow()
+    {
+        QCOMPARE(window(), QStringList() << "c" << "d" << "e");
+        QCOMPARE(model->rowCount(), 3);
+        QCOMPARE(model->totalCount(), 8);
+        QModelIndex source = model->mapToSource(model->index(0, 0));
+        QCOMPARE(source.row(), 2);
+        QCOMPARE(model->mapFromSource(strings->index(4, 0)).row(), 2);
+        QVERIFY(!model->mapFromSource(strings->index(5, 0)).isValid());
+        QVERIFY(!model->mapFromSource(strings->index(1, 0)).isValid());
+
+        model->setOffset(6);
+        QCOMPARE(window(), QStringList() << "g" << "h");
+        model->setOffset(10);
+        QCOMPARE(model->rowCount(), 0);
+    }
+
+    void shouldIgnoreChangesAfterTheWindow()
+    {
+        strings->insert(6, {"x", "y"});
+        strings->remove(7);
+        strings->move(7, 6);
+        strings->set(6, "z");
+        QVERIFY(noSignals());
+        QCOMPARE(window(), QStringList() << "c" << "d" << "e");
+    }
+
+    void shouldInsertRowsInTheWindow()
+    {
+        strings->insert(3, {"x"});
+        QCOMPARE(window(), QStringList() << "c" << "x" << "d");
+        // The window is full, the inserted row pushes the last one out
+        QVERIFY(spyInserted->isEmpty());
+        QCOMPARE(spyChanged->count(), 1);
+        QList<QVariant> args = spyChanged->takeFirst();
+        QCOMPARE(args.at(0).toModelIndex().row(), 1);
+        QCOMPARE(args.at(1).toModelIndex().row(), 2);
+
+        model->setLimit(10);
+        clearSpies();
+        strings->insert(4, {"y", "z"});
+        QCOMPARE(spyInserted->count(), 1);
+        args = spyInserted->takeFirst();
+        QCOMPARE(args.at(1).toInt(), 2);
+        QCOMPARE(args.at(2).toInt(), 3);
+        QVERIFY(spyChanged->isEmpty());
+        QCOMPARE(window(), QStringList() << "c" << "x" << "y" << "z" << "d" << "e" << "f" << "g" << "h");
+    }
+
+    void shouldShiftTheWindowWhenRowsChangeBeforeIt()
+    {
+        strings->insert(0, {"x"});
+        QCOMPARE(window(), QStringList() << "b" << "c" << "d");
+        QVERIFY(spyInserted->isEmpty());
+        QCOMPARE(spyChanged->count(), 1);
+
+        clearSpies();
+        strings->remove(0, 2);
+        QCOMPARE(window(), QStringList() << "d" << "e" << "f");
+        QVERIFY(spyRemoved->isEmpty());
+        QCOMPARE(spyChanged->count(), 1);
+
+        // Moving rows across the window changes its rows
+        clearSpies();
+        strings->move(0, 5);
+        QCOMPARE(window(), QStringList() << "e" << "f" << "g");
+        QVERIFY(spyMoved->isEmpty());
+        QCOMPARE(spyChanged->count(), 1);
+    }
+
+    void shouldRemoveRowsFromTheWindow()
+    {
+        // Rows after the window take the place of the removed ones
+        strings->remove(3);
+        QCOMPARE(window(), QStringList() << "c" << "e" << "f");
+        QVERIFY(spyRemoved->isEmpty());
+        QCOMPARE(spyChanged->count(), 1);
+
+        // Until there are not enough of them
+        clearSpies();
+        strings->remove(4, 3);
+        QCOMPARE(window(), QStringList() << "c" << "e");
+        QCOMPARE(spyRemoved->count(), 1);
+        QList<QVariant> args = spyRemoved->takeFirst();
+        QCOMPARE(args.at(1).toInt(), 2);
+        QCOMPARE(args.at(2).toInt(), 2);
+        QVERIFY(spyChanged->isEmpty());
+    }
+
+    void shouldMoveRowsWithinTheWindow()
+    {
+        strings->move(2, 4);
+        QCOMPARE(window(), QStringList() << "d" << "e" << "c");
+        QCOMPARE(spyMoved->count(), 1);
+        QList<QVariant> args = spyMoved->takeFirst();
+        QCOMPARE(args.at(1).toInt(), 0);
+        QCOMPARE(args.at(4).toInt(), 3);
+        QVERIFY(spyChanged->isEmpty());
+    }
+
+    void shouldForwardDataChangesInTheWindow()
+    {
+        strings->set(3, "x");
+        QCOMPARE(spyChanged->count(), 1);
+        QCOMPARE(spyChanged->first().at(0).toModelIndex().row(), 1);
+        QCOMPARE(window(), QStringList() << "c" << "x" << "e");
+    }
+
+    void shouldMoveTheWindowWithASingleLayoutChange()
+    {
+        QSignalSpy spyLayout(model, SIGNAL(layoutChanged()));
+        QSignalSpy spyReset(model, SIGNAL(modelReset()));
+        QSignalSpy spyOffset(model, SIGNAL(offsetChanged()));
+        QPersistentModelIndex kept = model->index(2, 0);
+        QPersistentModelIndex lost = model->index(0, 0);
+        model->setWindow(3, 3);
+        QCOMPARE(window(), QStringList() << "d" << "e" << "f");
+        QCOMPARE(spyLayout.count(), 1);
+        QVERIFY(spyReset.isEmpty());
+        QCOMPARE(spyOffset.count(), 1);
+        QVERIFY(noSignals());
+        QCOMPARE(kept.row(), 1);
+        QCOMPARE(kept.data(SimpleListModel::String).toString(), QString("e"));
+        QVERIFY(!lost.isValid());
+
+        // The window has fewer rows at the end of the source model
+        model->setWindow(6, 3);
+        QCOMPARE(window(), QStringList() << "g" << "h");
+        QCOMPARE(spyReset.count(), 1);
+    }
+
+    void shouldChangeTheLimitAtTheEndOfTheWindow()
+    {
+        model->setLimit(5);
+        QCOMPARE(window(), QStringList() << "c" << "d" << "e" << "f" << "g");
+        QCOMPARE(spyInserted->count(), 1);
+        QCOMPARE(spyInserted->first().at(1).toInt(), 3);
+        model->setLimit(1);
+        QCOMPARE(window(), QStringList() << "c");
+        QCOMPARE(spyRemoved->count(), 1);
+        QCOMPARE(spyRemoved->first().at(1).toInt(), 1);
+        model->setLimit(-1);
+        QCOMPARE(model->rowCount(), 6);
+    }
+
+    void shouldGetOnlyTheRequestedRoles()
+    {
+        QVariantMap item = model->get(1, QStringList() << "string");
+        QCOMPARE(item.count(), 1);
+        QCOMPARE(item.value("string").toString(), QString("d"));
+        item = model->get(1);
+        QCOMPARE(item.count(), 2);
+        QCOMPARE(item.value("index").toInt(), 3);
+        QVERIFY(model->get(1, QStringList() << "unknown").isEmpty());
+        QVERIFY(model->get(3).isEmpty());
+
+        QCOMPARE(model->getRole(2, "string").toString(), QString("e"));
+        QVERIFY(!model->getRole(2, "unknown").isValid());
+        QVERIFY(!model->getRole(3, "string").isValid());
+    }
+};
+
+QTEST_MAIN(WindowProxyModelTests)
+#include "tst_WindowProxyModelTests.moc"